@@ -334,6 +334,7 @@ void foo ( void )
    GENOFFSET(RISCV64,riscv64,f30);
    GENOFFSET(RISCV64,riscv64,f31);
    GENOFFSET(RISCV64,riscv64,fcsr);
+   GENOFFSET(RISCV64,riscv64,LLSC_SIZE);
 }
 
 /*--------------------------------------------------------------------*/
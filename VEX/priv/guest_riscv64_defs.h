@@ -37,6 +37,7 @@
 #define __VEX_GUEST_RISCV64_DEFS_H
 
 #include "libvex_basictypes.h"
+#include "libvex_guest_riscv64.h"
 
 #include "guest_generic_bb_to_IR.h"
 
@@ -69,6 +70,60 @@ Bool guest_riscv64_state_requires_precise_mem_exns(
 
 extern VexGuestLayout riscv64guest_layout;
 
+/* Vector register length in bytes (VLEN/8). The guest state provides
+   32 vector registers of this size. */
+#define RISCV64_VLENB 16
+
+/* Integer vector operations which can be evaluated by
+   riscv64g_dirtyhelper_vop(). */
+typedef enum {
+   RISCV64vop_INVALID = 0,
+   /* Single-width elementwise operations. */
+   RISCV64vop_ADD,
+   RISCV64vop_SUB,
+   RISCV64vop_RSUB,
+   RISCV64vop_MINU,
+   RISCV64vop_MIN,
+   RISCV64vop_MAXU,
+   RISCV64vop_MAX,
+   RISCV64vop_AND,
+   RISCV64vop_OR,
+   RISCV64vop_XOR,
+   RISCV64vop_SLL,
+   RISCV64vop_SRL,
+   RISCV64vop_SRA,
+   RISCV64vop_MUL,
+   RISCV64vop_MERGE,
+   RISCV64vop_MV,
+   RISCV64vop_ID,
+   /* Comparisons producing a mask. */
+   RISCV64vop_MSEQ,
+   RISCV64vop_MSNE,
+   RISCV64vop_MSLTU,
+   RISCV64vop_MSLT,
+   RISCV64vop_MSLEU,
+   RISCV64vop_MSLE,
+   RISCV64vop_MSGTU,
+   RISCV64vop_MSGT,
+   /* Single-width reductions. */
+   RISCV64vop_REDSUM,
+   RISCV64vop_REDAND,
+   RISCV64vop_REDOR,
+   RISCV64vop_REDXOR,
+   RISCV64vop_REDMINU,
+   RISCV64vop_REDMIN,
+   RISCV64vop_REDMAXU,
+   RISCV64vop_REDMAX,
+} RISCV64VOp;
+
+/* Packing of the register operands of riscv64g_dirtyhelper_vop(). A vs1 value
+   of RISCV64_VOP_SCALAR denotes that the second operand is the scalar argument
+   rather than a vector register. */
+#define RISCV64_VOP_SCALAR 32
+#define RISCV64_VOP_REGS(_vd, _vs2, _vs1, _masked)                             \
+   ((ULong)(_vd) | (ULong)(_vs2) << 8 | (ULong)(_vs1) << 16 |                  \
+    (ULong)(_masked) << 24)
+
 /*------------------------------------------------------------*/
 /*--- riscv64 guest helpers                                ---*/
 /*------------------------------------------------------------*/
@@ -129,6 +184,31 @@ UInt riscv64g_calculate_fflags_fmadd_d(Double a1,
 ULong riscv64g_calculate_fclass_s(Float a1);
 ULong riscv64g_calculate_fclass_d(Double a1);
 
+/* Sanitize a vtype value written by vsetvl{i}. Returns the value unchanged if
+   the described configuration is supported, otherwise a value with only the
+   vill bit set. */
+ULong riscv64g_calculate_vtype(ULong vtype);
+
+/* Calculate VLMAX for a sanitized vtype value. Returns 0 if vill is set. */
+ULong riscv64g_calculate_vlmax(ULong vtype);
+
+/* Count the set bits in a 128-bit mask value. */
+ULong riscv64g_calculate_vcpop(ULong w0, ULong w1);
+
+/* Find the lowest set bit in a 128-bit mask value. Returns -1 if no bit is
+   set. */
+ULong riscv64g_calculate_vfirst(ULong w0, ULong w1);
+
+/* --- DIRTY HELPERS --- */
+
+/* Evaluate an integer vector operation when the vtype setting is not known at
+   translation time. The operation reads vl and vtype from the guest state and
+   accesses the vector registers packed in regs by RISCV64_VOP_REGS. */
+void riscv64g_dirtyhelper_vop(VexGuestRISCV64State* guest_state,
+                              ULong                 op,
+                              ULong                 regs,
+                              ULong                 scalar);
+
 #endif /* ndef __VEX_GUEST_RISCV64_DEFS_H */
 
 /*--------------------------------------------------------------------*/
@@ -374,6 +374,291 @@ UInt riscv64g_calculate_fflags_fmadd_d(Double a1,
 ULong riscv64g_calculate_fclass_s(Float a1) { CALCULATE_FCLASS("fclass.s"); }
 ULong riscv64g_calculate_fclass_d(Double a1) { CALCULATE_FCLASS("fclass.d"); }
 
+/* CALLED FROM GENERATED CODE: CLEAN HELPER */
+ULong riscv64g_calculate_vtype(ULong vtype)
+{
+   const ULong vill  = 1ULL << 63;
+   UInt        vlmul = vtype & 0x7;
+   UInt        vsew  = (vtype >> 3) & 0x7;
+
+   /* Only vlmul, vsew, vta and vma may be set. */
+   if ((vtype >> 8) != 0)
+      return vill;
+   /* SEW must not exceed ELEN=64 and vlmul=0b100 is reserved. */
+   if (vsew > 3 || vlmul == 0b100)
+      return vill;
+   /* A fractional LMUL requires SEW <= LMUL * ELEN. */
+   if (vlmul > 0b100 && vsew + 5 > vlmul)
+      return vill;
+   return vtype;
+}
+
+/* CALLED FROM GENERATED CODE: CLEAN HELPER */
+ULong riscv64g_calculate_vlmax(ULong vtype)
+{
+   if ((vtype >> 63) != 0)
+      return 0;
+   UInt vlmul = vtype & 0x7;
+   UInt vsew  = (vtype >> 3) & 0x7;
+   UInt n     = RISCV64_VLENB >> vsew;
+   return vlmul < 0b100 ? n << vlmul : n >> (8 - vlmul);
+}
+
+/* CALLED FROM GENERATED CODE: CLEAN HELPER */
+ULong riscv64g_calculate_vcpop(ULong w0, ULong w1)
+{
+   ULong res = 0;
+   for (; w0 != 0; w0 &= w0 - 1)
+      res++;
+   for (; w1 != 0; w1 &= w1 - 1)
+      res++;
+   return res;
+}
+
+/* CALLED FROM GENERATED CODE: CLEAN HELPER */
+ULong riscv64g_calculate_vfirst(ULong w0, ULong w1)
+{
+   for (UInt i = 0; i < 128; i++) {
+      ULong w = i < 64 ? w0 : w1;
+      if ((w >> (i % 64)) & 1)
+         return i;
+   }
+   return -1ULL;
+}
+
+/* Accessors of vector register elements used by riscv64g_dirtyhelper_vop().
+   The registers are contiguous in the guest state, so an element index can
+   run past the first register of a group. */
+static ULong vop_get(const VexGuestRISCV64State* gst,
+                     UInt                        vreg,
+                     UInt                        idx,
+                     UInt                        sew_lg2,
+                     Bool                        is_signed)
+{
+   const UChar* p   = (const UChar*)&gst->guest_v0 + vreg * RISCV64_VLENB +
+                    (idx << sew_lg2);
+   ULong        res = 0;
+   vassert(p + (1 << sew_lg2) <=
+           (const UChar*)&gst->guest_v31 + RISCV64_VLENB);
+   for (UInt i = 0; i < (1U << sew_lg2); i++)
+      res |= (ULong)p[i] << (8 * i);
+   if (is_signed && sew_lg2 < 3)
+      res = vex_sx_to_64(res, 8 << sew_lg2);
+   return res;
+}
+
+static void vop_put(VexGuestRISCV64State* gst,
+                    UInt                  vreg,
+                    UInt                  idx,
+                    UInt                  sew_lg2,
+                    ULong                 val)
+{
+   UChar* p = (UChar*)&gst->guest_v0 + vreg * RISCV64_VLENB + (idx << sew_lg2);
+   vassert(p + (1 << sew_lg2) <= (UChar*)&gst->guest_v31 + RISCV64_VLENB);
+   for (UInt i = 0; i < (1U << sew_lg2); i++)
+      p[i] = (val >> (8 * i)) & 0xff;
+}
+
+static Bool vop_get_mask(const VexGuestRISCV64State* gst, UInt vreg, UInt idx)
+{
+   const UChar* p = (const UChar*)&gst->guest_v0 + vreg * RISCV64_VLENB;
+   return (p[idx / 8] >> (idx % 8)) & 1;
+}
+
+static void
+vop_put_mask(VexGuestRISCV64State* gst, UInt vreg, UInt idx, Bool val)
+{
+   UChar* p = (UChar*)&gst->guest_v0 + vreg * RISCV64_VLENB;
+   p[idx / 8] = (p[idx / 8] & ~(1 << (idx % 8))) | (val << (idx % 8));
+}
+
+/* Tell whether an operation interprets its operands as signed values. */
+static Bool vop_is_signed(RISCV64VOp op)
+{
+   switch (op) {
+   case RISCV64vop_MIN:
+   case RISCV64vop_MAX:
+   case RISCV64vop_SRA:
+   case RISCV64vop_MSLT:
+   case RISCV64vop_MSLE:
+   case RISCV64vop_MSGT:
+   case RISCV64vop_REDMIN:
+   case RISCV64vop_REDMAX:
+      return True;
+   default:
+      return False;
+   }
+}
+
+/* Evaluate a single-width operation on two extended elements. */
+static ULong vop_eval(RISCV64VOp op, ULong a, ULong b, UInt sew_lg2)
+{
+   UInt shmask = (8 << sew_lg2) - 1;
+   switch (op) {
+   case RISCV64vop_ADD:
+   case RISCV64vop_REDSUM:
+      return a + b;
+   case RISCV64vop_SUB:
+      return a - b;
+   case RISCV64vop_RSUB:
+      return b - a;
+   case RISCV64vop_MINU:
+   case RISCV64vop_REDMINU:
+      return a < b ? a : b;
+   case RISCV64vop_MIN:
+   case RISCV64vop_REDMIN:
+      return (Long)a < (Long)b ? a : b;
+   case RISCV64vop_MAXU:
+   case RISCV64vop_REDMAXU:
+      return a > b ? a : b;
+   case RISCV64vop_MAX:
+   case RISCV64vop_REDMAX:
+      return (Long)a > (Long)b ? a : b;
+   case RISCV64vop_AND:
+   case RISCV64vop_REDAND:
+      return a & b;
+   case RISCV64vop_OR:
+   case RISCV64vop_REDOR:
+      return a | b;
+   case RISCV64vop_XOR:
+   case RISCV64vop_REDXOR:
+      return a ^ b;
+   case RISCV64vop_SLL:
+      return a << (b & shmask);
+   case RISCV64vop_SRL:
+      return a >> (b & shmask);
+   case RISCV64vop_SRA:
+      return (ULong)((Long)a >> (b & shmask));
+   case RISCV64vop_MUL:
+      return a * b;
+   case RISCV64vop_MV:
+      return b;
+   case RISCV64vop_MSEQ:
+      return a == b;
+   case RISCV64vop_MSNE:
+      return a != b;
+   case RISCV64vop_MSLTU:
+      return a < b;
+   case RISCV64vop_MSLT:
+      return (Long)a < (Long)b;
+   case RISCV64vop_MSLEU:
+      return a <= b;
+   case RISCV64vop_MSLE:
+      return (Long)a <= (Long)b;
+   case RISCV64vop_MSGTU:
+      return a > b;
+   case RISCV64vop_MSGT:
+      return (Long)a > (Long)b;
+   default:
+      vpanic("vop_eval(riscv64)");
+   }
+}
+
+/* CALLED FROM GENERATED CODE: DIRTY HELPER */
+void riscv64g_dirtyhelper_vop(VexGuestRISCV64State* guest_state,
+                              ULong                 op,
+                              ULong                 regs,
+                              ULong                 scalar)
+{
+   UInt vd     = regs & 0xff;
+   UInt vs2    = (regs >> 8) & 0xff;
+   UInt vs1    = (regs >> 16) & 0xff;
+   Bool masked = (regs >> 24) & 1;
+   vassert(vd < 32 && vs2 < 32 && vs1 <= RISCV64_VOP_SCALAR);
+
+   ULong vtype = guest_state->guest_vtype;
+   ULong vl    = guest_state->guest_vl;
+   if ((vtype >> 63) != 0)
+      return;
+   UInt sew_lg2   = (vtype >> 3) & 0x7;
+   Bool is_signed = vop_is_signed(op);
+   vassert(vl <= riscv64g_calculate_vlmax(vtype));
+
+   switch (op) {
+   case RISCV64vop_REDSUM:
+   case RISCV64vop_REDAND:
+   case RISCV64vop_REDOR:
+   case RISCV64vop_REDXOR:
+   case RISCV64vop_REDMINU:
+   case RISCV64vop_REDMIN:
+   case RISCV64vop_REDMAXU:
+   case RISCV64vop_REDMAX: {
+      if (vl == 0)
+         return;
+      ULong acc = vop_get(guest_state, vs1, 0, sew_lg2, is_signed);
+      for (UInt i = 0; i < vl; i++) {
+         if (masked && !vop_get_mask(guest_state, 0, i))
+            continue;
+         acc = vop_eval(op, acc, vop_get(guest_state, vs2, i, sew_lg2, is_signed),
+                        sew_lg2);
+      }
+      vop_put(guest_state, vd, 0, sew_lg2, acc);
+      return;
+   }
+   case RISCV64vop_MSEQ:
+   case RISCV64vop_MSNE:
+   case RISCV64vop_MSLTU:
+   case RISCV64vop_MSLT:
+   case RISCV64vop_MSLEU:
+   case RISCV64vop_MSLE:
+   case RISCV64vop_MSGTU:
+   case RISCV64vop_MSGT: {
+      /* Compute all the bits before writing any of them as the destination
+         can overlap the sources. */
+      UChar bits[RISCV64_VLENB * 8];
+      for (UInt i = 0; i < vl; i++) {
+         ULong a = vop_get(guest_state, vs2, i, sew_lg2, is_signed);
+         ULong b = vs1 == RISCV64_VOP_SCALAR
+                      ? scalar
+                      : vop_get(guest_state, vs1, i, sew_lg2, is_signed);
+         if (vs1 == RISCV64_VOP_SCALAR && sew_lg2 < 3) {
+            ULong m = (1ULL << (8 << sew_lg2)) - 1;
+            b       = is_signed ? vex_sx_to_64(b & m, 8 << sew_lg2) : b & m;
+         }
+         bits[i] = vop_eval(op, a, b, sew_lg2);
+      }
+      for (UInt i = 0; i < vl; i++) {
+         if (masked && !vop_get_mask(guest_state, 0, i))
+            continue;
+         vop_put_mask(guest_state, vd, i, bits[i]);
+      }
+      return;
+   }
+   default:
+      break;
+   }
+
+   for (UInt i = 0; i < vl; i++) {
+      ULong res;
+      if (op == RISCV64vop_ID) {
+         res = i;
+      } else {
+         ULong b = vs1 == RISCV64_VOP_SCALAR
+                      ? scalar
+                      : vop_get(guest_state, vs1, i, sew_lg2, is_signed);
+         if (vs1 == RISCV64_VOP_SCALAR && is_signed && sew_lg2 < 3)
+            b = vex_sx_to_64(b & ((1ULL << (8 << sew_lg2)) - 1), 8 << sew_lg2);
+         else if (vs1 == RISCV64_VOP_SCALAR && sew_lg2 < 3)
+            b &= (1ULL << (8 << sew_lg2)) - 1;
+         if (op == RISCV64vop_MERGE) {
+            res = vop_get_mask(guest_state, 0, i)
+                     ? b
+                     : vop_get(guest_state, vs2, i, sew_lg2, False);
+         } else {
+            if (masked && !vop_get_mask(guest_state, 0, i))
+               continue;
+            ULong a = op == RISCV64vop_MV
+                         ? 0
+                         : vop_get(guest_state, vs2, i, sew_lg2, is_signed);
+            res     = vop_eval(op, a, b, sew_lg2);
+         }
+      }
+      if (op == RISCV64vop_ID && masked && !vop_get_mask(guest_state, 0, i))
+         continue;
+      vop_put(guest_state, vd, i, sew_lg2, res);
+   }
+}
+
 /*------------------------------------------------------------*/
 /*--- Flag-helpers translation-time function specialisers. ---*/
 /*--- These help iropt specialise calls the above run-time ---*/
@@ -398,6 +683,8 @@ IRExpr* guest_riscv64_spechelper(const HChar* function_name,
 void LibVEX_GuestRISCV64_initialise(/*OUT*/ VexGuestRISCV64State* vex_state)
 {
    vex_bzero(vex_state, sizeof(*vex_state));
+   /* The vector unit starts with vill set, as after reset. */
+   vex_state->guest_vtype = 1ULL << 63;
 }
 
 /* Figure out if any part of the guest state contained in minoff .. maxoff
@@ -182,7 +182,7 @@ static IRTemp newTemp(/*MOD*/ IRSB* irsb, IRType ty)
    return newIRTemp(irsb->tyenv, ty);
 }
 
-/* Sign-extend a 32/64-bit integer expression to 64 bits. */
+/* Sign-extend an 8/16/32/64-bit integer expression to 64 bits. */
 static IRExpr* widenSto64(IRType srcTy, IRExpr* e)
 {
    switch (srcTy) {
@@ -190,12 +190,33 @@ static IRExpr* widenSto64(IRType srcTy, IRExpr* e)
       return e;
    case Ity_I32:
       return unop(Iop_32Sto64, e);
+   case Ity_I16:
+      return unop(Iop_16Sto64, e);
+   case Ity_I8:
+      return unop(Iop_8Sto64, e);
    default:
       vpanic("widenSto64(riscv64)");
    }
 }
 
-/* Narrow a 64-bit integer expression to 32/64 bits. */
+/* Zero-extend an 8/16/32/64-bit integer expression to 64 bits. */
+static IRExpr* widenUto64(IRType srcTy, IRExpr* e)
+{
+   switch (srcTy) {
+   case Ity_I64:
+      return e;
+   case Ity_I32:
+      return unop(Iop_32Uto64, e);
+   case Ity_I16:
+      return unop(Iop_16Uto64, e);
+   case Ity_I8:
+      return unop(Iop_8Uto64, e);
+   default:
+      vpanic("widenUto64(riscv64)");
+   }
+}
+
+/* Narrow a 64-bit integer expression to 8/16/32/64 bits. */
 static IRExpr* narrowFrom64(IRType dstTy, IRExpr* e)
 {
    switch (dstTy) {
@@ -203,6 +224,10 @@ static IRExpr* narrowFrom64(IRType dstTy, IRExpr* e)
       return e;
    case Ity_I32:
       return unop(Iop_64to32, e);
+   case Ity_I16:
+      return unop(Iop_64to16, e);
+   case Ity_I8:
+      return unop(Iop_64to8, e);
    default:
       vpanic("narrowFrom64(riscv64)");
    }
@@ -289,6 +314,41 @@ static IRExpr* narrowFrom64(IRType dstTy, IRExpr* e)
 #define OFFB_LLSC_ADDR offsetof(VexGuestRISCV64State, guest_LLSC_ADDR)
 #define OFFB_LLSC_DATA offsetof(VexGuestRISCV64State, guest_LLSC_DATA)
 
+#define OFFB_VL    offsetof(VexGuestRISCV64State, guest_vl)
+#define OFFB_VTYPE offsetof(VexGuestRISCV64State, guest_vtype)
+#define OFFB_V0   offsetof(VexGuestRISCV64State, guest_v0)
+#define OFFB_V1   offsetof(VexGuestRISCV64State, guest_v1)
+#define OFFB_V2   offsetof(VexGuestRISCV64State, guest_v2)
+#define OFFB_V3   offsetof(VexGuestRISCV64State, guest_v3)
+#define OFFB_V4   offsetof(VexGuestRISCV64State, guest_v4)
+#define OFFB_V5   offsetof(VexGuestRISCV64State, guest_v5)
+#define OFFB_V6   offsetof(VexGuestRISCV64State, guest_v6)
+#define OFFB_V7   offsetof(VexGuestRISCV64State, guest_v7)
+#define OFFB_V8   offsetof(VexGuestRISCV64State, guest_v8)
+#define OFFB_V9   offsetof(VexGuestRISCV64State, guest_v9)
+#define OFFB_V10  offsetof(VexGuestRISCV64State, guest_v10)
+#define OFFB_V11  offsetof(VexGuestRISCV64State, guest_v11)
+#define OFFB_V12  offsetof(VexGuestRISCV64State, guest_v12)
+#define OFFB_V13  offsetof(VexGuestRISCV64State, guest_v13)
+#define OFFB_V14  offsetof(VexGuestRISCV64State, guest_v14)
+#define OFFB_V15  offsetof(VexGuestRISCV64State, guest_v15)
+#define OFFB_V16  offsetof(VexGuestRISCV64State, guest_v16)
+#define OFFB_V17  offsetof(VexGuestRISCV64State, guest_v17)
+#define OFFB_V18  offsetof(VexGuestRISCV64State, guest_v18)
+#define OFFB_V19  offsetof(VexGuestRISCV64State, guest_v19)
+#define OFFB_V20  offsetof(VexGuestRISCV64State, guest_v20)
+#define OFFB_V21  offsetof(VexGuestRISCV64State, guest_v21)
+#define OFFB_V22  offsetof(VexGuestRISCV64State, guest_v22)
+#define OFFB_V23  offsetof(VexGuestRISCV64State, guest_v23)
+#define OFFB_V24  offsetof(VexGuestRISCV64State, guest_v24)
+#define OFFB_V25  offsetof(VexGuestRISCV64State, guest_v25)
+#define OFFB_V26  offsetof(VexGuestRISCV64State, guest_v26)
+#define OFFB_V27  offsetof(VexGuestRISCV64State, guest_v27)
+#define OFFB_V28  offsetof(VexGuestRISCV64State, guest_v28)
+#define OFFB_V29  offsetof(VexGuestRISCV64State, guest_v29)
+#define OFFB_V30  offsetof(VexGuestRISCV64State, guest_v30)
+#define OFFB_V31  offsetof(VexGuestRISCV64State, guest_v31)
+
 /*------------------------------------------------------------*/
 /*--- Integer registers                                    ---*/
 /*------------------------------------------------------------*/
@@ -645,6 +705,306 @@ static void mk_get_rounding_mode(/*MOD*/ IRSB*   irsb,
    }
 }
 
+/*------------------------------------------------------------*/
+/*--- Vector registers                                     ---*/
+/*------------------------------------------------------------*/
+
+static Int offsetVReg(UInt vregNo)
+{
+   switch (vregNo) {
+   case 0:
+      return OFFB_V0;
+   case 1:
+      return OFFB_V1;
+   case 2:
+      return OFFB_V2;
+   case 3:
+      return OFFB_V3;
+   case 4:
+      return OFFB_V4;
+   case 5:
+      return OFFB_V5;
+   case 6:
+      return OFFB_V6;
+   case 7:
+      return OFFB_V7;
+   case 8:
+      return OFFB_V8;
+   case 9:
+      return OFFB_V9;
+   case 10:
+      return OFFB_V10;
+   case 11:
+      return OFFB_V11;
+   case 12:
+      return OFFB_V12;
+   case 13:
+      return OFFB_V13;
+   case 14:
+      return OFFB_V14;
+   case 15:
+      return OFFB_V15;
+   case 16:
+      return OFFB_V16;
+   case 17:
+      return OFFB_V17;
+   case 18:
+      return OFFB_V18;
+   case 19:
+      return OFFB_V19;
+   case 20:
+      return OFFB_V20;
+   case 21:
+      return OFFB_V21;
+   case 22:
+      return OFFB_V22;
+   case 23:
+      return OFFB_V23;
+   case 24:
+      return OFFB_V24;
+   case 25:
+      return OFFB_V25;
+   case 26:
+      return OFFB_V26;
+   case 27:
+      return OFFB_V27;
+   case 28:
+      return OFFB_V28;
+   case 29:
+      return OFFB_V29;
+   case 30:
+      return OFFB_V30;
+   case 31:
+      return OFFB_V31;
+   default:
+      vassert(0);
+   }
+}
+
+/* Obtain name of a vector register. */
+static const HChar* nameVReg(UInt vregNo)
+{
+   vassert(vregNo < 32);
+   static const HChar* names[32] = {
+      "v0",  "v1",  "v2",  "v3",  "v4",  "v5",  "v6",  "v7",
+      "v8",  "v9",  "v10", "v11", "v12", "v13", "v14", "v15",
+      "v16", "v17", "v18", "v19", "v20", "v21", "v22", "v23",
+      "v24", "v25", "v26", "v27", "v28", "v29", "v30", "v31"};
+   return names[vregNo];
+}
+
+/* Read the vl register. */
+static IRExpr* getVL(void) { return IRExpr_Get(OFFB_VL, Ity_I64); }
+
+/* Write a value into the vl register. */
+static void putVL(/*OUT*/ IRSB* irsb, /*IN*/ IRExpr* e)
+{
+   vassert(typeOfIRExpr(irsb->tyenv, e) == Ity_I64);
+   stmt(irsb, IRStmt_Put(OFFB_VL, e));
+}
+
+/* Read the vtype register. */
+static IRExpr* getVType(void) { return IRExpr_Get(OFFB_VTYPE, Ity_I64); }
+
+/* Write a value into the vtype register. */
+static void putVType(/*OUT*/ IRSB* irsb, /*IN*/ IRExpr* e)
+{
+   vassert(typeOfIRExpr(irsb->tyenv, e) == Ity_I64);
+   stmt(irsb, IRStmt_Put(OFFB_VTYPE, e));
+}
+
+/* Obtain the integer type of a vector element which is 1 << eew_lg2 bytes
+   wide. */
+static IRType vElemType(UInt eew_lg2)
+{
+   switch (eew_lg2) {
+   case 0:
+      return Ity_I8;
+   case 1:
+      return Ity_I16;
+   case 2:
+      return Ity_I32;
+   case 3:
+      return Ity_I64;
+   default:
+      vassert(0);
+   }
+}
+
+/* Obtain the guest state offset of element idx of a vector register group
+   starting at vregNo. The registers are laid out contiguously in the guest
+   state, so an element index can run past the first register of the group. */
+static Int offsetVElem(UInt vregNo, UInt idx, UInt eew_lg2)
+{
+   Int offset = offsetVReg(vregNo) + (idx << eew_lg2);
+   vassert(offset + (1 << eew_lg2) <= OFFB_V31 + RISCV64_VLENB);
+   return offset;
+}
+
+/* Read element idx of a vector register group. */
+static IRExpr* getVElem(UInt vregNo, UInt idx, UInt eew_lg2)
+{
+   return IRExpr_Get(offsetVElem(vregNo, idx, eew_lg2), vElemType(eew_lg2));
+}
+
+/* Read element idx of a vector register group and extend it to 64 bits. */
+static IRExpr* getVElem64(UInt vregNo, UInt idx, UInt eew_lg2, Bool is_signed)
+{
+   IRType ty = vElemType(eew_lg2);
+   IRExpr* e = getVElem(vregNo, idx, eew_lg2);
+   return is_signed ? widenSto64(ty, e) : widenUto64(ty, e);
+}
+
+/* Write element idx of a vector register group. */
+static void
+putVElem(/*OUT*/ IRSB* irsb, UInt vregNo, UInt idx, UInt eew_lg2, IRExpr* e)
+{
+   vassert(typeOfIRExpr(irsb->tyenv, e) == vElemType(eew_lg2));
+   stmt(irsb, IRStmt_Put(offsetVElem(vregNo, idx, eew_lg2), e));
+}
+
+/* Read 64-bit word w of a vector register. This is used to access mask
+   registers, in which bit i holds the mask value of element i. */
+static IRExpr* getVWord64(UInt vregNo, UInt w)
+{
+   vassert(w < RISCV64_VLENB / 8);
+   return IRExpr_Get(offsetVReg(vregNo) + 8 * w, Ity_I64);
+}
+
+/* Read a whole vector register as an Ity_V128 value. */
+static IRExpr* getVReg128(UInt vregNo)
+{
+   return IRExpr_Get(offsetVReg(vregNo), Ity_V128);
+}
+
+/* Write a whole vector register. */
+static void putVReg128(/*OUT*/ IRSB* irsb, UInt vregNo, IRExpr* e)
+{
+   vassert(typeOfIRExpr(irsb->tyenv, e) == Ity_V128);
+   stmt(irsb, IRStmt_Put(offsetVReg(vregNo), e));
+}
+
+/* Write 64-bit word w of a vector register. */
+static void putVWord64(/*OUT*/ IRSB* irsb, UInt vregNo, UInt w, IRExpr* e)
+{
+   vassert(w < RISCV64_VLENB / 8);
+   vassert(typeOfIRExpr(irsb->tyenv, e) == Ity_I64);
+   stmt(irsb, IRStmt_Put(offsetVReg(vregNo) + 8 * w, e));
+}
+
+/* Obtain mask bit idx of a mask register as an Ity_I1 value. */
+static IRExpr* getVMaskBit(UInt vregNo, UInt idx)
+{
+   return binop(Iop_CmpNE64,
+                binop(Iop_And64, getVWord64(vregNo, idx / 64),
+                      mkU64(1ULL << (idx % 64))),
+                mkU64(0));
+}
+
+/* Obtain an Ity_I1 value telling whether element idx is active, i.e. it is
+   below vl and, for a masked operation, enabled by its bit in v0. */
+static IRExpr* mkVActive(IRTemp vl, UInt idx, Bool masked)
+{
+   IRExpr* e = binop(Iop_CmpLT64U, mkU64(idx), mkexpr(vl));
+   if (masked)
+      e = binop(Iop_And1, e, getVMaskBit(0, idx));
+   return e;
+}
+
+/* Obtain a 64-bit mask selecting the bits of mask-register word w that belong
+   to the body elements, that is elements 64*w .. vl-1. */
+static IRExpr* mkVBodyBits(IRTemp vl, UInt w)
+{
+   ULong lo = 64 * w;
+   return IRExpr_ITE(
+      binop(Iop_CmpLE64U, mkU64(lo + 64), mkexpr(vl)), mkU64(~0ULL),
+      IRExpr_ITE(binop(Iop_CmpLE64U, mkexpr(vl), mkU64(lo)), mkU64(0),
+                 binop(Iop_Sub64,
+                       binop(Iop_Shl64, mkU64(1),
+                             unop(Iop_64to8,
+                                  binop(Iop_Sub64, mkexpr(vl), mkU64(lo)))),
+                       mkU64(1))));
+}
+
+/* Try to determine the vtype setting in effect at the current point of the
+   superblock. This succeeds when the last write of vtype in the superblock
+   sets it to a constant, which is what vsetvli and vsetivli do. Translating
+   for a known SEW and LMUL allows the element loops to be fully unrolled. */
+static Bool getStaticVType(const IRSB* irsb, /*OUT*/ ULong* vtype)
+{
+   for (Int i = irsb->stmts_used - 1; i >= 0; i--) {
+      const IRStmt* st = irsb->stmts[i];
+      if (st->tag != Ist_Put || st->Ist.Put.offset != OFFB_VTYPE)
+         continue;
+      if (st->Ist.Put.data->tag != Iex_Const)
+         return False;
+      *vtype = st->Ist.Put.data->Iex.Const.con->Ico.U64;
+      return True;
+   }
+   return False;
+}
+
+/* Try to determine the vl value in effect at the current point of the
+   superblock, in the same way as getStaticVType() does for vtype. */
+static Bool getStaticVL(const IRSB* irsb, /*OUT*/ ULong* vl)
+{
+   for (Int i = irsb->stmts_used - 1; i >= 0; i--) {
+      const IRStmt* st = irsb->stmts[i];
+      if (st->tag != Ist_Put || st->Ist.Put.offset != OFFB_VL)
+         continue;
+      const IRExpr* e = st->Ist.Put.data;
+      if (e->tag == Iex_RdTmp) {
+         /* Look through the assignment of the temporary. */
+         for (Int j = i - 1; j >= 0; j--) {
+            const IRStmt* st2 = irsb->stmts[j];
+            if (st2->tag == Ist_WrTmp &&
+                st2->Ist.WrTmp.tmp == e->Iex.RdTmp.tmp) {
+               e = st2->Ist.WrTmp.data;
+               break;
+            }
+         }
+      }
+      if (e->tag != Iex_Const)
+         return False;
+      *vl = e->Iex.Const.con->Ico.U64;
+      return True;
+   }
+   return False;
+}
+
+/* Split a vtype value into log2 of SEW in bytes and log2 of LMUL. Returns False
+   if vtype has the vill bit set. */
+static Bool decodeVType(ULong vtype, /*OUT*/ UInt* sew_lg2, /*OUT*/ Int* lmul_lg2)
+{
+   if ((vtype >> 63) != 0)
+      return False;
+   UInt vlmul = vtype & 0x7;
+   *sew_lg2   = (vtype >> 3) & 0x7;
+   *lmul_lg2  = vlmul < 4 ? (Int)vlmul : (Int)vlmul - 8;
+   vassert(*sew_lg2 <= 3 && *lmul_lg2 >= -3);
+   return True;
+}
+
+/* Obtain the number of elements of width 1 << eew_lg2 bytes held by a register
+   group with the multiplier 2^emul_lg2. */
+static UInt vElemsOfGroup(UInt eew_lg2, Int emul_lg2)
+{
+   UInt n = RISCV64_VLENB >> eew_lg2;
+   return emul_lg2 >= 0 ? n << emul_lg2 : n >> -emul_lg2;
+}
+
+/* Obtain the number of registers occupied by a register group with the
+   multiplier 2^emul_lg2. */
+static UInt vRegsOfGroup(Int emul_lg2) { return emul_lg2 > 0 ? 1 << emul_lg2 : 1; }
+
+/* Obtain the largest number of registers that a group starting at vregNo can
+   span. This is used when the actual LMUL is not known at translation time. */
+static UInt vMaxRegsOfGroup(UInt vregNo)
+{
+   vassert(vregNo < 32);
+   return 32 - vregNo < 8 ? 32 - vregNo : 8;
+}
+
 /*------------------------------------------------------------*/
 /*--- Name helpers                                         ---*/
 /*------------------------------------------------------------*/
@@ -676,6 +1036,14 @@ static const HChar* nameCSR(UInt csr)
       return "frm";
    case 0x003:
       return "fcsr";
+   case 0x008:
+      return "vstart";
+   case 0xc20:
+      return "vl";
+   case 0xc21:
+      return "vtype";
+   case 0xc22:
+      return "vlenb";
    default:
       vpanic("nameCSR(riscv64)");
    }
@@ -1919,10 +2287,12 @@ static Bool dis_RV64A(/*MB_OUT*/ DisResult* dres,
          IRTemp res = newTemp(irsb, Ity_I64);
          assign(irsb, res, widenSto64(ty, loadLE(ty, mkexpr(ea))));
 
-         /* Set up the LLSC fallback data. */
+         /* Set up the reservation. It is dropped by the dispatcher whenever
+            execution leaves generated code, so it can only be still valid at
+            the matching SC if no other thread ran in the meantime. */
          stmt(irsb, IRStmt_Put(OFFB_LLSC_DATA, mkexpr(res)));
          stmt(irsb, IRStmt_Put(OFFB_LLSC_ADDR, mkexpr(ea)));
-         stmt(irsb, IRStmt_Put(OFFB_LLSC_SIZE, mkU64(4)));
+         stmt(irsb, IRStmt_Put(OFFB_LLSC_SIZE, mkU64(is_32 ? 4 : 8)));
 
          /* Write the result to the destination register. */
          if (rd != 0)
@@ -1971,33 +2341,34 @@ static Bool dis_RV64A(/*MB_OUT*/ DisResult* dres,
          if (rd != 0)
             putIReg64(irsb, rd, mkU64(1));
 
-         /* Set that no transaction is in progress. */
+         /* Drop the reservation. */
          IRTemp size = newTemp(irsb, Ity_I64);
          assign(irsb, size, IRExpr_Get(OFFB_LLSC_SIZE, Ity_I64));
          stmt(irsb,
               IRStmt_Put(OFFB_LLSC_SIZE, mkU64(0) /* "no transaction" */));
 
-         /* Fail if no or wrong-size transaction. */
-         stmt(irsb, IRStmt_Exit(binop(Iop_CmpNE64, mkexpr(size), mkU64(4)),
-                                Ijk_Boring, nia, OFFB_PC));
-
-         /* Fail if the address doesn't match the LL address. */
-         stmt(irsb, IRStmt_Exit(binop(Iop_CmpNE64, mkexpr(ea),
-                                      IRExpr_Get(OFFB_LLSC_ADDR, Ity_I64)),
-                                Ijk_Boring, nia, OFFB_PC));
-
-         /* Fail if the data doesn't match the LL data. */
-         IRTemp data = newTemp(irsb, Ity_I64);
-         assign(irsb, data, IRExpr_Get(OFFB_LLSC_DATA, Ity_I64));
-         stmt(irsb, IRStmt_Exit(binop(Iop_CmpNE64,
-                                      widenSto64(ty, loadLE(ty, mkexpr(ea))),
-                                      mkexpr(data)),
-                                Ijk_Boring, nia, OFFB_PC));
-
-         /* Try to CAS the new value in. */
+         /* Fail if no or wrong-size reservation, or if the address doesn't
+            match the LR address. Both are tested with a single exit. */
+         stmt(irsb,
+              IRStmt_Exit(
+                 binop(Iop_CmpNE64,
+                       binop(Iop_Or64,
+                             binop(Iop_Xor64, mkexpr(size),
+                                   mkU64(is_32 ? 4 : 8)),
+                             binop(Iop_Xor64, mkexpr(ea),
+                                   IRExpr_Get(OFFB_LLSC_ADDR, Ity_I64))),
+                       mkU64(0)),
+                 Ijk_Boring, nia, OFFB_PC));
+
+         /* Try to CAS the new value in. A valid reservation means that no
+            other thread of the process ran since the LR, so the CAS only
+            fails if the memory was modified by other means, for instance by
+            another process. Comparing the data is not needed beforehand
+            since the CAS does it as well. */
          IRTemp old  = newTemp(irsb, ty);
          IRTemp expd = newTemp(irsb, ty);
-         assign(irsb, expd, narrowFrom64(ty, mkexpr(data)));
+         assign(irsb, expd,
+                narrowFrom64(ty, IRExpr_Get(OFFB_LLSC_DATA, Ity_I64)));
          stmt(irsb, IRStmt_CAS(mkIRCAS(
                        /*oldHi*/ IRTemp_INVALID, old, Iend_LE, mkexpr(ea),
                        /*expdHi*/ NULL, mkexpr(expd),
@@ -3305,28 +3676,2017 @@ static Bool dis_RV64Zicsr(/*MB_OUT*/ DisResult* dres,
    return False;
 }
 
-static Bool dis_RISCV64_standard(/*MB_OUT*/ DisResult* dres,
-                                 /*OUT*/ IRSB*         irsb,
-                                 UInt                  insn,
-                                 Addr                  guest_pc_curr_instr,
-                                 const VexAbiInfo*     abiinfo,
-                                 Bool                  sigill_diag)
+static Bool dis_RV64Zba(/*MB_OUT*/ DisResult* dres,
+                        /*OUT*/ IRSB*         irsb,
+                        UInt                  insn)
 {
-   vassert(INSN(1, 0) == 0b11);
+   /* ------------- RV64Zba standard extension -------------- */
 
-   Bool ok = False;
-   if (!ok)
-      ok = dis_RV64I(dres, irsb, insn, guest_pc_curr_instr);
-   if (!ok)
-      ok = dis_RV64M(dres, irsb, insn);
-   if (!ok)
-      ok = dis_RV64A(dres, irsb, insn, guest_pc_curr_instr, abiinfo);
-   if (!ok)
-      ok = dis_RV64F(dres, irsb, insn);
-   if (!ok)
-      ok = dis_RV64D(dres, irsb, insn);
-   if (!ok)
-      ok = dis_RV64Zicsr(dres, irsb, insn);
+   /* ---------------- add.uw rd, rs1, rs2 ------------------ */
+   if (INSN(6, 0) == 0b0111011 && INSN(14, 12) == 0b000 &&
+       INSN(31, 25) == 0b0000100) {
+      UInt rd  = INSN(11, 7);
+      UInt rs1 = INSN(19, 15);
+      UInt rs2 = INSN(24, 20);
+      if (rd != 0)
+         putIReg64(irsb, rd,
+                   binop(Iop_Add64, unop(Iop_32Uto64, getIReg32(rs1)),
+                         getIReg64(rs2)));
+      DIP("add.uw %s, %s, %s\n", nameIReg(rd), nameIReg(rs1), nameIReg(rs2));
+      return True;
+   }
+
+   /* ------------ sh{1,2,3}add rd, rs1, rs2 ---------------- */
+   /* ----------- sh{1,2,3}add.uw rd, rs1, rs2 -------------- */
+   if ((INSN(6, 0) == 0b0110011 || INSN(6, 0) == 0b0111011) &&
+       INSN(12, 12) == 0b0 && INSN(14, 13) != 0b00 &&
+       INSN(31, 25) == 0b0010000) {
+      Bool is_uw = INSN(6, 0) == 0b0111011;
+      UInt shift = INSN(14, 13);
+      UInt rd    = INSN(11, 7);
+      UInt rs1   = INSN(19, 15);
+      UInt rs2   = INSN(24, 20);
+      if (rd != 0) {
+         IRExpr* base =
+            is_uw ? unop(Iop_32Uto64, getIReg32(rs1)) : getIReg64(rs1);
+         putIReg64(irsb, rd,
+                   binop(Iop_Add64, binop(Iop_Shl64, base, mkU8(shift)),
+                         getIReg64(rs2)));
+      }
+      DIP("sh%uadd%s %s, %s, %s\n", shift, is_uw ? ".uw" : "", nameIReg(rd),
+          nameIReg(rs1), nameIReg(rs2));
+      return True;
+   }
+
+   /* ------------ slli.uw rd, rs1, uimm[5:0] --------------- */
+   if (INSN(6, 0) == 0b0011011 && INSN(14, 12) == 0b001 &&
+       INSN(31, 26) == 0b000010) {
+      UInt rd      = INSN(11, 7);
+      UInt rs1     = INSN(19, 15);
+      UInt uimm5_0 = INSN(25, 20);
+      if (rd != 0)
+         putIReg64(irsb, rd,
+                   binop(Iop_Shl64, unop(Iop_32Uto64, getIReg32(rs1)),
+                         mkU8(uimm5_0)));
+      DIP("slli.uw %s, %s, %u\n", nameIReg(rd), nameIReg(rs1), uimm5_0);
+      return True;
+   }
+
+   return False;
+}
+
+/* Rotate a 64-bit or 32-bit value. The amount is a run-time I64 expression
+   which gets masked to the operand width, so both shifts stay in range even
+   for a zero rotation. */
+static IRExpr* mkRotate(/*MOD*/ IRSB* irsb,
+                        IRType       ty,
+                        Bool         left,
+                        IRExpr*      val,
+                        IRExpr*      amt)
+{
+   vassert(ty == Ity_I64 || ty == Ity_I32);
+   Bool   is64 = ty == Ity_I64;
+   IROp   opL  = is64 ? Iop_Shl64 : Iop_Shl32;
+   IROp   opR  = is64 ? Iop_Shr64 : Iop_Shr32;
+   ULong  mask = is64 ? 63 : 31;
+   IRTemp a    = newTemp(irsb, Ity_I64);
+   IRTemp v    = newTemp(irsb, ty);
+   assign(irsb, a, amt);
+   assign(irsb, v, val);
+   IRExpr* fwd =
+      unop(Iop_64to8, binop(Iop_And64, mkexpr(a), mkU64(mask)));
+   IRExpr* bwd = unop(
+      Iop_64to8,
+      binop(Iop_And64, binop(Iop_Sub64, mkU64(0), mkexpr(a)), mkU64(mask)));
+   return binop(is64 ? Iop_Or64 : Iop_Or32,
+                binop(left ? opL : opR, mkexpr(v), fwd),
+                binop(left ? opR : opL, mkexpr(v), bwd));
+}
+
+static Bool dis_RV64Zbb(/*MB_OUT*/ DisResult* dres,
+                        /*OUT*/ IRSB*         irsb,
+                        UInt                  insn)
+{
+   /* ------------- RV64Zbb standard extension -------------- */
+
+   /* -------------- {andn,orn,xnor} rd, rs1, rs2 ----------- */
+   if (INSN(6, 0) == 0b0110011 && INSN(31, 25) == 0b0100000 &&
+       (INSN(14, 12) == 0b111 || INSN(14, 12) == 0b110 ||
+        INSN(14, 12) == 0b100)) {
+      UInt funct3 = INSN(14, 12);
+      UInt rd     = INSN(11, 7);
+      UInt rs1    = INSN(19, 15);
+      UInt rs2    = INSN(24, 20);
+      if (rd != 0) {
+         IRExpr* expr;
+         switch (funct3) {
+         case 0b111:
+            expr = binop(Iop_And64, getIReg64(rs1),
+                         unop(Iop_Not64, getIReg64(rs2)));
+            break;
+         case 0b110:
+            expr = binop(Iop_Or64, getIReg64(rs1),
+                         unop(Iop_Not64, getIReg64(rs2)));
+            break;
+         case 0b100:
+            expr = unop(Iop_Not64,
+                        binop(Iop_Xor64, getIReg64(rs1), getIReg64(rs2)));
+            break;
+         default:
+            vassert(0);
+         }
+         putIReg64(irsb, rd, expr);
+      }
+      const HChar* name;
+      switch (funct3) {
+      case 0b111:
+         name = "andn";
+         break;
+      case 0b110:
+         name = "orn";
+         break;
+      case 0b100:
+         name = "xnor";
+         break;
+      default:
+         vassert(0);
+      }
+      DIP("%s %s, %s, %s\n", name, nameIReg(rd), nameIReg(rs1), nameIReg(rs2));
+      return True;
+   }
+
+   /* ------------ {clz,ctz,cpop}[w] rd, rs1 ---------------- */
+   /* ---------------- sext.{b,h} rd, rs1 ------------------- */
+   if ((INSN(6, 0) == 0b0010011 || INSN(6, 0) == 0b0011011) &&
+       INSN(14, 12) == 0b001 && INSN(31, 25) == 0b0110000 &&
+       (INSN(24, 20) <= 0b00010 ||
+        (INSN(6, 0) == 0b0010011 &&
+         (INSN(24, 20) == 0b00100 || INSN(24, 20) == 0b00101)))) {
+      Bool is_w  = INSN(6, 0) == 0b0011011;
+      UInt which = INSN(24, 20);
+      UInt rd    = INSN(11, 7);
+      UInt rs1   = INSN(19, 15);
+      if (rd != 0) {
+         IRExpr* expr;
+         switch (which) {
+         case 0b00000:
+            expr = is_w ? unop(Iop_32Uto64, unop(Iop_ClzNat32, getIReg32(rs1)))
+                        : unop(Iop_ClzNat64, getIReg64(rs1));
+            break;
+         case 0b00001:
+            expr = is_w ? unop(Iop_32Uto64, unop(Iop_CtzNat32, getIReg32(rs1)))
+                        : unop(Iop_CtzNat64, getIReg64(rs1));
+            break;
+         case 0b00010:
+            expr = is_w
+                      ? unop(Iop_32Uto64, unop(Iop_PopCount32, getIReg32(rs1)))
+                      : unop(Iop_PopCount64, getIReg64(rs1));
+            break;
+         case 0b00100:
+            expr = unop(Iop_8Sto64, unop(Iop_64to8, getIReg64(rs1)));
+            break;
+         case 0b00101:
+            expr = unop(Iop_16Sto64, unop(Iop_64to16, getIReg64(rs1)));
+            break;
+         default:
+            vassert(0);
+         }
+         putIReg64(irsb, rd, expr);
+      }
+      const HChar* name;
+      switch (which) {
+      case 0b00000:
+         name = is_w ? "clzw" : "clz";
+         break;
+      case 0b00001:
+         name = is_w ? "ctzw" : "ctz";
+         break;
+      case 0b00010:
+         name = is_w ? "cpopw" : "cpop";
+         break;
+      case 0b00100:
+         name = "sext.b";
+         break;
+      case 0b00101:
+         name = "sext.h";
+         break;
+      default:
+         vassert(0);
+      }
+      DIP("%s %s, %s\n", name, nameIReg(rd), nameIReg(rs1));
+      return True;
+   }
+
+   /* ------------------- zext.h rd, rs1 -------------------- */
+   if (INSN(6, 0) == 0b0111011 && INSN(14, 12) == 0b100 &&
+       INSN(31, 20) == 0b000010000000) {
+      UInt rd  = INSN(11, 7);
+      UInt rs1 = INSN(19, 15);
+      if (rd != 0)
+         putIReg64(irsb, rd,
+                   unop(Iop_16Uto64, unop(Iop_64to16, getIReg64(rs1))));
+      DIP("zext.h %s, %s\n", nameIReg(rd), nameIReg(rs1));
+      return True;
+   }
+
+   /* ------------ {min,minu,max,maxu} rd, rs1, rs2 --------- */
+   if (INSN(6, 0) == 0b0110011 && INSN(31, 25) == 0b0000101 &&
+       INSN(14, 14) == 0b1) {
+      Bool is_max    = INSN(13, 13) == 0b1;
+      Bool is_signed = INSN(12, 12) == 0b0;
+      UInt rd        = INSN(11, 7);
+      UInt rs1       = INSN(19, 15);
+      UInt rs2       = INSN(24, 20);
+      if (rd != 0) {
+         IRTemp a = newTemp(irsb, Ity_I64);
+         IRTemp b = newTemp(irsb, Ity_I64);
+         assign(irsb, a, getIReg64(rs1));
+         assign(irsb, b, getIReg64(rs2));
+         IRExpr* lt = binop(is_signed ? Iop_CmpLT64S : Iop_CmpLT64U,
+                            mkexpr(a), mkexpr(b));
+         putIReg64(irsb, rd,
+                   is_max ? IRExpr_ITE(lt, mkexpr(b), mkexpr(a))
+                          : IRExpr_ITE(lt, mkexpr(a), mkexpr(b)));
+      }
+      DIP("%s%s %s, %s, %s\n", is_max ? "max" : "min", is_signed ? "" : "u",
+          nameIReg(rd), nameIReg(rs1), nameIReg(rs2));
+      return True;
+   }
+
+   /* --------------- {rol,ror}[w] rd, rs1, rs2 ------------- */
+   if ((INSN(6, 0) == 0b0110011 || INSN(6, 0) == 0b0111011) &&
+       INSN(31, 25) == 0b0110000 &&
+       (INSN(14, 12) == 0b001 || INSN(14, 12) == 0b101)) {
+      Bool is_w    = INSN(6, 0) == 0b0111011;
+      Bool is_left = INSN(14, 12) == 0b001;
+      UInt rd      = INSN(11, 7);
+      UInt rs1     = INSN(19, 15);
+      UInt rs2     = INSN(24, 20);
+      if (rd != 0) {
+         if (is_w)
+            putIReg32(irsb, rd,
+                      mkRotate(irsb, Ity_I32, is_left, getIReg32(rs1),
+                               getIReg64(rs2)));
+         else
+            putIReg64(irsb, rd,
+                      mkRotate(irsb, Ity_I64, is_left, getIReg64(rs1),
+                               getIReg64(rs2)));
+      }
+      DIP("%s%s %s, %s, %s\n", is_left ? "rol" : "ror", is_w ? "w" : "",
+          nameIReg(rd), nameIReg(rs1), nameIReg(rs2));
+      return True;
+   }
+
+   /* ----------------- rori rd, rs1, uimm[5:0] ------------- */
+   /* ---------------- roriw rd, rs1, uimm[4:0] ------------- */
+   if ((INSN(6, 0) == 0b0010011 && INSN(14, 12) == 0b101 &&
+        INSN(31, 26) == 0b011000) ||
+       (INSN(6, 0) == 0b0011011 && INSN(14, 12) == 0b101 &&
+        INSN(31, 25) == 0b0110000)) {
+      Bool is_w  = INSN(6, 0) == 0b0011011;
+      UInt rd    = INSN(11, 7);
+      UInt rs1   = INSN(19, 15);
+      UInt shamt = is_w ? INSN(24, 20) : INSN(25, 20);
+      if (rd != 0) {
+         if (is_w)
+            putIReg32(irsb, rd,
+                      mkRotate(irsb, Ity_I32, False, getIReg32(rs1),
+                               mkU64(shamt)));
+         else
+            putIReg64(irsb, rd,
+                      mkRotate(irsb, Ity_I64, False, getIReg64(rs1),
+                               mkU64(shamt)));
+      }
+      DIP("rori%s %s, %s, %u\n", is_w ? "w" : "", nameIReg(rd), nameIReg(rs1),
+          shamt);
+      return True;
+   }
+
+   /* -------------------- orc.b rd, rs1 -------------------- */
+   if (INSN(6, 0) == 0b0010011 && INSN(14, 12) == 0b101 &&
+       INSN(31, 20) == 0b001010000111) {
+      UInt rd  = INSN(11, 7);
+      UInt rs1 = INSN(19, 15);
+      if (rd != 0) {
+         /* Compute a mask with the top bit of each non-zero byte set, then
+            widen every such bit to the whole byte. Borrows out of the top
+            byte wrap around correctly modulo 2^64. */
+         IRTemp x = newTemp(irsb, Ity_I64);
+         IRTemp h = newTemp(irsb, Ity_I64);
+         assign(irsb, x, getIReg64(rs1));
+         IRExpr* low7 = mkU64(0x7f7f7f7f7f7f7f7fULL);
+         assign(irsb, h,
+                binop(Iop_And64,
+                      binop(Iop_Or64,
+                            binop(Iop_Add64,
+                                  binop(Iop_And64, mkexpr(x), low7), low7),
+                            mkexpr(x)),
+                      mkU64(0x8080808080808080ULL)));
+         putIReg64(irsb, rd,
+                   binop(Iop_Sub64, binop(Iop_Shl64, mkexpr(h), mkU8(1)),
+                         binop(Iop_Shr64, mkexpr(h), mkU8(7))));
+      }
+      DIP("orc.b %s, %s\n", nameIReg(rd), nameIReg(rs1));
+      return True;
+   }
+
+   /* -------------------- rev8 rd, rs1 --------------------- */
+   if (INSN(6, 0) == 0b0010011 && INSN(14, 12) == 0b101 &&
+       INSN(31, 20) == 0b011010111000) {
+      UInt rd  = INSN(11, 7);
+      UInt rs1 = INSN(19, 15);
+      if (rd != 0)
+         putIReg64(irsb, rd, unop(Iop_Reverse8sIn64_x1, getIReg64(rs1)));
+      DIP("rev8 %s, %s\n", nameIReg(rd), nameIReg(rs1));
+      return True;
+   }
+
+   return False;
+}
+
+static Bool dis_RV64Zbs(/*MB_OUT*/ DisResult* dres,
+                        /*OUT*/ IRSB*         irsb,
+                        UInt                  insn)
+{
+   /* ------------- RV64Zbs standard extension -------------- */
+
+   /* ---------- {bclr,bext,binv,bset} rd, rs1, rs2 --------- */
+   /* -------- {bclri,bexti,binvi,bseti} rd, rs1, uimm ------ */
+   if ((INSN(6, 0) == 0b0110011 &&
+        (INSN(31, 25) == 0b0100100 || INSN(31, 25) == 0b0110100 ||
+         INSN(31, 25) == 0b0010100)) ||
+       (INSN(6, 0) == 0b0010011 &&
+        (INSN(31, 26) == 0b010010 || INSN(31, 26) == 0b011010 ||
+         INSN(31, 26) == 0b001010))) {
+      Bool is_imm = INSN(6, 0) == 0b0010011;
+      UInt funct3 = INSN(14, 12);
+      UInt kind   = INSN(30, 29);
+      UInt rd     = INSN(11, 7);
+      UInt rs1    = INSN(19, 15);
+      UInt rs2    = INSN(24, 20);
+      UInt shamt  = INSN(25, 20);
+      /* bclr and bext share funct7, the remaining pairs are only valid with
+         funct3 = 001. */
+      if (!(funct3 == 0b001 || (funct3 == 0b101 && kind == 0b10)))
+         return False;
+      Bool is_ext = funct3 == 0b101;
+      if (rd != 0) {
+         IRExpr* amt = is_imm ? mkU8(shamt)
+                              : unop(Iop_64to8,
+                                     binop(Iop_And64, getIReg64(rs2),
+                                           mkU64(63)));
+         IRExpr* expr;
+         if (is_ext)
+            expr = binop(Iop_And64, binop(Iop_Shr64, getIReg64(rs1), amt),
+                         mkU64(1));
+         else {
+            IRExpr* bit = binop(Iop_Shl64, mkU64(1), amt);
+            switch (kind) {
+            case 0b10:
+               expr = binop(Iop_And64, getIReg64(rs1), unop(Iop_Not64, bit));
+               break;
+            case 0b11:
+               expr = binop(Iop_Xor64, getIReg64(rs1), bit);
+               break;
+            case 0b01:
+               expr = binop(Iop_Or64, getIReg64(rs1), bit);
+               break;
+            default:
+               vassert(0);
+            }
+         }
+         putIReg64(irsb, rd, expr);
+      }
+      const HChar* name;
+      if (is_ext)
+         name = "bext";
+      else
+         switch (kind) {
+         case 0b10:
+            name = "bclr";
+            break;
+         case 0b11:
+            name = "binv";
+            break;
+         case 0b01:
+            name = "bset";
+            break;
+         default:
+            vassert(0);
+         }
+      if (is_imm)
+         DIP("%si %s, %s, %u\n", name, nameIReg(rd), nameIReg(rs1), shamt);
+      else
+         DIP("%s %s, %s, %s\n", name, nameIReg(rd), nameIReg(rs1),
+             nameIReg(rs2));
+      return True;
+   }
+
+   return False;
+}
+
+/* Vector instructions are translated element by element, so a single one can
+   expand to hundreds of IR statements. Keep superblocks containing them below
+   the following size, which together with the instrumentation added by tools
+   leaves the generated code well within the translation buffer. */
+#define RISCV64_V_IR_BUDGET 800
+
+/* Rough number of IR statements needed per processed vector element. */
+#define RISCV64_V_STMTS_PER_ELEM 6
+
+/* Tell whether the instruction being translated is the first one of the
+   superblock. */
+static Bool isFirstInsnOfSB(const IRSB* irsb)
+{
+   UInt n_imarks = 0;
+   for (Int i = 0; i < irsb->stmts_used; i++)
+      if (irsb->stmts[i]->tag == Ist_IMark)
+         n_imarks++;
+   return n_imarks <= 1;
+}
+
+/* If translating an instruction processing n_elems vector elements would make
+   the superblock exceed its budget, end the superblock in front of the
+   instruction instead. It then gets translated at the start of the next
+   superblock. Returns True if the superblock was ended. */
+static Bool vStopBefore(/*MB_OUT*/ DisResult* dres,
+                        /*OUT*/ IRSB*         irsb,
+                        Addr                  guest_pc_curr_instr,
+                        UInt                  n_elems)
+{
+   if (irsb->stmts_used + n_elems * RISCV64_V_STMTS_PER_ELEM <=
+          RISCV64_V_IR_BUDGET ||
+       isFirstInsnOfSB(irsb))
+      return False;
+   putPC(irsb, mkU64(guest_pc_curr_instr));
+   dres->whatNext    = Dis_StopHere;
+   dres->jk_StopHere = Ijk_Boring;
+   DIP("(vector insn deferred to the next superblock)\n");
+   return True;
+}
+
+/* Obtain the name of an LMUL setting. */
+static const HChar* nameVLMUL(UInt vlmul)
+{
+   static const HChar* names[8] = {"m1",        "m2",  "m4",  "m8",
+                                   "<invalid>", "mf8", "mf4", "mf2"};
+   vassert(vlmul < 8);
+   return names[vlmul];
+}
+
+/* Obtain a vector mask operand string. */
+static const HChar* nameVMaskOperand(UInt vm) { return vm ? "" : ", v0.t"; }
+
+/* Obtain the name of an integer vector operation. */
+static const HChar* nameVOp(RISCV64VOp op)
+{
+   switch (op) {
+   case RISCV64vop_ADD:
+      return "vadd";
+   case RISCV64vop_SUB:
+      return "vsub";
+   case RISCV64vop_RSUB:
+      return "vrsub";
+   case RISCV64vop_MINU:
+      return "vminu";
+   case RISCV64vop_MIN:
+      return "vmin";
+   case RISCV64vop_MAXU:
+      return "vmaxu";
+   case RISCV64vop_MAX:
+      return "vmax";
+   case RISCV64vop_AND:
+      return "vand";
+   case RISCV64vop_OR:
+      return "vor";
+   case RISCV64vop_XOR:
+      return "vxor";
+   case RISCV64vop_SLL:
+      return "vsll";
+   case RISCV64vop_SRL:
+      return "vsrl";
+   case RISCV64vop_SRA:
+      return "vsra";
+   case RISCV64vop_MUL:
+      return "vmul";
+   case RISCV64vop_MERGE:
+      return "vmerge";
+   case RISCV64vop_MV:
+      return "vmv";
+   case RISCV64vop_ID:
+      return "vid";
+   case RISCV64vop_MSEQ:
+      return "vmseq";
+   case RISCV64vop_MSNE:
+      return "vmsne";
+   case RISCV64vop_MSLTU:
+      return "vmsltu";
+   case RISCV64vop_MSLT:
+      return "vmslt";
+   case RISCV64vop_MSLEU:
+      return "vmsleu";
+   case RISCV64vop_MSLE:
+      return "vmsle";
+   case RISCV64vop_MSGTU:
+      return "vmsgtu";
+   case RISCV64vop_MSGT:
+      return "vmsgt";
+   case RISCV64vop_REDSUM:
+      return "vredsum";
+   case RISCV64vop_REDAND:
+      return "vredand";
+   case RISCV64vop_REDOR:
+      return "vredor";
+   case RISCV64vop_REDXOR:
+      return "vredxor";
+   case RISCV64vop_REDMINU:
+      return "vredminu";
+   case RISCV64vop_REDMIN:
+      return "vredmin";
+   case RISCV64vop_REDMAXU:
+      return "vredmaxu";
+   case RISCV64vop_REDMAX:
+      return "vredmax";
+   default:
+      vpanic("nameVOp(riscv64)");
+   }
+}
+
+static Bool isVOpCompare(RISCV64VOp op)
+{
+   return op >= RISCV64vop_MSEQ && op <= RISCV64vop_MSGT;
+}
+
+static Bool isVOpReduction(RISCV64VOp op)
+{
+   return op >= RISCV64vop_REDSUM && op <= RISCV64vop_REDMAX;
+}
+
+/* Tell whether an operation interprets its operands as signed values. */
+static Bool isVOpSigned(RISCV64VOp op)
+{
+   switch (op) {
+   case RISCV64vop_MIN:
+   case RISCV64vop_MAX:
+   case RISCV64vop_SRA:
+   case RISCV64vop_MSLT:
+   case RISCV64vop_MSLE:
+   case RISCV64vop_MSGT:
+   case RISCV64vop_REDMIN:
+   case RISCV64vop_REDMAX:
+      return True;
+   default:
+      return False;
+   }
+}
+
+/* Decode the funct6 field of an OPIVV/OPIVX/OPIVI or OPMVV/OPMVX instruction
+   into an integer vector operation. Returns RISCV64vop_INVALID if the
+   combination is not an operation handled by this decoder. */
+static RISCV64VOp decodeVIntOp(UInt funct3, UInt funct6)
+{
+   Bool vv = funct3 == 0b000, vx = funct3 == 0b100, vi = funct3 == 0b011;
+   Bool mvv = funct3 == 0b010, mvx = funct3 == 0b110;
+   switch (funct6) {
+   case 0b000000:
+      if (vv || vx || vi)
+         return RISCV64vop_ADD;
+      if (mvv)
+         return RISCV64vop_REDSUM;
+      break;
+   case 0b000001:
+      if (mvv)
+         return RISCV64vop_REDAND;
+      break;
+   case 0b000010:
+      if (vv || vx)
+         return RISCV64vop_SUB;
+      if (mvv)
+         return RISCV64vop_REDOR;
+      break;
+   case 0b000011:
+      if (vx || vi)
+         return RISCV64vop_RSUB;
+      if (mvv)
+         return RISCV64vop_REDXOR;
+      break;
+   case 0b000100:
+      if (vv || vx)
+         return RISCV64vop_MINU;
+      if (mvv)
+         return RISCV64vop_REDMINU;
+      break;
+   case 0b000101:
+      if (vv || vx)
+         return RISCV64vop_MIN;
+      if (mvv)
+         return RISCV64vop_REDMIN;
+      break;
+   case 0b000110:
+      if (vv || vx)
+         return RISCV64vop_MAXU;
+      if (mvv)
+         return RISCV64vop_REDMAXU;
+      break;
+   case 0b000111:
+      if (vv || vx)
+         return RISCV64vop_MAX;
+      if (mvv)
+         return RISCV64vop_REDMAX;
+      break;
+   case 0b001001:
+      if (vv || vx || vi)
+         return RISCV64vop_AND;
+      break;
+   case 0b001010:
+      if (vv || vx || vi)
+         return RISCV64vop_OR;
+      break;
+   case 0b001011:
+      if (vv || vx || vi)
+         return RISCV64vop_XOR;
+      break;
+   case 0b010111:
+      if (vv || vx || vi)
+         return RISCV64vop_MERGE;
+      break;
+   case 0b011000:
+      if (vv || vx || vi)
+         return RISCV64vop_MSEQ;
+      break;
+   case 0b011001:
+      if (vv || vx || vi)
+         return RISCV64vop_MSNE;
+      break;
+   case 0b011010:
+      if (vv || vx)
+         return RISCV64vop_MSLTU;
+      break;
+   case 0b011011:
+      if (vv || vx)
+         return RISCV64vop_MSLT;
+      break;
+   case 0b011100:
+      if (vv || vx || vi)
+         return RISCV64vop_MSLEU;
+      break;
+   case 0b011101:
+      if (vv || vx || vi)
+         return RISCV64vop_MSLE;
+      break;
+   case 0b011110:
+      if (vx || vi)
+         return RISCV64vop_MSGTU;
+      break;
+   case 0b011111:
+      if (vx || vi)
+         return RISCV64vop_MSGT;
+      break;
+   case 0b100101:
+      if (vv || vx || vi)
+         return RISCV64vop_SLL;
+      if (mvv || mvx)
+         return RISCV64vop_MUL;
+      break;
+   case 0b101000:
+      if (vv || vx || vi)
+         return RISCV64vop_SRL;
+      break;
+   case 0b101001:
+      if (vv || vx || vi)
+         return RISCV64vop_SRA;
+      break;
+   default:
+      break;
+   }
+   return RISCV64vop_INVALID;
+}
+
+/* Obtain the second operand of an integer vector operation for element idx,
+   extended to 64 bits. It comes from vs1 if that is a vector register,
+   otherwise from the 64-bit scalar truncated to SEW. */
+static IRExpr*
+mkVOpnd(UInt vs1, IRTemp scalar, UInt idx, UInt sew_lg2, Bool is_signed)
+{
+   if (vs1 != RISCV64_VOP_SCALAR)
+      return getVElem64(vs1, idx, sew_lg2, is_signed);
+   IRType  ty = vElemType(sew_lg2);
+   IRExpr* e  = narrowFrom64(ty, mkexpr(scalar));
+   return is_signed ? widenSto64(ty, e) : widenUto64(ty, e);
+}
+
+/* Generate IR evaluating an integer vector operation on two elements extended
+   to 64 bits. The result is an Ity_I1 value for comparisons and an Ity_I64
+   value otherwise. */
+static IRExpr* mkVOpEval(RISCV64VOp op, IRTemp a, IRTemp b, UInt sew_lg2)
+{
+   IRExpr* shamt = unop(Iop_64to8, binop(Iop_And64, mkexpr(b),
+                                         mkU64((8 << sew_lg2) - 1)));
+   switch (op) {
+   case RISCV64vop_ADD:
+   case RISCV64vop_REDSUM:
+      return binop(Iop_Add64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_SUB:
+      return binop(Iop_Sub64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_RSUB:
+      return binop(Iop_Sub64, mkexpr(b), mkexpr(a));
+   case RISCV64vop_MINU:
+   case RISCV64vop_REDMINU:
+      return IRExpr_ITE(binop(Iop_CmpLT64U, mkexpr(a), mkexpr(b)), mkexpr(a),
+                        mkexpr(b));
+   case RISCV64vop_MIN:
+   case RISCV64vop_REDMIN:
+      return IRExpr_ITE(binop(Iop_CmpLT64S, mkexpr(a), mkexpr(b)), mkexpr(a),
+                        mkexpr(b));
+   case RISCV64vop_MAXU:
+   case RISCV64vop_REDMAXU:
+      return IRExpr_ITE(binop(Iop_CmpLT64U, mkexpr(a), mkexpr(b)), mkexpr(b),
+                        mkexpr(a));
+   case RISCV64vop_MAX:
+   case RISCV64vop_REDMAX:
+      return IRExpr_ITE(binop(Iop_CmpLT64S, mkexpr(a), mkexpr(b)), mkexpr(b),
+                        mkexpr(a));
+   case RISCV64vop_AND:
+   case RISCV64vop_REDAND:
+      return binop(Iop_And64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_OR:
+   case RISCV64vop_REDOR:
+      return binop(Iop_Or64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_XOR:
+   case RISCV64vop_REDXOR:
+      return binop(Iop_Xor64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_SLL:
+      return binop(Iop_Shl64, mkexpr(a), shamt);
+   case RISCV64vop_SRL:
+      return binop(Iop_Shr64, mkexpr(a), shamt);
+   case RISCV64vop_SRA:
+      return binop(Iop_Sar64, mkexpr(a), shamt);
+   case RISCV64vop_MUL:
+      return binop(Iop_Mul64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_MSEQ:
+      return binop(Iop_CmpEQ64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_MSNE:
+      return binop(Iop_CmpNE64, mkexpr(a), mkexpr(b));
+   case RISCV64vop_MSLTU:
+      return binop(Iop_CmpLT64U, mkexpr(a), mkexpr(b));
+   case RISCV64vop_MSLT:
+      return binop(Iop_CmpLT64S, mkexpr(a), mkexpr(b));
+   case RISCV64vop_MSLEU:
+      return binop(Iop_CmpLE64U, mkexpr(a), mkexpr(b));
+   case RISCV64vop_MSLE:
+      return binop(Iop_CmpLE64S, mkexpr(a), mkexpr(b));
+   case RISCV64vop_MSGTU:
+      return binop(Iop_CmpLT64U, mkexpr(b), mkexpr(a));
+   case RISCV64vop_MSGT:
+      return binop(Iop_CmpLT64S, mkexpr(b), mkexpr(a));
+   default:
+      vpanic("mkVOpEval(riscv64)");
+   }
+}
+
+/* Obtain the V128 operation computing an integer vector operation on elements
+   which are 1 << sew_lg2 bytes wide, or Iop_INVALID if there is none. */
+static IROp vOpToIROpV128(RISCV64VOp op, UInt sew_lg2)
+{
+   static const IROp add[4]  = {Iop_Add8x16, Iop_Add16x8, Iop_Add32x4,
+                                Iop_Add64x2};
+   static const IROp sub[4]  = {Iop_Sub8x16, Iop_Sub16x8, Iop_Sub32x4,
+                                Iop_Sub64x2};
+   static const IROp minu[4] = {Iop_Min8Ux16, Iop_Min16Ux8, Iop_Min32Ux4,
+                                Iop_Min64Ux2};
+   static const IROp min[4]  = {Iop_Min8Sx16, Iop_Min16Sx8, Iop_Min32Sx4,
+                                Iop_Min64Sx2};
+   static const IROp maxu[4] = {Iop_Max8Ux16, Iop_Max16Ux8, Iop_Max32Ux4,
+                                Iop_Max64Ux2};
+   static const IROp max[4]  = {Iop_Max8Sx16, Iop_Max16Sx8, Iop_Max32Sx4,
+                                Iop_Max64Sx2};
+   static const IROp shl[4]  = {Iop_Shl8x16, Iop_Shl16x8, Iop_Shl32x4,
+                                Iop_Shl64x2};
+   static const IROp shr[4]  = {Iop_Shr8x16, Iop_Shr16x8, Iop_Shr32x4,
+                                Iop_Shr64x2};
+   static const IROp sar[4]  = {Iop_Sar8x16, Iop_Sar16x8, Iop_Sar32x4,
+                                Iop_Sar64x2};
+   static const IROp mul[4]  = {Iop_Mul8x16, Iop_Mul16x8, Iop_Mul32x4,
+                                Iop_INVALID};
+   vassert(sew_lg2 <= 3);
+   switch (op) {
+   case RISCV64vop_ADD:
+      return add[sew_lg2];
+   case RISCV64vop_SUB:
+   case RISCV64vop_RSUB:
+      return sub[sew_lg2];
+   case RISCV64vop_MINU:
+      return minu[sew_lg2];
+   case RISCV64vop_MIN:
+      return min[sew_lg2];
+   case RISCV64vop_MAXU:
+      return maxu[sew_lg2];
+   case RISCV64vop_MAX:
+      return max[sew_lg2];
+   case RISCV64vop_AND:
+      return Iop_AndV128;
+   case RISCV64vop_OR:
+      return Iop_OrV128;
+   case RISCV64vop_XOR:
+      return Iop_XorV128;
+   case RISCV64vop_SLL:
+      return shl[sew_lg2];
+   case RISCV64vop_SRL:
+      return shr[sew_lg2];
+   case RISCV64vop_SRA:
+      return sar[sew_lg2];
+   case RISCV64vop_MUL:
+      return mul[sew_lg2];
+   case RISCV64vop_MV:
+      /* Handled specially by the caller. */
+      return Iop_AndV128;
+   default:
+      return Iop_INVALID;
+   }
+}
+
+/* Replicate the low 1 << sew_lg2 bytes of a 64-bit value into all elements of
+   a V128 value. */
+static IRExpr* mkVDup128(IRExpr* e, UInt sew_lg2)
+{
+   switch (sew_lg2) {
+   case 0:
+      return unop(Iop_Dup8x16, unop(Iop_64to8, e));
+   case 1:
+      return unop(Iop_Dup16x8, unop(Iop_64to16, e));
+   case 2:
+      return unop(Iop_Dup32x4, unop(Iop_64to32, e));
+   case 3:
+      return binop(Iop_64HLtoV128, e, e);
+   default:
+      vassert(0);
+   }
+}
+
+/* Try to generate IR for an unmasked integer vector operation with LMUL<=1 as
+   whole-register Ity_V128 operations. Only the elements below vl are written,
+   the tail is merged back from the old destination value. Returns False if the
+   operation has no V128 form. */
+static Bool mk_vop_v128(/*MOD*/ IRSB* irsb,
+                        RISCV64VOp    op,
+                        UInt          sew_lg2,
+                        UInt          vd,
+                        UInt          vs2,
+                        UInt          vs1,
+                        IRTemp        scalar)
+{
+   IROp iop = vOpToIROpV128(op, sew_lg2);
+   if (iop == Iop_INVALID)
+      return False;
+
+   IRTemp b = newTemp(irsb, Ity_V128);
+   if (vs1 != RISCV64_VOP_SCALAR)
+      assign(irsb, b, getVReg128(vs1));
+   else
+      assign(irsb, b, mkVDup128(mkexpr(scalar), sew_lg2));
+
+   IRTemp res = newTemp(irsb, Ity_V128);
+   if (op == RISCV64vop_MV)
+      assign(irsb, res, mkexpr(b));
+   else if (op == RISCV64vop_RSUB)
+      assign(irsb, res, binop(iop, mkexpr(b), getVReg128(vs2)));
+   else
+      assign(irsb, res, binop(iop, getVReg128(vs2), mkexpr(b)));
+
+   UInt  n_elems = RISCV64_VLENB >> sew_lg2;
+   ULong vl_c;
+   Bool  have_vl = getStaticVL(irsb, &vl_c);
+   if (have_vl && vl_c >= n_elems) {
+      putVReg128(irsb, vd, mkexpr(res));
+      return True;
+   }
+
+   /* Select the body elements, that is those below vl. */
+   IRExpr* body;
+   if (have_vl) {
+      UInt  n_bytes = vl_c << sew_lg2;
+      ULong lo      = n_bytes >= 8 ? ~0ULL : (1ULL << (8 * n_bytes)) - 1;
+      ULong hi      = n_bytes <= 8 ? 0 : (1ULL << (8 * (n_bytes - 8))) - 1;
+      body          = binop(Iop_64HLtoV128, mkU64(hi), mkU64(lo));
+   } else {
+      static const IROp cmpgt[4] = {Iop_CmpGT8Ux16, Iop_CmpGT16Ux8,
+                                    Iop_CmpGT32Ux4, Iop_CmpGT64Ux2};
+      ULong iota[2] = {0, 0};
+      for (UInt i = 0; i < n_elems; i++) {
+         UInt bit = (i << sew_lg2) * 8;
+         iota[bit / 64] |= (ULong)i << (bit % 64);
+      }
+      body = binop(cmpgt[sew_lg2], mkVDup128(getVL(), sew_lg2),
+                   binop(Iop_64HLtoV128, mkU64(iota[1]), mkU64(iota[0])));
+   }
+   IRTemp mask = newTemp(irsb, Ity_V128);
+   assign(irsb, mask, body);
+   putVReg128(irsb, vd,
+              binop(Iop_OrV128, binop(Iop_AndV128, mkexpr(res), mkexpr(mask)),
+                    binop(Iop_AndV128, getVReg128(vd),
+                          unop(Iop_NotV128, mkexpr(mask)))));
+   return True;
+}
+
+/* Generate IR for an integer vector operation when SEW and VLMAX are known at
+   translation time. All elements up to VLMAX are unrolled and each of them is
+   updated only when active, which gives the undisturbed tail and mask
+   policies. */
+static void mk_vop_static(/*MOD*/ IRSB* irsb,
+                          RISCV64VOp    op,
+                          UInt          sew_lg2,
+                          UInt          vlmax,
+                          UInt          vd,
+                          UInt          vs2,
+                          UInt          vs1,
+                          IRTemp        scalar,
+                          Bool          masked)
+{
+   IRType ty        = vElemType(sew_lg2);
+   Bool   is_signed = isVOpSigned(op);
+
+   if (!masked && vlmax <= (RISCV64_VLENB >> sew_lg2) &&
+       mk_vop_v128(irsb, op, sew_lg2, vd, vs2, vs1, scalar))
+      return;
+
+   IRTemp vl = newTemp(irsb, Ity_I64);
+   assign(irsb, vl, getVL());
+
+   if (isVOpReduction(op)) {
+      IRTemp acc = newTemp(irsb, Ity_I64);
+      assign(irsb, acc, getVElem64(vs1, 0, sew_lg2, is_signed));
+      for (UInt i = 0; i < vlmax; i++) {
+         IRTemp a = newTemp(irsb, Ity_I64);
+         assign(irsb, a, getVElem64(vs2, i, sew_lg2, is_signed));
+         IRTemp next = newTemp(irsb, Ity_I64);
+         assign(irsb, next,
+                IRExpr_ITE(mkVActive(vl, i, masked),
+                           mkVOpEval(op, acc, a, sew_lg2), mkexpr(acc)));
+         acc = next;
+      }
+      putVElem(irsb, vd, 0, sew_lg2,
+               narrowFrom64(ty, IRExpr_ITE(binop(Iop_CmpNE64, mkexpr(vl),
+                                                 mkU64(0)),
+                                           mkexpr(acc),
+                                           getVElem64(vd, 0, sew_lg2, False))));
+      return;
+   }
+
+   if (isVOpCompare(op)) {
+      /* Compute all the mask words before writing any of them as the
+         destination can overlap the sources. */
+      UInt   n_words = (vlmax + 63) / 64;
+      IRTemp acc[RISCV64_VLENB / 8];
+      IRTemp old[RISCV64_VLENB / 8];
+      vassert(n_words <= RISCV64_VLENB / 8);
+      for (UInt w = 0; w < n_words; w++) {
+         UInt  n_bits = vlmax - 64 * w < 64 ? vlmax - 64 * w : 64;
+         ULong bits   = n_bits == 64 ? ~0ULL : (1ULL << n_bits) - 1;
+         old[w]       = newTemp(irsb, Ity_I64);
+         assign(irsb, old[w], getVWord64(vd, w));
+         acc[w] = newTemp(irsb, Ity_I64);
+         assign(irsb, acc[w],
+                binop(Iop_And64, mkexpr(old[w]), mkU64(~bits)));
+      }
+      for (UInt i = 0; i < vlmax; i++) {
+         UInt   w = i / 64;
+         IRTemp a = newTemp(irsb, Ity_I64);
+         IRTemp b = newTemp(irsb, Ity_I64);
+         assign(irsb, a, getVElem64(vs2, i, sew_lg2, is_signed));
+         assign(irsb, b, mkVOpnd(vs1, scalar, i, sew_lg2, is_signed));
+         IRExpr* bit = IRExpr_ITE(
+            mkVActive(vl, i, masked), unop(Iop_1Uto64, mkVOpEval(op, a, b, sew_lg2)),
+            binop(Iop_And64, binop(Iop_Shr64, mkexpr(old[w]), mkU8(i % 64)),
+                  mkU64(1)));
+         IRTemp next = newTemp(irsb, Ity_I64);
+         assign(irsb, next,
+                binop(Iop_Or64, mkexpr(acc[w]),
+                      binop(Iop_Shl64, bit, mkU8(i % 64))));
+         acc[w] = next;
+      }
+      for (UInt w = 0; w < n_words; w++)
+         putVWord64(irsb, vd, w, mkexpr(acc[w]));
+      return;
+   }
+
+   for (UInt i = 0; i < vlmax; i++) {
+      IRExpr* res;
+      if (op == RISCV64vop_ID) {
+         res = mkU64(i);
+      } else {
+         IRTemp b = newTemp(irsb, Ity_I64);
+         assign(irsb, b, mkVOpnd(vs1, scalar, i, sew_lg2, is_signed));
+         if (op == RISCV64vop_MV) {
+            res = mkexpr(b);
+         } else {
+            IRTemp a = newTemp(irsb, Ity_I64);
+            assign(irsb, a, getVElem64(vs2, i, sew_lg2, is_signed));
+            if (op == RISCV64vop_MERGE)
+               res = IRExpr_ITE(getVMaskBit(0, i), mkexpr(b), mkexpr(a));
+            else
+               res = mkVOpEval(op, a, b, sew_lg2);
+         }
+      }
+      putVElem(irsb, vd, i, sew_lg2,
+               narrowFrom64(ty, IRExpr_ITE(mkVActive(vl, i, masked), res,
+                                           getVElem64(vd, i, sew_lg2, False))));
+   }
+}
+
+/* Add a guest state effect to a dirty helper call. */
+static void addFxState(IRDirty* d, IREffect fx, Int offset, Int size)
+{
+   vassert(d->nFxState < VEX_N_FXSTATE);
+   d->fxState[d->nFxState].fx     = fx;
+   d->fxState[d->nFxState].offset = offset;
+   d->fxState[d->nFxState].size   = size;
+   d->nFxState++;
+}
+
+/* Generate IR for an integer vector operation when the vtype setting is not
+   known at translation time. The operation is evaluated by a dirty helper. As
+   LMUL is not known either, the helper is declared to access the largest
+   register groups the operands can have, which makes Memcheck's definedness
+   tracking of such operations less precise. */
+static void mk_vop_dirty(/*MOD*/ IRSB* irsb,
+                         RISCV64VOp    op,
+                         UInt          vd,
+                         UInt          vs2,
+                         UInt          vs1,
+                         IRTemp        scalar,
+                         Bool          masked)
+{
+   IRDirty* d = unsafeIRDirty_0_N(
+      0 /*regparms*/, "riscv64g_dirtyhelper_vop", &riscv64g_dirtyhelper_vop,
+      mkIRExprVec_4(IRExpr_GSPTR(), mkU64(op),
+                    mkU64(RISCV64_VOP_REGS(vd, vs2, vs1, masked)),
+                    scalar != IRTemp_INVALID ? mkexpr(scalar) : mkU64(0)));
+   Bool is_red = isVOpReduction(op);
+   Bool is_cmp = isVOpCompare(op);
+
+   d->nFxState = 0;
+   vex_bzero(&d->fxState, sizeof(d->fxState));
+   vassert(OFFB_VTYPE == OFFB_VL + 8);
+   addFxState(d, Ifx_Read, OFFB_VL, 16);
+   if (masked || op == RISCV64vop_MERGE)
+      addFxState(d, Ifx_Read, OFFB_V0, RISCV64_VLENB);
+   if (op != RISCV64vop_ID && op != RISCV64vop_MV)
+      addFxState(d, Ifx_Read, offsetVReg(vs2),
+                 vMaxRegsOfGroup(vs2) * RISCV64_VLENB);
+   if (vs1 != RISCV64_VOP_SCALAR)
+      addFxState(d, Ifx_Read, offsetVReg(vs1),
+                 (is_red ? 1 : vMaxRegsOfGroup(vs1)) * RISCV64_VLENB);
+   addFxState(d, Ifx_Modify, offsetVReg(vd),
+              (is_red || is_cmp ? 1 : vMaxRegsOfGroup(vd)) * RISCV64_VLENB);
+   stmt(irsb, IRStmt_Dirty(d));
+}
+
+/* Generate IR for a floating-point vector operation with SEW of
+   8 << sew_lg2 bits, processing elements 0 .. n_elems-1. The second operand
+   comes from vs1 if that is a vector register, otherwise from the scalar
+   register f[rs1]. If guard is valid, elements are only updated when it holds.
+   The accrued exception flags in fcsr are not updated. */
+static void mk_vfop(/*MOD*/ IRSB* irsb,
+                    UInt          funct6,
+                    UInt          sew_lg2,
+                    UInt          n_elems,
+                    UInt          vd,
+                    UInt          vs2,
+                    UInt          vs1,
+                    UInt          rs1,
+                    Bool          vm,
+                    IRTemp        guard)
+{
+   vassert(sew_lg2 == 2 || sew_lg2 == 3);
+   Bool   is_d   = sew_lg2 == 3;
+   IRType fty    = is_d ? Ity_F64 : Ity_F32;
+   Bool   masked = !vm && funct6 != 0b010111;
+   IROp   add = is_d ? Iop_AddF64 : Iop_AddF32;
+   IROp   mul = is_d ? Iop_MulF64 : Iop_MulF32;
+   IROp   div = is_d ? Iop_DivF64 : Iop_DivF32;
+   IROp   neg = is_d ? Iop_NegF64 : Iop_NegF32;
+   IROp   mad = is_d ? Iop_MAddF64 : Iop_MAddF32;
+
+   IRTemp rm_RISCV, rm_IR;
+   mk_get_rounding_mode(irsb, &rm_RISCV, &rm_IR, 0b111);
+   IRTemp vl = newTemp(irsb, Ity_I64);
+   assign(irsb, vl, getVL());
+   IRTemp scalar = IRTemp_INVALID;
+   if (vs1 == RISCV64_VOP_SCALAR) {
+      scalar = newTemp(irsb, fty);
+      assign(irsb, scalar, is_d ? getFReg64(rs1) : getFReg32(rs1));
+   }
+
+   for (UInt i = 0; i < n_elems; i++) {
+      Int    offset = offsetVElem(vd, i, sew_lg2);
+      IRTemp a      = newTemp(irsb, fty);
+      IRTemp b      = newTemp(irsb, fty);
+      IRTemp old    = newTemp(irsb, fty);
+      assign(irsb, a, IRExpr_Get(offsetVElem(vs2, i, sew_lg2), fty));
+      assign(irsb, b,
+             vs1 == RISCV64_VOP_SCALAR
+                ? mkexpr(scalar)
+                : IRExpr_Get(offsetVElem(vs1, i, sew_lg2), fty));
+      assign(irsb, old, IRExpr_Get(offset, fty));
+
+      IRExpr* res;
+      switch (funct6) {
+      case 0b000000:
+         res = triop(add, mkexpr(rm_IR), mkexpr(a), mkexpr(b));
+         break;
+      case 0b000010:
+         res = triop(add, mkexpr(rm_IR), mkexpr(a), unop(neg, mkexpr(b)));
+         break;
+      case 0b100111:
+         res = triop(add, mkexpr(rm_IR), mkexpr(b), unop(neg, mkexpr(a)));
+         break;
+      case 0b000100:
+         res = binop(is_d ? Iop_MinNumF64 : Iop_MinNumF32, mkexpr(a), mkexpr(b));
+         break;
+      case 0b000110:
+         res = binop(is_d ? Iop_MaxNumF64 : Iop_MaxNumF32, mkexpr(a), mkexpr(b));
+         break;
+      case 0b100000:
+         res = triop(div, mkexpr(rm_IR), mkexpr(a), mkexpr(b));
+         break;
+      case 0b100001:
+         res = triop(div, mkexpr(rm_IR), mkexpr(b), mkexpr(a));
+         break;
+      case 0b100100:
+         res = triop(mul, mkexpr(rm_IR), mkexpr(a), mkexpr(b));
+         break;
+      case 0b101100:
+         res = qop(mad, mkexpr(rm_IR), mkexpr(b), mkexpr(a), mkexpr(old));
+         break;
+      case 0b101101:
+         res = qop(mad, mkexpr(rm_IR), unop(neg, mkexpr(b)), mkexpr(a),
+                   unop(neg, mkexpr(old)));
+         break;
+      case 0b101110:
+         res = qop(mad, mkexpr(rm_IR), mkexpr(b), mkexpr(a),
+                   unop(neg, mkexpr(old)));
+         break;
+      case 0b101111:
+         res = qop(mad, mkexpr(rm_IR), unop(neg, mkexpr(b)), mkexpr(a),
+                   mkexpr(old));
+         break;
+      case 0b010111:
+         res = vm ? mkexpr(b)
+                  : IRExpr_ITE(getVMaskBit(0, i), mkexpr(b), mkexpr(a));
+         break;
+      default:
+         vassert(0);
+      }
+
+      IRExpr* active = mkVActive(vl, i, masked);
+      if (guard != IRTemp_INVALID)
+         active = binop(Iop_And1, active, mkexpr(guard));
+      stmt(irsb, IRStmt_Put(offset, IRExpr_ITE(active, res, mkexpr(old))));
+   }
+}
+
+/* Generate IR transferring elements 0 .. n_elems-1 of a vector register group
+   starting at vd from or to memory. Elements are 1 << eew_lg2 bytes wide.
+   Element i is accessed at address base + i * (1 << eew_lg2) for a unit-stride
+   access, base + i * stride if stride is valid and base + the zero-extended
+   element i of the index group vidx (1 << idx_lg2 bytes wide) if vidx is a
+   register. Only active elements are transferred, and only when guard holds if
+   it is valid. Loads leave the other elements undisturbed. */
+static void mk_vldst(/*MOD*/ IRSB* irsb,
+                     Bool          is_load,
+                     UInt          vd,
+                     UInt          eew_lg2,
+                     UInt          n_elems,
+                     IRTemp        base,
+                     IRTemp        stride,
+                     UInt          vidx,
+                     UInt          idx_lg2,
+                     IRTemp        vl,
+                     Bool          masked,
+                     IRTemp        guard)
+{
+   IRType ty = vElemType(eew_lg2);
+   for (UInt i = 0; i < n_elems; i++) {
+      IRExpr* offset;
+      if (vidx < 32)
+         offset = getVElem64(vidx, i, idx_lg2, False);
+      else if (stride != IRTemp_INVALID)
+         offset = binop(Iop_Mul64, mkexpr(stride), mkU64(i));
+      else
+         offset = mkU64(i << eew_lg2);
+      IRTemp addr = newTemp(irsb, Ity_I64);
+      assign(irsb, addr, binop(Iop_Add64, mkexpr(base), offset));
+
+      IRExpr* active = mkVActive(vl, i, masked);
+      if (guard != IRTemp_INVALID)
+         active = binop(Iop_And1, active, mkexpr(guard));
+      IRTemp g = newTemp(irsb, Ity_I1);
+      assign(irsb, g, active);
+
+      if (!is_load) {
+         stmt(irsb, IRStmt_StoreG(Iend_LE, mkexpr(addr),
+                                  getVElem(vd, i, eew_lg2), mkexpr(g)));
+         continue;
+      }
+
+      IRLoadGOp cvt;
+      IRTemp    res;
+      IRExpr*   alt;
+      IRExpr*   val;
+      switch (ty) {
+      case Ity_I8:
+      case Ity_I16:
+         cvt = ty == Ity_I8 ? ILGop_8Uto32 : ILGop_16Uto32;
+         res = newTemp(irsb, Ity_I32);
+         alt = unop(Iop_64to32, getVElem64(vd, i, eew_lg2, False));
+         val = unop(ty == Ity_I8 ? Iop_32to8 : Iop_32to16, mkexpr(res));
+         break;
+      case Ity_I32:
+         cvt = ILGop_Ident32;
+         res = newTemp(irsb, Ity_I32);
+         alt = getVElem(vd, i, eew_lg2);
+         val = mkexpr(res);
+         break;
+      case Ity_I64:
+         cvt = ILGop_Ident64;
+         res = newTemp(irsb, Ity_I64);
+         alt = getVElem(vd, i, eew_lg2);
+         val = mkexpr(res);
+         break;
+      default:
+         vassert(0);
+      }
+      stmt(irsb, IRStmt_LoadG(Iend_LE, cvt, res, mkexpr(addr), alt, mkexpr(g)));
+      putVElem(irsb, vd, i, eew_lg2, val);
+   }
+}
+
+static Bool dis_RV64V(/*MB_OUT*/ DisResult* dres,
+                      /*OUT*/ IRSB*         irsb,
+                      UInt                  insn,
+                      Addr                  guest_pc_curr_instr)
+{
+   /* --------------- RV64V standard extension --------------- */
+
+   /* ------------------ csrr rd, {vl,vtype,vlenb} ------------------ */
+   if (INSN(6, 0) == 0b1110011 && INSN(14, 12) == 0b010 &&
+       INSN(19, 15) == 0 &&
+       (INSN(31, 20) == 0xc20 || INSN(31, 20) == 0xc21 ||
+        INSN(31, 20) == 0xc22)) {
+      UInt rd  = INSN(11, 7);
+      UInt csr = INSN(31, 20);
+      if (rd != 0) {
+         switch (csr) {
+         case 0xc20:
+            putIReg64(irsb, rd, getVL());
+            break;
+         case 0xc21:
+            putIReg64(irsb, rd, getVType());
+            break;
+         case 0xc22:
+            putIReg64(irsb, rd, mkU64(RISCV64_VLENB));
+            break;
+         default:
+            vassert(0);
+         }
+      }
+      DIP("csrr %s, %s\n", nameIReg(rd), nameCSR(csr));
+      return True;
+   }
+
+   /* --------------- csrr{w,s,c}{,i} rd, vstart, rs1 --------------- */
+   if (INSN(6, 0) == 0b1110011 && INSN(14, 12) != 0b000 &&
+       INSN(14, 12) != 0b100 && INSN(31, 20) == 0x008) {
+      /* Vector instructions always complete, so vstart is always zero and
+         writes to it are ignored. */
+      UInt rd = INSN(11, 7);
+      if (rd != 0)
+         putIReg64(irsb, rd, mkU64(0));
+      DIP("csrr%s%s %s, vstart, %u\n",
+          INSN(13, 12) == 0b01 ? "w" : INSN(13, 12) == 0b10 ? "s" : "c",
+          INSN(14, 14) ? "i" : "", nameIReg(rd), INSN(19, 15));
+      return True;
+   }
+
+   /* The translation is specialised for SEW and LMUL when the vtype setting
+      is known from a preceding vsetvli/vsetivli in the same superblock. */
+   ULong vtype_known;
+   Bool  have_vtype = getStaticVType(irsb, &vtype_known);
+   UInt  sew_lg2    = 0;
+   Int   lmul_lg2   = 0;
+   if (have_vtype && !decodeVType(vtype_known, &sew_lg2, &lmul_lg2)) {
+      /* Executing a vector instruction with vill set is illegal. */
+      have_vtype = False;
+      if (!(INSN(6, 0) == 0b1010111 && INSN(14, 12) == 0b111))
+         return False;
+   }
+
+   /* ---------------- vsetvli rd, rs1, vtypei ---------------- */
+   /* ---------------- vsetivli rd, uimm, vtypei --------------- */
+   /* ----------------- vsetvl rd, rs1, rs2 ------------------ */
+   if (INSN(6, 0) == 0b1010111 && INSN(14, 12) == 0b111) {
+      UInt rd  = INSN(11, 7);
+      UInt rs1 = INSN(19, 15);
+      IRTemp  vlmax = newTemp(irsb, Ity_I64);
+      IRExpr* vtype;
+      IRExpr* avl;
+      Bool    have_vlmax_c = False;
+      ULong   vlmax_c      = 0;
+      if (INSN(31, 31) == 0 || INSN(31, 30) == 0b11) {
+         UInt  zimm  = INSN(31, 31) == 0 ? INSN(30, 20) : INSN(29, 20);
+         /* The vtype value is written as a constant so that the following
+            instructions can be specialised for it. */
+         ULong vtype_c = riscv64g_calculate_vtype(zimm);
+         vtype         = mkU64(vtype_c);
+         vlmax_c       = riscv64g_calculate_vlmax(vtype_c);
+         have_vlmax_c  = True;
+         assign(irsb, vlmax, mkU64(vlmax_c));
+         if (INSN(31, 31) == 0) {
+            /* vsetvli */
+            if (rs1 != 0)
+               avl = getIReg64(rs1);
+            else if (rd != 0)
+               avl = mkU64(~0ULL);
+            else
+               avl = getVL();
+            DIP("vsetvli %s, %s, e%u, %s, %s, %s\n", nameIReg(rd),
+                nameIReg(rs1), 8U << ((zimm >> 3) & 0x7),
+                nameVLMUL(zimm & 0x7), (zimm >> 6) & 1 ? "ta" : "tu",
+                (zimm >> 7) & 1 ? "ma" : "mu");
+         } else {
+            /* vsetivli */
+            avl = mkU64(rs1);
+            DIP("vsetivli %s, %u, e%u, %s, %s, %s\n", nameIReg(rd), rs1,
+                8U << ((zimm >> 3) & 0x7), nameVLMUL(zimm & 0x7),
+                (zimm >> 6) & 1 ? "ta" : "tu", (zimm >> 7) & 1 ? "ma" : "mu");
+         }
+      } else if (INSN(31, 25) == 0b1000000) {
+         /* vsetvl */
+         UInt   rs2 = INSN(24, 20);
+         IRTemp t   = newTemp(irsb, Ity_I64);
+         assign(irsb, t,
+                mkIRExprCCall(Ity_I64, 0 /*regparms*/,
+                              "riscv64g_calculate_vtype",
+                              riscv64g_calculate_vtype,
+                              mkIRExprVec_1(getIReg64(rs2))));
+         vtype = mkexpr(t);
+         assign(irsb, vlmax,
+                mkIRExprCCall(Ity_I64, 0 /*regparms*/,
+                              "riscv64g_calculate_vlmax",
+                              riscv64g_calculate_vlmax,
+                              mkIRExprVec_1(mkexpr(t))));
+         if (rs1 != 0)
+            avl = getIReg64(rs1);
+         else if (rd != 0)
+            avl = mkU64(~0ULL);
+         else
+            avl = getVL();
+         DIP("vsetvl %s, %s, %s\n", nameIReg(rd), nameIReg(rs1),
+             nameIReg(rs2));
+      } else {
+         return False;
+      }
+      IRTemp vl = newTemp(irsb, Ity_I64);
+      if (have_vlmax_c && avl->tag == Iex_Const) {
+         /* Write vl as a constant too when it is known, which allows the
+            following instructions to skip the tail handling. */
+         ULong avl_c = avl->Iex.Const.con->Ico.U64;
+         assign(irsb, vl, mkU64(avl_c < vlmax_c ? avl_c : vlmax_c));
+      } else {
+         assign(irsb, vl,
+                IRExpr_ITE(binop(Iop_CmpLT64U, avl, mkexpr(vlmax)), avl,
+                           mkexpr(vlmax)));
+      }
+      putVL(irsb, mkexpr(vl));
+      putVType(irsb, vtype);
+      if (rd != 0)
+         putIReg64(irsb, rd, mkexpr(vl));
+      return True;
+   }
+
+   /* ----------- vmv<nr>r.v vd, vs2 (whole registers) ----------- */
+   if (INSN(6, 0) == 0b1010111 && INSN(14, 12) == 0b011 &&
+       INSN(31, 26) == 0b100111 && INSN(25, 25) == 1) {
+      UInt vd    = INSN(11, 7);
+      UInt simm5 = INSN(19, 15);
+      UInt vs2   = INSN(24, 20);
+      UInt nregs = simm5 + 1;
+      if ((nregs != 1 && nregs != 2 && nregs != 4 && nregs != 8) ||
+          vd % nregs != 0 || vs2 % nregs != 0) {
+         /* Invalid VMV<NR>R.V, fall through. */
+      } else {
+         /* The groups are aligned to their size, so they either coincide or
+            do not overlap at all. */
+         for (UInt r = 0; r < nregs; r++)
+            putVReg128(irsb, vd + r, getVReg128(vs2 + r));
+         DIP("vmv%ur.v %s, %s\n", nregs, nameVReg(vd), nameVReg(vs2));
+         return True;
+      }
+   }
+
+   /* -------------- vmv.x.s rd, vs2 -------------- */
+   /* -------------- vmv.s.x vd, rs1 -------------- */
+   if (INSN(6, 0) == 0b1010111 && INSN(31, 26) == 0b010000 &&
+       INSN(25, 25) == 1 &&
+       ((INSN(14, 12) == 0b010 && INSN(19, 15) == 0b00000) ||
+        (INSN(14, 12) == 0b110 && INSN(24, 20) == 0b00000))) {
+      Bool is_mv_x_s = INSN(14, 12) == 0b010;
+      UInt rd        = INSN(11, 7);
+      UInt rs1       = INSN(19, 15);
+      UInt vs2       = INSN(24, 20);
+      /* Every possible SEW is handled, each one conditional on being the
+         current one, unless SEW is known at translation time. */
+      IRTemp vsew = newTemp(irsb, Ity_I64);
+      assign(irsb, vsew,
+             binop(Iop_And64, binop(Iop_Shr64, getVType(), mkU8(3)),
+                   mkU64(0x7)));
+      if (is_mv_x_s) {
+         IRExpr* res = NULL;
+         for (Int s = 3; s >= 0; s--) {
+            if (have_vtype && (UInt)s != sew_lg2)
+               continue;
+            IRExpr* e = getVElem64(vs2, 0, s, True);
+            res       = res == NULL || have_vtype
+                           ? e
+                           : IRExpr_ITE(binop(Iop_CmpEQ64, mkexpr(vsew),
+                                              mkU64(s)),
+                                        e, res);
+         }
+         if (rd != 0)
+            putIReg64(irsb, rd, res);
+         DIP("vmv.x.s %s, %s\n", nameIReg(rd), nameVReg(vs2));
+      } else {
+         IRTemp x = newTemp(irsb, Ity_I64);
+         assign(irsb, x, getIReg64(rs1));
+         for (UInt s = 0; s < 4; s++) {
+            if (have_vtype && s != sew_lg2)
+               continue;
+            IRExpr* cond = binop(Iop_CmpNE64, getVL(), mkU64(0));
+            if (!have_vtype)
+               cond = binop(Iop_And1, cond,
+                            binop(Iop_CmpEQ64, mkexpr(vsew), mkU64(s)));
+            putVElem(irsb, rd, 0, s,
+                     narrowFrom64(vElemType(s),
+                                  IRExpr_ITE(cond, mkexpr(x),
+                                             getVElem64(rd, 0, s, False))));
+         }
+         DIP("vmv.s.x %s, %s\n", nameVReg(rd), nameIReg(rs1));
+      }
+      return True;
+   }
+
+   /* ---------------- vfmv.f.s rd, vs2 ---------------- */
+   /* ---------------- vfmv.s.f vd, rs1 ---------------- */
+   if (INSN(6, 0) == 0b1010111 && INSN(31, 26) == 0b010000 &&
+       INSN(25, 25) == 1 &&
+       ((INSN(14, 12) == 0b001 && INSN(19, 15) == 0b00000) ||
+        (INSN(14, 12) == 0b101 && INSN(24, 20) == 0b00000))) {
+      Bool is_mv_f_s = INSN(14, 12) == 0b001;
+      UInt rd        = INSN(11, 7);
+      UInt rs1       = INSN(19, 15);
+      UInt vs2       = INSN(24, 20);
+      if (have_vtype && sew_lg2 != 2 && sew_lg2 != 3)
+         return False;
+      IRTemp is_d = newTemp(irsb, Ity_I1);
+      assign(irsb, is_d,
+             have_vtype ? IRExpr_Const(IRConst_U1(sew_lg2 == 3))
+                        : binop(Iop_CmpEQ64,
+                                binop(Iop_And64, getVType(), mkU64(0x38)),
+                                mkU64(3 << 3)));
+      if (is_mv_f_s) {
+         /* A 32-bit element is NaN-boxed in the 64-bit register. */
+         IRExpr* e32 = binop(Iop_Or64, mkU64(0xffffffff00000000ULL),
+                             getVElem64(vs2, 0, 2, False));
+         putFReg64(irsb, rd,
+                   unop(Iop_ReinterpI64asF64,
+                        IRExpr_ITE(mkexpr(is_d), getVElem(vs2, 0, 3), e32)));
+         DIP("vfmv.f.s %s, %s\n", nameFReg(rd), nameVReg(vs2));
+      } else {
+         IRTemp f = newTemp(irsb, Ity_I64);
+         assign(irsb, f, unop(Iop_ReinterpF64asI64, getFReg64(rs1)));
+         IRTemp nz = newTemp(irsb, Ity_I1);
+         assign(irsb, nz, binop(Iop_CmpNE64, getVL(), mkU64(0)));
+         putVElem(irsb, rd, 0, 3,
+                  IRExpr_ITE(binop(Iop_And1, mkexpr(nz), mkexpr(is_d)),
+                             mkexpr(f), getVElem(rd, 0, 3)));
+         putVElem(irsb, rd, 0, 2,
+                  IRExpr_ITE(binop(Iop_And1, mkexpr(nz),
+                                   unop(Iop_Not1, mkexpr(is_d))),
+                             unop(Iop_64to32, mkexpr(f)),
+                             getVElem(rd, 0, 2)));
+         DIP("vfmv.s.f %s, %s\n", nameVReg(rd), nameFReg(rs1));
+      }
+      return True;
+   }
+
+   /* ------------- vcpop.m rd, vs2{, v0.t} ------------- */
+   /* ------------- vfirst.m rd, vs2{, v0.t} ------------ */
+   if (INSN(6, 0) == 0b1010111 && INSN(14, 12) == 0b010 &&
+       INSN(31, 26) == 0b010000 &&
+       (INSN(19, 15) == 0b10000 || INSN(19, 15) == 0b10001)) {
+      Bool is_cpop = INSN(19, 15) == 0b10000;
+      UInt rd      = INSN(11, 7);
+      UInt vs2     = INSN(24, 20);
+      UInt vm      = INSN(25, 25);
+      IRTemp vl    = newTemp(irsb, Ity_I64);
+      assign(irsb, vl, getVL());
+      IRExpr* w[RISCV64_VLENB / 8];
+      for (UInt i = 0; i < RISCV64_VLENB / 8; i++) {
+         w[i] = binop(Iop_And64, getVWord64(vs2, i), mkVBodyBits(vl, i));
+         if (!vm)
+            w[i] = binop(Iop_And64, w[i], getVWord64(0, i));
+      }
+      IRExpr* res =
+         is_cpop ? mkIRExprCCall(Ity_I64, 0 /*regparms*/,
+                                 "riscv64g_calculate_vcpop",
+                                 riscv64g_calculate_vcpop,
+                                 mkIRExprVec_2(w[0], w[1]))
+                 : mkIRExprCCall(Ity_I64, 0 /*regparms*/,
+                                 "riscv64g_calculate_vfirst",
+                                 riscv64g_calculate_vfirst,
+                                 mkIRExprVec_2(w[0], w[1]));
+      if (rd != 0)
+         putIReg64(irsb, rd, res);
+      DIP("%s %s, %s%s\n", is_cpop ? "vcpop.m" : "vfirst.m", nameIReg(rd),
+          nameVReg(vs2), nameVMaskOperand(vm));
+      return True;
+   }
+
+   /* ----------------- vm<op>.mm vd, vs2, vs1 ----------------- */
+   if (INSN(6, 0) == 0b1010111 && INSN(14, 12) == 0b010 &&
+       INSN(31, 29) == 0b011 && INSN(25, 25) == 1) {
+      UInt funct3 = INSN(28, 26);
+      UInt vd     = INSN(11, 7);
+      UInt vs1    = INSN(19, 15);
+      UInt vs2    = INSN(24, 20);
+      IRTemp vl   = newTemp(irsb, Ity_I64);
+      assign(irsb, vl, getVL());
+      IRTemp res[RISCV64_VLENB / 8];
+      for (UInt i = 0; i < RISCV64_VLENB / 8; i++) {
+         IRExpr* a = getVWord64(vs2, i);
+         IRExpr* b = getVWord64(vs1, i);
+         IRExpr* e;
+         switch (funct3) {
+         case 0b000:
+            e = binop(Iop_And64, a, unop(Iop_Not64, b));
+            break;
+         case 0b001:
+            e = binop(Iop_And64, a, b);
+            break;
+         case 0b010:
+            e = binop(Iop_Or64, a, b);
+            break;
+         case 0b011:
+            e = binop(Iop_Xor64, a, b);
+            break;
+         case 0b100:
+            e = binop(Iop_Or64, a, unop(Iop_Not64, b));
+            break;
+         case 0b101:
+            e = unop(Iop_Not64, binop(Iop_And64, a, b));
+            break;
+         case 0b110:
+            e = unop(Iop_Not64, binop(Iop_Or64, a, b));
+            break;
+         case 0b111:
+            e = unop(Iop_Not64, binop(Iop_Xor64, a, b));
+            break;
+         default:
+            vassert(0);
+         }
+         IRTemp body = newTemp(irsb, Ity_I64);
+         assign(irsb, body, mkVBodyBits(vl, i));
+         res[i] = newTemp(irsb, Ity_I64);
+         assign(irsb, res[i],
+                binop(Iop_Or64, binop(Iop_And64, e, mkexpr(body)),
+                      binop(Iop_And64, getVWord64(vd, i),
+                            unop(Iop_Not64, mkexpr(body)))));
+      }
+      for (UInt i = 0; i < RISCV64_VLENB / 8; i++)
+         putVWord64(irsb, vd, i, mkexpr(res[i]));
+      static const HChar* names[8] = {"vmandn", "vmand", "vmor",  "vmxor",
+                                      "vmorn",  "vmnand", "vmnor", "vmxnor"};
+      DIP("%s.mm %s, %s, %s\n", names[funct3], nameVReg(vd), nameVReg(vs2),
+          nameVReg(vs1));
+      return True;
+   }
+
+   /* ------------- v<op>.{vv,vx,vi} vd, vs2, {vs1,rs1,imm} ------------- */
+   /* ------------------- vred<op>.vs vd, vs2, vs1 ------------------- */
+   /* ------------------------ vid.v vd ------------------------ */
+   if (INSN(6, 0) == 0b1010111 &&
+       (INSN(14, 12) == 0b000 || INSN(14, 12) == 0b011 ||
+        INSN(14, 12) == 0b100 || INSN(14, 12) == 0b010 ||
+        INSN(14, 12) == 0b110)) {
+      UInt       funct3 = INSN(14, 12);
+      UInt       vd     = INSN(11, 7);
+      UInt       rs1    = INSN(19, 15);
+      UInt       vs2    = INSN(24, 20);
+      UInt       vm     = INSN(25, 25);
+      RISCV64VOp op     = decodeVIntOp(funct3, INSN(31, 26));
+      if (funct3 == 0b010 && INSN(31, 26) == 0b010100 && rs1 == 0b10001 &&
+          vs2 == 0)
+         op = RISCV64vop_ID;
+      if (op == RISCV64vop_MERGE && vm == 1) {
+         /* vmv.v.{v,x,i} is vmerge without a mask and with vs2=v0. */
+         op = vs2 == 0 ? RISCV64vop_MV : RISCV64vop_INVALID;
+      }
+      Bool masked = vm == 0 && op != RISCV64vop_MERGE;
+      Bool is_vv  = funct3 == 0b000 || funct3 == 0b010;
+      UInt vs1    = is_vv ? rs1 : RISCV64_VOP_SCALAR;
+      if (op == RISCV64vop_ID)
+         vs1 = RISCV64_VOP_SCALAR;
+
+      /* The destination of an elementwise operation cannot overlap the mask
+         register. */
+      Bool elementwise = !isVOpCompare(op) && !isVOpReduction(op);
+      if (op == RISCV64vop_INVALID || (elementwise && vm == 0 && vd == 0)) {
+         /* Invalid or unhandled vector operation, fall through. */
+      } else {
+         UInt vlmax = 0;
+         if (have_vtype) {
+            UInt nregs = vRegsOfGroup(lmul_lg2);
+            vlmax      = vElemsOfGroup(sew_lg2, lmul_lg2);
+            if ((!isVOpReduction(op) && vs2 % nregs != 0) ||
+                (is_vv && !isVOpReduction(op) && vs1 % nregs != 0) ||
+                (elementwise && vd % nregs != 0) ||
+                (isVOpReduction(op) && vs2 % nregs != 0))
+               return False;
+            if (vStopBefore(dres, irsb, guest_pc_curr_instr, vlmax))
+               return True;
+         }
+
+         /* Shifts take an unsigned immediate, other operations a signed
+            one. */
+         Bool   is_shift = op == RISCV64vop_SLL || op == RISCV64vop_SRL ||
+                         op == RISCV64vop_SRA;
+         ULong  imm       = is_shift ? rs1 : vex_sx_to_64(rs1, 5);
+         IRTemp scalar    = IRTemp_INVALID;
+         if (vs1 == RISCV64_VOP_SCALAR && op != RISCV64vop_ID) {
+            scalar = newTemp(irsb, Ity_I64);
+            assign(irsb, scalar, funct3 == 0b011 ? mkU64(imm) : getIReg64(rs1));
+         }
+
+         if (have_vtype)
+            mk_vop_static(irsb, op, sew_lg2, vlmax, vd, vs2, vs1, scalar,
+                          masked);
+         else
+            mk_vop_dirty(irsb, op, vd, vs2, vs1, scalar, masked);
+
+         const HChar* suffix;
+         if (isVOpReduction(op))
+            suffix = ".vs";
+         else if (op == RISCV64vop_MERGE)
+            suffix = funct3 == 0b000 ? ".vvm" : funct3 == 0b100 ? ".vxm" : ".vim";
+         else
+            suffix = is_vv ? ".vv" : funct3 == 0b011 ? ".vi" : ".vx";
+         if (op == RISCV64vop_ID)
+            DIP("vid.v %s%s\n", nameVReg(vd), nameVMaskOperand(vm));
+         else if (op == RISCV64vop_MV)
+            DIP("vmv.v%s %s, ", suffix + 2, nameVReg(vd));
+         else
+            DIP("%s%s %s, %s, ", nameVOp(op), suffix, nameVReg(vd),
+                nameVReg(vs2));
+         if (op != RISCV64vop_ID) {
+            if (is_vv)
+               DIP("%s", nameVReg(rs1));
+            else if (funct3 == 0b011)
+               DIP("%lld", (Long)imm);
+            else
+               DIP("%s", nameIReg(rs1));
+            DIP("%s%s\n", op == RISCV64vop_MERGE ? ", v0" : "",
+                nameVMaskOperand(vm || op == RISCV64vop_MERGE));
+         }
+         return True;
+      }
+   }
+
+   /* -------- vf<op>.{vv,vf} vd, vs2, {vs1,rs1}{, v0.t} -------- */
+   if (INSN(6, 0) == 0b1010111 &&
+       (INSN(14, 12) == 0b001 || INSN(14, 12) == 0b101)) {
+      UInt funct6 = INSN(31, 26);
+      Bool is_vf  = INSN(14, 12) == 0b101;
+      UInt vd     = INSN(11, 7);
+      UInt rs1    = INSN(19, 15);
+      UInt vs2    = INSN(24, 20);
+      UInt vm     = INSN(25, 25);
+      const HChar* name;
+      switch (funct6) {
+      case 0b000000:
+         name = "vfadd";
+         break;
+      case 0b000010:
+         name = "vfsub";
+         break;
+      case 0b000100:
+         name = "vfmin";
+         break;
+      case 0b000110:
+         name = "vfmax";
+         break;
+      case 0b100000:
+         name = "vfdiv";
+         break;
+      case 0b100100:
+         name = "vfmul";
+         break;
+      case 0b101100:
+         name = "vfmacc";
+         break;
+      case 0b101101:
+         name = "vfnmacc";
+         break;
+      case 0b101110:
+         name = "vfmsac";
+         break;
+      case 0b101111:
+         name = "vfnmsac";
+         break;
+      case 0b100001:
+         name = is_vf ? "vfrdiv" : NULL;
+         break;
+      case 0b100111:
+         name = is_vf ? "vfrsub" : NULL;
+         break;
+      case 0b010111:
+         name = !is_vf ? NULL : vm ? "vfmv" : "vfmerge";
+         if (vm && vs2 != 0)
+            name = NULL;
+         break;
+      default:
+         name = NULL;
+         break;
+      }
+      if (name == NULL || (vm == 0 && vd == 0)) {
+         /* Invalid or unhandled vector operation, fall through. */
+      } else {
+         UInt vs1 = is_vf ? RISCV64_VOP_SCALAR : rs1;
+         if (have_vtype) {
+            UInt nregs = vRegsOfGroup(lmul_lg2);
+            if ((sew_lg2 != 2 && sew_lg2 != 3) || vd % nregs != 0 ||
+                vs2 % nregs != 0 || (!is_vf && vs1 % nregs != 0))
+               return False;
+            UInt vlmax = vElemsOfGroup(sew_lg2, lmul_lg2);
+            if (vStopBefore(dres, irsb, guest_pc_curr_instr, vlmax))
+               return True;
+            mk_vfop(irsb, funct6, sew_lg2, vlmax, vd, vs2, vs1, rs1, vm,
+                    IRTemp_INVALID);
+         } else {
+            /* Handle both floating-point SEWs, each one conditional on being
+               the current one. */
+            UInt nregs = vMaxRegsOfGroup(vd);
+            if (vMaxRegsOfGroup(vs2) < nregs)
+               nregs = vMaxRegsOfGroup(vs2);
+            if (!is_vf && vMaxRegsOfGroup(vs1) < nregs)
+               nregs = vMaxRegsOfGroup(vs1);
+            for (UInt s = 2; s <= 3; s++) {
+               IRTemp guard = newTemp(irsb, Ity_I1);
+               assign(irsb, guard,
+                      binop(Iop_CmpEQ64,
+                            binop(Iop_And64, getVType(), mkU64(0x38)),
+                            mkU64(s << 3)));
+               mk_vfop(irsb, funct6, s, nregs * RISCV64_VLENB >> s, vd, vs2,
+                       vs1, rs1, vm, guard);
+            }
+         }
+         if (funct6 == 0b010111 && vm)
+            DIP("%s.v.f %s, %s\n", name, nameVReg(vd), nameFReg(rs1));
+         else if (funct6 == 0b010111)
+            DIP("%s.vfm %s, %s, %s, v0\n", name, nameVReg(vd), nameVReg(vs2),
+                nameFReg(rs1));
+         else
+            DIP("%s.%s %s, %s, %s%s\n", name, is_vf ? "vf" : "vv",
+                nameVReg(vd), nameVReg(vs2),
+                is_vf ? nameFReg(rs1) : nameVReg(rs1), nameVMaskOperand(vm));
+         return True;
+      }
+   }
+
+   /* ------------------- vector loads and stores ------------------- */
+   if ((INSN(6, 0) == 0b0000111 || INSN(6, 0) == 0b0100111) &&
+       (INSN(14, 12) == 0b000 || INSN(14, 12) >= 0b101) &&
+       INSN(28, 28) == 0) {
+      Bool is_load = INSN(6, 0) == 0b0000111;
+      UInt width   = INSN(14, 12);
+      UInt eew_lg2 = width == 0b000 ? 0 : width - 0b100;
+      UInt vd      = INSN(11, 7);
+      UInt rs1     = INSN(19, 15);
+      UInt rs2     = INSN(24, 20);
+      UInt vm      = INSN(25, 25);
+      UInt mop     = INSN(27, 26);
+      UInt nf      = INSN(31, 29);
+      Bool masked  = vm == 0;
+      const HChar* ls = is_load ? "l" : "s";
+
+      IRTemp base = newTemp(irsb, Ity_I64);
+
+      /* Whole-register accesses vl<nr>re<eew>.v and vs<nr>r.v. These ignore vl
+         and vtype and are done in 64-bit pieces. */
+      if (mop == 0b00 && rs2 == 0b01000 && vm == 1) {
+         UInt nregs = nf + 1;
+         if ((nregs != 1 && nregs != 2 && nregs != 4 && nregs != 8) ||
+             vd % nregs != 0 || (!is_load && eew_lg2 != 0))
+            return False;
+         assign(irsb, base, getIReg64(rs1));
+         for (UInt r = 0; r < nregs; r++) {
+            IRExpr* addr =
+               binop(Iop_Add64, mkexpr(base), mkU64(r * RISCV64_VLENB));
+            if (is_load)
+               putVReg128(irsb, vd + r, loadLE(Ity_V128, addr));
+            else
+               storeLE(irsb, addr, getVReg128(vd + r));
+         }
+         if (is_load)
+            DIP("vl%ure%u.v %s, (%s)\n", nregs, 8U << eew_lg2, nameVReg(vd),
+                nameIReg(rs1));
+         else
+            DIP("vs%ur.v %s, (%s)\n", nregs, nameVReg(vd), nameIReg(rs1));
+         return True;
+      }
+
+      /* Segment accesses are not supported. */
+      if (nf != 0)
+         return False;
+
+      /* Mask accesses vlm.v and vsm.v. These transfer ceil(vl/8) bytes. */
+      if (mop == 0b00 && rs2 == 0b01011 && vm == 1) {
+         if (eew_lg2 != 0)
+            return False;
+         assign(irsb, base, getIReg64(rs1));
+         IRTemp evl = newTemp(irsb, Ity_I64);
+         assign(irsb, evl,
+                binop(Iop_Shr64, binop(Iop_Add64, getVL(), mkU64(7)),
+                      mkU8(3)));
+         mk_vldst(irsb, is_load, vd, 0, RISCV64_VLENB, base, IRTemp_INVALID,
+                  32, 0, evl, False, IRTemp_INVALID);
+         DIP("v%sm.v %s, (%s)\n", ls, nameVReg(vd), nameIReg(rs1));
+         return True;
+      }
+
+      if (masked && is_load && vd == 0)
+         return False;
+
+      /* Unit-stride, fault-only-first and strided accesses. */
+      if ((mop == 0b00 && (rs2 == 0b00000 || (is_load && rs2 == 0b10000))) ||
+          mop == 0b10) {
+         UInt n_elems;
+         if (have_vtype) {
+            Int emul_lg2 = (Int)eew_lg2 - (Int)sew_lg2 + lmul_lg2;
+            if (emul_lg2 < -3 || emul_lg2 > 3 ||
+                vd % vRegsOfGroup(emul_lg2) != 0)
+               return False;
+            n_elems = vElemsOfGroup(sew_lg2, lmul_lg2);
+         } else {
+            /* vl cannot exceed the number of elements of the largest group. */
+            n_elems = vMaxRegsOfGroup(vd) * RISCV64_VLENB >> eew_lg2;
+         }
+         if (vStopBefore(dres, irsb, guest_pc_curr_instr, n_elems))
+            return True;
+
+         assign(irsb, base, getIReg64(rs1));
+         IRTemp vl = newTemp(irsb, Ity_I64);
+         assign(irsb, vl, getVL());
+         if (mop == 0b00 && rs2 == 0b10000) {
+            /* A fault-only-first load may reduce vl for any reason. Limit it to
+               the elements in the page of the first one. Those cannot fault
+               unless the first one does, which then faults as usual. */
+            IRTemp n_fit = newTemp(irsb, Ity_I64);
+            assign(irsb, n_fit,
+                   binop(Iop_Shr64,
+                         binop(Iop_Sub64, mkU64(4096),
+                               binop(Iop_And64, mkexpr(base), mkU64(4095))),
+                         mkU8(eew_lg2)));
+            IRTemp n_fit1 = newTemp(irsb, Ity_I64);
+            assign(irsb, n_fit1,
+                   IRExpr_ITE(binop(Iop_CmpEQ64, mkexpr(n_fit), mkU64(0)),
+                              mkU64(1), mkexpr(n_fit)));
+            IRTemp new_vl = newTemp(irsb, Ity_I64);
+            assign(irsb, new_vl,
+                   IRExpr_ITE(binop(Iop_CmpLT64U, mkexpr(n_fit1), mkexpr(vl)),
+                              mkexpr(n_fit1), mkexpr(vl)));
+            putVL(irsb, mkexpr(new_vl));
+            vl = new_vl;
+         }
+
+         IRTemp stride = IRTemp_INVALID;
+         if (mop == 0b10) {
+            stride = newTemp(irsb, Ity_I64);
+            assign(irsb, stride, getIReg64(rs2));
+         }
+         mk_vldst(irsb, is_load, vd, eew_lg2, n_elems, base, stride, 32, 0, vl,
+                  masked, IRTemp_INVALID);
+
+         if (mop == 0b10)
+            DIP("v%sse%u.v %s, (%s), %s%s\n", ls, 8U << eew_lg2, nameVReg(vd),
+                nameIReg(rs1), nameIReg(rs2), nameVMaskOperand(vm));
+         else
+            DIP("v%se%u%s.v %s, (%s)%s\n", ls, 8U << eew_lg2,
+                rs2 == 0b10000 ? "ff" : "", nameVReg(vd), nameIReg(rs1),
+                nameVMaskOperand(vm));
+         return True;
+      }
+
+      /* Indexed accesses. The index elements have the width encoded in the
+         instruction and the data elements have SEW. */
+      if (mop == 0b01 || mop == 0b11) {
+         UInt vidx = rs2;
+         IRTemp vl = newTemp(irsb, Ity_I64);
+         if (have_vtype) {
+            Int  idx_emul_lg2 = (Int)eew_lg2 - (Int)sew_lg2 + lmul_lg2;
+            UInt n_elems      = vElemsOfGroup(sew_lg2, lmul_lg2);
+            if (idx_emul_lg2 < -3 || idx_emul_lg2 > 3 ||
+                vidx % vRegsOfGroup(idx_emul_lg2) != 0 ||
+                vd % vRegsOfGroup(lmul_lg2) != 0)
+               return False;
+            if (vStopBefore(dres, irsb, guest_pc_curr_instr, n_elems))
+               return True;
+            assign(irsb, base, getIReg64(rs1));
+            assign(irsb, vl, getVL());
+            mk_vldst(irsb, is_load, vd, sew_lg2, n_elems, base, IRTemp_INVALID,
+                     vidx, eew_lg2, vl, masked, IRTemp_INVALID);
+         } else {
+            /* Handle every SEW, each one conditional on being the current
+               one. */
+            UInt n_total = 0;
+            for (UInt s = 0; s < 4; s++) {
+               UInt n_data = vMaxRegsOfGroup(vd) * RISCV64_VLENB >> s;
+               UInt n_idx  = vMaxRegsOfGroup(vidx) * RISCV64_VLENB >> eew_lg2;
+               n_total += n_data < n_idx ? n_data : n_idx;
+            }
+            if (vStopBefore(dres, irsb, guest_pc_curr_instr, n_total))
+               return True;
+            assign(irsb, base, getIReg64(rs1));
+            assign(irsb, vl, getVL());
+            for (UInt s = 0; s < 4; s++) {
+               UInt n_data = vMaxRegsOfGroup(vd) * RISCV64_VLENB >> s;
+               UInt n_idx  = vMaxRegsOfGroup(vidx) * RISCV64_VLENB >> eew_lg2;
+               IRTemp guard = newTemp(irsb, Ity_I1);
+               assign(irsb, guard,
+                      binop(Iop_CmpEQ64,
+                            binop(Iop_And64, getVType(), mkU64(0x38)),
+                            mkU64(s << 3)));
+               mk_vldst(irsb, is_load, vd, s, n_data < n_idx ? n_data : n_idx,
+                        base, IRTemp_INVALID, vidx, eew_lg2, vl, masked, guard);
+            }
+         }
+         DIP("v%s%sxei%u.v %s, (%s), %s%s\n", ls, mop == 0b01 ? "u" : "o",
+             8U << eew_lg2, nameVReg(vd), nameIReg(rs1), nameVReg(vidx),
+             nameVMaskOperand(vm));
+         return True;
+      }
+   }
+
+   return False;
+}
+
+/* End the superblock after a vector instruction if it has grown large, so that
+   the following instructions are translated into a fresh one. */
+static void vStopAfter(/*MB_OUT*/ DisResult* dres,
+                       /*OUT*/ IRSB*         irsb,
+                       Addr                  guest_pc_next_instr)
+{
+   if (dres->whatNext != Dis_Continue ||
+       irsb->stmts_used <= RISCV64_V_IR_BUDGET)
+      return;
+   putPC(irsb, mkU64(guest_pc_next_instr));
+   dres->whatNext    = Dis_StopHere;
+   dres->jk_StopHere = Ijk_Boring;
+}
+
+static Bool dis_RISCV64_standard(/*MB_OUT*/ DisResult* dres,
+                                 /*OUT*/ IRSB*         irsb,
+                                 UInt                  insn,
+                                 Addr                  guest_pc_curr_instr,
+                                 const VexArchInfo*    archinfo,
+                                 const VexAbiInfo*     abiinfo,
+                                 Bool                  sigill_diag)
+{
+   vassert(INSN(1, 0) == 0b11);
+
+   Bool ok = False;
+   if (!ok)
+      ok = dis_RV64I(dres, irsb, insn, guest_pc_curr_instr);
+   if (!ok)
+      ok = dis_RV64M(dres, irsb, insn);
+   if (!ok)
+      ok = dis_RV64A(dres, irsb, insn, guest_pc_curr_instr, abiinfo);
+   if (!ok)
+      ok = dis_RV64F(dres, irsb, insn);
+   if (!ok)
+      ok = dis_RV64D(dres, irsb, insn);
+   if (!ok)
+      ok = dis_RV64Zicsr(dres, irsb, insn);
+   if (!ok && (archinfo->hwcaps & VEX_HWCAPS_RISCV64_ZBA))
+      ok = dis_RV64Zba(dres, irsb, insn);
+   if (!ok && (archinfo->hwcaps & VEX_HWCAPS_RISCV64_ZBB))
+      ok = dis_RV64Zbb(dres, irsb, insn);
+   if (!ok && (archinfo->hwcaps & VEX_HWCAPS_RISCV64_ZBS))
+      ok = dis_RV64Zbs(dres, irsb, insn);
+   if (!ok && (archinfo->hwcaps & VEX_HWCAPS_RISCV64_V)) {
+      ok = dis_RV64V(dres, irsb, insn, guest_pc_curr_instr);
+      if (ok)
+         vStopAfter(dres, irsb, guest_pc_curr_instr + 4);
+   }
    if (ok)
       return True;
 
@@ -3438,8 +5798,8 @@ static Bool disInstr_RISCV64_WRK(/*MB_OUT*/ DisResult* dres,
 
    case 0b11:
       dres->len = inst_size = 4;
-      ok = dis_RISCV64_standard(dres, irsb, insn, guest_pc_curr_instr, abiinfo,
-                                sigill_diag);
+      ok = dis_RISCV64_standard(dres, irsb, insn, guest_pc_curr_instr,
+                                archinfo, abiinfo, sigill_diag);
       break;
 
    default:
@@ -64,6 +64,11 @@ UInt ppHRegRISCV64(HReg reg)
       vassert(r < 32);
       return vex_printf("%s", fnames[r]);
    }
+   case HRcVec128: {
+      UInt r = hregEncoding(reg);
+      vassert(r < 32);
+      return vex_printf("v%u", r);
+   }
    default:
       vpanic("ppHRegRISCV64");
    }
@@ -89,6 +94,16 @@ static inline UInt fregEnc(HReg r)
    return n;
 }
 
+static inline UInt vregEnc(HReg r)
+{
+   UInt n;
+   vassert(hregClass(r) == HRcVec128);
+   vassert(!hregIsVirtual(r));
+   n = hregEncoding(r);
+   vassert(n < 32);
+   return n;
+}
+
 /*------------------------------------------------------------*/
 /*--- Instructions                                         ---*/
 /*------------------------------------------------------------*/
@@ -163,6 +178,50 @@ static const HChar* showRISCV64ALUOp(RISCV64ALUOp op)
       return "remw";
    case RISCV64op_REMUW:
       return "remuw";
+   case RISCV64op_ADD_UW:
+      return "add.uw";
+   case RISCV64op_SH1ADD:
+      return "sh1add";
+   case RISCV64op_SH2ADD:
+      return "sh2add";
+   case RISCV64op_SH3ADD:
+      return "sh3add";
+   case RISCV64op_SH1ADD_UW:
+      return "sh1add.uw";
+   case RISCV64op_SH2ADD_UW:
+      return "sh2add.uw";
+   case RISCV64op_SH3ADD_UW:
+      return "sh3add.uw";
+   case RISCV64op_ANDN:
+      return "andn";
+   case RISCV64op_ORN:
+      return "orn";
+   case RISCV64op_XNOR:
+      return "xnor";
+   case RISCV64op_MIN:
+      return "min";
+   case RISCV64op_MINU:
+      return "minu";
+   case RISCV64op_MAX:
+      return "max";
+   case RISCV64op_MAXU:
+      return "maxu";
+   case RISCV64op_ROL:
+      return "rol";
+   case RISCV64op_ROR:
+      return "ror";
+   case RISCV64op_ROLW:
+      return "rolw";
+   case RISCV64op_RORW:
+      return "rorw";
+   case RISCV64op_BCLR:
+      return "bclr";
+   case RISCV64op_BEXT:
+      return "bext";
+   case RISCV64op_BINV:
+      return "binv";
+   case RISCV64op_BSET:
+      return "bset";
    }
    vpanic("showRISCV64ALUOp");
 }
@@ -176,6 +235,8 @@ static const HChar* showRISCV64ALUImmOp(RISCV64ALUImmOp op)
       return "addiw";
    case RISCV64op_XORI:
       return "xori";
+   case RISCV64op_ORI:
+      return "ori";
    case RISCV64op_ANDI:
       return "andi";
    case RISCV64op_SLLI:
@@ -184,8 +245,50 @@ static const HChar* showRISCV64ALUImmOp(RISCV64ALUImmOp op)
       return "srli";
    case RISCV64op_SRAI:
       return "srai";
+   case RISCV64op_SLLIW:
+      return "slliw";
+   case RISCV64op_SRLIW:
+      return "srliw";
+   case RISCV64op_SRAIW:
+      return "sraiw";
+   case RISCV64op_SLTI:
+      return "slti";
    case RISCV64op_SLTIU:
       return "sltiu";
+   case RISCV64op_SLLI_UW:
+      return "slli.uw";
+   case RISCV64op_RORI:
+      return "rori";
+   case RISCV64op_RORIW:
+      return "roriw";
+   case RISCV64op_BCLRI:
+      return "bclri";
+   case RISCV64op_BEXTI:
+      return "bexti";
+   case RISCV64op_BINVI:
+      return "binvi";
+   case RISCV64op_BSETI:
+      return "bseti";
+   case RISCV64op_CLZ:
+      return "clz";
+   case RISCV64op_CTZ:
+      return "ctz";
+   case RISCV64op_CPOP:
+      return "cpop";
+   case RISCV64op_CLZW:
+      return "clzw";
+   case RISCV64op_CTZW:
+      return "ctzw";
+   case RISCV64op_CPOPW:
+      return "cpopw";
+   case RISCV64op_SEXT_B:
+      return "sext.b";
+   case RISCV64op_SEXT_H:
+      return "sext.h";
+   case RISCV64op_ZEXT_H:
+      return "zext.h";
+   case RISCV64op_REV8:
+      return "rev8";
    }
    vpanic("showRISCV64ALUImmOp");
 }
@@ -387,6 +490,94 @@ static const HChar* showRISCV64FpLdStOp(RISCV64FpLdStOp op)
    vpanic("showRISCV64FpLdStOp");
 }
 
+static const HChar* showRISCV64VecLdStOp(RISCV64VecLdStOp op)
+{
+   switch (op) {
+   case RISCV64op_VLE8:
+      return "vle8.v";
+   case RISCV64op_VSE8:
+      return "vse8.v";
+   }
+   vpanic("showRISCV64VecLdStOp");
+}
+
+static const HChar* showRISCV64VecUnaryOp(RISCV64VecUnaryOp op)
+{
+   switch (op) {
+   case RISCV64op_VNOT:
+      return "vnot.v";
+   case RISCV64op_VCMPNEZ:
+      return "(vcmpnez)";
+   }
+   vpanic("showRISCV64VecUnaryOp");
+}
+
+static const HChar* showRISCV64VecBinaryOp(RISCV64VecBinaryOp op)
+{
+   switch (op) {
+   case RISCV64op_VADD:
+      return "vadd.vv";
+   case RISCV64op_VSUB:
+      return "vsub.vv";
+   case RISCV64op_VSADDU:
+      return "vsaddu.vv";
+   case RISCV64op_VSADD:
+      return "vsadd.vv";
+   case RISCV64op_VSSUBU:
+      return "vssubu.vv";
+   case RISCV64op_VSSUB:
+      return "vssub.vv";
+   case RISCV64op_VMUL:
+      return "vmul.vv";
+   case RISCV64op_VMULHU:
+      return "vmulhu.vv";
+   case RISCV64op_VMULH:
+      return "vmulh.vv";
+   case RISCV64op_VMINU:
+      return "vminu.vv";
+   case RISCV64op_VMIN:
+      return "vmin.vv";
+   case RISCV64op_VMAXU:
+      return "vmaxu.vv";
+   case RISCV64op_VMAX:
+      return "vmax.vv";
+   case RISCV64op_VAND:
+      return "vand.vv";
+   case RISCV64op_VOR:
+      return "vor.vv";
+   case RISCV64op_VXOR:
+      return "vxor.vv";
+   case RISCV64op_VSLL:
+      return "vsll.vv";
+   case RISCV64op_VSRL:
+      return "vsrl.vv";
+   case RISCV64op_VSRA:
+      return "vsra.vv";
+   case RISCV64op_VCMPEQ:
+      return "(vcmpeq)";
+   case RISCV64op_VCMPGTU:
+      return "(vcmpgtu)";
+   case RISCV64op_VCMPGTS:
+      return "(vcmpgts)";
+   case RISCV64op_VPWADD:
+      return "(vpwadd)";
+   }
+   vpanic("showRISCV64VecBinaryOp");
+}
+
+static const HChar* showRISCV64VecShiftImmOp(RISCV64VecShiftImmOp op)
+{
+   switch (op) {
+   case RISCV64op_VSLLI:
+      return "vsll.vi";
+   case RISCV64op_VSRLI:
+      return "vsrl.vi";
+   case RISCV64op_VSRAI:
+      return "vsra.vi";
+   }
+   vpanic("showRISCV64VecShiftImmOp");
+}
+
 RISCV64Instr* RISCV64Instr_LI(HReg dst, ULong imm64)
 {
    RISCV64Instr* i       = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
@@ -474,6 +665,30 @@ RISCV64Instr_StoreC(RISCV64StoreCOp op, HReg res, HReg src, HReg addr)
    return i;
 }
 
+RISCV64Instr*
+RISCV64Instr_LoadG(RISCV64LoadOp op, HReg dst, HReg addr, HReg guard)
+{
+   RISCV64Instr* i          = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                   = RISCV64in_LoadG;
+   i->RISCV64in.LoadG.op    = op;
+   i->RISCV64in.LoadG.dst   = dst;
+   i->RISCV64in.LoadG.addr  = addr;
+   i->RISCV64in.LoadG.guard = guard;
+   return i;
+}
+
+RISCV64Instr*
+RISCV64Instr_StoreG(RISCV64StoreOp op, HReg src, HReg addr, HReg guard)
+{
+   RISCV64Instr* i           = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                    = RISCV64in_StoreG;
+   i->RISCV64in.StoreG.op    = op;
+   i->RISCV64in.StoreG.src   = src;
+   i->RISCV64in.StoreG.addr  = addr;
+   i->RISCV64in.StoreG.guard = guard;
+   return i;
+}
+
 RISCV64Instr* RISCV64Instr_CSRRW(HReg dst, HReg src, UInt csr)
 {
    RISCV64Instr* i        = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
@@ -606,6 +821,113 @@ RISCV64Instr* RISCV64Instr_CSEL(HReg dst, HReg iftrue, HReg iffalse, HReg cond)
    return i;
 }
 
+RISCV64Instr*
+RISCV64Instr_VLdSt(RISCV64VecLdStOp op, HReg reg, HReg base, Int soff)
+{
+   RISCV64Instr* i         = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                  = RISCV64in_VLdSt;
+   i->RISCV64in.VLdSt.op   = op;
+   i->RISCV64in.VLdSt.reg  = reg;
+   i->RISCV64in.VLdSt.base = base;
+   i->RISCV64in.VLdSt.soff = soff;
+   return i;
+}
+
+RISCV64Instr* RISCV64Instr_VMove(HReg dst, HReg src)
+{
+   RISCV64Instr* i        = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                 = RISCV64in_VMove;
+   i->RISCV64in.VMove.dst = dst;
+   i->RISCV64in.VMove.src = src;
+   return i;
+}
+
+RISCV64Instr*
+RISCV64Instr_VUnary(RISCV64VecUnaryOp op, UInt szLg2, HReg dst, HReg src)
+{
+   vassert(szLg2 <= 3);
+   RISCV64Instr* i           = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                    = RISCV64in_VUnary;
+   i->RISCV64in.VUnary.op    = op;
+   i->RISCV64in.VUnary.szLg2 = szLg2;
+   i->RISCV64in.VUnary.dst   = dst;
+   i->RISCV64in.VUnary.src   = src;
+   return i;
+}
+
+RISCV64Instr* RISCV64Instr_VBinary(
+   RISCV64VecBinaryOp op, UInt szLg2, HReg dst, HReg src1, HReg src2)
+{
+   vassert(szLg2 <= 3);
+   vassert(op != RISCV64op_VPWADD || szLg2 <= 2);
+   RISCV64Instr* i            = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                     = RISCV64in_VBinary;
+   i->RISCV64in.VBinary.op    = op;
+   i->RISCV64in.VBinary.szLg2 = szLg2;
+   i->RISCV64in.VBinary.dst   = dst;
+   i->RISCV64in.VBinary.src1  = src1;
+   i->RISCV64in.VBinary.src2  = src2;
+   return i;
+}
+
+RISCV64Instr* RISCV64Instr_VShiftImm(
+   RISCV64VecShiftImmOp op, UInt szLg2, HReg dst, HReg src, UInt amt)
+{
+   vassert(szLg2 <= 3);
+   vassert(amt < (8U << szLg2));
+   RISCV64Instr* i              = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                       = RISCV64in_VShiftImm;
+   i->RISCV64in.VShiftImm.op    = op;
+   i->RISCV64in.VShiftImm.szLg2 = szLg2;
+   i->RISCV64in.VShiftImm.amt   = amt;
+   i->RISCV64in.VShiftImm.dst   = dst;
+   i->RISCV64in.VShiftImm.src   = src;
+   return i;
+}
+
+RISCV64Instr* RISCV64Instr_VDup(UInt szLg2, HReg dst, HReg src)
+{
+   vassert(szLg2 <= 3);
+   RISCV64Instr* i         = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                  = RISCV64in_VDup;
+   i->RISCV64in.VDup.szLg2 = szLg2;
+   i->RISCV64in.VDup.dst   = dst;
+   i->RISCV64in.VDup.src   = src;
+   return i;
+}
+
+RISCV64Instr* RISCV64Instr_VFromI(HReg dst, HReg srcHi, HReg srcLo)
+{
+   RISCV64Instr* i           = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                    = RISCV64in_VFromI;
+   i->RISCV64in.VFromI.dst   = dst;
+   i->RISCV64in.VFromI.srcHi = srcHi;
+   i->RISCV64in.VFromI.srcLo = srcLo;
+   return i;
+}
+
+RISCV64Instr* RISCV64Instr_VToI(Bool hi, HReg dst, HReg src)
+{
+   RISCV64Instr* i       = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                = RISCV64in_VToI;
+   i->RISCV64in.VToI.hi  = hi;
+   i->RISCV64in.VToI.dst = dst;
+   i->RISCV64in.VToI.src = src;
+   return i;
+}
+
+RISCV64Instr*
+RISCV64Instr_VCSEL(HReg dst, HReg iftrue, HReg iffalse, HReg cond)
+{
+   RISCV64Instr* i            = LibVEX_Alloc_inline(sizeof(RISCV64Instr));
+   i->tag                     = RISCV64in_VCSEL;
+   i->RISCV64in.VCSEL.dst     = dst;
+   i->RISCV64in.VCSEL.iftrue  = iftrue;
+   i->RISCV64in.VCSEL.iffalse = iffalse;
+   i->RISCV64in.VCSEL.cond    = cond;
+   return i;
+}
+
 RISCV64Instr* RISCV64Instr_Call(
    RetLoc rloc, Addr64 target, HReg cond, UChar nArgRegs, UChar nFArgRegs)
 {
@@ -706,7 +1028,8 @@ void ppRISCV64Instr(const RISCV64Instr* i, Bool mode64)
       ppHRegRISCV64(i->RISCV64in.ALUImm.dst);
       vex_printf(", ");
       ppHRegRISCV64(i->RISCV64in.ALUImm.src);
-      vex_printf(", %d", i->RISCV64in.ALUImm.imm12);
+      if (i->RISCV64in.ALUImm.op < RISCV64op_CLZ)
+         vex_printf(", %d", i->RISCV64in.ALUImm.imm12);
       return;
    case RISCV64in_Load:
       vex_printf("%-7s ", showRISCV64LoadOp(i->RISCV64in.Load.op));
@@ -738,6 +1061,24 @@ void ppRISCV64Instr(const RISCV64Instr* i, Bool mode64)
       ppHRegRISCV64(i->RISCV64in.StoreC.addr);
       vex_printf(")");
       return;
+   case RISCV64in_LoadG:
+      vex_printf("(LoadG) beq ");
+      ppHRegRISCV64(i->RISCV64in.LoadG.guard);
+      vex_printf(", zero, 1f; %s ", showRISCV64LoadOp(i->RISCV64in.LoadG.op));
+      ppHRegRISCV64(i->RISCV64in.LoadG.dst);
+      vex_printf(", 0(");
+      ppHRegRISCV64(i->RISCV64in.LoadG.addr);
+      vex_printf("); 1:");
+      return;
+   case RISCV64in_StoreG:
+      vex_printf("(StoreG) beq ");
+      ppHRegRISCV64(i->RISCV64in.StoreG.guard);
+      vex_printf(", zero, 1f; %s ", showRISCV64StoreOp(i->RISCV64in.StoreG.op));
+      ppHRegRISCV64(i->RISCV64in.StoreG.src);
+      vex_printf(", 0(");
+      ppHRegRISCV64(i->RISCV64in.StoreG.addr);
+      vex_printf("); 1:");
+      return;
    case RISCV64in_CSRRW:
       vex_printf("csrrw   ");
       ppHRegRISCV64(i->RISCV64in.CSRRW.dst);
@@ -845,6 +1186,90 @@ void ppRISCV64Instr(const RISCV64Instr* i, Bool mode64)
       ppHRegRISCV64(i->RISCV64in.CSEL.iffalse);
       vex_printf("; 2:");
       return;
+   case RISCV64in_VLdSt:
+      vex_printf("%-9s ", showRISCV64VecLdStOp(i->RISCV64in.VLdSt.op));
+      ppHRegRISCV64(i->RISCV64in.VLdSt.reg);
+      vex_printf(", %d(", i->RISCV64in.VLdSt.soff);
+      ppHRegRISCV64(i->RISCV64in.VLdSt.base);
+      vex_printf(")");
+      return;
+   case RISCV64in_VMove:
+      vex_printf("vmv1r.v   ");
+      ppHRegRISCV64(i->RISCV64in.VMove.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VMove.src);
+      return;
+   case RISCV64in_VUnary:
+      vex_printf("%-9s ", showRISCV64VecUnaryOp(i->RISCV64in.VUnary.op));
+      ppHRegRISCV64(i->RISCV64in.VUnary.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VUnary.src);
+      vex_printf(" (e%u)", 8U << i->RISCV64in.VUnary.szLg2);
+      return;
+   case RISCV64in_VBinary:
+      vex_printf("%-9s ", showRISCV64VecBinaryOp(i->RISCV64in.VBinary.op));
+      ppHRegRISCV64(i->RISCV64in.VBinary.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VBinary.src1);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VBinary.src2);
+      vex_printf(" (e%u)", 8U << i->RISCV64in.VBinary.szLg2);
+      return;
+   case RISCV64in_VShiftImm:
+      vex_printf("%-9s ", showRISCV64VecShiftImmOp(i->RISCV64in.VShiftImm.op));
+      ppHRegRISCV64(i->RISCV64in.VShiftImm.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VShiftImm.src);
+      vex_printf(", %u (e%u)", (UInt)i->RISCV64in.VShiftImm.amt,
+                 8U << i->RISCV64in.VShiftImm.szLg2);
+      return;
+   case RISCV64in_VDup:
+      vex_printf("vmv.v.x   ");
+      ppHRegRISCV64(i->RISCV64in.VDup.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VDup.src);
+      vex_printf(" (e%u)", 8U << i->RISCV64in.VDup.szLg2);
+      return;
+   case RISCV64in_VFromI:
+      vex_printf("(VFromI) vmv.v.x ");
+      ppHRegRISCV64(i->RISCV64in.VFromI.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VFromI.srcHi);
+      vex_printf("; vmv.s.x ");
+      ppHRegRISCV64(i->RISCV64in.VFromI.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VFromI.srcLo);
+      vex_printf(" (e64)");
+      return;
+   case RISCV64in_VToI:
+      vex_printf("(VToI) ");
+      if (i->RISCV64in.VToI.hi) {
+         vex_printf("vslidedown.vi v31, ");
+         ppHRegRISCV64(i->RISCV64in.VToI.src);
+         vex_printf(", 1; vmv.x.s ");
+         ppHRegRISCV64(i->RISCV64in.VToI.dst);
+         vex_printf(", v31");
+      } else {
+         vex_printf("vmv.x.s ");
+         ppHRegRISCV64(i->RISCV64in.VToI.dst);
+         vex_printf(", ");
+         ppHRegRISCV64(i->RISCV64in.VToI.src);
+      }
+      vex_printf(" (e64)");
+      return;
+   case RISCV64in_VCSEL:
+      vex_printf("(VCSEL) beq ");
+      ppHRegRISCV64(i->RISCV64in.VCSEL.cond);
+      vex_printf(", zero, 1f; vmv1r.v ");
+      ppHRegRISCV64(i->RISCV64in.VCSEL.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VCSEL.iftrue);
+      vex_printf("; c.j 2f; 1: vmv1r.v ");
+      ppHRegRISCV64(i->RISCV64in.VCSEL.dst);
+      vex_printf(", ");
+      ppHRegRISCV64(i->RISCV64in.VCSEL.iffalse);
+      vex_printf("; 2:");
+      return;
    case RISCV64in_Call:
       vex_printf("(Call) ");
       if (!hregIsInvalid(i->RISCV64in.Call.cond)) {
@@ -982,7 +1407,28 @@ const RRegUniverse* getRRegUniverse_RISCV64(void)
    ru->regs[ru->size++]          = hregRISCV64_f30(); /* ft10 */
    ru->regs[ru->size++]          = hregRISCV64_f31(); /* ft11 */
    ru->allocable_end[HRcFlt64]   = ru->size - 1;
-   ru->allocable                 = ru->size;
+
+   /* Vector registers, all of which are caller-saved. Registers v0 (the mask
+      register) and v31 are reserved as scratch for the emitter. */
+   ru->allocable_start[HRcVec128] = ru->size;
+   ru->regs[ru->size++]           = hregRISCV64_v8();
+   ru->regs[ru->size++]           = hregRISCV64_v9();
+   ru->regs[ru->size++]           = hregRISCV64_v10();
+   ru->regs[ru->size++]           = hregRISCV64_v11();
+   ru->regs[ru->size++]           = hregRISCV64_v12();
+   ru->regs[ru->size++]           = hregRISCV64_v13();
+   ru->regs[ru->size++]           = hregRISCV64_v14();
+   ru->regs[ru->size++]           = hregRISCV64_v15();
+   ru->regs[ru->size++]           = hregRISCV64_v16();
+   ru->regs[ru->size++]           = hregRISCV64_v17();
+   ru->regs[ru->size++]           = hregRISCV64_v18();
+   ru->regs[ru->size++]           = hregRISCV64_v19();
+   ru->regs[ru->size++]           = hregRISCV64_v20();
+   ru->regs[ru->size++]           = hregRISCV64_v21();
+   ru->regs[ru->size++]           = hregRISCV64_v22();
+   ru->regs[ru->size++]           = hregRISCV64_v23();
+   ru->allocable_end[HRcVec128]   = ru->size - 1;
+   ru->allocable                  = ru->size;
 
    /* Add the registers that are not available for allocation. */
    ru->regs[ru->size++] = hregRISCV64_x0(); /* zero */
@@ -1036,6 +1482,17 @@ void getRegUsage_RISCV64Instr(HRegUsage* u, const RISCV64Instr* i, Bool mode64)
       addHRegUse(u, HRmRead, i->RISCV64in.StoreC.src);
       addHRegUse(u, HRmRead, i->RISCV64in.StoreC.addr);
       return;
+   case RISCV64in_LoadG:
+      /* The destination keeps its old value when the guard is zero. */
+      addHRegUse(u, HRmModify, i->RISCV64in.LoadG.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.LoadG.addr);
+      addHRegUse(u, HRmRead, i->RISCV64in.LoadG.guard);
+      return;
+   case RISCV64in_StoreG:
+      addHRegUse(u, HRmRead, i->RISCV64in.StoreG.src);
+      addHRegUse(u, HRmRead, i->RISCV64in.StoreG.addr);
+      addHRegUse(u, HRmRead, i->RISCV64in.StoreG.guard);
+      return;
    case RISCV64in_CSRRW:
       addHRegUse(u, HRmWrite, i->RISCV64in.CSRRW.dst);
       addHRegUse(u, HRmRead, i->RISCV64in.CSRRW.src);
@@ -1101,6 +1558,49 @@ void getRegUsage_RISCV64Instr(HRegUsage* u, const RISCV64Instr* i, Bool mode64)
       addHRegUse(u, HRmRead, i->RISCV64in.CSEL.iffalse);
       addHRegUse(u, HRmRead, i->RISCV64in.CSEL.cond);
       return;
+   case RISCV64in_VLdSt:
+      if (i->RISCV64in.VLdSt.op == RISCV64op_VLE8)
+         addHRegUse(u, HRmWrite, i->RISCV64in.VLdSt.reg);
+      else
+         addHRegUse(u, HRmRead, i->RISCV64in.VLdSt.reg);
+      addHRegUse(u, HRmRead, i->RISCV64in.VLdSt.base);
+      return;
+   case RISCV64in_VMove:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VMove.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VMove.src);
+      return;
+   case RISCV64in_VUnary:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VUnary.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VUnary.src);
+      return;
+   case RISCV64in_VBinary:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VBinary.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VBinary.src1);
+      addHRegUse(u, HRmRead, i->RISCV64in.VBinary.src2);
+      return;
+   case RISCV64in_VShiftImm:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VShiftImm.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VShiftImm.src);
+      return;
+   case RISCV64in_VDup:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VDup.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VDup.src);
+      return;
+   case RISCV64in_VFromI:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VFromI.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VFromI.srcHi);
+      addHRegUse(u, HRmRead, i->RISCV64in.VFromI.srcLo);
+      return;
+   case RISCV64in_VToI:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VToI.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VToI.src);
+      return;
+   case RISCV64in_VCSEL:
+      addHRegUse(u, HRmWrite, i->RISCV64in.VCSEL.dst);
+      addHRegUse(u, HRmRead, i->RISCV64in.VCSEL.iftrue);
+      addHRegUse(u, HRmRead, i->RISCV64in.VCSEL.iffalse);
+      addHRegUse(u, HRmRead, i->RISCV64in.VCSEL.cond);
+      return;
    case RISCV64in_Call:
       /* Logic and comments copied/modified from the arm64 backend. */
       /* First off, claim it trashes all the caller-saved registers which fall
@@ -1133,6 +1633,22 @@ void getRegUsage_RISCV64Instr(HRegUsage* u, const RISCV64Instr* i, Bool mode64)
       addHRegUse(u, HRmWrite, hregRISCV64_f29());
       addHRegUse(u, HRmWrite, hregRISCV64_f30());
       addHRegUse(u, HRmWrite, hregRISCV64_f31());
+      addHRegUse(u, HRmWrite, hregRISCV64_v8());
+      addHRegUse(u, HRmWrite, hregRISCV64_v9());
+      addHRegUse(u, HRmWrite, hregRISCV64_v10());
+      addHRegUse(u, HRmWrite, hregRISCV64_v11());
+      addHRegUse(u, HRmWrite, hregRISCV64_v12());
+      addHRegUse(u, HRmWrite, hregRISCV64_v13());
+      addHRegUse(u, HRmWrite, hregRISCV64_v14());
+      addHRegUse(u, HRmWrite, hregRISCV64_v15());
+      addHRegUse(u, HRmWrite, hregRISCV64_v16());
+      addHRegUse(u, HRmWrite, hregRISCV64_v17());
+      addHRegUse(u, HRmWrite, hregRISCV64_v18());
+      addHRegUse(u, HRmWrite, hregRISCV64_v19());
+      addHRegUse(u, HRmWrite, hregRISCV64_v20());
+      addHRegUse(u, HRmWrite, hregRISCV64_v21());
+      addHRegUse(u, HRmWrite, hregRISCV64_v22());
+      addHRegUse(u, HRmWrite, hregRISCV64_v23());
       /* Now we have to state any parameter-carrying registers which might be
          read. This depends on nArgRegs and nFArgRegs. */
       switch (i->RISCV64in.Call.nArgRegs) {
@@ -1263,6 +1779,16 @@ void mapRegs_RISCV64Instr(HRegRemap* m, RISCV64Instr* i, Bool mode64)
       mapReg(m, &i->RISCV64in.StoreC.src);
       mapReg(m, &i->RISCV64in.StoreC.addr);
       return;
+   case RISCV64in_LoadG:
+      mapReg(m, &i->RISCV64in.LoadG.dst);
+      mapReg(m, &i->RISCV64in.LoadG.addr);
+      mapReg(m, &i->RISCV64in.LoadG.guard);
+      return;
+   case RISCV64in_StoreG:
+      mapReg(m, &i->RISCV64in.StoreG.src);
+      mapReg(m, &i->RISCV64in.StoreG.addr);
+      mapReg(m, &i->RISCV64in.StoreG.guard);
+      return;
    case RISCV64in_CSRRW:
       mapReg(m, &i->RISCV64in.CSRRW.dst);
       mapReg(m, &i->RISCV64in.CSRRW.src);
@@ -1319,6 +1845,46 @@ void mapRegs_RISCV64Instr(HRegRemap* m, RISCV64Instr* i, Bool mode64)
       mapReg(m, &i->RISCV64in.CSEL.iffalse);
       mapReg(m, &i->RISCV64in.CSEL.cond);
       return;
+   case RISCV64in_VLdSt:
+      mapReg(m, &i->RISCV64in.VLdSt.reg);
+      mapReg(m, &i->RISCV64in.VLdSt.base);
+      return;
+   case RISCV64in_VMove:
+      mapReg(m, &i->RISCV64in.VMove.dst);
+      mapReg(m, &i->RISCV64in.VMove.src);
+      return;
+   case RISCV64in_VUnary:
+      mapReg(m, &i->RISCV64in.VUnary.dst);
+      mapReg(m, &i->RISCV64in.VUnary.src);
+      return;
+   case RISCV64in_VBinary:
+      mapReg(m, &i->RISCV64in.VBinary.dst);
+      mapReg(m, &i->RISCV64in.VBinary.src1);
+      mapReg(m, &i->RISCV64in.VBinary.src2);
+      return;
+   case RISCV64in_VShiftImm:
+      mapReg(m, &i->RISCV64in.VShiftImm.dst);
+      mapReg(m, &i->RISCV64in.VShiftImm.src);
+      return;
+   case RISCV64in_VDup:
+      mapReg(m, &i->RISCV64in.VDup.dst);
+      mapReg(m, &i->RISCV64in.VDup.src);
+      return;
+   case RISCV64in_VFromI:
+      mapReg(m, &i->RISCV64in.VFromI.dst);
+      mapReg(m, &i->RISCV64in.VFromI.srcHi);
+      mapReg(m, &i->RISCV64in.VFromI.srcLo);
+      return;
+   case RISCV64in_VToI:
+      mapReg(m, &i->RISCV64in.VToI.dst);
+      mapReg(m, &i->RISCV64in.VToI.src);
+      return;
+   case RISCV64in_VCSEL:
+      mapReg(m, &i->RISCV64in.VCSEL.dst);
+      mapReg(m, &i->RISCV64in.VCSEL.iftrue);
+      mapReg(m, &i->RISCV64in.VCSEL.iffalse);
+      mapReg(m, &i->RISCV64in.VCSEL.cond);
+      return;
    case RISCV64in_Call:
       if (!hregIsInvalid(i->RISCV64in.Call.cond))
          mapReg(m, &i->RISCV64in.Call.cond);
@@ -1370,7 +1936,9 @@ void genSpill_RISCV64(/*OUT*/ HInstr** i1,
 
    HReg base   = get_baseblock_register();
    Int  soff12 = offsetB - BASEBLOCK_OFFSET_ADJUSTMENT;
-   vassert(soff12 >= -2048 && soff12 < 2048);
+   /* Spill slots can lie beyond the simm12 reach of the baseblock register,
+      the emitter then forms the address in t0. */
+   vassert(soff12 >= -2048 && soff12 < 65536);
 
    HRegClass rclass = hregClass(rreg);
    switch (rclass) {
@@ -1380,6 +1948,9 @@ void genSpill_RISCV64(/*OUT*/ HInstr** i1,
    case HRcFlt64:
       *i1 = RISCV64Instr_FpLdSt(RISCV64op_FSD, rreg, base, soff12);
       return;
+   case HRcVec128:
+      *i1 = RISCV64Instr_VLdSt(RISCV64op_VSE8, rreg, base, soff12);
+      return;
    default:
       ppHRegClass(rclass);
       vpanic("genSpill_RISCV64: unimplemented regclass");
@@ -1398,7 +1969,9 @@ void genReload_RISCV64(/*OUT*/ HInstr** i1,
 
    HReg base   = get_baseblock_register();
    Int  soff12 = offsetB - BASEBLOCK_OFFSET_ADJUSTMENT;
-   vassert(soff12 >= -2048 && soff12 < 2048);
+   /* Spill slots can lie beyond the simm12 reach of the baseblock register,
+      the emitter then forms the address in t0. */
+   vassert(soff12 >= -2048 && soff12 < 65536);
 
    HRegClass rclass = hregClass(rreg);
    switch (rclass) {
@@ -1408,6 +1981,9 @@ void genReload_RISCV64(/*OUT*/ HInstr** i1,
    case HRcFlt64:
       *i1 = RISCV64Instr_FpLdSt(RISCV64op_FLD, rreg, base, soff12);
       return;
+   case HRcVec128:
+      *i1 = RISCV64Instr_VLdSt(RISCV64op_VLE8, rreg, base, soff12);
+      return;
    default:
       ppHRegClass(rclass);
       vpanic("genReload_RISCV64: unimplemented regclass");
@@ -1424,6 +2000,8 @@ RISCV64Instr* genMove_RISCV64(HReg from, HReg to, Bool mode64)
       return RISCV64Instr_MV(to, from);
    case HRcFlt64:
       return RISCV64Instr_FpMove(RISCV64op_FMV_D, to, from);
+   case HRcVec128:
+      return RISCV64Instr_VMove(to, from);
    default:
       ppHRegClass(rclass);
       vpanic("genMove_RISCV64: unimplemented regclass");
@@ -1640,6 +2218,52 @@ static UChar* emit_CJ(UChar* p, UInt opcode, UInt imm11_1, UInt funct3)
    return emit16(p, the_insn);
 }
 
+/* Emit an OP-V arithmetic instruction. The rs1 operand is a vector register,
+   a scalar register or a 5-bit immediate, depending on funct3. */
+static UChar* emit_V(
+   UChar* p, UInt funct3, UInt vd, UInt rs1, UInt vs2, UInt vm, UInt funct6)
+{
+   vassert(funct3 >> 3 == 0);
+   vassert(vd >> 5 == 0);
+   vassert(rs1 >> 5 == 0);
+   vassert(vs2 >> 5 == 0);
+   vassert(vm >> 1 == 0);
+   vassert(funct6 >> 6 == 0);
+
+   UInt the_insn = 0;
+
+   the_insn |= 0b1010111 << 0;
+   the_insn |= vd << 7;
+   the_insn |= funct3 << 12;
+   the_insn |= rs1 << 15;
+   the_insn |= vs2 << 20;
+   the_insn |= vm << 25;
+   the_insn |= funct6 << 26;
+
+   return emit32(p, the_insn);
+}
+
+/* Emit a vsetivli instruction with rd=zero, setting vl=avl and a vtype with
+   the given SEW (log2 of the element size in bytes) and LMUL encoding. The
+   tail and mask policies are set to undisturbed. */
+static UChar* emit_vsetivli(UChar* p, UInt avl, UInt szLg2, UInt vlmul)
+{
+   vassert(avl >> 5 == 0);
+   vassert(szLg2 <= 3);
+   vassert(vlmul >> 3 == 0);
+
+   UInt the_insn = 0;
+
+   the_insn |= 0b1010111 << 0;
+   the_insn |= 0 /*x0/zero*/ << 7;
+   the_insn |= 0b111 << 12;
+   the_insn |= avl << 15;
+   the_insn |= ((szLg2 << 3) | vlmul) << 20;
+   the_insn |= 0b11 << 30;
+
+   return emit32(p, the_insn);
+}
+
 /*------------------------------------------------------------*/
 /*--- Code generation                                      ---*/
 /*------------------------------------------------------------*/
@@ -1656,13 +2280,27 @@ static UChar* imm64_to_ireg(UChar* p, UInt dst, ULong imm64)
       return emit_CI(p, 0b01, imm64 & 0x3f, dst, 0b010);
    }
 
-   /* TODO Add implementation with addi only and c.lui+addi. */
+   if (simm64 >= -2048 && simm64 <= 2047) {
+      /* addi dst, zero, simm64[11:0] */
+      return emit_I(p, 0b0010011, dst, 0b000, 0 /*x0/zero*/, imm64 & 0xfff);
+   }
 
    if (simm64 >= -2147483648 && simm64 <= 2147483647) {
-      /* lui dst, simm64[31:12]+simm64[11] */
-      p = emit_U(p, 0b0110111, dst, ((imm64 + 0x800) >> 12) & 0xfffff);
-      if ((imm64 & 0xfff) == 0)
+      UInt imm31_12 = ((imm64 + 0x800) >> 12) & 0xfffff;
+      Int  simm11_0 = vex_sx_to_64(imm64 & 0xfff, 12);
+      if (dst != 2 && (imm31_12 <= 31 || imm31_12 >= 0xfffe0)) {
+         /* c.lui dst, simm64[17:12]+simm64[11] */
+         p = emit_CI(p, 0b01, imm31_12 & 0x3f, dst, 0b011);
+      } else {
+         /* lui dst, simm64[31:12]+simm64[11] */
+         p = emit_U(p, 0b0110111, dst, imm31_12);
+      }
+      if (simm11_0 == 0)
          return p;
+      if (simm11_0 >= -32 && simm11_0 <= 31) {
+         /* c.addiw dst, simm64[5:0] */
+         return emit_CI(p, 0b01, simm11_0 & 0x3f, dst, 0b001);
+      }
       /* addiw dst, dst, simm64[11:0] */
       return emit_I(p, 0b0011011, dst, 0b000, dst, imm64 & 0xfff);
    }
@@ -1697,6 +2335,49 @@ static UChar* imm64_to_ireg(UChar* p, UInt dst, ULong imm64)
    return p;
 }
 
+/* Make a base+offset memory operand addressable with a simm12 displacement.
+   Offsets that do not fit (spill slots placed past the guest state) are split
+   into an upper part which is added to the base in t0, and a remaining low
+   part. */
+static UChar* far_offset_to_t0(UChar* p, UInt* base, Int* soff)
+{
+   if (*soff >= -2048 && *soff < 2048)
+      return p;
+
+   Int hi = (*soff + 0x800) >> 12;
+   /* lui t0, hi */
+   p = emit_U(p, 0b0110111, 5 /*x5/t0*/, hi & 0xfffff);
+   /* add t0, t0, base */
+   p = emit_R(p, 0b0110011, 5 /*x5/t0*/, 0b000, 5 /*x5/t0*/, *base, 0b0000000);
+   *base = 5 /*x5/t0*/;
+   *soff -= hi << 12;
+   vassert(*soff >= -2048 && *soff < 2048);
+   return p;
+}
+
+/* Vector instructions are emitted assuming VLEN=128. Each V128 operation
+   first configures vl/vtype for its element size, viewing the register as
+   128/SEW elements. */
+#define VEC_OPIVV 0b000
+#define VEC_OPMVV 0b010
+#define VEC_OPIVI 0b011
+#define VEC_OPIVX 0b100
+#define VEC_OPMVX 0b110
+
+static UChar* emit_vset_V128(UChar* p, UInt szLg2)
+{
+   return emit_vsetivli(p, 16 >> szLg2, szLg2, 0b000 /*m1*/);
+}
+
+/* Turn a mask in v0 into a V128 with all-ones/all-zeroes lanes. */
+static UChar* emit_vmask_to_V128(UChar* p, UInt dst)
+{
+   /* vmv.v.i dst, 0 */
+   p = emit_V(p, VEC_OPIVI, dst, 0, 0, 1, 0b010111);
+   /* vmerge.vim dst, dst, -1, v0 */
+   return emit_V(p, VEC_OPIVI, dst, 0x1f, dst, 0, 0b010111);
+}
+
 /* Get a 48-bit address into a register, using only that register, and
    generating a constant number of instructions with 18 bytes in size,
    regardless of the value of the address. This is used when generating
@@ -1885,6 +2566,72 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
       case RISCV64op_REMUW:
          p = emit_R(p, 0b0111011, dst, 0b111, src1, src2, 0b0000001);
          goto done;
+      case RISCV64op_ADD_UW:
+         p = emit_R(p, 0b0111011, dst, 0b000, src1, src2, 0b0000100);
+         goto done;
+      case RISCV64op_SH1ADD:
+         p = emit_R(p, 0b0110011, dst, 0b010, src1, src2, 0b0010000);
+         goto done;
+      case RISCV64op_SH2ADD:
+         p = emit_R(p, 0b0110011, dst, 0b100, src1, src2, 0b0010000);
+         goto done;
+      case RISCV64op_SH3ADD:
+         p = emit_R(p, 0b0110011, dst, 0b110, src1, src2, 0b0010000);
+         goto done;
+      case RISCV64op_SH1ADD_UW:
+         p = emit_R(p, 0b0111011, dst, 0b010, src1, src2, 0b0010000);
+         goto done;
+      case RISCV64op_SH2ADD_UW:
+         p = emit_R(p, 0b0111011, dst, 0b100, src1, src2, 0b0010000);
+         goto done;
+      case RISCV64op_SH3ADD_UW:
+         p = emit_R(p, 0b0111011, dst, 0b110, src1, src2, 0b0010000);
+         goto done;
+      case RISCV64op_ANDN:
+         p = emit_R(p, 0b0110011, dst, 0b111, src1, src2, 0b0100000);
+         goto done;
+      case RISCV64op_ORN:
+         p = emit_R(p, 0b0110011, dst, 0b110, src1, src2, 0b0100000);
+         goto done;
+      case RISCV64op_XNOR:
+         p = emit_R(p, 0b0110011, dst, 0b100, src1, src2, 0b0100000);
+         goto done;
+      case RISCV64op_MIN:
+         p = emit_R(p, 0b0110011, dst, 0b100, src1, src2, 0b0000101);
+         goto done;
+      case RISCV64op_MINU:
+         p = emit_R(p, 0b0110011, dst, 0b101, src1, src2, 0b0000101);
+         goto done;
+      case RISCV64op_MAX:
+         p = emit_R(p, 0b0110011, dst, 0b110, src1, src2, 0b0000101);
+         goto done;
+      case RISCV64op_MAXU:
+         p = emit_R(p, 0b0110011, dst, 0b111, src1, src2, 0b0000101);
+         goto done;
+      case RISCV64op_ROL:
+         p = emit_R(p, 0b0110011, dst, 0b001, src1, src2, 0b0110000);
+         goto done;
+      case RISCV64op_ROR:
+         p = emit_R(p, 0b0110011, dst, 0b101, src1, src2, 0b0110000);
+         goto done;
+      case RISCV64op_ROLW:
+         p = emit_R(p, 0b0111011, dst, 0b001, src1, src2, 0b0110000);
+         goto done;
+      case RISCV64op_RORW:
+         p = emit_R(p, 0b0111011, dst, 0b101, src1, src2, 0b0110000);
+         goto done;
+      case RISCV64op_BCLR:
+         p = emit_R(p, 0b0110011, dst, 0b001, src1, src2, 0b0100100);
+         goto done;
+      case RISCV64op_BEXT:
+         p = emit_R(p, 0b0110011, dst, 0b101, src1, src2, 0b0100100);
+         goto done;
+      case RISCV64op_BINV:
+         p = emit_R(p, 0b0110011, dst, 0b001, src1, src2, 0b0110100);
+         goto done;
+      case RISCV64op_BSET:
+         p = emit_R(p, 0b0110011, dst, 0b001, src1, src2, 0b0010100);
+         goto done;
       }
       break;
    }
@@ -1906,6 +2653,10 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
          vassert(imm12 >= -2048 && imm12 < 2048);
          p = emit_I(p, 0b0010011, dst, 0b100, src, imm12 & 0xfff);
          goto done;
+      case RISCV64op_ORI:
+         vassert(imm12 >= -2048 && imm12 < 2048);
+         p = emit_I(p, 0b0010011, dst, 0b110, src, imm12 & 0xfff);
+         goto done;
       case RISCV64op_ANDI:
          vassert(imm12 >= -2048 && imm12 < 2048);
          p = emit_I(p, 0b0010011, dst, 0b111, src, imm12 & 0xfff);
@@ -1922,10 +2673,95 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
          vassert(imm12 >= 0 && imm12 < 64);
          p = emit_I(p, 0b0010011, dst, 0b101, src, (0b010000 << 6) | imm12);
          goto done;
+      case RISCV64op_SLLIW:
+         vassert(imm12 >= 0 && imm12 < 32);
+         p = emit_I(p, 0b0011011, dst, 0b001, src, (0b0000000 << 5) | imm12);
+         goto done;
+      case RISCV64op_SRLIW:
+         vassert(imm12 >= 0 && imm12 < 32);
+         p = emit_I(p, 0b0011011, dst, 0b101, src, (0b0000000 << 5) | imm12);
+         goto done;
+      case RISCV64op_SRAIW:
+         vassert(imm12 >= 0 && imm12 < 32);
+         p = emit_I(p, 0b0011011, dst, 0b101, src, (0b0100000 << 5) | imm12);
+         goto done;
+      case RISCV64op_SLTI:
+         vassert(imm12 >= -2048 && imm12 < 2048);
+         p = emit_I(p, 0b0010011, dst, 0b010, src, imm12 & 0xfff);
+         goto done;
       case RISCV64op_SLTIU:
          vassert(imm12 >= -2048 && imm12 < 2048);
          p = emit_I(p, 0b0010011, dst, 0b011, src, imm12 & 0xfff);
          goto done;
+      case RISCV64op_SLLI_UW:
+         vassert(imm12 >= 0 && imm12 < 64);
+         p = emit_I(p, 0b0011011, dst, 0b001, src, (0b000010 << 6) | imm12);
+         goto done;
+      case RISCV64op_RORI:
+         vassert(imm12 >= 0 && imm12 < 64);
+         p = emit_I(p, 0b0010011, dst, 0b101, src, (0b011000 << 6) | imm12);
+         goto done;
+      case RISCV64op_RORIW:
+         vassert(imm12 >= 0 && imm12 < 32);
+         p = emit_I(p, 0b0011011, dst, 0b101, src, (0b011000 << 6) | imm12);
+         goto done;
+      case RISCV64op_BCLRI:
+         vassert(imm12 >= 0 && imm12 < 64);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, (0b010010 << 6) | imm12);
+         goto done;
+      case RISCV64op_BEXTI:
+         vassert(imm12 >= 0 && imm12 < 64);
+         p = emit_I(p, 0b0010011, dst, 0b101, src, (0b010010 << 6) | imm12);
+         goto done;
+      case RISCV64op_BINVI:
+         vassert(imm12 >= 0 && imm12 < 64);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, (0b011010 << 6) | imm12);
+         goto done;
+      case RISCV64op_BSETI:
+         vassert(imm12 >= 0 && imm12 < 64);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, (0b001010 << 6) | imm12);
+         goto done;
+      case RISCV64op_CLZ:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, 0b011000000000);
+         goto done;
+      case RISCV64op_CTZ:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, 0b011000000001);
+         goto done;
+      case RISCV64op_CPOP:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, 0b011000000010);
+         goto done;
+      case RISCV64op_CLZW:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0011011, dst, 0b001, src, 0b011000000000);
+         goto done;
+      case RISCV64op_CTZW:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0011011, dst, 0b001, src, 0b011000000001);
+         goto done;
+      case RISCV64op_CPOPW:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0011011, dst, 0b001, src, 0b011000000010);
+         goto done;
+      case RISCV64op_SEXT_B:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, 0b011000000100);
+         goto done;
+      case RISCV64op_SEXT_H:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0010011, dst, 0b001, src, 0b011000000101);
+         goto done;
+      case RISCV64op_ZEXT_H:
+         /* zext.h is encoded as an R-type OP-32 instruction with rs2 = 0. */
+         vassert(imm12 == 0);
+         p = emit_R(p, 0b0111011, dst, 0b100, src, 0, 0b0000100);
+         goto done;
+      case RISCV64op_REV8:
+         vassert(imm12 == 0);
+         p = emit_I(p, 0b0010011, dst, 0b101, src, 0b011010111000);
+         goto done;
       }
       break;
    }
@@ -1934,7 +2770,7 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
       UInt dst    = iregEnc(i->RISCV64in.Load.dst);
       UInt base   = iregEnc(i->RISCV64in.Load.base);
       Int  soff12 = i->RISCV64in.Load.soff12;
-      vassert(soff12 >= -2048 && soff12 < 2048);
+      p           = far_offset_to_t0(p, &base, &soff12);
       UInt imm11_0 = soff12 & 0xfff;
       switch (i->RISCV64in.Load.op) {
       case RISCV64op_LD:
@@ -1957,7 +2793,7 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
       UInt src    = iregEnc(i->RISCV64in.Store.src);
       UInt base   = iregEnc(i->RISCV64in.Store.base);
       Int  soff12 = i->RISCV64in.Store.soff12;
-      vassert(soff12 >= -2048 && soff12 < 2048);
+      p           = far_offset_to_t0(p, &base, &soff12);
       UInt imm11_0 = soff12 & 0xfff;
       switch (i->RISCV64in.Store.op) {
       case RISCV64op_SD:
@@ -1998,6 +2834,64 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
       }
       break;
    }
+   case RISCV64in_LoadG: {
+      /*    beq guard, zero, 1f
+            l<size> dst, 0(addr)
+         1:
+       */
+      UInt dst   = iregEnc(i->RISCV64in.LoadG.dst);
+      UInt addr  = iregEnc(i->RISCV64in.LoadG.addr);
+      UInt guard = iregEnc(i->RISCV64in.LoadG.guard);
+      UInt funct3;
+      switch (i->RISCV64in.LoadG.op) {
+      case RISCV64op_LD:
+         funct3 = 0b011;
+         break;
+      case RISCV64op_LW:
+         funct3 = 0b010;
+         break;
+      case RISCV64op_LH:
+         funct3 = 0b001;
+         break;
+      case RISCV64op_LB:
+         funct3 = 0b000;
+         break;
+      default:
+         goto bad;
+      }
+      p = emit_B(p, 0b1100011, (8 >> 1) & 0xfff, 0b000, guard, 0 /*x0/zero*/);
+      p = emit_I(p, 0b0000011, dst, funct3, addr, 0);
+      goto done;
+   }
+   case RISCV64in_StoreG: {
+      /*    beq guard, zero, 1f
+            s<size> src, 0(addr)
+         1:
+       */
+      UInt src   = iregEnc(i->RISCV64in.StoreG.src);
+      UInt addr  = iregEnc(i->RISCV64in.StoreG.addr);
+      UInt guard = iregEnc(i->RISCV64in.StoreG.guard);
+      UInt funct3;
+      switch (i->RISCV64in.StoreG.op) {
+      case RISCV64op_SD:
+         funct3 = 0b011;
+         break;
+      case RISCV64op_SW:
+         funct3 = 0b010;
+         break;
+      case RISCV64op_SH:
+         funct3 = 0b001;
+         break;
+      case RISCV64op_SB:
+         funct3 = 0b000;
+         break;
+      default:
+         goto bad;
+      }
+      p = emit_B(p, 0b1100011, (8 >> 1) & 0xfff, 0b000, guard, 0 /*x0/zero*/);
+      p = emit_S(p, 0b0100011, 0, funct3, addr, src);
+      goto done;
+   }
    case RISCV64in_CSRRW: {
       /* csrrw dst, csr, src */
       UInt dst = iregEnc(i->RISCV64in.CSRRW.dst);
@@ -2247,7 +3141,7 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
       UInt reg    = fregEnc(i->RISCV64in.FpLdSt.reg);
       UInt base   = iregEnc(i->RISCV64in.FpLdSt.base);
       Int  soff12 = i->RISCV64in.FpLdSt.soff12;
-      vassert(soff12 >= -2048 && soff12 < 2048);
+      p           = far_offset_to_t0(p, &base, &soff12);
       UInt imm11_0 = soff12 & 0xfff;
       switch (i->RISCV64in.FpLdSt.op) {
       case RISCV64op_FLW:
@@ -2334,6 +3228,273 @@ Int emit_RISCV64Instr(/*MB_MOD*/ Bool*    is_profInc,
       p = emit_CR(p, 0b10, iffalse, dst, 0b1000);
       goto done;
    }
+   case RISCV64in_VLdSt: {
+      /* vsetivli zero, 16, e8, m1, tu, mu
+         addi t0, base, soff
+         v<op> reg, (t0)
+
+         Unit-stride accesses with vl=16 are used rather than whole-register
+         ones so that exactly 16 bytes are transferred even when the host VLEN
+         is larger than 128.
+       */
+      UInt reg  = vregEnc(i->RISCV64in.VLdSt.reg);
+      UInt base = iregEnc(i->RISCV64in.VLdSt.base);
+      Int  soff = i->RISCV64in.VLdSt.soff;
+      p         = emit_vset_V128(p, 0);
+      p         = far_offset_to_t0(p, &base, &soff);
+      if (soff != 0) {
+         p    = emit_I(p, 0b0010011, 5 /*x5/t0*/, 0b000, base, soff & 0xfff);
+         base = 5 /*x5/t0*/;
+      }
+      UInt the_insn = 0;
+      the_insn |= reg << 7;
+      the_insn |= base << 15;
+      the_insn |= 1 << 25; /* vm */
+      switch (i->RISCV64in.VLdSt.op) {
+      case RISCV64op_VLE8:
+         p = emit32(p, the_insn | 0b0000111);
+         goto done;
+      case RISCV64op_VSE8:
+         p = emit32(p, the_insn | 0b0100111);
+         goto done;
+      }
+      break;
+   }
+   case RISCV64in_VMove: {
+      /* vmv1r.v dst, src */
+      UInt dst = vregEnc(i->RISCV64in.VMove.dst);
+      UInt src = vregEnc(i->RISCV64in.VMove.src);
+      p        = emit_vset_V128(p, 0);
+      p        = emit_V(p, VEC_OPIVI, dst, 0, src, 1, 0b100111);
+      goto done;
+   }
+   case RISCV64in_VUnary: {
+      UInt szLg2 = i->RISCV64in.VUnary.szLg2;
+      UInt dst   = vregEnc(i->RISCV64in.VUnary.dst);
+      UInt src   = vregEnc(i->RISCV64in.VUnary.src);
+      p          = emit_vset_V128(p, szLg2);
+      switch (i->RISCV64in.VUnary.op) {
+      case RISCV64op_VNOT:
+         /* vxor.vi dst, src, -1 */
+         p = emit_V(p, VEC_OPIVI, dst, 0x1f, src, 1, 0b001011);
+         goto done;
+      case RISCV64op_VCMPNEZ:
+         /* vmsne.vi v0, src, 0 */
+         p = emit_V(p, VEC_OPIVI, 0 /*v0*/, 0, src, 1, 0b011001);
+         p = emit_vmask_to_V128(p, dst);
+         goto done;
+      }
+      break;
+   }
+   case RISCV64in_VBinary: {
+      UInt szLg2 = i->RISCV64in.VBinary.szLg2;
+      UInt dst   = vregEnc(i->RISCV64in.VBinary.dst);
+      UInt src1  = vregEnc(i->RISCV64in.VBinary.src1);
+      UInt src2  = vregEnc(i->RISCV64in.VBinary.src2);
+      UInt funct3, funct6;
+      switch (i->RISCV64in.VBinary.op) {
+      case RISCV64op_VADD:
+         funct3 = VEC_OPIVV, funct6 = 0b000000;
+         break;
+      case RISCV64op_VSUB:
+         funct3 = VEC_OPIVV, funct6 = 0b000010;
+         break;
+      case RISCV64op_VSADDU:
+         funct3 = VEC_OPIVV, funct6 = 0b100000;
+         break;
+      case RISCV64op_VSADD:
+         funct3 = VEC_OPIVV, funct6 = 0b100001;
+         break;
+      case RISCV64op_VSSUBU:
+         funct3 = VEC_OPIVV, funct6 = 0b100010;
+         break;
+      case RISCV64op_VSSUB:
+         funct3 = VEC_OPIVV, funct6 = 0b100011;
+         break;
+      case RISCV64op_VMUL:
+         funct3 = VEC_OPMVV, funct6 = 0b100101;
+         break;
+      case RISCV64op_VMULHU:
+         funct3 = VEC_OPMVV, funct6 = 0b100100;
+         break;
+      case RISCV64op_VMULH:
+         funct3 = VEC_OPMVV, funct6 = 0b100111;
+         break;
+      case RISCV64op_VMINU:
+         funct3 = VEC_OPIVV, funct6 = 0b000100;
+         break;
+      case RISCV64op_VMIN:
+         funct3 = VEC_OPIVV, funct6 = 0b000101;
+         break;
+      case RISCV64op_VMAXU:
+         funct3 = VEC_OPIVV, funct6 = 0b000110;
+         break;
+      case RISCV64op_VMAX:
+         funct3 = VEC_OPIVV, funct6 = 0b000111;
+         break;
+      case RISCV64op_VAND:
+         funct3 = VEC_OPIVV, funct6 = 0b001001;
+         break;
+      case RISCV64op_VOR:
+         funct3 = VEC_OPIVV, funct6 = 0b001010;
+         break;
+      case RISCV64op_VXOR:
+         funct3 = VEC_OPIVV, funct6 = 0b001011;
+         break;
+      case RISCV64op_VSLL:
+         funct3 = VEC_OPIVV, funct6 = 0b100101;
+         break;
+      case RISCV64op_VSRL:
+         funct3 = VEC_OPIVV, funct6 = 0b101000;
+         break;
+      case RISCV64op_VSRA:
+         funct3 = VEC_OPIVV, funct6 = 0b101001;
+         break;
+      case RISCV64op_VCMPEQ:
+         /* vmseq.vv v0, src1, src2 */
+         p = emit_vset_V128(p, szLg2);
+         p = emit_V(p, VEC_OPIVV, 0 /*v0*/, src2, src1, 1, 0b011000);
+         p = emit_vmask_to_V128(p, dst);
+         goto done;
+      case RISCV64op_VCMPGTU:
+         /* vmsltu.vv v0, src2, src1 */
+         p = emit_vset_V128(p, szLg2);
+         p = emit_V(p, VEC_OPIVV, 0 /*v0*/, src1, src2, 1, 0b011010);
+         p = emit_vmask_to_V128(p, dst);
+         goto done;
+      case RISCV64op_VCMPGTS:
+         /* vmslt.vv v0, src2, src1 */
+         p = emit_vset_V128(p, szLg2);
+         p = emit_V(p, VEC_OPIVV, 0 /*v0*/, src1, src2, 1, 0b011011);
+         p = emit_vmask_to_V128(p, dst);
+         goto done;
+      case RISCV64op_VPWADD: {
+         /* Sum adjacent pairs of each source by narrowing the sources viewed
+            as vectors of double-width elements. The low half of the result
+            comes from src2, the high half from src1.
+
+               vsetivli zero, N/2, e<sew>, mf2, tu, mu
+               li t0, sew
+               vnsrl.wi v0, src2, 0
+               vnsrl.wx v31, src2, t0
+               vadd.vv v31, v0, v31
+               vnsrl.wi v0, src1, 0
+               vnsrl.wx dst, src1, t0
+               vadd.vv dst, v0, dst
+               vsetivli zero, N, e<sew>, m1, tu, mu
+               vslideup.vi v31, dst, N/2
+               vmv1r.v dst, v31
+          */
+         UInt half = 8 >> szLg2;
+         p = emit_vsetivli(p, half, szLg2, 0b111 /*mf2*/);
+         p = imm64_to_ireg(p, 5 /*x5/t0*/, 8 << szLg2);
+         p = emit_V(p, VEC_OPIVI, 0 /*v0*/, 0, src2, 1, 0b101100);
+         p = emit_V(p, VEC_OPIVX, 31 /*v31*/, 5 /*x5/t0*/, src2, 1, 0b101100);
+         p = emit_V(p, VEC_OPIVV, 31 /*v31*/, 31 /*v31*/, 0 /*v0*/, 1,
+                    0b000000);
+         p = emit_V(p, VEC_OPIVI, 0 /*v0*/, 0, src1, 1, 0b101100);
+         p = emit_V(p, VEC_OPIVX, dst, 5 /*x5/t0*/, src1, 1, 0b101100);
+         p = emit_V(p, VEC_OPIVV, dst, dst, 0 /*v0*/, 1, 0b000000);
+         p = emit_vset_V128(p, szLg2);
+         p = emit_V(p, VEC_OPIVI, 31 /*v31*/, half, dst, 1, 0b001110);
+         p = emit_V(p, VEC_OPIVI, dst, 0, 31 /*v31*/, 1, 0b100111);
+         goto done;
+      }
+      default:
+         goto bad;
+      }
+      /* v<op>.vv dst, src1, src2 */
+      p = emit_vset_V128(p, szLg2);
+      p = emit_V(p, funct3, dst, src2, src1, 1, funct6);
+      goto done;
+   }
+   case RISCV64in_VShiftImm: {
+      /* v<op>.vi dst, src, amt
+         or, for amounts that do not fit in uimm5:
+         li t0, amt; v<op>.vx dst, src, t0
+       */
+      UInt szLg2 = i->RISCV64in.VShiftImm.szLg2;
+      UInt dst   = vregEnc(i->RISCV64in.VShiftImm.dst);
+      UInt src   = vregEnc(i->RISCV64in.VShiftImm.src);
+      UInt amt   = i->RISCV64in.VShiftImm.amt;
+      UInt funct6;
+      switch (i->RISCV64in.VShiftImm.op) {
+      case RISCV64op_VSLLI:
+         funct6 = 0b100101;
+         break;
+      case RISCV64op_VSRLI:
+         funct6 = 0b101000;
+         break;
+      case RISCV64op_VSRAI:
+         funct6 = 0b101001;
+         break;
+      default:
+         goto bad;
+      }
+      p = emit_vset_V128(p, szLg2);
+      if (amt < 32) {
+         p = emit_V(p, VEC_OPIVI, dst, amt, src, 1, funct6);
+      } else {
+         p = imm64_to_ireg(p, 5 /*x5/t0*/, amt);
+         p = emit_V(p, VEC_OPIVX, dst, 5 /*x5/t0*/, src, 1, funct6);
+      }
+      goto done;
+   }
+   case RISCV64in_VDup: {
+      /* vmv.v.x dst, src */
+      UInt dst = vregEnc(i->RISCV64in.VDup.dst);
+      UInt src = iregEnc(i->RISCV64in.VDup.src);
+      p        = emit_vset_V128(p, i->RISCV64in.VDup.szLg2);
+      p        = emit_V(p, VEC_OPIVX, dst, src, 0, 1, 0b010111);
+      goto done;
+   }
+   case RISCV64in_VFromI: {
+      /* vsetivli zero, 2, e64, m1, tu, mu
+         vmv.v.x dst, srcHi
+         vmv.s.x dst, srcLo
+       */
+      UInt dst   = vregEnc(i->RISCV64in.VFromI.dst);
+      UInt srcHi = iregEnc(i->RISCV64in.VFromI.srcHi);
+      UInt srcLo = iregEnc(i->RISCV64in.VFromI.srcLo);
+      p          = emit_vset_V128(p, 3);
+      p          = emit_V(p, VEC_OPIVX, dst, srcHi, 0, 1, 0b010111);
+      p          = emit_V(p, VEC_OPMVX, dst, srcLo, 0, 1, 0b010000);
+      goto done;
+   }
+   case RISCV64in_VToI: {
+      /* vsetivli zero, 2, e64, m1, tu, mu
+         vslidedown.vi v31, src, 1 (only for the upper half)
+         vmv.x.s dst, src/v31
+       */
+      UInt dst = iregEnc(i->RISCV64in.VToI.dst);
+      UInt src = vregEnc(i->RISCV64in.VToI.src);
+      p        = emit_vset_V128(p, 3);
+      if (i->RISCV64in.VToI.hi) {
+         p   = emit_V(p, VEC_OPIVI, 31 /*v31*/, 1, src, 1, 0b001111);
+         src = 31 /*v31*/;
+      }
+      p = emit_V(p, VEC_OPMVV, dst, 0, src, 1, 0b010000);
+      goto done;
+   }
+   case RISCV64in_VCSEL: {
+      /*    vsetivli zero, 16, e8, m1, tu, mu
+            beq cond, zero, 1f
+            vmv1r.v dst, iftrue
+            c.j 2f
+         1: vmv1r.v dst, iffalse
+         2:
+       */
+      UInt dst     = vregEnc(i->RISCV64in.VCSEL.dst);
+      UInt iftrue  = vregEnc(i->RISCV64in.VCSEL.iftrue);
+      UInt iffalse = vregEnc(i->RISCV64in.VCSEL.iffalse);
+      UInt cond    = iregEnc(i->RISCV64in.VCSEL.cond);
+      p = emit_vset_V128(p, 0);
+      p = emit_B(p, 0b1100011, (10 >> 1) & 0xfff, 0b000, cond, 0 /*x0/zero*/);
+      p = emit_V(p, VEC_OPIVI, dst, 0, iftrue, 1, 0b100111);
+      p = emit_CJ(p, 0b01, (6 >> 1) & 0x7ff, 0b101);
+      p = emit_V(p, VEC_OPIVI, dst, 0, iffalse, 1, 0b100111);
+      goto done;
+   }
    case RISCV64in_Call: {
       /*    beq cond, zero, 1f
             li t0, target
@@ -2621,7 +3782,7 @@ bad:
    /*NOTREACHED*/
 
 done:
-   vassert(p - &buf[0] <= 44);
+   vassert(p - &buf[0] <= 48);
    return p - &buf[0];
 }
 
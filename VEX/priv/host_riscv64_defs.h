@@ -82,9 +82,26 @@ ST_IN HReg hregRISCV64_f29(void) { return mkHReg(False, HRcFlt64, 29, 35); }
 ST_IN HReg hregRISCV64_f30(void) { return mkHReg(False, HRcFlt64, 30, 36); }
 ST_IN HReg hregRISCV64_f31(void) { return mkHReg(False, HRcFlt64, 31, 37); }
 
-ST_IN HReg hregRISCV64_x0(void) { return mkHReg(False, HRcInt64, 0, 38); }
-ST_IN HReg hregRISCV64_x2(void) { return mkHReg(False, HRcInt64, 2, 39); }
-ST_IN HReg hregRISCV64_x8(void) { return mkHReg(False, HRcInt64, 8, 40); }
+ST_IN HReg hregRISCV64_v8(void) { return mkHReg(False, HRcVec128, 8, 38); }
+ST_IN HReg hregRISCV64_v9(void) { return mkHReg(False, HRcVec128, 9, 39); }
+ST_IN HReg hregRISCV64_v10(void) { return mkHReg(False, HRcVec128, 10, 40); }
+ST_IN HReg hregRISCV64_v11(void) { return mkHReg(False, HRcVec128, 11, 41); }
+ST_IN HReg hregRISCV64_v12(void) { return mkHReg(False, HRcVec128, 12, 42); }
+ST_IN HReg hregRISCV64_v13(void) { return mkHReg(False, HRcVec128, 13, 43); }
+ST_IN HReg hregRISCV64_v14(void) { return mkHReg(False, HRcVec128, 14, 44); }
+ST_IN HReg hregRISCV64_v15(void) { return mkHReg(False, HRcVec128, 15, 45); }
+ST_IN HReg hregRISCV64_v16(void) { return mkHReg(False, HRcVec128, 16, 46); }
+ST_IN HReg hregRISCV64_v17(void) { return mkHReg(False, HRcVec128, 17, 47); }
+ST_IN HReg hregRISCV64_v18(void) { return mkHReg(False, HRcVec128, 18, 48); }
+ST_IN HReg hregRISCV64_v19(void) { return mkHReg(False, HRcVec128, 19, 49); }
+ST_IN HReg hregRISCV64_v20(void) { return mkHReg(False, HRcVec128, 20, 50); }
+ST_IN HReg hregRISCV64_v21(void) { return mkHReg(False, HRcVec128, 21, 51); }
+ST_IN HReg hregRISCV64_v22(void) { return mkHReg(False, HRcVec128, 22, 52); }
+ST_IN HReg hregRISCV64_v23(void) { return mkHReg(False, HRcVec128, 23, 53); }
+
+ST_IN HReg hregRISCV64_x0(void) { return mkHReg(False, HRcInt64, 0, 54); }
+ST_IN HReg hregRISCV64_x2(void) { return mkHReg(False, HRcInt64, 2, 55); }
+ST_IN HReg hregRISCV64_x8(void) { return mkHReg(False, HRcInt64, 8, 56); }
 #undef ST_IN
 
 /* Number of registers used for argument passing in function calls. */
@@ -134,6 +151,37 @@ typedef enum {
                              register by another. */
    RISCV64op_REMUW,       /* Remainder from 32-bit unsigned division of one
                              register by another. */
+   RISCV64op_ADD_UW,      /* Addition of a zx-32-to-64-bit register and a
+                             register (Zba). */
+   RISCV64op_SH1ADD,      /* Addition of a register shifted left by 1 and a
+                             register (Zba). */
+   RISCV64op_SH2ADD,      /* Addition of a register shifted left by 2 and a
+                             register (Zba). */
+   RISCV64op_SH3ADD,      /* Addition of a register shifted left by 3 and a
+                             register (Zba). */
+   RISCV64op_SH1ADD_UW,   /* Addition of a zx-32-to-64-bit register shifted
+                             left by 1 and a register (Zba). */
+   RISCV64op_SH2ADD_UW,   /* Addition of a zx-32-to-64-bit register shifted
+                             left by 2 and a register (Zba). */
+   RISCV64op_SH3ADD_UW,   /* Addition of a zx-32-to-64-bit register shifted
+                             left by 3 and a register (Zba). */
+   RISCV64op_ANDN,        /* Bitwise AND of a register and an inverted
+                             register (Zbb). */
+   RISCV64op_ORN,         /* Bitwise OR of a register and an inverted register
+                             (Zbb). */
+   RISCV64op_XNOR,        /* Inverted bitwise XOR of two registers (Zbb). */
+   RISCV64op_MIN,         /* Signed minimum of two registers (Zbb). */
+   RISCV64op_MINU,        /* Unsigned minimum of two registers (Zbb). */
+   RISCV64op_MAX,         /* Signed maximum of two registers (Zbb). */
+   RISCV64op_MAXU,        /* Unsigned maximum of two registers (Zbb). */
+   RISCV64op_ROL,         /* Left rotation of a register (Zbb). */
+   RISCV64op_ROR,         /* Right rotation of a register (Zbb). */
+   RISCV64op_ROLW,        /* 32-bit left rotation of a register (Zbb). */
+   RISCV64op_RORW,        /* 32-bit right rotation of a register (Zbb). */
+   RISCV64op_BCLR,        /* Clearing of a single register bit (Zbs). */
+   RISCV64op_BEXT,        /* Extraction of a single register bit (Zbs). */
+   RISCV64op_BINV,        /* Inversion of a single register bit (Zbs). */
+   RISCV64op_BSET,        /* Setting of a single register bit (Zbs). */
 } RISCV64ALUOp;
 
 /* RISCV64in_ALUImm sub-types. */
@@ -144,6 +192,8 @@ typedef enum {
                               immediate. */
    RISCV64op_XORI,         /* Bitwise XOR of a register and a sx-12-bit
                               immediate. */
+   RISCV64op_ORI,          /* Bitwise OR of a register and a sx-12-bit
+                              immediate. */
    RISCV64op_ANDI,         /* Bitwise AND of a register and a sx-12-bit
                               immediate. */
    RISCV64op_SLLI,         /* Logical left shift on a register by a 6-bit
@@ -152,8 +202,43 @@ typedef enum {
                               immediate. */
    RISCV64op_SRAI,         /* Arithmetic right shift on a register by a 6-bit
                               immediate. */
+   RISCV64op_SLLIW,        /* 32-bit logical left shift on a register by a
+                              5-bit immediate. */
+   RISCV64op_SRLIW,        /* 32-bit logical right shift on a register by a
+                              5-bit immediate. */
+   RISCV64op_SRAIW,        /* 32-bit arithmetic right shift on a register by a
+                              5-bit immediate. */
+   RISCV64op_SLTI,         /* Signed comparison of a register and a sx-12-bit
+                              immediate. */
    RISCV64op_SLTIU,        /* Unsigned comparison of a register and a sx-12-bit
                               immediate. */
+   RISCV64op_SLLI_UW,      /* Logical left shift on a zx-32-to-64-bit register
+                              by a 6-bit immediate (Zba). */
+   RISCV64op_RORI,         /* Right rotation of a register by a 6-bit
+                              immediate (Zbb). */
+   RISCV64op_RORIW,        /* 32-bit right rotation of a register by a 5-bit
+                              immediate (Zbb). */
+   RISCV64op_BCLRI,        /* Clearing of a single register bit selected by a
+                              6-bit immediate (Zbs). */
+   RISCV64op_BEXTI,        /* Extraction of a single register bit selected by
+                              a 6-bit immediate (Zbs). */
+   RISCV64op_BINVI,        /* Inversion of a single register bit selected by a
+                              6-bit immediate (Zbs). */
+   RISCV64op_BSETI,        /* Setting of a single register bit selected by a
+                              6-bit immediate (Zbs). */
+   /* The following operations take no immediate, imm12 must be 0. */
+   RISCV64op_CLZ,          /* Count of leading zero bits (Zbb). */
+   RISCV64op_CTZ,          /* Count of trailing zero bits (Zbb). */
+   RISCV64op_CPOP,         /* Count of set bits (Zbb). */
+   RISCV64op_CLZW,         /* Count of leading zero bits in the lower 32 bits
+                              (Zbb). */
+   RISCV64op_CTZW,         /* Count of trailing zero bits in the lower 32 bits
+                              (Zbb). */
+   RISCV64op_CPOPW,        /* Count of set bits in the lower 32 bits (Zbb). */
+   RISCV64op_SEXT_B,       /* Sign-extension of the lowest byte (Zbb). */
+   RISCV64op_SEXT_H,       /* Sign-extension of the lowest halfword (Zbb). */
+   RISCV64op_ZEXT_H,       /* Zero-extension of the lowest halfword (Zbb). */
+   RISCV64op_REV8,         /* Byte-reversal of a register (Zbb). */
 } RISCV64ALUImmOp;
 
 /* RISCV64in_Load sub-types. */
@@ -316,6 +401,63 @@ typedef enum {
    RISCV64op_CAS_W,         /* 32-bit compare-and-swap pseudoinstruction. */
 } RISCV64CASOp;
 
+/* RISCV64in_VLdSt sub-types. */
+typedef enum {
+   RISCV64op_VLE8 = 0xf00, /* 16-byte unit-stride load. */
+   RISCV64op_VSE8,         /* 16-byte unit-stride store. */
+} RISCV64VecLdStOp;
+
+/* RISCV64in_VUnary sub-types. */
+typedef enum {
+   RISCV64op_VNOT = 0x1000, /* Bitwise NOT of a vector register. */
+   RISCV64op_VCMPNEZ,       /* Set each element to all ones if it is non-zero,
+                               else to zero (pseudoinstruction). */
+} RISCV64VecUnaryOp;
+
+/* RISCV64in_VBinary sub-types. */
+typedef enum {
+   RISCV64op_VADD = 0x1100, /* Addition of two vector registers. */
+   RISCV64op_VSUB,          /* Subtraction of one vector register from
+                               another. */
+   RISCV64op_VSADDU,        /* Unsigned saturating addition. */
+   RISCV64op_VSADD,         /* Signed saturating addition. */
+   RISCV64op_VSSUBU,        /* Unsigned saturating subtraction. */
+   RISCV64op_VSSUB,         /* Signed saturating subtraction. */
+   RISCV64op_VMUL,          /* Multiplication, producing the lower halves. */
+   RISCV64op_VMULHU,        /* Unsigned multiplication, producing the upper
+                               halves. */
+   RISCV64op_VMULH,         /* Signed multiplication, producing the upper
+                               halves. */
+   RISCV64op_VMINU,         /* Unsigned minimum. */
+   RISCV64op_VMIN,          /* Signed minimum. */
+   RISCV64op_VMAXU,         /* Unsigned maximum. */
+   RISCV64op_VMAX,          /* Signed maximum. */
+   RISCV64op_VAND,          /* Bitwise AND. */
+   RISCV64op_VOR,           /* Bitwise OR. */
+   RISCV64op_VXOR,          /* Bitwise XOR. */
+   RISCV64op_VSLL,          /* Logical left shift by elements of the second
+                               input. */
+   RISCV64op_VSRL,          /* Logical right shift by elements of the second
+                               input. */
+   RISCV64op_VSRA,          /* Arithmetic right shift by elements of the second
+                               input. */
+   RISCV64op_VCMPEQ,        /* Equality comparison, producing all ones/zero per
+                               element (pseudoinstruction). */
+   RISCV64op_VCMPGTU,       /* Unsigned greater-than comparison, producing all
+                               ones/zero per element (pseudoinstruction). */
+   RISCV64op_VCMPGTS,       /* Signed greater-than comparison, producing all
+                               ones/zero per element (pseudoinstruction). */
+   RISCV64op_VPWADD,        /* Pairwise addition, the first input providing the
+                               upper half of the result (pseudoinstruction). */
+} RISCV64VecBinaryOp;
+
+/* RISCV64in_VShiftImm sub-types. */
+typedef enum {
+   RISCV64op_VSLLI = 0x1200, /* Logical left shift by an immediate. */
+   RISCV64op_VSRLI,          /* Logical right shift by an immediate. */
+   RISCV64op_VSRAI,          /* Arithmetic right shift by an immediate. */
+} RISCV64VecShiftImmOp;
+
 /* The kind of instructions. */
 typedef enum {
    RISCV64in_LI = 0x52640000, /* Load immediate pseudoinstruction. */
@@ -327,6 +469,8 @@ typedef enum {
    RISCV64in_Store,           /* Store to memory. */
    RISCV64in_LoadR,           /* Load-reserved from memory (sign-extended). */
    RISCV64in_StoreC,          /* Store-conditional to memory. */
+   RISCV64in_LoadG,           /* Guarded load from memory (sign-extended). */
+   RISCV64in_StoreG,          /* Guarded store to memory. */
    RISCV64in_CSRRW,           /* Atomic swap of values in a CSR and an integer
                                  register. */
    RISCV64in_FpUnary,         /* Floating-point unary instruction. */
@@ -340,6 +484,19 @@ typedef enum {
    RISCV64in_CAS,             /* Compare-and-swap pseudoinstruction. */
    RISCV64in_FENCE,           /* Device I/O and memory fence. */
    RISCV64in_CSEL,            /* Conditional-select pseudoinstruction. */
+   RISCV64in_VLdSt,           /* 128-bit vector load/store. */
+   RISCV64in_VMove,           /* Copy one vector register to another. */
+   RISCV64in_VUnary,          /* Vector unary instruction. */
+   RISCV64in_VBinary,         /* Vector binary instruction. */
+   RISCV64in_VShiftImm,       /* Vector shift by an immediate. */
+   RISCV64in_VDup,            /* Duplicate an integer register into all vector
+                                 elements. */
+   RISCV64in_VFromI,          /* Build a vector register from two 64-bit
+                                 integer registers (pseudoinstruction). */
+   RISCV64in_VToI,            /* Extract a 64-bit half of a vector register
+                                 (pseudoinstruction). */
+   RISCV64in_VCSEL,           /* Vector conditional-select
+                                 pseudoinstruction. */
    RISCV64in_Call,            /* Call pseudoinstruction. */
    RISCV64in_XDirect,         /* Direct transfer to guest address. */
    RISCV64in_XIndir,          /* Indirect transfer to guest address. */
@@ -381,14 +538,14 @@ typedef struct {
          RISCV64LoadOp op;
          HReg          dst;
          HReg          base;
-         Int           soff12; /* -2048 .. +2047 */
+         Int           soff12; /* -2048 .. +2047, or a far spill offset */
       } Load;
       /* Store to memory. */
       struct {
          RISCV64StoreOp op;
          HReg           src;
          HReg           base;
-         Int            soff12; /* -2048 .. +2047 */
+         Int            soff12; /* -2048 .. +2047, or a far spill offset */
       } Store;
       /* Load-reserved from memory (sign-extended). */
       struct {
@@ -403,6 +560,21 @@ typedef struct {
          HReg            src;
          HReg            addr;
       } StoreC;
+      /* Guarded load from memory (sign-extended). The destination is left
+         unchanged if the guard is zero. */
+      struct {
+         RISCV64LoadOp op;
+         HReg          dst;
+         HReg          addr;
+         HReg          guard;
+      } LoadG;
+      /* Guarded store to memory. Nothing is written if the guard is zero. */
+      struct {
+         RISCV64StoreOp op;
+         HReg           src;
+         HReg           addr;
+         HReg           guard;
+      } StoreG;
       /* Atomic swap of values in a CSR and an integer register. */
       struct {
          HReg dst;
@@ -454,7 +626,7 @@ typedef struct {
          RISCV64FpLdStOp op;
          HReg            reg; /* dst for load, src for store */
          HReg            base;
-         Int             soff12; /* -2048 .. +2047 */
+         Int             soff12; /* -2048 .. +2047, or a far spill offset */
       } FpLdSt;
       /* Floating-point conditional-select pseudoinstruction. */
       struct {
@@ -481,6 +653,69 @@ typedef struct {
          HReg iffalse;
          HReg cond;
       } CSEL;
+      /* Whole vector register load/store. The address is base+soff, where soff
+         may be any offset (it is formed in t0 when non-zero). */
+      struct {
+         RISCV64VecLdStOp op;
+         HReg             reg; /* dst for load, src for store */
+         HReg             base;
+         Int              soff;
+      } VLdSt;
+      /* Copy one vector register to another. */
+      struct {
+         HReg dst;
+         HReg src;
+      } VMove;
+      /* Vector unary instruction. All vector arithmetic is done on the full
+         128-bit register with the element width given as log2 of SEW in
+         bytes (0 = 8-bit .. 3 = 64-bit). */
+      struct {
+         RISCV64VecUnaryOp op;
+         UChar             szLg2;
+         HReg              dst;
+         HReg              src;
+      } VUnary;
+      /* Vector binary instruction. */
+      struct {
+         RISCV64VecBinaryOp op;
+         UChar              szLg2;
+         HReg               dst;
+         HReg               src1;
+         HReg               src2;
+      } VBinary;
+      /* Vector shift by an immediate. */
+      struct {
+         RISCV64VecShiftImmOp op;
+         UChar                szLg2;
+         UChar                amt; /* 0 .. 8 * (1 << szLg2) - 1 */
+         HReg                 dst;
+         HReg                 src;
+      } VShiftImm;
+      /* Duplicate an integer register into all vector elements. */
+      struct {
+         UChar szLg2;
+         HReg  dst;
+         HReg  src;
+      } VDup;
+      /* Build a vector register from two 64-bit integer registers. */
+      struct {
+         HReg dst;
+         HReg srcHi;
+         HReg srcLo;
+      } VFromI;
+      /* Extract a 64-bit half of a vector register. */
+      struct {
+         Bool hi;
+         HReg dst;
+         HReg src;
+      } VToI;
+      /* Vector conditional-select pseudoinstruction. */
+      struct {
+         HReg dst;
+         HReg iftrue;
+         HReg iffalse;
+         HReg cond;
+      } VCSEL;
       /* Call pseudoinstruction. Call a target (an absolute address), on a given
          condition register. */
       struct {
@@ -548,6 +783,10 @@ RISCV64Instr_Store(RISCV64StoreOp op, HReg src, HReg base, Int soff12);
 RISCV64Instr* RISCV64Instr_LoadR(RISCV64LoadROp op, HReg dst, HReg addr);
 RISCV64Instr*
 RISCV64Instr_StoreC(RISCV64StoreCOp op, HReg res, HReg src, HReg addr);
+RISCV64Instr*
+RISCV64Instr_LoadG(RISCV64LoadOp op, HReg dst, HReg addr, HReg guard);
+RISCV64Instr*
+RISCV64Instr_StoreG(RISCV64StoreOp op, HReg src, HReg addr, HReg guard);
 RISCV64Instr* RISCV64Instr_CSRRW(HReg dst, HReg src, UInt csr);
 RISCV64Instr* RISCV64Instr_FpUnary(RISCV64FpUnaryOp op, HReg dst, HReg src);
 RISCV64Instr*
@@ -566,6 +805,20 @@ RISCV64Instr*
 RISCV64Instr_CAS(RISCV64CASOp op, HReg old, HReg addr, HReg expd, HReg data);
 RISCV64Instr* RISCV64Instr_FENCE(void);
 RISCV64Instr* RISCV64Instr_CSEL(HReg dst, HReg iftrue, HReg iffalse, HReg cond);
+RISCV64Instr*
+RISCV64Instr_VLdSt(RISCV64VecLdStOp op, HReg reg, HReg base, Int soff);
+RISCV64Instr* RISCV64Instr_VMove(HReg dst, HReg src);
+RISCV64Instr*
+RISCV64Instr_VUnary(RISCV64VecUnaryOp op, UInt szLg2, HReg dst, HReg src);
+RISCV64Instr* RISCV64Instr_VBinary(
+   RISCV64VecBinaryOp op, UInt szLg2, HReg dst, HReg src1, HReg src2);
+RISCV64Instr* RISCV64Instr_VShiftImm(
+   RISCV64VecShiftImmOp op, UInt szLg2, HReg dst, HReg src, UInt amt);
+RISCV64Instr* RISCV64Instr_VDup(UInt szLg2, HReg dst, HReg src);
+RISCV64Instr* RISCV64Instr_VFromI(HReg dst, HReg srcHi, HReg srcLo);
+RISCV64Instr* RISCV64Instr_VToI(Bool hi, HReg dst, HReg src);
+RISCV64Instr*
+RISCV64Instr_VCSEL(HReg dst, HReg iftrue, HReg iffalse, HReg cond);
 RISCV64Instr* RISCV64Instr_Call(
    RetLoc rloc, Addr64 target, HReg cond, UChar nArgRegs, UChar nFArgRegs);
 RISCV64Instr* RISCV64Instr_XDirect(
@@ -73,9 +73,19 @@
      settings of the FPU's rounding mode, as described in
      set_fcsr_rounding_mode() below.
 
+   - A small cache of integer constants which do not fit into a sx-12-bit
+     immediate and have already been materialised in a virtual register. The
+     vcode of a superblock is straight-line (side exits only leave it), so a
+     register set earlier is valid for the rest of the block and can be reused
+     instead of repeating a lui+addi(w) or longer sequence. Entries are
+     replaced in round-robin order to bound the extra register pressure.
+
    Note, this is all (well, mostly) host-independent.
 */
 
+/* Number of entries in the constant cache of ISelEnv. */
+#define RISCV64_N_CONSTS 4
+
 typedef struct {
    /* Constant -- are set at the start and do not change. */
    IRTypeEnv* type_env;
@@ -94,6 +104,13 @@ typedef struct {
    Int          vreg_ctr;
 
    IRExpr* previous_rm;
+
+   struct {
+      ULong imm64;
+      HReg  reg;
+   } consts[RISCV64_N_CONSTS];
+   UInt n_consts;
+   UInt next_const;
 } ISelEnv;
 
 static HReg lookupIRTemp(ISelEnv* env, IRTemp tmp)
@@ -125,6 +142,13 @@ static HReg newVRegF(ISelEnv* env)
    return reg;
 }
 
+static HReg newVRegV(ISelEnv* env)
+{
+   HReg reg = mkHReg(True /*virtual*/, HRcVec128, 0, env->vreg_ctr);
+   env->vreg_ctr++;
+   return reg;
+}
+
 /*------------------------------------------------------------*/
 /*--- ISEL: Forward declarations                           ---*/
 /*------------------------------------------------------------*/
@@ -137,6 +161,7 @@ static HReg newVRegF(ISelEnv* env)
 static HReg iselIntExpr_R(ISelEnv* env, IRExpr* e);
 static void iselInt128Expr(HReg* rHi, HReg* rLo, ISelEnv* env, IRExpr* e);
 static HReg iselFltExpr(ISelEnv* env, IRExpr* e);
+static HReg iselV128Expr(ISelEnv* env, IRExpr* e);
 
 /*------------------------------------------------------------*/
 /*--- ISEL: FP rounding mode helpers                       ---*/
@@ -579,6 +604,551 @@ static Bool doHelperCall(/*OUT*/ UInt*   stackAdjustAfterCall,
    other VEX backends.
 */
 
+/* ------------------- Bit-manipulation -------------------- */
+
+/* The following helpers recognise IR trees which map directly onto a single
+   Zba/Zbb/Zbs instruction. The guest produces these shapes when decoding the
+   corresponding instructions, and they also appear in ordinary integer code
+   (address arithmetic, masking, zero-extension). */
+
+static Bool isConstU8(IRExpr* e, /*OUT*/ UInt* val)
+{
+   if (e->tag != Iex_Const || e->Iex.Const.con->tag != Ico_U8)
+      return False;
+   *val = e->Iex.Const.con->Ico.U8;
+   return True;
+}
+
+static Bool isConstU64(IRExpr* e, ULong val)
+{
+   return e->tag == Iex_Const && e->Iex.Const.con->tag == Ico_U64 &&
+          e->Iex.Const.con->Ico.U64 == val;
+}
+
+/* Check whether e is a 64-bit or 32-bit constant which fits into a sx-12-bit
+   immediate. A 32-bit constant is interpreted as sign-extended, which matches
+   how 32-bit values are kept in registers. */
+static Bool isSimm12Const(IRExpr* e, /*OUT*/ Int* imm)
+{
+   Long simm64;
+   if (e->tag != Iex_Const)
+      return False;
+   switch (e->Iex.Const.con->tag) {
+   case Ico_U64:
+      simm64 = e->Iex.Const.con->Ico.U64;
+      break;
+   case Ico_U32:
+      simm64 = vex_sx_to_64(e->Iex.Const.con->Ico.U32, 32);
+      break;
+   default:
+      return False;
+   }
+   if (simm64 < -2048 || simm64 > 2047)
+      return False;
+   *imm = simm64;
+   return True;
+}
+
+/* Find an <instr>i form which computes 'arg1 <op> arg2' when arg2 is a small
+   constant. All operands of the 32-bit operations are sign-extended, so the
+   64-bit bitwise instructions can be used for them too. */
+static Bool matchALUImm(IROp op, IRExpr* arg2, /*OUT*/ RISCV64ALUImmOp* opi,
+                        /*OUT*/ Int* imm)
+{
+   Int  simm;
+   UInt sham;
+
+   switch (op) {
+   case Iop_Add64:
+   case Iop_Add32:
+      if (!isSimm12Const(arg2, &simm))
+         return False;
+      *opi = op == Iop_Add64 ? RISCV64op_ADDI : RISCV64op_ADDIW;
+      *imm = simm;
+      return True;
+   case Iop_Sub64:
+   case Iop_Sub32:
+      if (!isSimm12Const(arg2, &simm) || simm == -2048)
+         return False;
+      *opi = op == Iop_Sub64 ? RISCV64op_ADDI : RISCV64op_ADDIW;
+      *imm = -simm;
+      return True;
+   case Iop_Xor64:
+   case Iop_Xor32:
+   case Iop_Or64:
+   case Iop_Or32:
+   case Iop_And64:
+   case Iop_And32:
+      if (!isSimm12Const(arg2, &simm))
+         return False;
+      if (op == Iop_Xor64 || op == Iop_Xor32)
+         *opi = RISCV64op_XORI;
+      else if (op == Iop_Or64 || op == Iop_Or32)
+         *opi = RISCV64op_ORI;
+      else
+         *opi = RISCV64op_ANDI;
+      *imm = simm;
+      return True;
+   case Iop_Shl64:
+   case Iop_Shr64:
+   case Iop_Sar64:
+      if (!isConstU8(arg2, &sham) || sham >= 64)
+         return False;
+      if (op == Iop_Shl64)
+         *opi = RISCV64op_SLLI;
+      else if (op == Iop_Shr64)
+         *opi = RISCV64op_SRLI;
+      else
+         *opi = RISCV64op_SRAI;
+      *imm = sham;
+      return True;
+   case Iop_Shl32:
+   case Iop_Shr32:
+   case Iop_Sar32:
+      if (!isConstU8(arg2, &sham) || sham >= 32)
+         return False;
+      if (op == Iop_Shl32)
+         *opi = RISCV64op_SLLIW;
+      else if (op == Iop_Shr32)
+         *opi = RISCV64op_SRLIW;
+      else
+         *opi = RISCV64op_SRAIW;
+      *imm = sham;
+      return True;
+   default:
+      return False;
+   }
+}
+
+static Bool isSameTmp(IRExpr* e1, IRExpr* e2)
+{
+   return e1->tag == Iex_RdTmp && e2->tag == Iex_RdTmp &&
+          e1->Iex.RdTmp.tmp == e2->Iex.RdTmp.tmp;
+}
+
+static Bool isUnop(IRExpr* e, IROp op)
+{
+   return e->tag == Iex_Unop && e->Iex.Unop.op == op;
+}
+
+static Bool isBinop(IRExpr* e, IROp op)
+{
+   return e->tag == Iex_Binop && e->Iex.Binop.op == op;
+}
+
+/* Zba/Zbb/Zbs shift and rotate instructions use only the low log2(XLEN) bits
+   of their rs2 operand. Strip any narrowing or masking of a shift amount
+   which the instruction performs implicitly. */
+static IRExpr* stripShiftAmount(IRExpr* amt, ULong mask)
+{
+   if (isUnop(amt, Iop_64to8))
+      amt = amt->Iex.Unop.arg;
+   if (isBinop(amt, Iop_And64) && amt->Iex.Binop.arg2->tag == Iex_Const &&
+       amt->Iex.Binop.arg2->Iex.Const.con->tag == Ico_U64 &&
+       (amt->Iex.Binop.arg2->Iex.Const.con->Ico.U64 & mask) == mask)
+      amt = amt->Iex.Binop.arg1;
+   return amt;
+}
+
+/* Instructions which read only the low 32 or 16 bits of their source do not
+   need any preceding narrowing of it. */
+static IRExpr* stripNarrowing(IRExpr* e, UInt bits)
+{
+   if (isUnop(e, Iop_64to32) ||
+       (bits == 16 && (isUnop(e, Iop_64to16) || isUnop(e, Iop_32to16))))
+      return e->Iex.Unop.arg;
+   return e;
+}
+
+/* Match a 64-bit constant with exactly one bit set. */
+static Bool isConstSingleBit(IRExpr* e, Bool inverted, /*OUT*/ UInt* bit)
+{
+   if (e->tag != Iex_Const || e->Iex.Const.con->tag != Ico_U64)
+      return False;
+   ULong v = e->Iex.Const.con->Ico.U64;
+   if (inverted)
+      v = ~v;
+   if (v == 0 || (v & (v - 1)) != 0)
+      return False;
+   *bit = 0;
+   while ((v & 1) == 0) {
+      v >>= 1;
+      (*bit)++;
+   }
+   return True;
+}
+
+/* Match Shl64(1, amt), the single-bit mask used by the Zbs instructions. */
+static Bool isSingleBit(IRExpr* e, /*OUT*/ IRExpr** amt)
+{
+   if (!isBinop(e, Iop_Shl64) || !isConstU64(e->Iex.Binop.arg1, 1))
+      return False;
+   *amt = e->Iex.Binop.arg2;
+   return True;
+}
+
+/* Emit a Zbs operation on src and the bit selected by amt, using the
+   immediate form when amt is a constant. */
+static HReg mk_zbs_op(ISelEnv*        env,
+                      RISCV64ALUOp    op,
+                      RISCV64ALUImmOp opi,
+                      HReg            src,
+                      IRExpr*         amt)
+{
+   HReg dst = newVRegI(env);
+   UInt imm;
+   if (isConstU8(amt, &imm) && imm < 64) {
+      addInstr(env, RISCV64Instr_ALUImm(opi, dst, src, imm));
+      return dst;
+   }
+   HReg bit = iselIntExpr_R(env, stripShiftAmount(amt, 63));
+   addInstr(env, RISCV64Instr_ALU(op, dst, src, bit));
+   return dst;
+}
+
+/* Match a rotation Or(Shl(v, l), Shr(v, r)) as produced by the guest, where
+   either both amounts are constants summing up to the width, or one amount
+   is And64(a, width-1) and the other And64(Sub64(0, a), width-1). On success,
+   return the value and the right-rotation amount (constant in *imm when
+   *is_imm) or the run-time left/right rotation amount. */
+static Bool isRotate(IRExpr*           e,
+                     Bool              is64,
+                     /*OUT*/ IRExpr**  val,
+                     /*OUT*/ Bool*     is_imm,
+                     /*OUT*/ UInt*     imm,
+                     /*OUT*/ Bool*     is_left,
+                     /*OUT*/ IRExpr**  amt)
+{
+   IROp  opOr  = is64 ? Iop_Or64 : Iop_Or32;
+   IROp  opShl = is64 ? Iop_Shl64 : Iop_Shl32;
+   IROp  opShr = is64 ? Iop_Shr64 : Iop_Shr32;
+   UInt  width = is64 ? 64 : 32;
+   ULong mask  = width - 1;
+
+   if (!isBinop(e, opOr))
+      return False;
+   IRExpr* shl = e->Iex.Binop.arg1;
+   IRExpr* shr = e->Iex.Binop.arg2;
+   if (isBinop(shl, opShr) && isBinop(shr, opShl)) {
+      IRExpr* tmp = shl;
+      shl         = shr;
+      shr         = tmp;
+   }
+   if (!isBinop(shl, opShl) || !isBinop(shr, opShr))
+      return False;
+   if (!isSameTmp(shl->Iex.Binop.arg1, shr->Iex.Binop.arg1))
+      return False;
+   *val = shl->Iex.Binop.arg1;
+
+   IRExpr* amtL = shl->Iex.Binop.arg2;
+   IRExpr* amtR = shr->Iex.Binop.arg2;
+   UInt    cL, cR;
+   if (isConstU8(amtL, &cL) && isConstU8(amtR, &cR)) {
+      if (cL + cR != width || cR == 0 || cR >= width)
+         return False;
+      *is_imm = True;
+      *imm    = cR;
+      return True;
+   }
+
+   /* Variable form: 64to8(And64(x, mask)). */
+   if (!isUnop(amtL, Iop_64to8) || !isUnop(amtR, Iop_64to8))
+      return False;
+   amtL = amtL->Iex.Unop.arg;
+   amtR = amtR->Iex.Unop.arg;
+   if (!isBinop(amtL, Iop_And64) || !isBinop(amtR, Iop_And64) ||
+       !isConstU64(amtL->Iex.Binop.arg2, mask) ||
+       !isConstU64(amtR->Iex.Binop.arg2, mask))
+      return False;
+   amtL = amtL->Iex.Binop.arg1;
+   amtR = amtR->Iex.Binop.arg1;
+   *is_imm = False;
+   if (isBinop(amtR, Iop_Sub64) && isConstU64(amtR->Iex.Binop.arg1, 0) &&
+       isSameTmp(amtR->Iex.Binop.arg2, amtL)) {
+      *is_left = True;
+      *amt     = amtL;
+      return True;
+   }
+   if (isBinop(amtL, Iop_Sub64) && isConstU64(amtL->Iex.Binop.arg1, 0) &&
+       isSameTmp(amtL->Iex.Binop.arg2, amtR)) {
+      *is_left = False;
+      *amt     = amtR;
+      return True;
+   }
+   return False;
+}
+
+/* Try to select a single Zba/Zbb/Zbs instruction for e. Return INVALID_HREG
+   if no pattern matches, or the required extension is not available. */
+static HReg iselBitmanipExpr(ISelEnv* env, IRExpr* e)
+{
+   Bool has_zba = (env->hwcaps & VEX_HWCAPS_RISCV64_ZBA) != 0;
+   Bool has_zbb = (env->hwcaps & VEX_HWCAPS_RISCV64_ZBB) != 0;
+   Bool has_zbs = (env->hwcaps & VEX_HWCAPS_RISCV64_ZBS) != 0;
+
+   switch (e->tag) {
+   case Iex_Binop: {
+      IROp    op   = e->Iex.Binop.op;
+      IRExpr* arg1 = e->Iex.Binop.arg1;
+      IRExpr* arg2 = e->Iex.Binop.arg2;
+
+      if (has_zba && op == Iop_Add64) {
+         /* sh{1,2,3}add[.uw] */
+         for (UInt i = 0; i < 2; i++) {
+            IRExpr* shl   = i == 0 ? arg1 : arg2;
+            IRExpr* other = i == 0 ? arg2 : arg1;
+            UInt    shift;
+            if (isBinop(shl, Iop_Shl64) &&
+                isConstU8(shl->Iex.Binop.arg2, &shift) && shift >= 1 &&
+                shift <= 3) {
+               IRExpr* base  = shl->Iex.Binop.arg1;
+               Bool    is_uw = isUnop(base, Iop_32Uto64);
+               if (is_uw)
+                  base = stripNarrowing(base->Iex.Unop.arg, 32);
+               static const RISCV64ALUOp ops[2][3] = {
+                  {RISCV64op_SH1ADD, RISCV64op_SH2ADD, RISCV64op_SH3ADD},
+                  {RISCV64op_SH1ADD_UW, RISCV64op_SH2ADD_UW,
+                   RISCV64op_SH3ADD_UW}};
+               HReg dst  = newVRegI(env);
+               HReg argL = iselIntExpr_R(env, base);
+               HReg argR = iselIntExpr_R(env, other);
+               addInstr(env, RISCV64Instr_ALU(ops[is_uw][shift - 1], dst, argL,
+                                              argR));
+               return dst;
+            }
+         }
+         /* add.uw */
+         for (UInt i = 0; i < 2; i++) {
+            IRExpr* ext   = i == 0 ? arg1 : arg2;
+            IRExpr* other = i == 0 ? arg2 : arg1;
+            if (isUnop(ext, Iop_32Uto64)) {
+               HReg dst  = newVRegI(env);
+               HReg argL =
+                  iselIntExpr_R(env, stripNarrowing(ext->Iex.Unop.arg, 32));
+               HReg argR = iselIntExpr_R(env, other);
+               addInstr(env,
+                        RISCV64Instr_ALU(RISCV64op_ADD_UW, dst, argL, argR));
+               return dst;
+            }
+         }
+      }
+
+      if (has_zba && op == Iop_Shl64 && isUnop(arg1, Iop_32Uto64)) {
+         /* slli.uw */
+         UInt shift;
+         if (isConstU8(arg2, &shift) && shift < 64) {
+            HReg dst = newVRegI(env);
+            HReg src =
+               iselIntExpr_R(env, stripNarrowing(arg1->Iex.Unop.arg, 32));
+            addInstr(env,
+                     RISCV64Instr_ALUImm(RISCV64op_SLLI_UW, dst, src, shift));
+            return dst;
+         }
+      }
+
+      if (has_zbs) {
+         IRExpr* amt;
+         /* bset rd, zero, rs2 */
+         if (isSingleBit(e, &amt))
+            return mk_zbs_op(env, RISCV64op_BSET, RISCV64op_BSETI,
+                             hregRISCV64_x0(), amt);
+         /* {bset,binv,bclr}[i] */
+         if (op == Iop_Or64 || op == Iop_Xor64 || op == Iop_And64) {
+            for (UInt i = 0; i < 2; i++) {
+               IRExpr* bit   = i == 0 ? arg2 : arg1;
+               IRExpr* other = i == 0 ? arg1 : arg2;
+               if (op == Iop_And64) {
+                  if (!isUnop(bit, Iop_Not64))
+                     continue;
+                  bit = bit->Iex.Unop.arg;
+               }
+               if (!isSingleBit(bit, &amt))
+                  continue;
+               HReg src = iselIntExpr_R(env, other);
+               switch (op) {
+               case Iop_Or64:
+                  return mk_zbs_op(env, RISCV64op_BSET, RISCV64op_BSETI, src,
+                                   amt);
+               case Iop_Xor64:
+                  return mk_zbs_op(env, RISCV64op_BINV, RISCV64op_BINVI, src,
+                                   amt);
+               case Iop_And64:
+                  return mk_zbs_op(env, RISCV64op_BCLR, RISCV64op_BCLRI, src,
+                                   amt);
+               default:
+                  vassert(0);
+               }
+            }
+         }
+         /* {bseti,binvi,bclri} with a constant mask */
+         if (op == Iop_Or64 || op == Iop_Xor64 || op == Iop_And64) {
+            UInt bit;
+            if (isConstSingleBit(arg2, op == Iop_And64, &bit)) {
+               RISCV64ALUImmOp opi = op == Iop_Or64    ? RISCV64op_BSETI
+                                     : op == Iop_Xor64 ? RISCV64op_BINVI
+                                                       : RISCV64op_BCLRI;
+               HReg dst = newVRegI(env);
+               HReg src = iselIntExpr_R(env, arg1);
+               addInstr(env, RISCV64Instr_ALUImm(opi, dst, src, bit));
+               return dst;
+            }
+         }
+         /* bext[i] */
+         if (op == Iop_And64 && isConstU64(arg2, 1) &&
+             isBinop(arg1, Iop_Shr64)) {
+            HReg src = iselIntExpr_R(env, arg1->Iex.Binop.arg1);
+            return mk_zbs_op(env, RISCV64op_BEXT, RISCV64op_BEXTI, src,
+                             arg1->Iex.Binop.arg2);
+         }
+      }
+
+      if (has_zbb) {
+         /* {andn,orn} */
+         if (op == Iop_And64 || op == Iop_And32 || op == Iop_Or64 ||
+             op == Iop_Or32) {
+            IROp opNot = op == Iop_And64 || op == Iop_Or64 ? Iop_Not64
+                                                           : Iop_Not32;
+            for (UInt i = 0; i < 2; i++) {
+               IRExpr* inv   = i == 0 ? arg2 : arg1;
+               IRExpr* other = i == 0 ? arg1 : arg2;
+               if (!isUnop(inv, opNot))
+                  continue;
+               HReg dst  = newVRegI(env);
+               HReg argL = iselIntExpr_R(env, other);
+               HReg argR = iselIntExpr_R(env, inv->Iex.Unop.arg);
+               addInstr(env, RISCV64Instr_ALU(op == Iop_And64 ||
+                                                    op == Iop_And32
+                                                 ? RISCV64op_ANDN
+                                                 : RISCV64op_ORN,
+                                              dst, argL, argR));
+               return dst;
+            }
+         }
+         /* {rol,ror,rori}[w] */
+         if (op == Iop_Or64 || op == Iop_Or32) {
+            Bool    is64 = op == Iop_Or64;
+            IRExpr* val;
+            IRExpr* amt;
+            Bool    is_imm, is_left;
+            UInt    imm;
+            if (isRotate(e, is64, &val, &is_imm, &imm, &is_left, &amt)) {
+               HReg dst = newVRegI(env);
+               HReg src = iselIntExpr_R(env, val);
+               if (is_imm) {
+                  addInstr(env, RISCV64Instr_ALUImm(is64 ? RISCV64op_RORI
+                                                         : RISCV64op_RORIW,
+                                                    dst, src, imm));
+               } else {
+                  RISCV64ALUOp opr =
+                     is64 ? (is_left ? RISCV64op_ROL : RISCV64op_ROR)
+                          : (is_left ? RISCV64op_ROLW : RISCV64op_RORW);
+                  HReg sh = iselIntExpr_R(env, amt);
+                  addInstr(env, RISCV64Instr_ALU(opr, dst, src, sh));
+               }
+               return dst;
+            }
+         }
+      }
+      break;
+   }
+
+   case Iex_Unop: {
+      IROp    op  = e->Iex.Unop.op;
+      IRExpr* arg = e->Iex.Unop.arg;
+
+      /* {clzw,ctzw,cpopw} produce a small non-negative result, its
+         zero-extension is a no-op */
+      if (has_zbb && op == Iop_32Uto64 &&
+          (isUnop(arg, Iop_ClzNat32) || isUnop(arg, Iop_CtzNat32) ||
+           isUnop(arg, Iop_PopCount32))) {
+         RISCV64ALUImmOp opi = isUnop(arg, Iop_ClzNat32)   ? RISCV64op_CLZW
+                               : isUnop(arg, Iop_CtzNat32) ? RISCV64op_CTZW
+                                                           : RISCV64op_CPOPW;
+         HReg dst = newVRegI(env);
+         HReg src = iselIntExpr_R(env, stripNarrowing(arg->Iex.Unop.arg, 32));
+         addInstr(env, RISCV64Instr_ALUImm(opi, dst, src, 0));
+         return dst;
+      }
+
+      /* zext.w, an alias of add.uw rd, rs1, zero */
+      if (has_zba && op == Iop_32Uto64) {
+         HReg dst = newVRegI(env);
+         HReg src = iselIntExpr_R(env, stripNarrowing(arg, 32));
+         addInstr(env, RISCV64Instr_ALU(RISCV64op_ADD_UW, dst, src,
+                                        hregRISCV64_x0()));
+         return dst;
+      }
+
+      if (has_zbb) {
+         RISCV64ALUImmOp opi;
+         switch (op) {
+         case Iop_16Uto64:
+            opi = RISCV64op_ZEXT_H;
+            break;
+         case Iop_32to16:
+         case Iop_64to16:
+            opi = RISCV64op_SEXT_H;
+            break;
+         case Iop_32to8:
+         case Iop_64to8:
+            opi = RISCV64op_SEXT_B;
+            break;
+         case Iop_Not64:
+         case Iop_Not32:
+            /* xnor */
+            if (isBinop(arg, op == Iop_Not64 ? Iop_Xor64 : Iop_Xor32)) {
+               HReg dst  = newVRegI(env);
+               HReg argL = iselIntExpr_R(env, arg->Iex.Binop.arg1);
+               HReg argR = iselIntExpr_R(env, arg->Iex.Binop.arg2);
+               addInstr(env, RISCV64Instr_ALU(RISCV64op_XNOR, dst, argL, argR));
+               return dst;
+            }
+            return INVALID_HREG;
+         default:
+            return INVALID_HREG;
+         }
+         HReg dst = newVRegI(env);
+         HReg src = iselIntExpr_R(
+            env, opi == RISCV64op_ZEXT_H ? stripNarrowing(arg, 16) : arg);
+         addInstr(env, RISCV64Instr_ALUImm(opi, dst, src, 0));
+         return dst;
+      }
+      break;
+   }
+
+   case Iex_ITE: {
+      /* {min,minu,max,maxu} */
+      IRExpr* cond = e->Iex.ITE.cond;
+      if (has_zbb && typeOfIRExpr(env->type_env, e) == Ity_I64 &&
+          (isBinop(cond, Iop_CmpLT64S) || isBinop(cond, Iop_CmpLT64U))) {
+         IRExpr* a         = cond->Iex.Binop.arg1;
+         IRExpr* b         = cond->Iex.Binop.arg2;
+         Bool    is_signed = cond->Iex.Binop.op == Iop_CmpLT64S;
+         RISCV64ALUOp opm;
+         if (isSameTmp(e->Iex.ITE.iftrue, a) &&
+             isSameTmp(e->Iex.ITE.iffalse, b))
+            opm = is_signed ? RISCV64op_MIN : RISCV64op_MINU;
+         else if (isSameTmp(e->Iex.ITE.iftrue, b) &&
+                  isSameTmp(e->Iex.ITE.iffalse, a))
+            opm = is_signed ? RISCV64op_MAX : RISCV64op_MAXU;
+         else
+            break;
+         HReg dst  = newVRegI(env);
+         HReg argL = iselIntExpr_R(env, a);
+         HReg argR = iselIntExpr_R(env, b);
+         addInstr(env, RISCV64Instr_ALU(opm, dst, argL, argR));
+         return dst;
+      }
+      break;
+   }
+
+   default:
+      break;
+   }
+
+   return INVALID_HREG;
+}
+
 /* -------------------------- Reg --------------------------- */
 
 /* DO NOT CALL THIS DIRECTLY ! */
@@ -588,6 +1158,13 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
    vassert(ty == Ity_I64 || ty == Ity_I32 || ty == Ity_I16 || ty == Ity_I8 ||
            ty == Ity_I1);
 
+   if (env->hwcaps & (VEX_HWCAPS_RISCV64_ZBA | VEX_HWCAPS_RISCV64_ZBB |
+                      VEX_HWCAPS_RISCV64_ZBS)) {
+      HReg r = iselBitmanipExpr(env, e);
+      if (!hregIsInvalid(r))
+         return r;
+   }
+
    switch (e->tag) {
    /* ------------------------ TEMP ------------------------- */
    case Iex_RdTmp: {
@@ -618,7 +1195,6 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
 
    /* ---------------------- BINARY OP ---------------------- */
    case Iex_Binop: {
-      /* TODO Optimize for small imms by generating <instr>i. */
       switch (e->Iex.Binop.op) {
       case Iop_Add64:
       case Iop_Add32:
@@ -711,9 +1287,29 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
          default:
             vassert(0);
          }
+
+         /* Use the <instr>i form if one operand is a small constant. */
+         IRExpr*         arg1 = e->Iex.Binop.arg1;
+         IRExpr*         arg2 = e->Iex.Binop.arg2;
+         RISCV64ALUImmOp opi;
+         Int             imm;
+         if (arg1->tag == Iex_Const && arg2->tag != Iex_Const &&
+             (op == RISCV64op_ADD || op == RISCV64op_ADDW ||
+              op == RISCV64op_XOR || op == RISCV64op_OR ||
+              op == RISCV64op_AND)) {
+            arg1 = e->Iex.Binop.arg2;
+            arg2 = e->Iex.Binop.arg1;
+         }
+         if (matchALUImm(e->Iex.Binop.op, arg2, &opi, &imm)) {
+            HReg dst = newVRegI(env);
+            HReg src = iselIntExpr_R(env, arg1);
+            addInstr(env, RISCV64Instr_ALUImm(opi, dst, src, imm));
+            return dst;
+         }
+
          HReg dst  = newVRegI(env);
-         HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
-         HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
+         HReg argL = iselIntExpr_R(env, arg1);
+         HReg argR = iselIntExpr_R(env, arg2);
          addInstr(env, RISCV64Instr_ALU(op, dst, argL, argR));
          return dst;
       }
@@ -721,10 +1317,23 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
       case Iop_CmpEQ32:
       case Iop_CasCmpEQ64:
       case Iop_CasCmpEQ32: {
-         HReg tmp  = newVRegI(env);
-         HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
-         HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
-         addInstr(env, RISCV64Instr_ALU(RISCV64op_SUB, tmp, argL, argR));
+         /* A comparison against zero, as in the checks of SC, needs no
+            subtraction. A small constant is subtracted with addi. */
+         HReg tmp = iselIntExpr_R(env, e->Iex.Binop.arg1);
+         Int  imm;
+         if (isSimm12Const(e->Iex.Binop.arg2, &imm) && imm != -2048) {
+            if (imm != 0) {
+               HReg argL = tmp;
+               tmp       = newVRegI(env);
+               addInstr(env,
+                        RISCV64Instr_ALUImm(RISCV64op_ADDI, tmp, argL, -imm));
+            }
+         } else {
+            HReg argL = tmp;
+            HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
+            tmp       = newVRegI(env);
+            addInstr(env, RISCV64Instr_ALU(RISCV64op_SUB, tmp, argL, argR));
+         }
          HReg dst = newVRegI(env);
          addInstr(env, RISCV64Instr_ALUImm(RISCV64op_SLTIU, dst, tmp, 1));
          return dst;
@@ -733,10 +1342,21 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
       case Iop_CmpNE32:
       case Iop_CasCmpNE64:
       case Iop_CasCmpNE32: {
-         HReg tmp  = newVRegI(env);
-         HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
-         HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
-         addInstr(env, RISCV64Instr_ALU(RISCV64op_SUB, tmp, argL, argR));
+         HReg tmp = iselIntExpr_R(env, e->Iex.Binop.arg1);
+         Int  imm;
+         if (isSimm12Const(e->Iex.Binop.arg2, &imm) && imm != -2048) {
+            if (imm != 0) {
+               HReg argL = tmp;
+               tmp       = newVRegI(env);
+               addInstr(env,
+                        RISCV64Instr_ALUImm(RISCV64op_ADDI, tmp, argL, -imm));
+            }
+         } else {
+            HReg argL = tmp;
+            HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
+            tmp       = newVRegI(env);
+            addInstr(env, RISCV64Instr_ALU(RISCV64op_SUB, tmp, argL, argR));
+         }
          HReg dst = newVRegI(env);
          addInstr(env,
                   RISCV64Instr_ALU(RISCV64op_SLTU, dst, hregRISCV64_x0(), tmp));
@@ -744,6 +1364,13 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
       }
       case Iop_CmpLT64S:
       case Iop_CmpLT32S: {
+         Int imm;
+         if (isSimm12Const(e->Iex.Binop.arg2, &imm)) {
+            HReg dst  = newVRegI(env);
+            HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
+            addInstr(env, RISCV64Instr_ALUImm(RISCV64op_SLTI, dst, argL, imm));
+            return dst;
+         }
          HReg dst  = newVRegI(env);
          HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
          HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
@@ -752,6 +1379,15 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
       }
       case Iop_CmpLE64S:
       case Iop_CmpLE32S: {
+         /* x <=s imm is the same as x <s imm+1. */
+         Int imm;
+         if (isSimm12Const(e->Iex.Binop.arg2, &imm) && imm != 2047) {
+            HReg dst  = newVRegI(env);
+            HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
+            addInstr(env,
+                     RISCV64Instr_ALUImm(RISCV64op_SLTI, dst, argL, imm + 1));
+            return dst;
+         }
          HReg tmp  = newVRegI(env);
          HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
          HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
@@ -762,6 +1398,16 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
       }
       case Iop_CmpLT64U:
       case Iop_CmpLT32U: {
+         /* sltiu compares with the sign-extended immediate, which is also the
+            register form of a 32-bit constant. */
+         Int imm;
+         if (isSimm12Const(e->Iex.Binop.arg2, &imm)) {
+            HReg dst  = newVRegI(env);
+            HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
+            addInstr(env,
+                     RISCV64Instr_ALUImm(RISCV64op_SLTIU, dst, argL, imm));
+            return dst;
+         }
          HReg dst  = newVRegI(env);
          HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
          HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
@@ -770,6 +1416,16 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
       }
       case Iop_CmpLE64U:
       case Iop_CmpLE32U: {
+         /* x <=u imm is the same as x <u imm+1, unless imm is all ones. */
+         Int imm;
+         if (isSimm12Const(e->Iex.Binop.arg2, &imm) && imm != -1 &&
+             imm != 2047) {
+            HReg dst  = newVRegI(env);
+            HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
+            addInstr(env,
+                     RISCV64Instr_ALUImm(RISCV64op_SLTIU, dst, argL, imm + 1));
+            return dst;
+         }
          HReg tmp  = newVRegI(env);
          HReg argL = iselIntExpr_R(env, e->Iex.Binop.arg1);
          HReg argR = iselIntExpr_R(env, e->Iex.Binop.arg2);
@@ -1022,6 +1678,22 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
          iselInt128Expr(&rHi, &rLo, env, e->Iex.Unop.arg);
          return rHi; /* and abandon rLo */
       }
+      case Iop_V128to64:
+      case Iop_V128HIto64: {
+         HReg dst = newVRegI(env);
+         HReg src = iselV128Expr(env, e->Iex.Unop.arg);
+         addInstr(env, RISCV64Instr_VToI(e->Iex.Unop.op == Iop_V128HIto64, dst,
+                                         src));
+         return dst;
+      }
+      case Iop_V128to32: {
+         HReg tmp = newVRegI(env);
+         HReg src = iselV128Expr(env, e->Iex.Unop.arg);
+         addInstr(env, RISCV64Instr_VToI(False /*hi*/, tmp, src));
+         HReg dst = newVRegI(env);
+         addInstr(env, RISCV64Instr_ALUImm(RISCV64op_ADDIW, dst, tmp, 0));
+         return dst;
+      }
       case Iop_64HIto32: {
          HReg dst = newVRegI(env);
          HReg src = iselIntExpr_R(env, e->Iex.Unop.arg);
@@ -1063,6 +1735,48 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
          addInstr(env, RISCV64Instr_ALUImm(RISCV64op_SRAI, dst, or, 63));
          return dst;
       }
+      case Iop_ClzNat64:
+      case Iop_ClzNat32:
+      case Iop_CtzNat64:
+      case Iop_CtzNat32:
+      case Iop_PopCount64:
+      case Iop_PopCount32:
+      case Iop_Reverse8sIn64_x1: {
+         /* The guest only produces these when decoding Zbb instructions,
+            which means the host has Zbb too. */
+         vassert(env->hwcaps & VEX_HWCAPS_RISCV64_ZBB);
+         RISCV64ALUImmOp op;
+         switch (e->Iex.Unop.op) {
+         case Iop_ClzNat64:
+            op = RISCV64op_CLZ;
+            break;
+         case Iop_ClzNat32:
+            op = RISCV64op_CLZW;
+            break;
+         case Iop_CtzNat64:
+            op = RISCV64op_CTZ;
+            break;
+         case Iop_CtzNat32:
+            op = RISCV64op_CTZW;
+            break;
+         case Iop_PopCount64:
+            op = RISCV64op_CPOP;
+            break;
+         case Iop_PopCount32:
+            op = RISCV64op_CPOPW;
+            break;
+         case Iop_Reverse8sIn64_x1:
+            op = RISCV64op_REV8;
+            break;
+         default:
+            vassert(0);
+         }
+         /* The W variants read only the lower 32 bits of their source. */
+         HReg dst = newVRegI(env);
+         HReg src = iselIntExpr_R(env, stripNarrowing(e->Iex.Unop.arg, 32));
+         addInstr(env, RISCV64Instr_ALUImm(op, dst, src, 0));
+         return dst;
+      }
       case Iop_Left32:
       case Iop_Left64: {
          /* Left32/64(src) = src | -src. */
@@ -1143,7 +1857,6 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
    /* 64/32/16/8-bit literals. */
    case Iex_Const: {
       ULong u;
-      HReg  dst = newVRegI(env);
       switch (e->Iex.Const.con->tag) {
       case Ico_U64:
          u = e->Iex.Const.con->Ico.U64;
@@ -1167,6 +1880,26 @@ static HReg iselIntExpr_R_wrk(ISelEnv* env, IRExpr* e)
       default:
          goto irreducible;
       }
+
+      /* Reuse a wide constant if it is already available in a register. */
+      Long simm64 = u;
+      if (simm64 < -2048 || simm64 > 2047) {
+         for (UInt j = 0; j < env->n_consts; j++) {
+            if (env->consts[j].imm64 == u)
+               return env->consts[j].reg;
+         }
+         HReg dst = newVRegI(env);
+         addInstr(env, RISCV64Instr_LI(dst, u));
+         UInt j = env->next_const;
+         env->consts[j].imm64 = u;
+         env->consts[j].reg   = dst;
+         env->next_const      = (j + 1) % RISCV64_N_CONSTS;
+         if (env->n_consts < RISCV64_N_CONSTS)
+            env->n_consts++;
+         return dst;
+      }
+
+      HReg dst = newVRegI(env);
       addInstr(env, RISCV64Instr_LI(dst, u));
       return dst;
    }
@@ -1588,6 +2321,521 @@ static HReg iselFltExpr(ISelEnv* env, IRExpr* e)
    return r;
 }
 
+/*------------------------------------------------------------*/
+/*--- ISEL: Vector expressions (128 bit)                   ---*/
+/*------------------------------------------------------------*/
+
+/* Vector values are held in the RVV registers. The backend assumes VLEN=128,
+   so that a V128 value fills exactly one register. Each instruction sets vl and
+   vtype for its element width, see emit_RISCV64Instr(). The guest only
+   produces V128 IR when the V extension is available, which is then available
+   on the host as well. */
+
+/* Get a 64-bit constant into an integer register. */
+static HReg mk_iconst64(ISelEnv* env, ULong imm)
+{
+   if (imm == 0)
+      return hregRISCV64_x0();
+   HReg dst = newVRegI(env);
+   addInstr(env, RISCV64Instr_LI(dst, imm));
+   return dst;
+}
+
+/* DO NOT CALL THIS DIRECTLY ! */
+static HReg iselV128Expr_wrk(ISelEnv* env, IRExpr* e)
+{
+   IRType ty = typeOfIRExpr(env->type_env, e);
+   vassert(ty == Ity_V128);
+   vassert(env->hwcaps & VEX_HWCAPS_RISCV64_V);
+
+   switch (e->tag) {
+   /* ------------------------ TEMP ------------------------- */
+   case Iex_RdTmp: {
+      return lookupIRTemp(env, e->Iex.RdTmp.tmp);
+   }
+
+   /* ------------------------ LOAD ------------------------- */
+   case Iex_Load: {
+      if (e->Iex.Load.end != Iend_LE)
+         goto irreducible;
+
+      HReg dst  = newVRegV(env);
+      HReg addr = iselIntExpr_R(env, e->Iex.Load.addr);
+      addInstr(env, RISCV64Instr_VLdSt(RISCV64op_VLE8, dst, addr, 0));
+      return dst;
+   }
+
+   /* ------------------------- GET ------------------------- */
+   case Iex_Get: {
+      HReg dst  = newVRegV(env);
+      HReg base = get_baseblock_register();
+      Int  off  = e->Iex.Get.offset - BASEBLOCK_OFFSET_ADJUSTMENT;
+      addInstr(env, RISCV64Instr_VLdSt(RISCV64op_VLE8, dst, base, off));
+      return dst;
+   }
+
+   /* ----------------------- LITERAL ----------------------- */
+   case Iex_Const: {
+      /* Each bit of the constant selects whether the corresponding byte is
+         0x00 or 0xff. */
+      vassert(e->Iex.Const.con->tag == Ico_V128);
+      UShort con = e->Iex.Const.con->Ico.V128;
+      HReg   dst = newVRegV(env);
+      if (con == 0x0000 || con == 0xffff) {
+         HReg src = mk_iconst64(env, con == 0 ? 0 : ~0ULL);
+         addInstr(env, RISCV64Instr_VDup(3, dst, src));
+         return dst;
+      }
+      ULong w[2] = {0, 0};
+      for (UInt i = 0; i < 16; i++)
+         if (con & (1 << i))
+            w[i / 8] |= 0xffULL << (8 * (i % 8));
+      addInstr(env, RISCV64Instr_VFromI(dst, mk_iconst64(env, w[1]),
+                                        mk_iconst64(env, w[0])));
+      return dst;
+   }
+
+   /* ---------------------- BINARY OP ---------------------- */
+   case Iex_Binop: {
+      RISCV64VecBinaryOp op;
+      UInt               szLg2;
+      switch (e->Iex.Binop.op) {
+      case Iop_64HLtoV128: {
+         HReg srcHi = iselIntExpr_R(env, e->Iex.Binop.arg1);
+         HReg srcLo = iselIntExpr_R(env, e->Iex.Binop.arg2);
+         HReg dst   = newVRegV(env);
+         addInstr(env, RISCV64Instr_VFromI(dst, srcHi, srcLo));
+         return dst;
+      }
+      case Iop_ShlN8x16:
+      case Iop_ShlN16x8:
+      case Iop_ShlN32x4:
+      case Iop_ShlN64x2:
+      case Iop_ShrN8x16:
+      case Iop_ShrN16x8:
+      case Iop_ShrN32x4:
+      case Iop_ShrN64x2:
+      case Iop_SarN8x16:
+      case Iop_SarN16x8:
+      case Iop_SarN32x4:
+      case Iop_SarN64x2: {
+         RISCV64VecShiftImmOp sop;
+         switch (e->Iex.Binop.op) {
+         case Iop_ShlN8x16:
+            sop = RISCV64op_VSLLI, szLg2 = 0;
+            break;
+         case Iop_ShlN16x8:
+            sop = RISCV64op_VSLLI, szLg2 = 1;
+            break;
+         case Iop_ShlN32x4:
+            sop = RISCV64op_VSLLI, szLg2 = 2;
+            break;
+         case Iop_ShlN64x2:
+            sop = RISCV64op_VSLLI, szLg2 = 3;
+            break;
+         case Iop_ShrN8x16:
+            sop = RISCV64op_VSRLI, szLg2 = 0;
+            break;
+         case Iop_ShrN16x8:
+            sop = RISCV64op_VSRLI, szLg2 = 1;
+            break;
+         case Iop_ShrN32x4:
+            sop = RISCV64op_VSRLI, szLg2 = 2;
+            break;
+         case Iop_ShrN64x2:
+            sop = RISCV64op_VSRLI, szLg2 = 3;
+            break;
+         case Iop_SarN8x16:
+            sop = RISCV64op_VSRAI, szLg2 = 0;
+            break;
+         case Iop_SarN16x8:
+            sop = RISCV64op_VSRAI, szLg2 = 1;
+            break;
+         case Iop_SarN32x4:
+            sop = RISCV64op_VSRAI, szLg2 = 2;
+            break;
+         case Iop_SarN64x2:
+            sop = RISCV64op_VSRAI, szLg2 = 3;
+            break;
+         default:
+            vassert(0);
+         }
+         /* Only constant shift amounts are handled. An amount of the lane
+            width or more gives zero, or the sign for an arithmetic shift. */
+         IRExpr* amt = e->Iex.Binop.arg2;
+         if (amt->tag != Iex_Const || amt->Iex.Const.con->tag != Ico_U8)
+            goto irreducible;
+         UInt n     = amt->Iex.Const.con->Ico.U8;
+         UInt nbits = 8 << szLg2;
+         HReg src   = iselV128Expr(env, e->Iex.Binop.arg1);
+         HReg dst   = newVRegV(env);
+         if (n >= nbits) {
+            if (sop != RISCV64op_VSRAI) {
+               addInstr(env, RISCV64Instr_VDup(3, dst, hregRISCV64_x0()));
+               return dst;
+            }
+            n = nbits - 1;
+         }
+         addInstr(env, RISCV64Instr_VShiftImm(sop, szLg2, dst, src, n));
+         return dst;
+      }
+      case Iop_AndV128:
+         op = RISCV64op_VAND, szLg2 = 3;
+         break;
+      case Iop_OrV128:
+         op = RISCV64op_VOR, szLg2 = 3;
+         break;
+      case Iop_XorV128:
+         op = RISCV64op_VXOR, szLg2 = 3;
+         break;
+      case Iop_Add8x16:
+         op = RISCV64op_VADD, szLg2 = 0;
+         break;
+      case Iop_Add16x8:
+         op = RISCV64op_VADD, szLg2 = 1;
+         break;
+      case Iop_Add32x4:
+         op = RISCV64op_VADD, szLg2 = 2;
+         break;
+      case Iop_Add64x2:
+         op = RISCV64op_VADD, szLg2 = 3;
+         break;
+      case Iop_Sub8x16:
+         op = RISCV64op_VSUB, szLg2 = 0;
+         break;
+      case Iop_Sub16x8:
+         op = RISCV64op_VSUB, szLg2 = 1;
+         break;
+      case Iop_Sub32x4:
+         op = RISCV64op_VSUB, szLg2 = 2;
+         break;
+      case Iop_Sub64x2:
+         op = RISCV64op_VSUB, szLg2 = 3;
+         break;
+      case Iop_QAdd8Ux16:
+         op = RISCV64op_VSADDU, szLg2 = 0;
+         break;
+      case Iop_QAdd16Ux8:
+         op = RISCV64op_VSADDU, szLg2 = 1;
+         break;
+      case Iop_QAdd32Ux4:
+         op = RISCV64op_VSADDU, szLg2 = 2;
+         break;
+      case Iop_QAdd64Ux2:
+         op = RISCV64op_VSADDU, szLg2 = 3;
+         break;
+      case Iop_QAdd8Sx16:
+         op = RISCV64op_VSADD, szLg2 = 0;
+         break;
+      case Iop_QAdd16Sx8:
+         op = RISCV64op_VSADD, szLg2 = 1;
+         break;
+      case Iop_QAdd32Sx4:
+         op = RISCV64op_VSADD, szLg2 = 2;
+         break;
+      case Iop_QAdd64Sx2:
+         op = RISCV64op_VSADD, szLg2 = 3;
+         break;
+      case Iop_QSub8Ux16:
+         op = RISCV64op_VSSUBU, szLg2 = 0;
+         break;
+      case Iop_QSub16Ux8:
+         op = RISCV64op_VSSUBU, szLg2 = 1;
+         break;
+      case Iop_QSub32Ux4:
+         op = RISCV64op_VSSUBU, szLg2 = 2;
+         break;
+      case Iop_QSub64Ux2:
+         op = RISCV64op_VSSUBU, szLg2 = 3;
+         break;
+      case Iop_QSub8Sx16:
+         op = RISCV64op_VSSUB, szLg2 = 0;
+         break;
+      case Iop_QSub16Sx8:
+         op = RISCV64op_VSSUB, szLg2 = 1;
+         break;
+      case Iop_QSub32Sx4:
+         op = RISCV64op_VSSUB, szLg2 = 2;
+         break;
+      case Iop_QSub64Sx2:
+         op = RISCV64op_VSSUB, szLg2 = 3;
+         break;
+      case Iop_Mul8x16:
+         op = RISCV64op_VMUL, szLg2 = 0;
+         break;
+      case Iop_Mul16x8:
+         op = RISCV64op_VMUL, szLg2 = 1;
+         break;
+      case Iop_Mul32x4:
+         op = RISCV64op_VMUL, szLg2 = 2;
+         break;
+      case Iop_MulHi8Ux16:
+         op = RISCV64op_VMULHU, szLg2 = 0;
+         break;
+      case Iop_MulHi16Ux8:
+         op = RISCV64op_VMULHU, szLg2 = 1;
+         break;
+      case Iop_MulHi32Ux4:
+         op = RISCV64op_VMULHU, szLg2 = 2;
+         break;
+      case Iop_MulHi8Sx16:
+         op = RISCV64op_VMULH, szLg2 = 0;
+         break;
+      case Iop_MulHi16Sx8:
+         op = RISCV64op_VMULH, szLg2 = 1;
+         break;
+      case Iop_MulHi32Sx4:
+         op = RISCV64op_VMULH, szLg2 = 2;
+         break;
+      case Iop_Min8Ux16:
+         op = RISCV64op_VMINU, szLg2 = 0;
+         break;
+      case Iop_Min16Ux8:
+         op = RISCV64op_VMINU, szLg2 = 1;
+         break;
+      case Iop_Min32Ux4:
+         op = RISCV64op_VMINU, szLg2 = 2;
+         break;
+      case Iop_Min64Ux2:
+         op = RISCV64op_VMINU, szLg2 = 3;
+         break;
+      case Iop_Min8Sx16:
+         op = RISCV64op_VMIN, szLg2 = 0;
+         break;
+      case Iop_Min16Sx8:
+         op = RISCV64op_VMIN, szLg2 = 1;
+         break;
+      case Iop_Min32Sx4:
+         op = RISCV64op_VMIN, szLg2 = 2;
+         break;
+      case Iop_Min64Sx2:
+         op = RISCV64op_VMIN, szLg2 = 3;
+         break;
+      case Iop_Max8Ux16:
+         op = RISCV64op_VMAXU, szLg2 = 0;
+         break;
+      case Iop_Max16Ux8:
+         op = RISCV64op_VMAXU, szLg2 = 1;
+         break;
+      case Iop_Max32Ux4:
+         op = RISCV64op_VMAXU, szLg2 = 2;
+         break;
+      case Iop_Max64Ux2:
+         op = RISCV64op_VMAXU, szLg2 = 3;
+         break;
+      case Iop_Max8Sx16:
+         op = RISCV64op_VMAX, szLg2 = 0;
+         break;
+      case Iop_Max16Sx8:
+         op = RISCV64op_VMAX, szLg2 = 1;
+         break;
+      case Iop_Max32Sx4:
+         op = RISCV64op_VMAX, szLg2 = 2;
+         break;
+      case Iop_Max64Sx2:
+         op = RISCV64op_VMAX, szLg2 = 3;
+         break;
+      case Iop_Shl8x16:
+         op = RISCV64op_VSLL, szLg2 = 0;
+         break;
+      case Iop_Shl16x8:
+         op = RISCV64op_VSLL, szLg2 = 1;
+         break;
+      case Iop_Shl32x4:
+         op = RISCV64op_VSLL, szLg2 = 2;
+         break;
+      case Iop_Shl64x2:
+         op = RISCV64op_VSLL, szLg2 = 3;
+         break;
+      case Iop_Shr8x16:
+         op = RISCV64op_VSRL, szLg2 = 0;
+         break;
+      case Iop_Shr16x8:
+         op = RISCV64op_VSRL, szLg2 = 1;
+         break;
+      case Iop_Shr32x4:
+         op = RISCV64op_VSRL, szLg2 = 2;
+         break;
+      case Iop_Shr64x2:
+         op = RISCV64op_VSRL, szLg2 = 3;
+         break;
+      case Iop_Sar8x16:
+         op = RISCV64op_VSRA, szLg2 = 0;
+         break;
+      case Iop_Sar16x8:
+         op = RISCV64op_VSRA, szLg2 = 1;
+         break;
+      case Iop_Sar32x4:
+         op = RISCV64op_VSRA, szLg2 = 2;
+         break;
+      case Iop_Sar64x2:
+         op = RISCV64op_VSRA, szLg2 = 3;
+         break;
+      case Iop_CmpEQ8x16:
+         op = RISCV64op_VCMPEQ, szLg2 = 0;
+         break;
+      case Iop_CmpEQ16x8:
+         op = RISCV64op_VCMPEQ, szLg2 = 1;
+         break;
+      case Iop_CmpEQ32x4:
+         op = RISCV64op_VCMPEQ, szLg2 = 2;
+         break;
+      case Iop_CmpEQ64x2:
+         op = RISCV64op_VCMPEQ, szLg2 = 3;
+         break;
+      case Iop_CmpGT8Ux16:
+         op = RISCV64op_VCMPGTU, szLg2 = 0;
+         break;
+      case Iop_CmpGT16Ux8:
+         op = RISCV64op_VCMPGTU, szLg2 = 1;
+         break;
+      case Iop_CmpGT32Ux4:
+         op = RISCV64op_VCMPGTU, szLg2 = 2;
+         break;
+      case Iop_CmpGT64Ux2:
+         op = RISCV64op_VCMPGTU, szLg2 = 3;
+         break;
+      case Iop_CmpGT8Sx16:
+         op = RISCV64op_VCMPGTS, szLg2 = 0;
+         break;
+      case Iop_CmpGT16Sx8:
+         op = RISCV64op_VCMPGTS, szLg2 = 1;
+         break;
+      case Iop_CmpGT32Sx4:
+         op = RISCV64op_VCMPGTS, szLg2 = 2;
+         break;
+      case Iop_CmpGT64Sx2:
+         op = RISCV64op_VCMPGTS, szLg2 = 3;
+         break;
+      case Iop_PwAdd8x16:
+         op = RISCV64op_VPWADD, szLg2 = 0;
+         break;
+      case Iop_PwAdd16x8:
+         op = RISCV64op_VPWADD, szLg2 = 1;
+         break;
+      case Iop_PwAdd32x4:
+         op = RISCV64op_VPWADD, szLg2 = 2;
+         break;
+      default:
+         goto irreducible;
+      }
+      HReg src1 = iselV128Expr(env, e->Iex.Binop.arg1);
+      HReg src2 = iselV128Expr(env, e->Iex.Binop.arg2);
+      HReg dst  = newVRegV(env);
+      addInstr(env, RISCV64Instr_VBinary(op, szLg2, dst, src1, src2));
+      return dst;
+   }
+
+   /* ---------------------- UNARY OP ----------------------- */
+   case Iex_Unop: {
+      switch (e->Iex.Unop.op) {
+      case Iop_NotV128: {
+         HReg src = iselV128Expr(env, e->Iex.Unop.arg);
+         HReg dst = newVRegV(env);
+         addInstr(env, RISCV64Instr_VUnary(RISCV64op_VNOT, 3, dst, src));
+         return dst;
+      }
+      case Iop_CmpNEZ8x16:
+      case Iop_CmpNEZ16x8:
+      case Iop_CmpNEZ32x4:
+      case Iop_CmpNEZ64x2: {
+         UInt szLg2;
+         switch (e->Iex.Unop.op) {
+         case Iop_CmpNEZ8x16:
+            szLg2 = 0;
+            break;
+         case Iop_CmpNEZ16x8:
+            szLg2 = 1;
+            break;
+         case Iop_CmpNEZ32x4:
+            szLg2 = 2;
+            break;
+         case Iop_CmpNEZ64x2:
+            szLg2 = 3;
+            break;
+         default:
+            vassert(0);
+         }
+         HReg src = iselV128Expr(env, e->Iex.Unop.arg);
+         HReg dst = newVRegV(env);
+         addInstr(env, RISCV64Instr_VUnary(RISCV64op_VCMPNEZ, szLg2, dst, src));
+         return dst;
+      }
+      case Iop_Dup8x16:
+      case Iop_Dup16x8:
+      case Iop_Dup32x4: {
+         UInt szLg2 = e->Iex.Unop.op == Iop_Dup8x16   ? 0
+                      : e->Iex.Unop.op == Iop_Dup16x8 ? 1
+                                                      : 2;
+         HReg src   = iselIntExpr_R(env, e->Iex.Unop.arg);
+         HReg dst   = newVRegV(env);
+         addInstr(env, RISCV64Instr_VDup(szLg2, dst, src));
+         return dst;
+      }
+      case Iop_64UtoV128: {
+         HReg src = iselIntExpr_R(env, e->Iex.Unop.arg);
+         HReg dst = newVRegV(env);
+         addInstr(env, RISCV64Instr_VFromI(dst, hregRISCV64_x0(), src));
+         return dst;
+      }
+      case Iop_32UtoV128: {
+         HReg src = iselIntExpr_R(env, e->Iex.Unop.arg);
+         HReg tmp = newVRegI(env);
+         addInstr(env, RISCV64Instr_ALUImm(RISCV64op_SLLI, tmp, src, 32));
+         HReg lo = newVRegI(env);
+         addInstr(env, RISCV64Instr_ALUImm(RISCV64op_SRLI, lo, tmp, 32));
+         HReg dst = newVRegV(env);
+         addInstr(env, RISCV64Instr_VFromI(dst, hregRISCV64_x0(), lo));
+         return dst;
+      }
+      case Iop_ZeroHI64ofV128: {
+         HReg src = iselV128Expr(env, e->Iex.Unop.arg);
+         HReg lo  = newVRegI(env);
+         addInstr(env, RISCV64Instr_VToI(False /*hi*/, lo, src));
+         HReg dst = newVRegV(env);
+         addInstr(env, RISCV64Instr_VFromI(dst, hregRISCV64_x0(), lo));
+         return dst;
+      }
+      default:
+         break;
+      }
+      break;
+   }
+
+   /* ---------------------- MULTIPLEX ---------------------- */
+   case Iex_ITE: {
+      /* ITE(ccexpr, iftrue, iffalse) */
+      HReg cond    = iselIntExpr_R(env, e->Iex.ITE.cond);
+      HReg iftrue  = iselV128Expr(env, e->Iex.ITE.iftrue);
+      HReg iffalse = iselV128Expr(env, e->Iex.ITE.iffalse);
+      HReg dst     = newVRegV(env);
+      addInstr(env, RISCV64Instr_VCSEL(dst, iftrue, iffalse, cond));
+      return dst;
+   }
+
+   default:
+      break;
+   }
+
+irreducible:
+   ppIRExpr(e);
+   vpanic("iselV128Expr(riscv64)");
+}
+
+/* Compute a V128 value into a vector register, the identity of which is
+   returned. As with iselIntExpr_R, the register will be virtual and must not be
+   changed by subsequent code emitted by the caller. */
+static HReg iselV128Expr(ISelEnv* env, IRExpr* e)
+{
+   HReg r = iselV128Expr_wrk(env, e);
+
+   /* Sanity checks ... */
+   vassert(hregClass(r) == HRcVec128);
+   vassert(hregIsVirtual(r));
+
+   return r;
+}
+
 /*------------------------------------------------------------*/
 /*--- ISEL: Statements                                     ---*/
 /*------------------------------------------------------------*/
@@ -1634,9 +2882,98 @@ static void iselStmt(ISelEnv* env, IRStmt* stmt)
             vassert(0);
          return;
       }
+      if (tyd == Ity_V128) {
+         HReg src  = iselV128Expr(env, stmt->Ist.Store.data);
+         HReg addr = iselIntExpr_R(env, stmt->Ist.Store.addr);
+         addInstr(env, RISCV64Instr_VLdSt(RISCV64op_VSE8, src, addr, 0));
+         return;
+      }
       break;
    }
 
+   /* ----------------------- LOADG ------------------------- */
+   /* Guarded little-endian read from memory. */
+   case Ist_LoadG: {
+      IRLoadG* lg = stmt->Ist.LoadG.details;
+      if (lg->end != Iend_LE)
+         break;
+
+      RISCV64LoadOp op;
+      UInt          shift = 0;
+      switch (lg->cvt) {
+      case ILGop_Ident64:
+         op = RISCV64op_LD;
+         break;
+      case ILGop_Ident32:
+         op = RISCV64op_LW;
+         break;
+      case ILGop_16Uto32:
+         op    = RISCV64op_LH;
+         shift = 48;
+         break;
+      case ILGop_16Sto32:
+         op = RISCV64op_LH;
+         break;
+      case ILGop_8Uto32:
+         op    = RISCV64op_LB;
+         shift = 56;
+         break;
+      case ILGop_8Sto32:
+         op = RISCV64op_LB;
+         break;
+      default:
+         goto stmt_fail;
+      }
+
+      /* Start from the alternative value so that a false guard leaves it in
+         place, then widen only what was actually loaded. */
+      HReg alt   = iselIntExpr_R(env, lg->alt);
+      HReg addr  = iselIntExpr_R(env, lg->addr);
+      HReg guard = iselIntExpr_R(env, lg->guard);
+      HReg tmp   = newVRegI(env);
+      addInstr(env, RISCV64Instr_MV(tmp, alt));
+      addInstr(env, RISCV64Instr_LoadG(op, tmp, addr, guard));
+
+      HReg dst = lookupIRTemp(env, lg->dst);
+      if (shift == 0) {
+         addInstr(env, RISCV64Instr_MV(dst, tmp));
+         return;
+      }
+      HReg sll = newVRegI(env);
+      addInstr(env, RISCV64Instr_ALUImm(RISCV64op_SLLI, sll, tmp, shift));
+      HReg ext = newVRegI(env);
+      addInstr(env, RISCV64Instr_ALUImm(RISCV64op_SRLI, ext, sll, shift));
+      addInstr(env, RISCV64Instr_CSEL(dst, ext, alt, guard));
+      return;
+   }
+
+   /* ----------------------- STOREG ------------------------ */
+   /* Guarded little-endian write to memory. */
+   case Ist_StoreG: {
+      IRStoreG* sg = stmt->Ist.StoreG.details;
+      if (sg->end != Iend_LE)
+         break;
+
+      IRType         tyd = typeOfIRExpr(env->type_env, sg->data);
+      RISCV64StoreOp op;
+      if (tyd == Ity_I64)
+         op = RISCV64op_SD;
+      else if (tyd == Ity_I32)
+         op = RISCV64op_SW;
+      else if (tyd == Ity_I16)
+         op = RISCV64op_SH;
+      else if (tyd == Ity_I8)
+         op = RISCV64op_SB;
+      else
+         break;
+
+      HReg src   = iselIntExpr_R(env, sg->data);
+      HReg addr  = iselIntExpr_R(env, sg->addr);
+      HReg guard = iselIntExpr_R(env, sg->guard);
+      addInstr(env, RISCV64Instr_StoreG(op, src, addr, guard));
+      return;
+   }
+
    /* ------------------------- PUT ------------------------- */
    /* Write guest state, fixed offset. */
    case Ist_Put: {
@@ -1673,6 +3010,13 @@ static void iselStmt(ISelEnv* env, IRStmt* stmt)
             vassert(0);
          return;
       }
+      if (tyd == Ity_V128) {
+         HReg src  = iselV128Expr(env, stmt->Ist.Put.data);
+         HReg base = get_baseblock_register();
+         Int  off  = stmt->Ist.Put.offset - BASEBLOCK_OFFSET_ADJUSTMENT;
+         addInstr(env, RISCV64Instr_VLdSt(RISCV64op_VSE8, src, base, off));
+         return;
+      }
       break;
    }
 
@@ -1693,6 +3037,12 @@ static void iselStmt(ISelEnv* env, IRStmt* stmt)
          addInstr(env, RISCV64Instr_FpMove(RISCV64op_FMV_D, dst, src));
          return;
       }
+      if (ty == Ity_V128) {
+         HReg dst = lookupIRTemp(env, stmt->Ist.WrTmp.tmp);
+         HReg src = iselV128Expr(env, stmt->Ist.WrTmp.data);
+         addInstr(env, RISCV64Instr_VMove(dst, src));
+         return;
+      }
       break;
    }
 
@@ -1707,7 +3057,7 @@ static void iselStmt(ISelEnv* env, IRStmt* stmt)
          retty = typeOfIRTemp(env->type_env, d->tmp);
 
       if (retty != Ity_INVALID && retty != Ity_I8 && retty != Ity_I16 &&
-          retty != Ity_I32 && retty != Ity_I64)
+          retty != Ity_I32 && retty != Ity_I64 && retty != Ity_V128)
          goto stmt_fail;
 
       /* Marshal args and do the call. */
@@ -1718,7 +3068,7 @@ static void iselStmt(ISelEnv* env, IRStmt* stmt)
       if (!ok)
          goto stmt_fail;
       vassert(is_sane_RetLoc(rloc));
-      vassert(addToSp == 0);
+      vassert(addToSp == 0 || retty == Ity_V128);
 
       /* Now figure out what to do with the returned value, if any. */
       switch (retty) {
@@ -1756,6 +3106,18 @@ static void iselStmt(ISelEnv* env, IRStmt* stmt)
          addInstr(env, RISCV64Instr_MV(dst, hregRISCV64_x10()));
          return;
       }
+      /* The returned value is on the stack. Load it into the register
+         associated with tmp and release the stack space. */
+      case Ity_V128: {
+         vassert(rloc.pri == RLPri_V128SpRel);
+         vassert(addToSp == 16);
+         HReg dst = lookupIRTemp(env, d->tmp);
+         addInstr(env, RISCV64Instr_VLdSt(RISCV64op_VLE8, dst,
+                                          hregRISCV64_x2(), rloc.spOff));
+         addInstr(env, RISCV64Instr_ALUImm(RISCV64op_ADDI, hregRISCV64_x2(),
+                                           hregRISCV64_x2(), addToSp));
+         return;
+      }
       default:
          vassert(0);
       }
@@ -2044,6 +3406,8 @@ HInstrArray* iselSB_RISCV64(const IRSB*        bb,
    env->chainingAllowed = chainingAllowed;
    env->hwcaps          = archinfo_host->hwcaps;
    env->previous_rm     = NULL;
+   env->n_consts        = 0;
+   env->next_const      = 0;
    env->max_ga          = max_ga;
 
    /* For each IR temporary, allocate a suitably-kinded virtual register. */
@@ -2066,6 +3430,9 @@ HInstrArray* iselSB_RISCV64(const IRSB*        bb,
       case Ity_F64:
          hreg = mkHReg(True, HRcFlt64, 0, j++);
          break;
+      case Ity_V128:
+         hreg = mkHReg(True, HRcVec128, 0, j++);
+         break;
       default:
          ppIRType(bb->tyenv->types[i]);
          vpanic("iselBB(riscv64): IRTemp type");
@@ -2000,7 +2000,28 @@ static const HChar* show_hwcaps_mips64 ( UInt hwcaps )
 
 static const HChar* show_hwcaps_riscv64 ( UInt hwcaps )
 {
-   return "riscv64";
+   static const HChar prefix[] = "riscv64";
+   static const struct {
+      UInt  hwcaps_bit;
+      HChar name[4];
+   } hwcaps_list[] = {
+      { VEX_HWCAPS_RISCV64_V,   "v" },
+      { VEX_HWCAPS_RISCV64_ZBA, "zba" },
+      { VEX_HWCAPS_RISCV64_ZBB, "zbb" },
+      { VEX_HWCAPS_RISCV64_ZBS, "zbs" },
+   };
+
+   static HChar buf[sizeof prefix +                       // '\0'
+                    NUM_HWCAPS * (sizeof hwcaps_list[0].name + 1) + 1];
+
+   HChar *p = buf + vex_sprintf(buf, "%s", prefix);
+   UInt i;
+   for (i = 0 ; i < NUM_HWCAPS; ++i) {
+      if (hwcaps & hwcaps_list[i].hwcaps_bit)
+         p = p + vex_sprintf(p, "-%s", hwcaps_list[i].name);
+   }
+
+   return buf;
 }
 
 #undef NUM_HWCAPS
@@ -2283,7 +2304,8 @@ static void check_hwcaps ( VexArch arch, UInt hwcaps )
          invalid_hwcaps(arch, hwcaps, "Unsupported baseline\n");
 
       case VexArchRISCV64:
-         if (hwcaps == 0)
+         if ((hwcaps & ~(VEX_HWCAPS_RISCV64_V | VEX_HWCAPS_RISCV64_ZBA |
+                         VEX_HWCAPS_RISCV64_ZBB | VEX_HWCAPS_RISCV64_ZBS)) == 0)
             return;
          invalid_hwcaps(arch, hwcaps, "Cannot handle capabilities\n");
 
@@ -230,6 +230,12 @@ typedef
 #define VEX_HWCAPS_ARM64_FP16        (1 << 14)
 #define VEX_HWCAPS_ARM64_VFP16       (1 << 15)
 
+/* riscv64: baseline capability is RV64GC. */
+#define VEX_HWCAPS_RISCV64_V         (1 << 0) /* Vector extension, VLEN=128 */
+#define VEX_HWCAPS_RISCV64_ZBA       (1 << 1) /* Address generation */
+#define VEX_HWCAPS_RISCV64_ZBB       (1 << 2) /* Basic bit-manipulation */
+#define VEX_HWCAPS_RISCV64_ZBS       (1 << 3) /* Single-bit instructions */
+
 /* MIPS baseline capability */
 /* Assigned Company values for bits 23:16 of the PRId Register
    (CP0 register 15, select 0).  As of the MIPS32 and MIPS64 specs from
@@ -123,13 +123,51 @@ typedef struct {
       wrap-style redirects, not for replace-style ones. */
    /* 560 */ ULong guest_NRADDR;
 
-   /* Fallback LL/SC support. */
+   /* LR/SC reservation, see the LR and SC translation in
+      guest_riscv64_toIR.c. LLSC_SIZE is reset by the dispatcher each time
+      execution leaves generated code. */
    /* 568 */ ULong guest_LLSC_SIZE; /* 0==no transaction, else 4 or 8. */
    /* 576 */ ULong guest_LLSC_ADDR; /* Address of the transaction. */
    /* 584 */ ULong guest_LLSC_DATA; /* Original value at ADDR, sign-extended. */
 
+   /* Vector state (V extension, VLEN=128). */
+   /* 592 */ ULong guest_vl;
+   /* 600 */ ULong guest_vtype;
+   /*  608 */ U128  guest_v0;
+   /*  624 */ U128  guest_v1;
+   /*  640 */ U128  guest_v2;
+   /*  656 */ U128  guest_v3;
+   /*  672 */ U128  guest_v4;
+   /*  688 */ U128  guest_v5;
+   /*  704 */ U128  guest_v6;
+   /*  720 */ U128  guest_v7;
+   /*  736 */ U128  guest_v8;
+   /*  752 */ U128  guest_v9;
+   /*  768 */ U128  guest_v10;
+   /*  784 */ U128  guest_v11;
+   /*  800 */ U128  guest_v12;
+   /*  816 */ U128  guest_v13;
+   /*  832 */ U128  guest_v14;
+   /*  848 */ U128  guest_v15;
+   /*  864 */ U128  guest_v16;
+   /*  880 */ U128  guest_v17;
+   /*  896 */ U128  guest_v18;
+   /*  912 */ U128  guest_v19;
+   /*  928 */ U128  guest_v20;
+   /*  944 */ U128  guest_v21;
+   /*  960 */ U128  guest_v22;
+   /*  976 */ U128  guest_v23;
+   /*  992 */ U128  guest_v24;
+   /* 1008 */ U128  guest_v25;
+   /* 1024 */ U128  guest_v26;
+   /* 1040 */ U128  guest_v27;
+   /* 1056 */ U128  guest_v28;
+   /* 1072 */ U128  guest_v29;
+   /* 1088 */ U128  guest_v30;
+   /* 1104 */ U128  guest_v31;
+
    /* Padding to 16 bytes. */
-   /* 592 */
+   /* 1120 */
 } VexGuestRISCV64State;
 
 /*------------------------------------------------------------*/
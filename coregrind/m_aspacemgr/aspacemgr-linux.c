@@ -1117,22 +1117,28 @@ inline static Int find_nsegment_idx ( Addr a )
 
    ix = (a >> 12) % N_CACHE;
 
+   /* Read the entry once.  Tool helper threads (memcheck's parallel
+      leak search) look segments up concurrently, so the entry may
+      change under our feet; the range check below validates whatever
+      index we read. */
+   Int segidx = cache_segidx[ix];
    if ((a >> 12) == cache_pageno[ix]
-       && cache_segidx[ix] >= 0
-       && cache_segidx[ix] < nsegments_used
-       && nsegments[cache_segidx[ix]].start <= a
-       && a <= nsegments[cache_segidx[ix]].end) {
+       && segidx >= 0
+       && segidx < nsegments_used
+       && nsegments[segidx].start <= a
+       && a <= nsegments[segidx].end) {
       /* hit */
-      /* aspacem_assert( cache_segidx[ix] == find_nsegment_idx_WRK(a) ); */
-      return cache_segidx[ix];
+      /* aspacem_assert( segidx == find_nsegment_idx_WRK(a) ); */
+      return segidx;
    }
    /* miss */
 #  ifdef N_Q_M_STATS
    n_m++;
 #  endif
-   cache_segidx[ix] = find_nsegment_idx_WRK(a);
+   segidx = find_nsegment_idx_WRK(a);
+   cache_segidx[ix] = segidx;
    cache_pageno[ix] = a >> 12;
-   return cache_segidx[ix];
+   return segidx;
 #  undef N_CACHE
 }
 
@@ -708,6 +708,9 @@ struct _DebugInfo {
    /* The file's soname. */
    HChar* soname;
 
+   /* The object's build-id as a hex string, or NULL if it has none. */
+   HChar* buildid;
+
    /* Description of some important mapped segments.  The presence or
       absence of the mapping is denoted by the _present field, since
       in some obscure circumstances (to do with data/sdata/bss) it is
@@ -2971,6 +2971,11 @@ Bool ML_(read_elf_object) ( struct _DebugInfo* di )
       }
    }
 
+   /* TOPLEVEL */
+   /* Note the build-id, which names the object's code for the
+      translation cache (m_transcache). */
+   di->buildid = find_buildid(mimg, False, False);
+
    retval = True;
 
  out:
@@ -517,7 +517,7 @@ Int VG_(machine_arm_archlevel) = 4;
    testing, so we need a VG_MINIMAL_JMP_BUF. */
 #if defined(VGA_ppc32) || defined(VGA_ppc64be) || defined(VGA_ppc64le) \
     || defined(VGA_arm) || defined(VGA_s390x) || defined(VGA_mips32) \
-    || defined(VGA_mips64) || defined(VGA_arm64)
+    || defined(VGA_mips64) || defined(VGA_arm64) || defined(VGA_riscv64)
 #include "pub_core_libcsetjmp.h"
 static VG_MINIMAL_JMP_BUF(env_unsup_insn);
 static void handler_unsup_insn ( Int x ) {
@@ -2282,12 +2282,89 @@ Bool VG_(machine_get_hwcaps)( void )
 
 #elif defined(VGA_riscv64)
    {
+     vki_sigset_t          saved_set, tmp_set;
+     vki_sigaction_fromK_t saved_sigill_act;
+     vki_sigaction_toK_t   tmp_sigill_act;
+
+     volatile Bool have_V, have_Zba, have_Zbb, have_Zbs;
+     Int r;
+
+     vg_assert(sizeof(vki_sigaction_fromK_t) == sizeof(vki_sigaction_toK_t));
+
+     VG_(sigemptyset)(&tmp_set);
+     VG_(sigaddset)(&tmp_set, VKI_SIGILL);
+
+     r = VG_(sigprocmask)(VKI_SIG_UNBLOCK, &tmp_set, &saved_set);
+     vg_assert(r == 0);
+
+     r = VG_(sigaction)(VKI_SIGILL, NULL, &saved_sigill_act);
+     vg_assert(r == 0);
+     tmp_sigill_act = saved_sigill_act;
+
+     /* NODEFER: signal handler does not return (from the kernel's point of
+        view), hence if it is to successfully catch a signal more than once,
+        we need the NODEFER flag. */
+     tmp_sigill_act.sa_flags &= ~VKI_SA_RESETHAND;
+     tmp_sigill_act.sa_flags &= ~VKI_SA_SIGINFO;
+     tmp_sigill_act.sa_flags |=  VKI_SA_NODEFER;
+     tmp_sigill_act.ksa_handler = handler_unsup_insn;
+     r = VG_(sigaction)(VKI_SIGILL, &tmp_sigill_act, NULL);
+     vg_assert(r == 0);
+
+     /* V insns. The guest vector unit is emulated with VLEN=128 regardless
+        of the host VLEN, so only the presence of the extension matters. */
+     have_V = True;
+     if (VG_MINIMAL_SETJMP(env_unsup_insn)) {
+        have_V = False;
+     } else {
+        __asm__ __volatile__(".word 0x0c0072d7" /* vsetvli t0, zero, e8, m1 */
+                             ::: "t0");
+     }
+
+     /* Zba insns */
+     have_Zba = True;
+     if (VG_MINIMAL_SETJMP(env_unsup_insn)) {
+        have_Zba = False;
+     } else {
+        __asm__ __volatile__(".word 0x200022b3" /* sh1add t0, zero, zero */
+                             ::: "t0");
+     }
+
+     /* Zbb insns */
+     have_Zbb = True;
+     if (VG_MINIMAL_SETJMP(env_unsup_insn)) {
+        have_Zbb = False;
+     } else {
+        __asm__ __volatile__(".word 0x60001293" /* clz t0, zero */
+                             ::: "t0");
+     }
+
+     /* Zbs insns */
+     have_Zbs = True;
+     if (VG_MINIMAL_SETJMP(env_unsup_insn)) {
+        have_Zbs = False;
+     } else {
+        __asm__ __volatile__(".word 0x280012b3" /* bset t0, zero, zero */
+                             ::: "t0");
+     }
+
+     r = VG_(sigaction)(VKI_SIGILL, &saved_sigill_act, NULL);
+     vg_assert(r == 0);
+     r = VG_(sigprocmask)(VKI_SIG_SETMASK, &saved_set, NULL);
+     vg_assert(r == 0);
+
      va = VexArchRISCV64;
      vai.endness = VexEndnessLE;
 
      /* Hardware baseline is RV64GC. */
      vai.hwcaps = 0;
+     if (have_V)   vai.hwcaps |= VEX_HWCAPS_RISCV64_V;
+     if (have_Zba) vai.hwcaps |= VEX_HWCAPS_RISCV64_ZBA;
+     if (have_Zbb) vai.hwcaps |= VEX_HWCAPS_RISCV64_ZBB;
+     if (have_Zbs) vai.hwcaps |= VEX_HWCAPS_RISCV64_ZBS;
 
+     VG_(debugLog)(1, "machine", "V %d Zba %d Zbb %d Zbs %d\n", (Int)have_V,
+                   (Int)have_Zba, (Int)have_Zbb, (Int)have_Zbs);
      VG_(debugLog)(1, "machine", "hwcaps = 0x%x\n", vai.hwcaps);
 
      VG_(machine_get_cache_info)(&vai);
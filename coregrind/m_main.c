@@ -63,6 +63,7 @@
 #include "pub_core_translate.h"     // For VG_(translate)
 #include "pub_core_trampoline.h"
 #include "pub_core_transtab.h"
+#include "pub_core_transcache.h"
 #include "pub_core_inner.h"
 #if defined(ENABLE_INNER_CLIENT_REQUEST)
 #include "pub_core_clreq.h"
@@ -213,6 +214,8 @@ static void usage_NORETURN ( int need_help )
 "    --scheduling-quantum=<number>  thread-scheduling timeslice in number of\n"
 "           basic blocks [100000]\n"
 "    --fair-sched=no|yes|try   schedule threads fairly on multicore systems [no]\n"
+"    --parallel-threads=no|yes run generated code of several threads at once,\n"
+"                              if the tool supports it; implies --vgdb=no [no]\n"
 "    --kernel-variant=variant1,variant2,...\n"
 "         handle non-standard kernel variants [none]\n"
 "         where variant is one of:\n"
@@ -224,6 +227,8 @@ static void usage_NORETURN ( int need_help )
 "           more sectors may increase performance, but use more memory.\n"
 "    --avg-transtab-entry-size=<number> avg size in bytes of a translated\n"
 "           basic block [0, meaning use tool provided default]\n"
+"    --translation-cache=<dir> keep translations of shared objects in <dir>\n"
+"           for reuse by later runs, if the tool supports it [none]\n"
 "    --aspace-minaddr=0xPP     avoid mapping memory below 0xPP [guessed]\n"
 "    --valgrind-stacksize=<number> size of valgrind (host) thread's stack\n"
 "                               (in bytes) ["
@@ -663,6 +668,7 @@ static void process_option (Clo_Mode mode,
          VG_(fmsg_bad_option)(arg,
             "Bad argument, should be 'yes', 'try' or 'no'\n");
    }
+   else if VG_BOOL_CLO(arg, "--parallel-threads", VG_(clo_parallel_threads)) {}
    else if VG_BOOL_CLOM(cloPD, arg, "--trace-sched",      VG_(clo_trace_sched)) {}
    else if VG_BOOL_CLOM(cloPD, arg, "--trace-signals",    VG_(clo_trace_signals)) {}
    else if VG_BOOL_CLOM(cloPD, arg, "--trace-symtab",     VG_(clo_trace_symtab)) {}
@@ -709,6 +715,8 @@ static void process_option (Clo_Mode mode,
    else if VG_BINT_CLO(arg, "--avg-transtab-entry-size",
                        VG_(clo_avg_transtab_entry_size),
                        50, 5000) {}
+   else if VG_STR_CLO (arg, "--translation-cache",
+                       VG_(clo_translation_cache)) {}
    else if VG_BINT_CLOM(cloPD, arg, "--merge-recursive-frames",
                         VG_(clo_merge_recursive_frames), 0,
                         VG_DEEPEST_BACKTRACE) {}
@@ -1079,6 +1087,47 @@ void main_process_cmd_line_options( void )
       /*NOTREACHED*/
    }
 
+   /* Likewise for running threads in parallel.  The gdbserver expects
+      all other threads to be stopped while it runs, so it is disabled
+      in that mode.  On riscv64, LR/SC is emulated with a reservation in
+      the guest state which is only dropped when a thread leaves
+      generated code; an SC would then miss stores done meanwhile by
+      threads running in parallel. */
+   if (VG_(clo_parallel_threads)) {
+      if (!VG_(needs).parallel_threads) {
+         VG_(clo_parallel_threads) = False;
+         VG_(fmsg_bad_option)("--parallel-threads=yes",
+            "%s does not support running threads in parallel.\n",
+            VG_(details).name);
+         /*NOTREACHED*/
+      }
+#     if defined(VGA_riscv64)
+      VG_(clo_parallel_threads) = False;
+      VG_(fmsg_bad_option)("--parallel-threads=yes",
+         "Running threads in parallel is not supported on riscv64.\n");
+      /*NOTREACHED*/
+#     endif
+      VG_(clo_vgdb) = Vg_VgdbNo;
+   }
+
+   /* Likewise for reusing translations from earlier runs. */
+   if (VG_(clo_translation_cache)) {
+      const HChar*   dir = VG_(clo_translation_cache);
+      struct vg_stat st;
+      if (!VG_(needs).translation_cache) {
+         VG_(clo_translation_cache) = NULL;
+         VG_(fmsg_bad_option)("--translation-cache",
+            "%s does not support a translation cache.\n",
+            VG_(details).name);
+         /*NOTREACHED*/
+      } else if (sr_isError(VG_(stat)(dir, &st)) || !VKI_S_ISDIR(st.mode)) {
+         VG_(clo_translation_cache) = NULL;
+         VG_(fmsg_bad_option)("--translation-cache",
+            "'%s' is not a directory.\n", dir);
+         /*NOTREACHED*/
+      }
+   }
+
    vg_assert( VG_(clo_gen_suppressions) >= 0 );
    vg_assert( VG_(clo_gen_suppressions) <= 2 );
 
@@ -1839,6 +1888,16 @@ Int valgrind_main ( Int argc, HChar **argv, HChar **envp )
    VG_(debugLog)(1, "main", "Initialise TT/TC\n");
    VG_(init_tt_tc)();
 
+   //--------------------------------------------------------------
+   // Initialise the cache of translations from earlier runs
+   //   p: main_process_cmd_line_options [for VG_(clo_translation_cache)]
+   //   p: tl_post_clo_init [so the tool's options are final]
+   //--------------------------------------------------------------
+   if (VG_(clo_translation_cache)) {
+      VG_(debugLog)(1, "main", "Initialise translation cache\n");
+      VG_(init_transcache)();
+   }
+
    //--------------------------------------------------------------
    // Initialise the redirect table.
    //   p: init_tt_tc [so it can call VG_(search_transtab) safely]
@@ -2347,6 +2406,9 @@ void shutdown_actions_NORETURN( ThreadId tid,
 
    VG_(sanity_check_general)( True /*include expensive checks*/ );
 
+   if (VG_(clo_translation_cache))
+      VG_(save_transcache)();
+
    if (VG_(clo_stats))
       VG_(print_all_stats)(VG_(clo_verbosity) >= 1, /* Memory stats */
                            False /* tool prints stats in the tool fini */);
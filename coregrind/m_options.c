@@ -151,6 +151,7 @@ Bool   VG_(clo_debug_dump_frames) = False;
 Bool   VG_(clo_trace_redir)    = False;
 enum FairSchedType
        VG_(clo_fair_sched)     = disable_fair_sched;
+Bool   VG_(clo_parallel_threads) = False;
 /* VG_(clo_scheduling_quantum) defines the thread-scheduling timeslice,
    in terms of the number of basic blocks we attempt to run each thread for.
    Smaller values give finer interleaving but much increased scheduling
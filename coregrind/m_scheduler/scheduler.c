@@ -45,6 +45,11 @@
    the_BigLock, and re-takes it when it becomes runnable again (either
    because the syscall finished, or we took a signal).
 
+   With --parallel-threads=yes, and a tool which declares it can cope,
+   a thread also releases the_BigLock while it runs generated code, so
+   that several threads can do so at once.  See "Parallel execution of
+   generated code" below.
+
    VG_(scheduler) therefore runs in each thread.  It returns only when
    the thread is exiting, either because it exited itself, or it was
    told to exit by another thread.
@@ -69,6 +74,7 @@
 #include "pub_core_extension.h"
 #include "pub_core_gdbserver.h"  // for VG_(gdbserver)/VG_(gdbserver_activity)
 #include "pub_core_libcbase.h"
+#include "pub_core_libcfile.h"    // VG_(pipe)
 #include "pub_core_libcassert.h"
 #include "pub_core_libcprint.h"
 #include "pub_core_libcproc.h"
@@ -133,6 +139,10 @@ static ULong stats__n_xIndir_hits2 = 0;
 static ULong stats__n_xIndir_hits3 = 0;
 static ULong stats__n_xIndir_misses = 0;
 
+/* Number of times VG_(stop_parallel_threads) had to wait for threads
+   running in parallel. */
+static ULong stats__n_parallel_stops = 0;
+
 /* And 32-bit temp bins for the above, so that 32-bit platforms don't
    have to do 64 bit incs on the hot path through
    VG_(disp_cp_xindir). */
@@ -169,6 +179,24 @@ void VG_(print_scheduler_stats)(void)
                 stats__n_xIndir_hits3,
                 stats__n_xIndir_misses);
 
+   for (ThreadId tid = 1; tid < VG_N_THREADS; tid++) {
+      const ThreadState* tst = &VG_(threads)[tid];
+      if (tst->n_xIndirs == 0)
+         continue;
+      const ULong hits = tst->n_xIndirs - tst->n_xIndir_misses;
+      const ULong permille = hits * 1000 / tst->n_xIndirs;
+      VG_(message)(Vg_DebugMsg,
+                   "scheduler: thread %u: %'llu indir transfers, "
+                   "%'llu misses, %llu.%llu%% fast-cache hit rate\n",
+                   tid, tst->n_xIndirs, tst->n_xIndir_misses,
+                   permille / 10, permille % 10);
+   }
+
+   if (VG_(clo_parallel_threads))
+      VG_(message)(Vg_DebugMsg,
+                   "scheduler: %'llu stops of parallel threads\n",
+                   stats__n_parallel_stops);
+
    VG_(message)(Vg_DebugMsg,
       "scheduler: %'llu/%'llu major/minor sched events.\n",
       n_scheduling_events_MAJOR, n_scheduling_events_MINOR);
@@ -435,6 +463,278 @@ Bool VG_(owns_BigLock_LL) ( ThreadId tid )
 }
 
 
+
+/* ---------------------------------------------------------------------
+   Parallel execution of generated code (--parallel-threads=yes).
+
+   In this mode a thread drops the_BigLock for the duration of each
+   call to VG_(disp_run_translations), so that several threads can run
+   generated code at the same time.  Everything else -- translation,
+   syscalls, signal delivery, client requests, tool callbacks -- still
+   happens with the_BigLock held.
+
+   Generated code touches only the guest state and memory and the
+   thread's own fast cache, none of which the core changes on behalf of
+   another thread.  The exception is code that might be executing:
+   chaining and unchaining translations, discarding them and recycling
+   a sector.  m_transtab calls VG_(stop_parallel_threads) before doing
+   any of those.  That waits until no thread is left in generated code,
+   and since threads only go back in while holding the_BigLock, none
+   can until the caller releases it.
+
+   A thread which takes a synchronous signal while in generated code
+   re-acquires the_BigLock in the signal handler, so the handling is as
+   in the serial case.  It can't stay counted while it waits for the
+   lock, since a thread holding the lock may be waiting in
+   VG_(stop_parallel_threads) for it.  Instead, it first pins the
+   translation cache sector of the faulting code, so that the handler
+   can safely return there even if other threads patched or discarded
+   translations meanwhile: the code of a discarded translation stays in
+   place until its sector is recycled.
+   ------------------------------------------------------------------ */
+
+/* Number of threads running generated code without the_BigLock.
+   Incremented with the_BigLock held, decremented without it. */
+static volatile UInt n_parallel_threads = 0;
+
+static void do_sched_yield ( void )
+{
+   /* 
+      Tell the kernel we're yielding.
+    */
+#  if defined(VGO_linux) || defined(VGO_darwin) || defined(VGO_freebsd)
+   VG_(do_syscall0)(__NR_sched_yield);
+#  elif defined(VGO_solaris)
+   VG_(do_syscall0)(__NR_yield);
+#  else
+#    error Unknown OS
+#  endif
+}
+
+/* Drop the sector pin taken by VG_(leave_parallel_code), if any. */
+static void unpin_sector ( ThreadState* tst )
+{
+   VG_(unpin_tc_sector)(tst->pinned_sector);
+   tst->pinned_sector = INV_SNO;
+}
+
+/* See pub_core_scheduler.h for description */
+void VG_(enter_parallel_code) ( ThreadId tid )
+{
+   ThreadState* tst = VG_(get_ThreadState)(tid);
+
+   vg_assert(VG_(clo_parallel_threads));
+   vg_assert(VG_(is_running_thread)(tid));
+   vg_assert(VG_(in_generated_code));
+   vg_assert(!tst->in_parallel_code);
+
+   /* Going back to the faulting code after a signal.  Once counted
+      again, the thread is protected by VG_(stop_parallel_threads). */
+   unpin_sector(tst);
+
+   __sync_fetch_and_add(&n_parallel_threads, 1);
+   tst->in_parallel_code = True;
+
+   /* The thread stays Runnable, but no longer owns the_BigLock. */
+   VG_(in_generated_code) = False;
+   VG_(running_tid) = VG_INVALID_THREADID;
+   VG_(release_BigLock_LL)(NULL);
+}
+
+/* See pub_core_scheduler.h for description */
+Bool VG_(leave_parallel_code) ( ThreadId tid, Addr fault_hcode )
+{
+   ThreadState* tst = VG_(get_ThreadState)(tid);
+
+   if (!tst->in_parallel_code) {
+      /* Back from a signal handler which took the_BigLock and then
+         longjmp'd out of the generated code. */
+      unpin_sector(tst);
+      return False;
+   }
+
+   vg_assert(tst->pinned_sector == INV_SNO);
+   if (fault_hcode != 0)
+      tst->pinned_sector = VG_(pin_tc_sector)(fault_hcode);
+
+   tst->in_parallel_code = False;
+   __sync_fetch_and_sub(&n_parallel_threads, 1);
+
+   VG_(acquire_BigLock_LL)(NULL);
+   vg_assert(tst->status == VgTs_Runnable);
+   vg_assert(VG_(running_tid) == VG_INVALID_THREADID);
+   VG_(running_tid) = tid;
+   vg_assert(!VG_(in_generated_code));
+   VG_(in_generated_code) = True;
+   return True;
+}
+
+/* See pub_core_scheduler.h for description */
+void VG_(stop_parallel_threads) ( void )
+{
+   ThreadId tid;
+
+   if (n_parallel_threads == 0)
+      return;
+
+   vg_assert(VG_(running_tid) != VG_INVALID_THREADID);
+   stats__n_parallel_stops++;
+
+   while (n_parallel_threads > 0) {
+      /* Make the threads fail their next event check.  Their own
+         decrement of the counter may overwrite this, so keep at it
+         until they are all out. */
+      for (tid = 1; tid < VG_N_THREADS; tid++) {
+         if (VG_(threads)[tid].in_parallel_code)
+            VG_(threads)[tid].arch.vex.host_EvC_COUNTER = 0;
+      }
+      do_sched_yield();
+   }
+   __sync_synchronize();
+}
+
+
+/* ---------------------------------------------------------------------
+   Helper threads for tools.
+
+   VG_(run_in_helper_threads) lets a tool spread a piece of work over
+   several host threads, e.g. memcheck's leak search with
+   --leak-check-threads=N.  The helpers are bare host threads started
+   with VG_(start_helper_thread) the first time they are needed, and
+   kept for the next time.  Each sleeps on a pipe until it is given a
+   job, and reports on another pipe when it has finished.  Helpers
+   never touch the_BigLock: the caller holds it throughout, so the job
+   must only read what the rest of Valgrind might be changing.
+   ------------------------------------------------------------------ */
+
+#define N_TOOL_HELPERS_MAX 64
+
+static Int  n_tool_helpers = 0;
+static Int  tool_helper_go[2]   = { -1, -1 };
+static Int  tool_helper_done[2] = { -1, -1 };
+
+/* The current job. */
+static void (*tool_helper_fn)(void*, UInt, UInt);
+static void*  tool_helper_opaque;
+static UInt   tool_helper_n;
+static volatile UInt tool_helper_next;
+
+static Word tool_helper_thread ( void* arg )
+{
+   vki_sigset_t blockall;
+
+   VG_(sigfillset)(&blockall);
+   while (True) {
+      UChar c;
+      UInt  i;
+
+      if (VG_(read)(tool_helper_go[0], &c, 1) != 1)
+         continue;
+      i = __sync_fetch_and_add(&tool_helper_next, 1);
+      vg_assert(i > 0 && i < tool_helper_n);
+      tool_helper_fn(tool_helper_opaque, i, tool_helper_n);
+      /* The job may have unblocked some signals. */
+      VG_(sigprocmask)(VKI_SIG_SETMASK, &blockall, NULL);
+      VG_(write)(tool_helper_done[1], "", 1);
+   }
+   /*NOTREACHED*/
+   return 0;
+}
+
+/* The child of a fork has no helpers, and must not share the pipes
+   with the parent's. */
+static void tool_helpers_atfork_child ( ThreadId tid )
+{
+   Int i;
+
+   for (i = 0; i < 2; i++) {
+      if (tool_helper_go[i] != -1)
+         VG_(close)(tool_helper_go[i]);
+      if (tool_helper_done[i] != -1)
+         VG_(close)(tool_helper_done[i]);
+      tool_helper_go[i] = tool_helper_done[i] = -1;
+   }
+   n_tool_helpers = 0;
+}
+
+/* Start helpers until there are n of them, or no more can be
+   started.  Returns how many there are. */
+static Int start_tool_helpers ( Int n )
+{
+#  if defined(VGO_linux)
+   static Bool atfork_done = False;
+
+   if (n > N_TOOL_HELPERS_MAX)
+      n = N_TOOL_HELPERS_MAX;
+   if (n <= n_tool_helpers)
+      return n_tool_helpers;
+
+   if (tool_helper_go[0] == -1) {
+      Int go[2], done[2];
+      if (VG_(pipe)(go) != 0)
+         return n_tool_helpers;
+      if (VG_(pipe)(done) != 0) {
+         VG_(close)(go[0]);
+         VG_(close)(go[1]);
+         return n_tool_helpers;
+      }
+      tool_helper_go[0]   = VG_(safe_fd)(go[0]);
+      tool_helper_go[1]   = VG_(safe_fd)(go[1]);
+      tool_helper_done[0] = VG_(safe_fd)(done[0]);
+      tool_helper_done[1] = VG_(safe_fd)(done[1]);
+   }
+   if (!atfork_done) {
+      VG_(atfork)(NULL, NULL, tool_helpers_atfork_child);
+      atfork_done = True;
+   }
+   while (n_tool_helpers < n) {
+      if (!VG_(start_helper_thread)(tool_helper_thread))
+         break;
+      n_tool_helpers++;
+   }
+#  endif
+   return n_tool_helpers;
+}
+
+/* See pub_tool_threadstate.h for description */
+void VG_(run_in_helper_threads) ( UInt n,
+                                  void (*fn)(void* opaque, UInt i, UInt n),
+                                  void* opaque )
+{
+   UInt i;
+
+   vg_assert(n >= 1);
+   if (n > 1)
+      n = 1 + start_tool_helpers(n - 1);
+
+   tool_helper_fn     = fn;
+   tool_helper_opaque = opaque;
+   tool_helper_n      = n;
+   tool_helper_next   = 1;
+
+   /* The pipes order these stores before the helpers' loads, and the
+      helpers' work before our return. */
+   for (i = 1; i < n; i++)
+      VG_(write)(tool_helper_go[1], "", 1);
+   fn(opaque, 0, n);
+   for (i = 1; i < n; i++) {
+      UChar c;
+      while (VG_(read)(tool_helper_done[0], &c, 1) != 1)
+         ;
+   }
+   vg_assert(tool_helper_next == n);
+
+   tool_helper_fn     = NULL;
+   tool_helper_opaque = NULL;
+}
+
+/* See pub_tool_threadstate.h for description */
+void VG_(helper_thread_yield) ( void )
+{
+   do_sched_yield();
+}
+
+
 /* Clear out the ThreadState and release the semaphore. Leaves the
    ThreadState in VgTs_Zombie state, so that it doesn't get
    reallocated until the caller is really ready. */
@@ -513,16 +813,7 @@ void VG_(vg_yield)(void)
 
    VG_(release_BigLock)(tid, VgTs_Yielding, "VG_(vg_yield)");
 
-   /* 
-      Tell the kernel we're yielding.
-    */
-#  if defined(VGO_linux) || defined(VGO_darwin) || defined(VGO_freebsd)
-   VG_(do_syscall0)(__NR_sched_yield);
-#  elif defined(VGO_solaris)
-   VG_(do_syscall0)(__NR_yield);
-#  else
-#    error Unknown OS
-#  endif
+   do_sched_yield();
 
    VG_(acquire_BigLock)(tid, "VG_(vg_yield)");
 }
@@ -599,6 +890,7 @@ void mostly_clear_thread_record ( ThreadId tid )
 
    vg_assert(tid < VG_N_THREADS);
    VG_(cleanup_thread)(&VG_(threads)[tid].arch);
+   VG_(release_tt_fast)(tid);
    VG_(threads)[tid].tid = tid;
 
    /* Leave the thread in Zombie, so that it doesn't get reallocated
@@ -618,6 +910,8 @@ void mostly_clear_thread_record ( ThreadId tid )
    VG_(clear_out_queued_signals)(tid, &savedmask);
 
    VG_(threads)[tid].sched_jmpbuf_valid = False;
+   VG_(threads)[tid].in_parallel_code = False;
+   VG_(threads)[tid].pinned_sector = INV_SNO;
 }
 
 /*                                                                             
@@ -653,12 +947,19 @@ static void sched_fork_cleanup(ThreadId me)
    /* clear out all the unused thread slots */
    for (tid = 1; tid < VG_N_THREADS; tid++) {
       if (tid != me) {
+         /* A thread which was waiting for the lock in a signal handler
+            leaves a sector pinned. */
+         VG_(unpin_tc_sector)(VG_(threads)[tid].pinned_sector);
          mostly_clear_thread_record(tid);
          VG_(threads)[tid].status = VgTs_Empty;
          VG_(clear_syscallInfo)(tid);
       }
    }
 
+   /* Threads which were running generated code in the parent are
+      gone. */
+   n_parallel_threads = 0;
+
    /* re-init and take the sema */
    deinit_BigLock();
    init_BigLock();
@@ -950,12 +1251,18 @@ void run_thread_for_a_while ( /*OUT*/HWord* two_words,
    do_pre_run_checks( tst );
    /* end Paranoia */
 
-   /* Futz with the XIndir stats counters. */
-   vg_assert(VG_(stats__n_xIndirs_32) == 0);
-   vg_assert(VG_(stats__n_xIndir_hits1_32) == 0);
-   vg_assert(VG_(stats__n_xIndir_hits2_32) == 0);
-   vg_assert(VG_(stats__n_xIndir_hits3_32) == 0);
-   vg_assert(VG_(stats__n_xIndir_misses_32) == 0);
+   /* Make the thread's fast cache usable by the dispatcher. */
+   VG_(prepare_tt_fast)( tid );
+
+   /* Futz with the XIndir stats counters.  Other threads may be
+      updating them if they run in parallel. */
+   if (!VG_(clo_parallel_threads)) {
+      vg_assert(VG_(stats__n_xIndirs_32) == 0);
+      vg_assert(VG_(stats__n_xIndir_hits1_32) == 0);
+      vg_assert(VG_(stats__n_xIndir_hits2_32) == 0);
+      vg_assert(VG_(stats__n_xIndir_hits3_32) == 0);
+      vg_assert(VG_(stats__n_xIndir_misses_32) == 0);
+   }
 
    /* Clear return area. */
    two_words[0] = two_words[1] = 0;
@@ -969,12 +1276,13 @@ void run_thread_for_a_while ( /*OUT*/HWord* two_words,
       Addr host_from_fast_cache = 0;
       Bool found_in_fast_cache
          = VG_(lookupInFastCache)( &host_from_fast_cache,
+                                   tst->arch.tt_fast,
                                    (Addr)tst->arch.vex.VG_INSTR_PTR );
       if (found_in_fast_cache) {
          host_code_addr = host_from_fast_cache;
       } else {
          Addr res = 0;
-         /* not found in VG_(tt_fast). Searching here the transtab
+         /* not found in the fast cache. Searching here the transtab
             improves the performance compared to returning directly
             to the scheduler. */
          Bool  found = VG_(search_transtab)(&res, NULL, NULL,
@@ -1034,6 +1342,11 @@ void run_thread_for_a_while ( /*OUT*/HWord* two_words,
    vg_assert(VG_(in_generated_code) == False);
    VG_(in_generated_code) = True;
 
+   /* No-redir translations are not run in parallel: they can be
+      thrown away when the unredir cache fills up. */
+   if (VG_(clo_parallel_threads) && !use_alt_host_addr)
+      VG_(enter_parallel_code)(tid);
+
    SCHEDSETJMP(
       tid, 
       jumped, 
@@ -1044,6 +1357,10 @@ void run_thread_for_a_while ( /*OUT*/HWord* two_words,
       )
    );
 
+   /* If a signal handler longjmp'd us out, it already took back the
+      lock. */
+   VG_(leave_parallel_code)(tid, 0);
+
    vg_assert(VG_(in_generated_code) == True);
    VG_(in_generated_code) = False;
 
@@ -1058,7 +1375,11 @@ void run_thread_for_a_while ( /*OUT*/HWord* two_words,
 
    /* Merge the 32-bit XIndir/miss counters into the 64 bit versions,
       and zero out the 32-bit ones in preparation for the next run of
-      generated code. */
+      generated code.  Only this thread ran, so the counts are also its
+      own -- except with --parallel-threads=yes, where they are only
+      approximate. */
+   tst->n_xIndirs += (ULong)VG_(stats__n_xIndirs_32);
+   tst->n_xIndir_misses += (ULong)VG_(stats__n_xIndir_misses_32);
    stats__n_xIndirs += (ULong)VG_(stats__n_xIndirs_32);
    VG_(stats__n_xIndirs_32) = 0;
    stats__n_xIndir_hits1 += (ULong)VG_(stats__n_xIndir_hits1_32);
@@ -49,6 +49,9 @@
 /*--- Signal frame layout                                  ---*/
 /*------------------------------------------------------------*/
 
+/* Size of the guest vector state: guest_vl, guest_vtype and guest_v0..31. */
+#define VSTATE_SIZEB (2 * sizeof(ULong) + 32 * sizeof(U128))
+
 /* Valgrind-specific parts of the signal frame. */
 struct vg_sigframe {
    /* Sanity check word. */
@@ -57,6 +60,11 @@ struct vg_sigframe {
    /* Safely-saved version of sigNo. */
    Int sigNo_private;
 
+   /* Vector state (V extension) together with its shadows. It is not part of
+      the client-visible sigcontext, so it is preserved here across the signal
+      handler. */
+   UChar vstate[3][VSTATE_SIZEB];
+
    /* Sanity check word. */
    UInt magicE;
 };
@@ -176,11 +184,19 @@ static void synth_ucontext(ThreadState*         tst,
 }
 
 /* Build the Valgrind-specific part of a signal frame. */
-static void build_vg_sigframe(struct vg_sigframe* frame, Int sigNo)
+static void
+build_vg_sigframe(ThreadState* tst, struct vg_sigframe* frame, Int sigNo)
 {
+   vg_assert(offsetof(VexGuestRISCV64State, guest_v31) + sizeof(U128) -
+                offsetof(VexGuestRISCV64State, guest_vl) ==
+             VSTATE_SIZEB);
+
    frame->magicPI       = 0x31415927;
    frame->sigNo_private = sigNo;
-   frame->magicE        = 0x27182818;
+   VG_(memcpy)(frame->vstate[0], &tst->arch.vex.guest_vl, VSTATE_SIZEB);
+   VG_(memcpy)(frame->vstate[1], &tst->arch.vex_shadow1.guest_vl, VSTATE_SIZEB);
+   VG_(memcpy)(frame->vstate[2], &tst->arch.vex_shadow2.guest_vl, VSTATE_SIZEB);
+   frame->magicE = 0x27182818;
 }
 
 static Addr build_rt_sigframe(ThreadState*         tst,
@@ -216,7 +232,7 @@ static Addr build_rt_sigframe(ThreadState*         tst,
    synth_ucontext(tst, siginfo, mask, &frame->uc);
 
    /* Fill in the Valgrind-specific part. */
-   build_vg_sigframe(&frame->vg, sigNo);
+   build_vg_sigframe(tst, &frame->vg, sigNo);
 
    return sp;
 }
@@ -290,6 +306,9 @@ restore_vg_sigframe(ThreadState* tst, struct vg_sigframe* frame, Int* sigNo)
       return False;
    }
    *sigNo = frame->sigNo_private;
+   VG_(memcpy)(&tst->arch.vex.guest_vl, frame->vstate[0], VSTATE_SIZEB);
+   VG_(memcpy)(&tst->arch.vex_shadow1.guest_vl, frame->vstate[1], VSTATE_SIZEB);
+   VG_(memcpy)(&tst->arch.vex_shadow2.guest_vl, frame->vstate[2], VSTATE_SIZEB);
    return True;
 }
 
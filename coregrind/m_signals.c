@@ -2995,6 +2995,7 @@ void sync_signalhandler ( Int sigNo,
 {
    ThreadId tid = VG_(lwpid_to_vgtid)(VG_(gettid)());
    Bool from_user;
+   Bool in_parallel_code;
 
    if (0) 
       VG_(printf)("sync_sighandler(%d, %p, %p)\n", sigNo, info, uc);
@@ -3007,6 +3008,22 @@ void sync_signalhandler ( Int sigNo,
 	     || sigNo == VKI_SIGILL
 	     || sigNo == VKI_SIGTRAP);
 
+   /* A tool helper thread (see VG_(run_in_helper_threads)) has no
+      ThreadId, and only unblocks SIGSEGV and SIGBUS while a fault
+      catcher is set. */
+   if (tid == VG_INVALID_THREADID && fault_catcher != NULL) {
+      (*fault_catcher)(sigNo, (Addr)info->VKI_SIGINFO_si_addr);
+      VG_(core_panic)("sync_signalhandler: "
+                      "fault in a helper thread not caught");
+   }
+
+   /* With --parallel-threads=yes, a thread in generated code does not
+      hold the_BigLock.  Take it back before looking at anything, and
+      give it up again if we return to the generated code. */
+   in_parallel_code
+      = tid != VG_INVALID_THREADID
+        && VG_(leave_parallel_code)(tid, VG_UCONTEXT_INSTR_PTR(uc));
+
    info->si_code = sanitize_si_code(info->si_code);
 
    from_user = !is_signal_from_kernel(tid, sigNo, info->si_code);
@@ -3042,6 +3059,9 @@ void sync_signalhandler ( Int sigNo,
       sync_signalhandler_from_kernel(tid, sigNo, info, uc);
    }
 
+   if (in_parallel_code)
+      VG_(enter_parallel_code)(tid);
+
 #  if defined(VGO_solaris)
    /* On Solaris we have to return from signal handler manually. */
    VG_(do_syscall2)(__NR_context, VKI_SETCONTEXT, (UWord)uc);
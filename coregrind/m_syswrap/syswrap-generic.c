@@ -37,6 +37,7 @@
 #include "pub_core_debuginfo.h"     // VG_(di_notify_*)
 #include "pub_core_aspacemgr.h"
 #include "pub_core_transtab.h"      // VG_(discard_translations)
+#include "pub_core_transcache.h"    // VG_(save_transcache)
 #include "pub_core_xarray.h"
 #include "pub_core_clientstate.h"   // VG_(brk_base), VG_(brk_limit)
 #include "pub_core_debuglog.h"
@@ -3364,6 +3365,10 @@ void handle_pre_sys_execve(ThreadId tid, SyscallStatus *status, Addr pathname,
       vg_assert(j == tot_args+1);
    }
 
+   /* The new translations of this process would be lost with it. */
+   if (VG_(clo_translation_cache))
+      VG_(save_transcache)();
+
    /*
       Set the signal state up for exec.
 
@@ -457,14 +457,14 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    Int          eax;
    ctst->arch.vex.guest_EAX = 0;
    eax = do_syscall_clone_x86_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    res = VG_(mk_SysRes_x86_linux)( eax );
 #elif defined(VGP_amd64_linux)
    Long         rax;
    ctst->arch.vex.guest_RAX = 0;
    rax = do_syscall_clone_amd64_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    res = VG_(mk_SysRes_amd64_linux)( rax );
 #elif defined(VGP_ppc32_linux)
@@ -475,7 +475,7 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    /* %cr0.so = 0 */
    LibVEX_GuestPPC32_put_CR( old_cr & ~(1<<28), &ctst->arch.vex );
    word64 = do_syscall_clone_ppc32_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    /* High half word64 is syscall return value.  Low half is
       the entire CR, from which we need to extract CR0.SO. */
@@ -491,7 +491,7 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    /* %cr0.so = 0 */
    LibVEX_GuestPPC64_put_CR( old_cr & ~(1<<28), &ctst->arch.vex );
    word64 = do_syscall_clone_ppc64_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    /* Low half word64 is syscall return value.  Hi half is
       the entire CR, from which we need to extract CR0.SO. */
@@ -504,20 +504,20 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    ctst->arch.vex.guest_r2 = 0;
    r2 = do_syscall_clone_s390x_linux
       (stack, flags, parent_tidptr, child_tidptr, NULL,
-       ML_(start_thread_NORETURN), ctst);
+       fn, ctst);
    res = VG_(mk_SysRes_s390x_linux)( r2 );
 #elif defined(VGP_arm64_linux)
    ULong        x0;
    ctst->arch.vex.guest_X0 = 0;
    x0 = do_syscall_clone_arm64_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    res = VG_(mk_SysRes_arm64_linux)( x0 );
 #elif defined(VGP_arm_linux)
    UInt r0;
    ctst->arch.vex.guest_R0 = 0;
    r0 = do_syscall_clone_arm_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    res = VG_(mk_SysRes_arm_linux)( r0 );
 #elif defined(VGP_mips64_linux)
@@ -525,7 +525,7 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    ctst->arch.vex.guest_r2 = 0;
    ctst->arch.vex.guest_r7 = 0;
    ret = do_syscall_clone_mips64_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        parent_tidptr, NULL, child_tidptr);
    res = VG_(mk_SysRes_mips64_linux)( /* val */ ret, 0, /* errflag */ 0);
 #elif defined(VGP_mips32_linux)
@@ -533,7 +533,7 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    ctst->arch.vex.guest_r2 = 0;
    ctst->arch.vex.guest_r7 = 0;
    ret = do_syscall_clone_mips_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    /* High half word64 is syscall return value.  Low half is
       the entire CR, from which we need to extract CR0.SO. */ 
@@ -542,14 +542,14 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    UInt ret = 0;
    ctst->arch.vex.guest_r4 = 0;
    ret = do_syscall_clone_nanomips_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    res = VG_ (mk_SysRes_nanomips_linux) (ret);
 #elif defined(VGP_riscv64_linux)
    ULong a0;
    ctst->arch.vex.guest_x10 = 0;
    a0 = do_syscall_clone_riscv64_linux
-      (ML_(start_thread_NORETURN), stack, flags, ctst,
+      (fn, stack, flags, ctst,
        child_tidptr, parent_tidptr, NULL);
    res = VG_(mk_SysRes_riscv64_linux)( a0 );
 #else
@@ -558,6 +558,33 @@ static SysRes clone_new_thread ( Word (*fn)(void *),
    return res;
 }
 
+/* See pub_core_syswrap.h.  clone_new_thread wants a ThreadState in
+   which to set the child's syscall result; the helper does not use
+   it. */
+Bool VG_(start_helper_thread) ( Word (*fn)(void *) )
+{
+   static ThreadState helper_tst;
+   vki_sigset_t blockall, savedmask;
+   Addr   sp;
+   SysRes res;
+
+   if (VG_(am_alloc_VgStack)(&sp) == NULL)
+      return False;
+
+   /* The helper runs with all signals blocked, so that they all go to
+      the guest threads. */
+   VG_(sigfillset)(&blockall);
+   VG_(sigprocmask)(VKI_SIG_SETMASK, &blockall, &savedmask);
+   res = clone_new_thread ( fn, (void*)sp,
+                            VKI_CLONE_VM | VKI_CLONE_FS | VKI_CLONE_FILES
+                            | VKI_CLONE_SIGHAND | VKI_CLONE_THREAD
+                            | VKI_CLONE_SYSVSEM,
+                            &helper_tst, NULL, NULL );
+   VG_(sigprocmask)(VKI_SIG_SETMASK, &savedmask, NULL);
+
+   return !sr_isError(res);
+}
+
 static void setup_child ( /*OUT*/ ThreadArchState *child, 
                           /*IN*/  ThreadArchState *parent )
 {  
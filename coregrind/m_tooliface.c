@@ -97,7 +97,9 @@ VgNeeds VG_(needs) = {
    .var_info	         = False,
    .malloc_replacement   = False,
    .xml_output           = False,
-   .final_IR_tidy_pass   = False
+   .final_IR_tidy_pass   = False,
+   .parallel_threads     = False,
+   .translation_cache    = False
 };
 
 /* static */
@@ -206,6 +208,16 @@ Bool VG_(finish_needs_init)(const HChar** failmsg)
    VG_(tdict).any_die_mem_stack
       = VG_(tdict).track_die_mem_stack || any_die_mem_stack_N;
 
+   /* Stack events are reported from generated code, which does not hold
+      the big lock when threads run in parallel. */
+   if (VG_(needs).parallel_threads
+       && (VG_(tdict).any_new_mem_stack || VG_(tdict).any_die_mem_stack)) {
+      *failmsg = "Tool error: 'parallel_threads' needed, but stack events\n"
+                 "   are tracked.  These are reported from generated code,\n"
+                 "   which may then run in several threads at once.\n";
+      return False;
+   }
+
    return True;
 
 #undef CHECK_NOT
@@ -378,6 +390,16 @@ void VG_(needs_xml_output)( void )
    VG_(needs).xml_output = True;
 }
 
+void VG_(needs_parallel_threads)( void )
+{
+   VG_(needs).parallel_threads = True;
+}
+
+void VG_(needs_translation_cache)( void )
+{
+   VG_(needs).translation_cache = True;
+}
+
 void VG_(needs_final_IR_tidy_pass)( 
    IRSB*(*final_tidy)(IRSB*)
 )
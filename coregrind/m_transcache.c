@@ -0,0 +1,561 @@
+
+/*--------------------------------------------------------------------*/
+/*--- Keeping translations across runs.             m_transcache.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Valgrind, a dynamic binary instrumentation
+   framework.
+
+   Copyright (C) 2000-2017 Julian Seward
+      jseward@acm.org
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#include "pub_core_basics.h"
+#include "pub_core_vki.h"
+#include "pub_core_aspacemgr.h"
+#include "pub_core_clientstate.h"   // VG_(args_for_valgrind)
+#include "pub_core_debuginfo.h"
+#include "pub_core_hashtable.h"
+#include "pub_core_libcassert.h"
+#include "pub_core_libcbase.h"
+#include "pub_core_libcfile.h"
+#include "pub_core_libcprint.h"
+#include "pub_core_libcproc.h"
+#include "pub_core_machine.h"       // VG_(machine_get_VexArchInfo)
+#include "pub_core_mallocfree.h"
+#include "pub_core_options.h"
+#include "pub_core_xarray.h"
+#include "pub_core_transcache.h"    // self
+
+/* With --translation-cache=<dir>, translations made from the code of
+   executables and shared objects are written to <dir> at exit, and
+   later runs use them instead of translating the same code again.
+   For short-lived programs, translation is most of the run time.
+
+   There is one file per object, named after the object's build-id
+   and a hash of everything else the generated code depends on: the
+   Valgrind version, the tool binary, the host's capabilities and the
+   command line options.  Generated code is not position independent
+   -- guest addresses and the addresses of helper functions are built
+   into it -- so a file also records where the object's text was
+   mapped, and is only used if the object is mapped there again.
+   Valgrind places objects deterministically, so that is the normal
+   case for a given program.  In addition each translation carries a
+   checksum of the guest code it was made from, which is checked
+   before it is used.
+
+   Only translations of code in non-writable file mappings are kept.
+   m_translate adds the remaining conditions (no redirection, no
+   self-check, no gdbserver instrumentation), and enters a translation
+   taken from here into the translation table like a new one, so
+   chaining and discarding work on it as usual. */
+
+const HChar* VG_(clo_translation_cache) = NULL;
+
+/* A file starts with a header, followed by n_recs records, each
+   followed by its code padded to a multiple of 8 bytes. */
+#define TC_MAGIC "VGTC0001"
+
+typedef
+   struct {
+      HChar magic[8];
+      ULong config;        /* config_hash of the run that wrote it */
+      Addr  text_avma;     /* where the object's text was mapped */
+      SizeT text_size;
+      ULong n_recs;
+   }
+   TCFileHeader;
+
+typedef
+   struct {
+      VexGuestExtents vge;
+      UInt guest_sum;      /* guest_checksum(&vge) */
+      UInt n_guest_instrs;
+      Int  offs_profInc;
+      UInt code_len;
+   }
+   TCRecord;
+
+typedef
+   struct _TCNode {
+      struct _TCNode* next;
+      UWord           key;    /* the guest address, rec->vge.base[0] */
+      TCRecord*       rec;
+   }
+   TCNode;
+
+typedef
+   struct {
+      HChar*       buildid;
+      Addr         text_avma;
+      SizeT        text_size;
+      HChar*       path;
+      VgHashTable* recs;      /* of TCNode */
+      UInt         n_new;     /* records not yet written out */
+   }
+   TCObject;
+
+/* Hash of everything besides the guest code which the generated code
+   depends on.  Set by VG_(init_transcache). */
+static ULong config_hash = 0;
+
+/* Objects seen so far. */
+static XArray* /* of TCObject* */ objects = NULL;
+
+/* Stats */
+static ULong stats__files_read     = 0;
+static ULong stats__files_rejected = 0;
+static ULong stats__loaded         = 0;
+static ULong stats__lookups        = 0;
+static ULong stats__hits           = 0;
+static ULong stats__added          = 0;
+static ULong stats__saved          = 0;
+
+
+/*------------------------------------------------------------*/
+/*--- Hashing                                              ---*/
+/*------------------------------------------------------------*/
+
+/* 64-bit FNV-1a. */
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+static ULong hash_bytes ( ULong h, const void* p, SizeT n )
+{
+   const UChar* b = p;
+   SizeT i;
+   for (i = 0; i < n; i++) {
+      h ^= b[i];
+      h *= FNV_PRIME;
+   }
+   return h;
+}
+
+static ULong hash_str ( ULong h, const HChar* s )
+{
+   return hash_bytes(h, s, VG_(strlen)(s) + 1);
+}
+
+static ULong hash_word ( ULong h, ULong w )
+{
+   return hash_bytes(h, &w, sizeof(w));
+}
+
+static UInt guest_checksum ( const VexGuestExtents* vge )
+{
+   ULong h = FNV_OFFSET;
+   UInt  i;
+   for (i = 0; i < vge->n_used; i++)
+      h = hash_bytes(h, (const void*)vge->base[i], vge->len[i]);
+   return (UInt)(h ^ (h >> 32));
+}
+
+/* Options which make no difference to the generated code. */
+static const HChar* const ignored_options[] = {
+   "--translation-cache=", "--log-", "--xml", "--vgdb",
+   "--trace-children", "--child-silent-after-fork", "--stats",
+   "--time-stamp", "--error-exitcode", "--num-transtab-sectors",
+   "--parallel-threads", "-v", "--verbose", "-q", "--quiet",
+};
+
+static Bool is_ignored_option ( const HChar* arg )
+{
+   UInt i;
+   for (i = 0; i < sizeof(ignored_options)/sizeof(ignored_options[0]); i++) {
+      const HChar* opt = ignored_options[i];
+      if (VG_(strncmp)(arg, opt, VG_(strlen)(opt)) == 0)
+         return True;
+   }
+   return False;
+}
+
+void VG_(init_transcache) ( void )
+{
+   struct vg_stat  st;
+   NSegment const* seg;
+   VexArch         arch;
+   VexArchInfo     archinfo;
+   ULong           h = FNV_OFFSET;
+   Word            i;
+
+   vg_assert(VG_(clo_translation_cache));
+
+   h = hash_str(h, VERSION);
+   h = hash_str(h, VG_(clo_toolname));
+
+   /* The tool binary, which contains the core and VEX. */
+   seg = VG_(am_find_nsegment)((Addr)&VG_(init_transcache));
+   vg_assert(seg);
+   if (VG_(am_get_filename)(seg)
+       && !sr_isError(VG_(stat)(VG_(am_get_filename)(seg), &st))) {
+      h = hash_word(h, st.ino);
+      h = hash_word(h, st.size);
+      h = hash_word(h, st.mtime);
+      h = hash_word(h, st.mtime_nsec);
+   }
+
+   VG_(machine_get_VexArchInfo)(&arch, &archinfo);
+   h = hash_word(h, arch);
+   h = hash_word(h, archinfo.hwcaps);
+   h = hash_word(h, archinfo.endness);
+   h = hash_word(h, archinfo.ppc_icache_line_szB);
+   h = hash_word(h, archinfo.ppc_dcbz_szB);
+   h = hash_word(h, archinfo.ppc_dcbzl_szB);
+   h = hash_word(h, archinfo.ppc_scv_supported);
+   h = hash_word(h, archinfo.arm64_dMinLine_lg2_szB);
+   h = hash_word(h, archinfo.arm64_iMinLine_lg2_szB);
+   h = hash_word(h, archinfo.arm64_cache_block_size);
+   h = hash_word(h, archinfo.arm64_requires_fallback_LLSC);
+
+   for (i = 0; i < VG_(sizeXA)(VG_(args_for_valgrind)); i++) {
+      const HChar* arg
+         = *(HChar**)VG_(indexXA)(VG_(args_for_valgrind), i);
+      if (!is_ignored_option(arg))
+         h = hash_str(h, arg);
+   }
+
+   config_hash = h;
+   objects = VG_(newXA)(VG_(malloc), "transcache.init.1",
+                        VG_(free), sizeof(TCObject*));
+}
+
+
+/*------------------------------------------------------------*/
+/*--- Objects and their files                              ---*/
+/*------------------------------------------------------------*/
+
+/* Read the records in obj's file, if it was written for this
+   configuration and for the object mapped at the same place. */
+static void load_object ( TCObject* obj )
+{
+   SysRes        sr;
+   Int           fd;
+   Long          size, off;
+   ULong         n;
+   UChar*        buf;
+   TCFileHeader* hdr;
+
+   sr = VG_(open)(obj->path, VKI_O_RDONLY, 0);
+   if (sr_isError(sr))
+      return;
+   fd = sr_Res(sr);
+   stats__files_read++;
+
+   size = VG_(fsize)(fd);
+   if (size < (Long)sizeof(TCFileHeader) || size > 0x7fffffff) {
+      VG_(close)(fd);
+      stats__files_rejected++;
+      return;
+   }
+   buf = VG_(malloc)("transcache.lo.1", size);
+   if (VG_(read)(fd, buf, size) != size)
+      goto bad;
+
+   hdr = (TCFileHeader*)buf;
+   if (VG_(memcmp)(hdr->magic, TC_MAGIC, sizeof(hdr->magic)) != 0
+       || hdr->config != config_hash
+       || hdr->text_avma != obj->text_avma
+       || hdr->text_size != obj->text_size)
+      goto bad;
+
+   /* Check the whole file before using any of it. */
+   off = sizeof(TCFileHeader);
+   for (n = 0; n < hdr->n_recs; n++) {
+      const TCRecord* rec = (const TCRecord*)(buf + off);
+      if (off + (Long)sizeof(TCRecord) > size
+          || rec->vge.n_used < 1 || rec->vge.n_used > 3
+          || rec->code_len == 0 || rec->code_len >= 65536)
+         goto bad;
+      off += sizeof(TCRecord) + VG_ROUNDUP(rec->code_len, 8);
+      if (off > size)
+         goto bad;
+   }
+   if (off != size)
+      goto bad;
+
+   off = sizeof(TCFileHeader);
+   for (n = 0; n < hdr->n_recs; n++) {
+      TCNode* node = VG_(malloc)("transcache.lo.2", sizeof(TCNode));
+      node->rec = (TCRecord*)(buf + off);
+      node->key = node->rec->vge.base[0];
+      VG_(HT_add_node)(obj->recs, node);
+      off += sizeof(TCRecord) + VG_ROUNDUP(node->rec->code_len, 8);
+   }
+   stats__loaded += hdr->n_recs;
+   VG_(close)(fd);
+   return;
+
+  bad:
+   if (VG_(clo_verbosity) > 1)
+      VG_(message)(Vg_DebugMsg,
+                   "transcache: ignoring %s\n", obj->path);
+   VG_(free)(buf);
+   VG_(close)(fd);
+   stats__files_rejected++;
+}
+
+/* Find the object whose text contains a, reading its file when it is
+   first seen.  NULL if there is no such object with a build-id. */
+static TCObject* find_object ( Addr a )
+{
+   DebugInfo*   di;
+   const HChar* buildid;
+   Addr         text_avma;
+   SizeT        text_size;
+   TCObject*    obj;
+   Word         i;
+
+   di = VG_(find_DebugInfo)(VG_(current_DiEpoch)(), a);
+   if (di == NULL)
+      return NULL;
+   buildid = VG_(DebugInfo_get_buildid)(di);
+   if (buildid == NULL)
+      return NULL;
+   text_avma = VG_(DebugInfo_get_text_avma)(di);
+   text_size = VG_(DebugInfo_get_text_size)(di);
+
+   for (i = 0; i < VG_(sizeXA)(objects); i++) {
+      obj = *(TCObject**)VG_(indexXA)(objects, i);
+      if (obj->text_avma == text_avma && obj->text_size == text_size
+          && VG_(strcmp)(obj->buildid, buildid) == 0)
+         return obj;
+   }
+
+   obj = VG_(malloc)("transcache.fo.1", sizeof(TCObject));
+   obj->buildid   = VG_(strdup)("transcache.fo.2", buildid);
+   obj->text_avma = text_avma;
+   obj->text_size = text_size;
+   obj->path      = VG_(malloc)("transcache.fo.3",
+                                VG_(strlen)(VG_(clo_translation_cache))
+                                + VG_(strlen)(buildid) + 19);
+   VG_(sprintf)(obj->path, "%s/%s-%016llx",
+                VG_(clo_translation_cache), buildid, config_hash);
+   obj->recs      = VG_(HT_construct)("transcache.fo.4");
+   obj->n_new     = 0;
+   load_object(obj);
+   VG_(addToXA)(objects, &obj);
+   return obj;
+}
+
+/* Is each extent within obj's text, in a file mapping which cannot
+   have been changed? */
+static Bool extents_unchanging ( const TCObject* obj,
+                                 const VexGuestExtents* vge )
+{
+   UInt i;
+   for (i = 0; i < vge->n_used; i++) {
+      Addr  base = vge->base[i];
+      SizeT len  = vge->len[i];
+      NSegment const* seg;
+      if (base < obj->text_avma
+          || base + len > obj->text_avma + obj->text_size)
+         return False;
+      seg = VG_(am_find_nsegment)(base);
+      if (seg == NULL || seg->kind != SkFileC || seg->hasW
+          || (len > 0 && base + len - 1 > seg->end))
+         return False;
+   }
+   return True;
+}
+
+
+/*------------------------------------------------------------*/
+/*--- Lookup, adding and saving                            ---*/
+/*------------------------------------------------------------*/
+
+Bool VG_(transcache_lookup) ( Addr addr, /*OUT*/TCTrans* res )
+{
+   TCObject* obj;
+   TCNode*   node;
+   TCRecord* rec;
+
+   stats__lookups++;
+   obj = find_object(addr);
+   if (obj == NULL)
+      return False;
+   node = VG_(HT_lookup)(obj->recs, addr);
+   if (node == NULL)
+      return False;
+   rec = node->rec;
+   if (!extents_unchanging(obj, &rec->vge)
+       || guest_checksum(&rec->vge) != rec->guest_sum)
+      return False;
+
+   res->vge            = rec->vge;
+   res->code           = (const UChar*)(rec + 1);
+   res->code_len       = rec->code_len;
+   res->offs_profInc   = rec->offs_profInc;
+   res->n_guest_instrs = rec->n_guest_instrs;
+   stats__hits++;
+   return True;
+}
+
+void VG_(transcache_add) ( const VexGuestExtents* vge,
+                           const UChar* code, UInt code_len,
+                           Int offs_profInc, UInt n_guest_instrs )
+{
+   TCObject* obj;
+   TCNode*   node;
+   TCRecord* rec;
+
+   vg_assert(code_len > 0 && code_len < 65536);
+   obj = find_object(vge->base[0]);
+   if (obj == NULL || !extents_unchanging(obj, vge))
+      return;
+   /* Already known, e.g. translated again after being discarded. */
+   if (VG_(HT_lookup)(obj->recs, vge->base[0]))
+      return;
+
+   rec = VG_(malloc)("transcache.add.1", sizeof(TCRecord) + code_len);
+   rec->vge            = *vge;
+   rec->guest_sum      = guest_checksum(vge);
+   rec->n_guest_instrs = n_guest_instrs;
+   rec->offs_profInc   = offs_profInc;
+   rec->code_len       = code_len;
+   VG_(memcpy)(rec + 1, code, code_len);
+
+   node = VG_(malloc)("transcache.add.2", sizeof(TCNode));
+   node->key = vge->base[0];
+   node->rec = rec;
+   VG_(HT_add_node)(obj->recs, node);
+   obj->n_new++;
+   stats__added++;
+}
+
+/* Buffered writing of a file. */
+typedef
+   struct {
+      Int    fd;
+      Bool   ok;
+      UInt   used;
+      UChar* buf;
+   }
+   TCWriter;
+
+#define TC_WRITER_SZB 65536
+
+static void writer_flush ( TCWriter* w )
+{
+   if (w->ok && w->used > 0
+       && VG_(write)(w->fd, w->buf, w->used) != (Int)w->used)
+      w->ok = False;
+   w->used = 0;
+}
+
+static void writer_put ( TCWriter* w, const void* p, UInt n )
+{
+   const UChar* b = p;
+   while (n > 0) {
+      UInt chunk = TC_WRITER_SZB - w->used;
+      if (chunk > n)
+         chunk = n;
+      VG_(memcpy)(w->buf + w->used, b, chunk);
+      w->used += chunk;
+      b += chunk;
+      n -= chunk;
+      if (w->used == TC_WRITER_SZB)
+         writer_flush(w);
+   }
+}
+
+/* Write all of obj's records to a new file, then move it into place,
+   so that other processes never see a partly written one. */
+static void save_object ( TCObject* obj )
+{
+   static const UChar zeroes[8] = { 0 };
+   HChar        tmp[VG_(strlen)(obj->path) + 32];
+   SysRes       sr;
+   TCWriter     w;
+   TCFileHeader hdr;
+   TCNode*      node;
+
+   VG_(sprintf)(tmp, "%s.%d.tmp", obj->path, VG_(getpid)());
+   sr = VG_(open)(tmp, VKI_O_CREAT|VKI_O_WRONLY|VKI_O_TRUNC,
+                  VKI_S_IRUSR|VKI_S_IWUSR);
+   if (sr_isError(sr)) {
+      VG_(message)(Vg_UserMsg,
+                   "Warning: cannot create translation cache file %s\n",
+                   tmp);
+      return;
+   }
+
+   w.fd   = sr_Res(sr);
+   w.ok   = True;
+   w.used = 0;
+   w.buf  = VG_(malloc)("transcache.so.1", TC_WRITER_SZB);
+
+   VG_(memset)(&hdr, 0, sizeof(hdr));
+   VG_(memcpy)(hdr.magic, TC_MAGIC, sizeof(hdr.magic));
+   hdr.config    = config_hash;
+   hdr.text_avma = obj->text_avma;
+   hdr.text_size = obj->text_size;
+   hdr.n_recs    = VG_(HT_count_nodes)(obj->recs);
+   writer_put(&w, &hdr, sizeof(hdr));
+
+   VG_(HT_ResetIter)(obj->recs);
+   while ((node = VG_(HT_Next)(obj->recs))) {
+      UInt len = node->rec->code_len;
+      writer_put(&w, node->rec, sizeof(TCRecord) + len);
+      writer_put(&w, zeroes, VG_ROUNDUP(len, 8) - len);
+   }
+   writer_flush(&w);
+   VG_(free)(w.buf);
+   VG_(close)(w.fd);
+
+   if (!w.ok || VG_(rename)(tmp, obj->path) != 0) {
+      VG_(message)(Vg_UserMsg,
+                   "Warning: cannot write translation cache file %s\n",
+                   obj->path);
+      VG_(unlink)(tmp);
+      return;
+   }
+   stats__saved += obj->n_new;
+   obj->n_new = 0;
+}
+
+void VG_(save_transcache) ( void )
+{
+   Word i;
+
+   if (objects == NULL)
+      return;
+   for (i = 0; i < VG_(sizeXA)(objects); i++) {
+      TCObject* obj = *(TCObject**)VG_(indexXA)(objects, i);
+      if (obj->n_new > 0)
+         save_object(obj);
+   }
+}
+
+void VG_(print_transcache_stats) ( void )
+{
+   if (VG_(clo_translation_cache) == NULL)
+      return;
+   VG_(message)(Vg_DebugMsg,
+                "transcache: %'llu files read (%'llu rejected), "
+                "%'llu translations loaded\n",
+                stats__files_read, stats__files_rejected, stats__loaded);
+   VG_(message)(Vg_DebugMsg,
+                "transcache: %'llu lookups, %'llu hits, %'llu new, "
+                "%'llu saved\n",
+                stats__lookups, stats__hits, stats__added, stats__saved);
+}
+
+/*--------------------------------------------------------------------*/
+/*--- end                                                          ---*/
+/*--------------------------------------------------------------------*/
@@ -48,6 +48,7 @@
 
 #include "pub_core_translate.h"
 #include "pub_core_transtab.h"
+#include "pub_core_transcache.h"
 #include "pub_core_dispatch.h" // VG_(run_innerloop__dispatch_{un}profiled)
                                // VG_(run_a_noredir_translation__return_point)
 
@@ -209,6 +210,11 @@ static void update_SP_aliases(Long delta)
    }
 }
 
+/* Set by mk_ecu_Expr if the translation being made contains an ECU.
+   ECUs are only valid in the current run, so such a translation must
+   not be saved with --translation-cache. */
+static Bool translation_has_ecu = False;
+
 /* Given a guest IP, get an origin tag for a 1-element stack trace,
    and wrap it up in an IR atom that can be passed as the origin-tag
    value for a stack-adjustment helper function. */
@@ -220,6 +226,7 @@ static IRExpr* mk_ecu_Expr ( Addr guest_IP )
    vg_assert(ec);
    ecu = VG_(get_ECU_from_ExeContext)( ec );
    vg_assert(VG_(is_plausible_ECU)(ecu));
+   translation_has_ecu = True;
    /* This is always safe to do, since ecu is only 32 bits, and
       HWord is 32 or 64. */
    return mkIRExpr_HWord( (HWord)ecu );
@@ -977,7 +984,7 @@ static Bool chase_into_ok ( void* closureV, Addr addr )
 
    /* overly conservative, but .. don't chase into the distinguished
       address that m_transtab uses as an empty-slot marker for
-      VG_(tt_fast). */
+      the fast caches. */
    if (addr == TRANSTAB_BOGUS_GUEST_ADDR)
       goto dontchase;
 
@@ -1005,6 +1012,39 @@ static Bool chase_into_ok ( void* closureV, Addr addr )
 }
 
 
+/* Would translating vge->base[0] now give the same result as the
+   translation saved in m_transcache for vge?  m_transcache has checked
+   that the guest code is the same; what remains are the things
+   decided at translation time: whether to chase into the later
+   extents, self-checks, and gdbserver instrumentation. */
+
+static Bool saved_translation_usable ( ThreadId tid,
+                                       const VexGuestExtents* vge )
+{
+   VgCallbackClosure  closure;
+   VexRegisterUpdates pxControl
+      = VG_(clo_vex_control).iropt_register_updates_default;
+   UInt i;
+
+   for (i = 1; i < vge->n_used; i++) {
+      if (!chase_into_ok(NULL, vge->base[i]))
+         return False;
+   }
+
+   closure.tid    = tid;
+   closure.nraddr = vge->base[0];
+   closure.readdr = vge->base[0];
+   if (needs_self_check(&closure, &pxControl, vge) != 0)
+      return False;
+
+   if (VG_(clo_vgdb) != Vg_VgdbNo
+       && VG_(gdbserver_instrumentation_needed)(vge) != Vg_VgdbNo)
+      return False;
+
+   return True;
+}
+
+
 /* --------------- helpers for with-TOC platforms --------------- */
 
 /* NOTE: with-TOC platforms are: ppc64-linux. */
@@ -1649,6 +1689,26 @@ Bool VG_(translate) ( ThreadId tid,
       verbosity = VG_(clo_trace_flags);
    }
 
+   /* Use a translation saved by an earlier run, if there is one and
+      we would make the same one now. */
+   if (VG_(clo_translation_cache) && kind == T_Normal
+       && verbosity == 0 && !debugging_translation) {
+      TCTrans tct;
+      if (VG_(transcache_lookup)( addr, &tct )
+          && saved_translation_usable( tid, &tct.vge )) {
+         for (i = 0; i < tct.vge.n_used; i++)
+            VG_(am_set_segment_hasT)( tct.vge.base[i] );
+         VG_(add_to_transtab)( &tct.vge,
+                               nraddr,
+                               (Addr)tct.code,
+                               tct.code_len,
+                               False,
+                               tct.offs_profInc,
+                               tct.n_guest_instrs );
+         return True;
+      }
+   }
+
    /* Figure out which preamble-mangling callback to send. */
    preamble_fn = NULL;
    if (kind == T_Redir_Replace)
@@ -1751,6 +1811,9 @@ Bool VG_(translate) ( ThreadId tid,
 #  endif
 
 #  if defined(VGP_riscv64_linux)
+   /* Instrumentation code placed between LR and SC would break a host
+      reservation, so LR/SC is always emulated with a reservation held in
+      the guest state, which the dispatcher drops on each exit. */
    vex_abiinfo.guest__use_fallback_LLSC = True;
 #  endif
 
@@ -1832,6 +1895,7 @@ Bool VG_(translate) ( ThreadId tid,
       = VG_(fnptr_to_fnentry)( &VG_(disp_cp_xassisted) );
 
    /* Sheesh.  Finally, actually _do_ the translation! */
+   translation_has_ecu = False;
    tres = LibVEX_Translate ( &vta );
 
    vg_assert(tres.status == VexTransOK);
@@ -1871,6 +1935,15 @@ Bool VG_(translate) ( ThreadId tid,
                                 tres.n_sc_extents > 0,
                                 tres.offs_profInc,
                                 tres.n_guest_instrs );
+
+          if (VG_(clo_translation_cache) && kind == T_Normal
+              && tres.n_sc_extents == 0 && !translation_has_ecu
+              && VG_(gdbserver_instrumentation_needed)( &vge ) == Vg_VgdbNo)
+             VG_(transcache_add)( &vge,
+                                  &tmpbuf[0],
+                                  tmpbuf_used,
+                                  tres.offs_profInc,
+                                  tres.n_guest_instrs );
       } else {
           vg_assert(tres.offs_profInc == -1); /* -1 == unset */
           VG_(add_to_unredir_transtab)( &vge,
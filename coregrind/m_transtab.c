@@ -42,6 +42,8 @@
 #include "pub_core_mallocfree.h" // VG_(out_of_memory_NORETURN)
 #include "pub_core_xarray.h"
 #include "pub_core_dispatch.h"   // For VG_(disp_cp*) addresses
+#include "pub_core_threadstate.h" // For the per-thread fast caches
+#include "pub_core_scheduler.h"   // VG_(stop_parallel_threads)
 
 
 #define DEBUG_TRANSTAB 0
@@ -447,6 +449,16 @@ static Int    youngest_sector = INV_SNO;
    at startup and does not change. */
 static Int    tc_sector_szQ = 0;
 
+/* With --parallel-threads=yes, a thread which takes a synchronous
+   signal in generated code stops being counted as running it while it
+   waits for the_BigLock, and may afterwards return to the faulting
+   translation.  It pins the sector holding that translation first, see
+   VG_(pin_tc_sector), and sectors with pins are not recycled.  Pins are
+   added without the_BigLock, but only by threads which
+   VG_(stop_parallel_threads) waits for, so they can't change while a
+   sector is being chosen for recycling. */
+static volatile UInt sector_pins[MAX_N_SECTORS];
+
 
 /* A list of sector numbers, in the order which they should be
    searched to find translations.  This is an optimisation to be used
@@ -457,12 +469,24 @@ static SECno sector_search_order[MAX_N_SECTORS];
 
 /* Fast helper for the TC.  A 4-way set-associative cache, with more-or-less LRU
    replacement.  It holds a set of recently used (guest address, host address)
-   pairs.  This array is referred to directly from
-   m_dispatch/dispatch-<platform>.S.
+   pairs.  Each thread has its own cache of VG_TT_FAST_SETS sets, allocated
+   when the thread first runs and pointed to by ThreadArchState.tt_fast.
+   m_dispatch/dispatch-<platform>.S loads that pointer via the guest state
+   pointer, so thread switches don't evict each other's entries.
 
    Entries in tt_fast may refer to any valid TC entry, regardless of
    which sector it's in.  Consequently we must be very careful to
    invalidate this cache when TC entries are changed or disappear.
+   Invalidating all entries just advances tt_fast_epoch; each cache is
+   cleared when its thread is next prepared to run generated code, see
+   VG_(prepare_tt_fast), so that blocked threads don't have to be visited.
+
+   Each cache takes VG_TT_FAST_SETS * sizeof(FastCacheSet) bytes, 512KB on
+   64-bit hosts, so a program with many threads would use a lot of memory
+   for them.  When a thread exits, its cache is therefore handed back by
+   VG_(release_tt_fast).  Up to N_SPARE_FAST_CACHES of them are kept for
+   threads created later, and the others are unmapped.  The memory used is
+   thus bounded by the number of threads alive at once plus that number.
 
    A special .guest address - TRANSTAB_BOGUS_GUEST_ADDR -- must be
    pointed at to cause that cache entry to miss.  This relies on the
@@ -472,7 +496,7 @@ static SECno sector_search_order[MAX_N_SECTORS];
 */
 /*
 typedef
-   struct { 
+   struct _FastCacheSet {
       Addr guest0;
       Addr host0;
       Addr guest1;
@@ -484,8 +508,15 @@ typedef
    }
    FastCacheSet;
 */
-/*global*/ __attribute__((aligned(64)))
-           FastCacheSet VG_(tt_fast)[VG_TT_FAST_SETS];
+
+/* Number of invalidations of all fast caches so far.  A thread's cache is
+   up to date if its tt_fast_epoch is equal to this. */
+static UInt tt_fast_epoch = 0;
+
+/* Caches of exited threads kept for reuse, see VG_(release_tt_fast). */
+#define N_SPARE_FAST_CACHES 4
+static FastCacheSet* spare_fast_caches[N_SPARE_FAST_CACHES];
+static UInt          n_spare_fast_caches = 0;
 
 /* Make sure we're not used before initialisation. */
 static Bool init_done = False;
@@ -496,6 +527,9 @@ static Bool init_done = False;
 /* Number of fast-cache updates and flushes done. */
 static ULong n_fast_flushes = 0;
 static ULong n_fast_updates = 0;
+static ULong n_fast_caches  = 0;
+static ULong n_fast_reused  = 0;
+static ULong n_fast_unmaps  = 0;
 
 /* Number of full lookups done. */
 static ULong n_full_lookups = 0;
@@ -877,6 +911,20 @@ void VG_(tt_tc_do_chaining) ( void* from__patch_addr,
    VG_(machine_get_VexArchInfo)( &arch_host, &archinfo_host );
    VexEndness endness_host = archinfo_host.endness;
 
+   /* With --parallel-threads=yes, other threads may have recycled a
+      sector between this one leaving generated code and getting here,
+      in which case from__patch_addr could now be inside some other
+      translation.  That also invalidates the fast caches, so the
+      running thread's is then out of date.  Don't chain, just to be
+      safe. */
+   if (VG_(clo_parallel_threads)
+       && VG_(threads)[VG_(running_tid)].arch.tt_fast_epoch
+          != tt_fast_epoch)
+      return;
+
+   /* Nobody may be running the code we're about to patch. */
+   VG_(stop_parallel_threads)();
+
    // host_code is where we're patching to.  So it needs to
    // take into account, whether we're jumping to the slow
    // or fast entry point.  By definition, the fast entry point
@@ -911,6 +959,21 @@ void VG_(tt_tc_do_chaining) ( void* from__patch_addr,
    }
 
    TTEntryC* from_tteC = index_tteC(from_sNo, from_tteNo);
+   HWord from_offs = (HWord)( (UChar*)from__patch_addr
+                              - (UChar*)from_tteC->tcptr );
+   vg_assert(from_offs < 100000/* let's say */);
+
+   /* With --parallel-threads=yes, several threads may have exited via
+      the same chain-me point before the first one got to patch it.  In
+      that case, the work is already done. */
+   if (VG_(clo_parallel_threads)) {
+      UWord i, n = OutEdgeArr__size(&from_tteC->out_edges);
+      for (i = 0; i < n; i++) {
+         OutEdge* oe = OutEdgeArr__index(&from_tteC->out_edges, i);
+         if (oe->from_offs == (UInt)from_offs)
+            return;
+      }
+   }
 
    /* Get VEX to do the patching itself.  We have to hand it off
       since it is host-dependent. */
@@ -936,9 +999,6 @@ void VG_(tt_tc_do_chaining) ( void* from__patch_addr,
    ie.from_sNo   = from_sNo;
    ie.from_tteNo = from_tteNo;
    ie.to_fastEP  = to_fastEP;
-   HWord from_offs = (HWord)( (UChar*)from__patch_addr
-                              - (UChar*)from_tteC->tcptr );
-   vg_assert(from_offs < 100000/* let's say */);
    ie.from_offs  = (UInt)from_offs;
 
    /* This is the new to_ -> from_ backlink to add. */
@@ -1460,19 +1520,79 @@ static inline HTTno HASH_TT ( Addr key )
    return (HTTno)(k32 % N_HTTES_PER_SECTOR);
 }
 
-/* Invalidate the fast cache VG_(tt_fast). */
-static void invalidateFastCache ( void )
+/* Invalidate all entries of a single fast cache. */
+static void clearFastCache ( FastCacheSet* tt_fast )
 {
    for (UWord j = 0; j < VG_TT_FAST_SETS; j++) {
-      FastCacheSet* set = &VG_(tt_fast)[j];
+      FastCacheSet* set = &tt_fast[j];
       set->guest0 = TRANSTAB_BOGUS_GUEST_ADDR;
       set->guest1 = TRANSTAB_BOGUS_GUEST_ADDR;
       set->guest2 = TRANSTAB_BOGUS_GUEST_ADDR;
       set->guest3 = TRANSTAB_BOGUS_GUEST_ADDR;
    }
+}
+
+/* Invalidate the fast caches of all threads.  The caches are actually
+   cleared by getFastCache. */
+static void invalidateFastCache ( void )
+{
+   tt_fast_epoch++;
    n_fast_flushes++;
 }
 
+/* Get the fast cache of a thread, allocating it if the thread doesn't have
+   one yet, and clearing it if it was invalidated since it was last used. */
+static FastCacheSet* getFastCache ( ThreadArchState* arch )
+{
+   if (UNLIKELY(arch->tt_fast == NULL && n_spare_fast_caches > 0)) {
+      arch->tt_fast = spare_fast_caches[--n_spare_fast_caches];
+      arch->tt_fast_epoch = tt_fast_epoch - 1;
+      n_fast_reused++;
+   }
+   if (UNLIKELY(arch->tt_fast == NULL)) {
+      SizeT  szB  = VG_TT_FAST_SETS * sizeof(FastCacheSet);
+      SysRes sres = VG_(am_mmap_anon_float_valgrind)( szB );
+      if (sr_isError(sres)) {
+         VG_(out_of_memory_NORETURN)("getFastCache", szB, sr_Err(sres) );
+         /*NOTREACHED*/
+      }
+      arch->tt_fast = (FastCacheSet*)(Addr)sr_Res(sres);
+      /* Not fatal if it isn't, but we might as well make sure. */
+      vg_assert(VG_IS_64_ALIGNED( (Addr)arch->tt_fast ));
+      arch->tt_fast_epoch = tt_fast_epoch - 1;
+      n_fast_caches++;
+   }
+   if (arch->tt_fast_epoch != tt_fast_epoch) {
+      clearFastCache(arch->tt_fast);
+      arch->tt_fast_epoch = tt_fast_epoch;
+   }
+   return arch->tt_fast;
+}
+
+void VG_(prepare_tt_fast) ( ThreadId tid )
+{
+   vg_assert(VG_(is_valid_tid)(tid));
+   getFastCache( &VG_(threads)[tid].arch );
+}
+
+void VG_(release_tt_fast) ( ThreadId tid )
+{
+   vg_assert(tid < VG_N_THREADS);
+   ThreadArchState* arch    = &VG_(threads)[tid].arch;
+   FastCacheSet*    tt_fast = arch->tt_fast;
+   if (tt_fast == NULL)
+      return;
+   arch->tt_fast = NULL;
+   if (n_spare_fast_caches < N_SPARE_FAST_CACHES) {
+      spare_fast_caches[n_spare_fast_caches++] = tt_fast;
+   } else {
+      SysRes sres = VG_(am_munmap_valgrind)(
+                       (Addr)tt_fast, VG_TT_FAST_SETS * sizeof(FastCacheSet) );
+      vg_assert(!sr_isError(sres));
+      n_fast_unmaps++;
+   }
+}
+
 /* Invalidate a single fast cache entry. */
 static void invalidateFastCacheEntry ( Addr guest )
 {
@@ -1484,33 +1604,58 @@ static void invalidateFastCacheEntry ( Addr guest )
       TRANSTAB_BOGUS_GUEST_ADDR.  Doing so ensure that the entry will never
       be used in future, so will eventually fall off the end of the line,
       due to LRU replacement, and be replaced with something that's actually
-      useful. */
+      useful.  This has to be done in the caches of all threads, except
+      those which will be cleared anyway. */
    UWord setNo = (UInt)VG_TT_FAST_HASH(guest);
-   FastCacheSet* set = &VG_(tt_fast)[setNo];
-   if (set->guest0 == guest) {
-      set->guest0 = TRANSTAB_BOGUS_GUEST_ADDR;
-   }
-   if (set->guest1 == guest) {
-      set->guest1 = TRANSTAB_BOGUS_GUEST_ADDR;
-   }
-   if (set->guest2 == guest) {
-      set->guest2 = TRANSTAB_BOGUS_GUEST_ADDR;
+   for (ThreadId tid = 1; tid < VG_N_THREADS; tid++) {
+      ThreadArchState* arch = &VG_(threads)[tid].arch;
+      if (arch->tt_fast == NULL || arch->tt_fast_epoch != tt_fast_epoch)
+         continue;
+      FastCacheSet* set = &arch->tt_fast[setNo];
+      if (set->guest0 == guest) {
+         set->guest0 = TRANSTAB_BOGUS_GUEST_ADDR;
+      }
+      if (set->guest1 == guest) {
+         set->guest1 = TRANSTAB_BOGUS_GUEST_ADDR;
+      }
+      if (set->guest2 == guest) {
+         set->guest2 = TRANSTAB_BOGUS_GUEST_ADDR;
+      }
+      if (set->guest3 == guest) {
+         set->guest3 = TRANSTAB_BOGUS_GUEST_ADDR;
+      }
    }
-   if (set->guest3 == guest) {
-      set->guest3 = TRANSTAB_BOGUS_GUEST_ADDR;
+}
+
+/* Check that no up-to-date fast cache holds an entry for guest. */
+static Bool notInAnyFastCache ( Addr guest )
+{
+   for (ThreadId tid = 1; tid < VG_N_THREADS; tid++) {
+      ThreadArchState* arch = &VG_(threads)[tid].arch;
+      Addr fake_host = 0;
+      if (arch->tt_fast == NULL || arch->tt_fast_epoch != tt_fast_epoch)
+         continue;
+      if (VG_(lookupInFastCache)(&fake_host, arch->tt_fast, guest))
+         return False;
    }
+   return True;
 }
 
+/* Add an entry to the fast cache of the running thread, which is the one
+   that will look for it next. */
 static void setFastCacheEntry ( Addr guest, ULong* tcptr )
 {
    /* This shouldn't fail.  It should be assured by m_translate
       which should reject any attempt to make translation of code
       starting at TRANSTAB_BOGUS_GUEST_ADDR. */
    vg_assert(guest != TRANSTAB_BOGUS_GUEST_ADDR);
+   if (!VG_(is_valid_tid)(VG_(running_tid)))
+      return;
    /* Shift all entries along one, so that the LRU one disappears, and put the
       new entry at the MRU position. */
    UWord setNo = (UInt)VG_TT_FAST_HASH(guest);
-   FastCacheSet* set = &VG_(tt_fast)[setNo];
+   FastCacheSet* set
+      = &getFastCache( &VG_(threads)[VG_(running_tid)].arch )[setNo];
    set->host3  = set->host2;
    set->guest3 = set->guest2;
    set->host2  = set->host1;
@@ -1637,10 +1782,13 @@ static void initialiseSector ( SECno sno )
 
    } else {
 
-      /* Sector has been used before.  Dump the old contents. */
+      /* Sector has been used before.  Dump the old contents, once
+         nobody can be running them. */
       if (VG_(clo_stats) || VG_(debugLog_getLevel)() >= 1)
          VG_(dmsg)("transtab: " "recycle  sector %d\n", sno);
       n_sectors_recycled++;
+      VG_(stop_parallel_threads)();
+      vg_assert(sector_pins[sno] == 0);
 
       vg_assert(sec->ttC != NULL);
       vg_assert(sec->ttH != NULL);
@@ -1726,6 +1874,44 @@ static void initialiseSector ( SECno sno )
    }
 }
 
+/* Return the sector to move on to when sector sno is full.  That is
+   normally the next one, but sectors pinned by a thread handling a signal
+   are skipped. */
+static SECno next_sector ( SECno sno )
+{
+   VG_(stop_parallel_threads)();
+   for (Int i = 0; i < n_sectors; i++) {
+      sno = sno + 1 < n_sectors ? sno + 1 : 0;
+      if (sectors[sno].tc == NULL || sector_pins[sno] == 0)
+         return sno;
+   }
+   VG_(core_panic)("add_to_transtab: all sectors are pinned");
+   /*NOTREACHED*/
+}
+
+SECno VG_(pin_tc_sector) ( Addr hcode )
+{
+   for (SECno sno = 0; sno < n_sectors; sno++) {
+      const Sector* sec = &sectors[sno];
+      if (sec->tc != NULL
+          && hcode >= (Addr)sec->tc
+          && hcode <  (Addr)&sec->tc[tc_sector_szQ]) {
+         __sync_fetch_and_add(&sector_pins[sno], 1);
+         return sno;
+      }
+   }
+   return INV_SNO;
+}
+
+void VG_(unpin_tc_sector) ( SECno sno )
+{
+   if (sno == INV_SNO)
+      return;
+   vg_assert(isValidSector(sno));
+   vg_assert(sector_pins[sno] > 0);
+   __sync_fetch_and_sub(&sector_pins[sno], 1);
+}
+
 /* Add a translation of vge to TT/TC.  The translation is temporarily
    in code[0 .. code_len-1].
 
@@ -1797,9 +1983,7 @@ void VG_(add_to_transtab)( const VexGuestExtents* vge,
                    y, tt_loading_pct, tc_loading_pct,
                    8 * (tc_sector_szQ - tcAvailQ)/sectors[y].tt_n_inuse);
       }
-      youngest_sector++;
-      if (youngest_sector >= n_sectors)
-         youngest_sector = 0;
+      youngest_sector = next_sector(youngest_sector);
       y = youngest_sector;
       initialiseSector(y);
    }
@@ -2199,6 +2383,10 @@ void VG_(discard_translations) ( Addr guest_start, ULong range,
    if (range == 0)
       return;
 
+   /* Nobody may be running, or about to look up, what gets thrown
+      away. */
+   VG_(stop_parallel_threads)();
+
    VexArch     arch_host = VexArch_INVALID;
    VexArchInfo archinfo_host;
    VG_(bzero_inline)(&archinfo_host, sizeof(archinfo_host));
@@ -2279,14 +2467,13 @@ void VG_(discard_translations) ( Addr guest_start, ULong range,
    if (numDeleted == 1) {
       // "ga_deleted was set to something valid"
       vg_assert(ga_deleted != TRANSTAB_BOGUS_GUEST_ADDR);
-      // Just invalidate the individual VG_(tt_fast) cache entry \o/
+      // Just invalidate the individual fast cache entries \o/
       invalidateFastCacheEntry(ga_deleted);
-      Addr fake_host = 0;
-      vg_assert(! VG_(lookupInFastCache)(&fake_host, ga_deleted));
+      vg_assert(notInAnyFastCache(ga_deleted));
    } else {
       // "ga_deleted was set to something valid"
       vg_assert(ga_deleted != TRANSTAB_BOGUS_GUEST_ADDR);
-      // Nuke the entire VG_(tt_fast) cache.  Sigh.
+      // Nuke the entire fast caches.  Sigh.
       invalidateFastCache();
    }
 
@@ -2521,9 +2708,6 @@ void VG_(init_tt_tc) ( void )
    /* check fast cache entries really are 8 words long */
    vg_assert(sizeof(Addr) == sizeof(void*));
    vg_assert(sizeof(FastCacheSet) == 8 * sizeof(Addr));
-   /* check fast cache entries are packed back-to-back with no spaces */
-   vg_assert(sizeof( VG_(tt_fast) ) 
-             == VG_TT_FAST_SETS * sizeof(FastCacheSet));
    /* check fast cache entries have the layout that the handwritten assembly
       fragments assume. */
    vg_assert(sizeof(FastCacheSet) == (1 << VG_FAST_CACHE_SET_BITS));
@@ -2544,9 +2728,9 @@ void VG_(init_tt_tc) ( void )
    vg_assert(offsetof(FastCacheSet,guest3) == 6 * sizeof(Addr));
    vg_assert(offsetof(FastCacheSet,host3)  == 7 * sizeof(Addr));
 
-   /* check fast cache is aligned as we requested.  Not fatal if it
-      isn't, but we might as well make sure. */
-   vg_assert(VG_IS_64_ALIGNED( ((Addr) & VG_(tt_fast)[0]) ));
+   /* check the dispatchers find the fast cache pointer where it is */
+   vg_assert((Int)offsetof(ThreadArchState, tt_fast)
+             - (Int)offsetof(ThreadArchState, vex) == VG_TT_FAST_PTR_OFFSET);
 
    /* The TTEntryH size is critical for keeping the LLC miss rate down
       when doing a lot of discarding.  Hence check it here.  We also
@@ -2683,8 +2867,10 @@ void VG_(print_tt_tc_stats) ( void )
       "    tt/tc: %'llu tt lookups requiring %'llu probes\n",
       n_full_lookups, n_lookup_probes );
    VG_(message)(Vg_DebugMsg,
-      "    tt/tc: %'llu fast-cache updates, %'llu flushes\n",
-      n_fast_updates, n_fast_flushes );
+      "    tt/tc: %'llu fast-cache updates, %'llu flushes, "
+      "%'llu per-thread caches (%'llu reused, %'llu unmapped)\n",
+      n_fast_updates, n_fast_flushes, n_fast_caches,
+      n_fast_reused, n_fast_unmaps );
 
    VG_(message)(Vg_DebugMsg,
                 " transtab: new        %'llu "
@@ -238,6 +238,9 @@ void VG_(DebugInfo_syms_getidx)  ( const DebugInfo *di,
    guest_code_addr.  Returns 0 if not known. */
 extern Addr VG_(get_tocptr) ( DiEpoch ep, Addr guest_code_addr );
 
+/* The object's build-id as a hex string, or NULL if it has none. */
+extern const HChar* VG_(DebugInfo_get_buildid) ( const DebugInfo *di );
+
 /* Map a function name to its SymAVMAs.  Is done by
    sequential search of all symbol tables, so is very slow.  To
    mitigate the worst performance effects, you may specify a soname
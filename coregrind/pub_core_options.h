@@ -214,6 +214,9 @@ extern Bool  VG_(clo_trace_redir);
 /* Enable fair scheduling on multicore systems? default: NO */
 enum FairSchedType { disable_fair_sched, enable_fair_sched, try_fair_sched };
 extern enum FairSchedType VG_(clo_fair_sched);
+/* Let threads run generated code concurrently, for tools which declare
+   VG_(needs_parallel_threads)?  default: NO */
+extern Bool  VG_(clo_parallel_threads);
 /* thread-scheduling timeslice. */
 extern Word   VG_(clo_scheduling_quantum);
 /* DEBUG: print thread scheduling events?  default: NO */
@@ -341,6 +344,10 @@ extern UInt VG_(clo_num_transtab_sectors);
    provided default. */
 extern UInt VG_(clo_avg_transtab_entry_size);
 
+/* Directory in which translations are kept across runs, for tools
+   which declare VG_(needs_translation_cache).  NULL means none. */
+extern const HChar* VG_(clo_translation_cache);
+
 /* Only client requested fixed mapping can be done below 
    VG_(clo_aspacem_minAddr). */
 extern Addr VG_(clo_aspacem_minAddr);
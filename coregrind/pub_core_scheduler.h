@@ -113,6 +113,21 @@ extern void VG_(print_scheduler_stats) ( void );
 /* If False, a fault is Valgrind-internal (ie, a bug) */
 extern Bool VG_(in_generated_code);
 
+/* --parallel-threads=yes support.  VG_(enter_parallel_code) releases
+   the_BigLock for the running thread tid, which is about to run
+   generated code.  VG_(leave_parallel_code) takes it back, if tid was
+   in that state, and returns whether it was.  A signal handler passes
+   the faulting host code address as fault_hcode, the translation cache
+   sector containing it is then pinned until the thread goes back to
+   generated code or the scheduler; otherwise it is 0. */
+extern void VG_(enter_parallel_code) ( ThreadId tid );
+extern Bool VG_(leave_parallel_code) ( ThreadId tid, Addr fault_hcode );
+
+/* Wait until no other thread runs generated code.  Must be called with
+   the_BigLock held; no thread goes back in until it is released.  Used
+   before patching or throwing away translations. */
+extern void VG_(stop_parallel_threads) ( void );
+
 /* Sanity checks which may be done at any time.  The scheduler decides when. */
 extern void VG_(sanity_check_general) ( Bool force_expensive );
 
@@ -77,6 +77,13 @@ extern void VG_(reap_threads)(ThreadId self);
 // Release resources held by this thread
 extern void VG_(cleanup_thread) ( ThreadArchState* );
 
+#if defined(VGO_linux)
+// Start a host thread, which is not a Valgrind thread, running fn.  It
+// shares the address space and has all signals blocked.  Returns False
+// if it could not be started.
+extern Bool VG_(start_helper_thread) ( Word (*fn)(void *) );
+#endif
+
 /* fd leakage calls. */
 extern void VG_(init_preopened_fds) ( void );
 extern void VG_(show_open_fds) ( const HChar* when );
@@ -86,6 +86,17 @@ struct SyscallArgs;
 /* Architecture-specific thread state */
 typedef 
    struct {
+      /* Number of the last fast cache flush that tt_fast has caught up
+         with, see VG_(prepare_tt_fast). */
+      UInt tt_fast_epoch;
+      UChar tt_fast_pad[LibVEX_GUEST_STATE_ALIGN
+                        - sizeof(UInt) - sizeof(void*)];
+
+      /* This thread's fast cache, VG_TT_FAST_SETS entries.  The dispatchers
+         load it at VG_TT_FAST_PTR_OFFSET from the guest state pointer, so it
+         must immediately precede the guest state. */
+      struct _FastCacheSet* tt_fast;
+
       /* --- BEGIN vex-mandated guest state --- */
 
       /* Note that for code generation reasons, we require that the
@@ -403,9 +414,23 @@ typedef struct {
    Bool               sched_jmpbuf_valid;
    VG_MINIMAL_JMP_BUF(sched_jmpbuf);
 
+   /* True while this thread runs generated code without holding
+      the_BigLock (--parallel-threads=yes).  See m_scheduler. */
+   volatile Bool in_parallel_code;
+
+   /* The translation cache sector this thread pinned while it handled a
+      synchronous signal taken in parallel code, as a SECno.  INV_SNO if
+      none.  See VG_(leave_parallel_code). */
+   UShort pinned_sector;
+
    /* This thread's name. NULL, if no name. */
    HChar *thread_name;
    UInt ptrace;
+
+   /* Indirect transfers looked up in this thread's fast cache, and the
+      misses among them, for --stats=yes.  Kept across reuse of the slot. */
+   ULong n_xIndirs;
+   ULong n_xIndir_misses;
 }
 ThreadState;
 
@@ -93,6 +93,8 @@ typedef
       Bool malloc_replacement;
       Bool xml_output;
       Bool final_IR_tidy_pass;
+      Bool parallel_threads;
+      Bool translation_cache;
    } 
    VgNeeds;
 
@@ -0,0 +1,77 @@
+
+/*--------------------------------------------------------------------*/
+/*--- Keeping translations across runs.      pub_core_transcache.h ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Valgrind, a dynamic binary instrumentation
+   framework.
+
+   Copyright (C) 2000-2017 Julian Seward
+      jseward@acm.org
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#ifndef __PUB_CORE_TRANSCACHE_H
+#define __PUB_CORE_TRANSCACHE_H
+
+#include "pub_core_basics.h"   // VG_ macro
+#include "libvex.h"            // VexGuestExtents
+
+//--------------------------------------------------------------------
+// PURPOSE: This module keeps translations of the code of shared
+// objects and executables in files (--translation-cache=<dir>), so
+// that later runs of the same program can reuse them rather than
+// translating the code again.
+//--------------------------------------------------------------------
+
+/* A translation found in the cache. */
+typedef
+   struct {
+      VexGuestExtents vge;
+      const UChar*    code;
+      UInt            code_len;
+      Int             offs_profInc;   /* -1 if none */
+      UInt            n_guest_instrs;
+   }
+   TCTrans;
+
+/* Check the cache directory and work out what the generated code
+   depends on.  Call after the tool's post_clo_init. */
+extern void VG_(init_transcache) ( void );
+
+/* Look for a saved translation starting at guest address addr.  Only
+   checks that it was made from the same code; the caller must check
+   that it would translate that code in the same way now. */
+extern Bool VG_(transcache_lookup) ( Addr addr, /*OUT*/TCTrans* res );
+
+/* Offer a new translation for saving.  It is kept only if it was made
+   from the unchanging code of an object with a build-id. */
+extern void VG_(transcache_add) ( const VexGuestExtents* vge,
+                                  const UChar* code, UInt code_len,
+                                  Int offs_profInc, UInt n_guest_instrs );
+
+/* Write out the new translations.  Called at exit and before exec. */
+extern void VG_(save_transcache) ( void );
+
+extern void VG_(print_transcache_stats) ( void );
+
+#endif   // __PUB_CORE_TRANSCACHE_H
+
+/*--------------------------------------------------------------------*/
+/*--- end                                    pub_core_transcache.h ---*/
+/*--------------------------------------------------------------------*/
@@ -44,7 +44,7 @@
    to be a bogus address for all guest code.  See pub_core_transtab_asm.h
    for further description. */
 typedef
-   struct { 
+   struct _FastCacheSet {
       Addr guest0;
       Addr host0;
       Addr guest1;
@@ -59,8 +59,14 @@ typedef
 STATIC_ASSERT(sizeof(Addr) == sizeof(UWord));
 STATIC_ASSERT(sizeof(FastCacheSet) == sizeof(Addr) * 8);
 
-extern __attribute__((aligned(64)))
-       FastCacheSet VG_(tt_fast) [VG_TT_FAST_SETS];
+/* Make sure that thread tid has a fast cache and that it does not hold
+   entries which were invalidated since the thread last ran.  This must be
+   called before the thread enters generated code. */
+extern void VG_(prepare_tt_fast) ( ThreadId tid );
+
+/* Take away the fast cache of thread tid, which no longer runs generated
+   code.  The cache is kept for reuse by other threads or unmapped. */
+extern void VG_(release_tt_fast) ( ThreadId tid );
 
 #define TRANSTAB_BOGUS_GUEST_ADDR ((Addr)1)
 
@@ -94,10 +100,11 @@ static inline UWord VG_TT_FAST_HASH ( Addr guest ) {
 #  error "VG_TT_FAST_HASH: unknown platform"
 #endif
 
-static inline Bool VG_(lookupInFastCache)( /*MB_OUT*/Addr* host, Addr guest )
+static inline Bool VG_(lookupInFastCache)( /*MB_OUT*/Addr* host,
+                                           FastCacheSet* tt_fast, Addr guest )
 {
    UWord setNo = (UInt)VG_TT_FAST_HASH(guest);
-   FastCacheSet* set = &VG_(tt_fast)[setNo];
+   FastCacheSet* set = &tt_fast[setNo];
    if (LIKELY(set->guest0 == guest)) {
       // hit at way 0
       *host = set->host0;
@@ -184,6 +191,14 @@ typedef UShort TTEno; // TTEno type identifies a TT entry in a sector.
 #define INV_SNO ((SECno)0xFFFF)
 #define INV_TTE ((TTEno)0xFFFF)
 
+/* With --parallel-threads=yes, keep the sector containing host code
+   address hcode from being recycled until it is unpinned.  Must be
+   called by a thread running generated code without the_BigLock.
+   Returns the sector, or INV_SNO if hcode is not in the translation
+   cache. */
+extern SECno VG_(pin_tc_sector)   ( Addr hcode );
+extern void  VG_(unpin_tc_sector) ( SECno sno );
+
 extern
 void VG_(tt_tc_do_chaining) ( void* from__patch_addr,
                               SECno to_sNo,
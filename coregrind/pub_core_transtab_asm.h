@@ -69,7 +69,12 @@
 
    On arm32/s390x/riscv64, the minimum instruction size is 2, so we discard only
    the least significant bit of the address, hence:
-   (address ^ (address >>u VG_TT_FAST_BITS))[VG_TT_FAST_BITS-1+1 : 0+1]'. */
+   (address ^ (address >>u VG_TT_FAST_BITS))[VG_TT_FAST_BITS-1+1 : 0+1]'.
+
+   Each thread has its own cache, so that thread switches don't evict each
+   other's entries.  A pointer to it is kept in ThreadArchState.tt_fast,
+   which immediately precedes the guest state.  The dispatchers therefore
+   find it at VG_TT_FAST_PTR_OFFSET from the guest state pointer. */
 
 #define VG_TT_FAST_BITS 13
 #define VG_TT_FAST_SETS (1 << VG_TT_FAST_BITS)
@@ -93,6 +98,8 @@
 # define FCS_h2 40
 # define FCS_g3 48
 # define FCS_h3 56
+  // Offset of ThreadArchState.tt_fast relative to ThreadArchState.vex.
+# define VG_TT_FAST_PTR_OFFSET (-8)
 
 #elif defined(VGA_x86) || defined(VGA_arm) || defined(VGA_ppc32) \
       || defined(VGA_mips32) || defined(VGP_nanomips_linux) \
@@ -107,6 +114,7 @@
 # define FCS_h2 20
 # define FCS_g3 24
 # define FCS_h3 28
+# define VG_TT_FAST_PTR_OFFSET (-4)
 
 #else
 # error "VG_FAST_CACHE_SET_BITS not known"
@@ -550,6 +550,29 @@ Bool DRD_(bm_has_1)(struct bitmap* const bm,
    return False;
 }
 
+/**
+ * Return the lowest address in range [ b, a2 [ that is covered by a second
+ * level bitmap of bm, or a2 if there is no such address. Used by the
+ * functions below to skip over large ranges without second level bitmaps,
+ * e.g. the stack of a thread that has finished, in a single OSet lookup
+ * instead of one lookup per second level bitmap that could be present.
+ */
+static Addr bm_skip_absent(struct bitmap* const bm, const Addr b, const Addr a2)
+{
+   const UWord a1 = address_msb(b);
+   const struct bitmap2* p2;
+   Addr next;
+
+   VG_(OSetGen_ResetIterAt)(bm->oset, &a1);
+   p2 = VG_(OSetGen_Next)(bm->oset);
+   if (p2 == 0)
+      return a2;
+   next = make_address(p2->addr, 0);
+   if (next < b)
+      return b;
+   return next < a2 ? next : a2;
+}
+
 void DRD_(bm_clear)(struct bitmap* const bm, Addr a1, Addr a2)
 {
    Addr b, b_next;
@@ -578,7 +601,11 @@ void DRD_(bm_clear)(struct bitmap* const bm, Addr a1, Addr a2)
       }
 
       if (p2 == 0)
+      {
+         if (b_next < a2)
+            b_next = bm_skip_absent(bm, b_next, a2);
          continue;
+      }
 
       c = b;
       /* If the first address in the bitmap that must be cleared does not */
@@ -655,7 +682,11 @@ void DRD_(bm_clear_load)(struct bitmap* const bm, Addr a1, Addr a2)
       }
 
       if (p2 == 0)
+      {
+         if (b_next < a2)
+            b_next = bm_skip_absent(bm, b_next, a2);
          continue;
+      }
 
       c = b;
       /* If the first address in the bitmap that must be cleared does not */
@@ -737,7 +768,11 @@ void DRD_(bm_clear_store)(struct bitmap* const bm,
       }
 
       if (p2 == 0)
+      {
+         if (b_next < a2)
+            b_next = bm_skip_absent(bm, b_next, a2);
          continue;
+      }
 
       c = b;
       /* If the first address in the bitmap that must be cleared does not */
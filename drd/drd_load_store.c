@@ -60,10 +60,53 @@
 #endif
 
 
+#if defined(VG_BIGENDIAN)
+#define HOST_ENDNESS Iend_BE
+#else
+#define HOST_ENDNESS Iend_LE
+#endif
+
+/*
+ * Access cache: for each access type and for each of the access sizes 1, 2,
+ * 4 and 8, a direct-mapped table with the addresses of recent accesses by the
+ * running thread that have been recorded in its current segment and that did
+ * not conflict with the conflict set. Repeating such an access would neither
+ * change the segment bitmap nor trigger a race report, so the generated code
+ * only calls the helper function for an access if it misses in this table.
+ * The whole cache is invalidated when the current segment or the conflict set
+ * of the running thread changes, and the affected entries are invalidated
+ * when memory is no longer in use. An unused entry holds ~0, an address that
+ * client code does not access in practice. Since the cache is invalidated at
+ * every synchronization operation, the entries filled since the last
+ * invalidation are logged, such that only these have to be reset unless there
+ * were more than ACCESS_CACHE_LOG_SIZE. At a context switch the logged entries
+ * are saved for the thread that stops running, and those saved for the thread
+ * that starts running are reloaded if its current segment still holds the
+ * access and if the access does not conflict with its new conflict set.
+ */
+#define ACCESS_CACHE_BITS     12
+#define ACCESS_CACHE_SIZE     (1 << ACCESS_CACHE_BITS)
+#define ACCESS_CACHE_LOG_SIZE 512
+
+
 /* Local variables. */
 
 static Bool s_check_stack_accesses = False;
 static Bool s_first_race_only      = False;
+static Bool s_inline_access_filter = True;
+/* Indexed by [access_type == eStore][log2(access size)]. */
+static Addr s_access_cache[2][4][ACCESS_CACHE_SIZE];
+static Addr* s_access_cache_log[ACCESS_CACHE_LOG_SIZE];
+static UInt s_access_cache_log_used;
+/* True such that the first flush, at the first context switch, sets up */
+/* the cache.                                                           */
+static Bool s_access_cache_log_overflow = True;
+/* Entries saved at a context switch, indexed by DRD thread ID. The index */
+/* is the offset of the entry in s_access_cache.                          */
+static struct saved_access_cache {
+   UInt count;
+   struct { Addr addr; UInt index; } entry[ACCESS_CACHE_LOG_SIZE];
+}** s_access_cache_saved;
 
 
 /* Function definitions. */
@@ -79,6 +122,177 @@ void DRD_(set_check_stack_accesses)(const Bool c)
    s_check_stack_accesses = c;
 }
 
+Bool DRD_(get_inline_access_filter)(void)
+{
+   return s_inline_access_filter;
+}
+
+void DRD_(set_inline_access_filter)(const Bool f)
+{
+   tl_assert(f == False || f == True);
+   s_inline_access_filter = f;
+}
+
+/** Invalidate all access cache entries. */
+void DRD_(access_cache_flush)(void)
+{
+   UInt i;
+
+   if (s_access_cache_log_overflow)
+   {
+      VG_(memset)(s_access_cache, 0xff, sizeof(s_access_cache));
+      s_access_cache_log_overflow = False;
+   }
+   else
+   {
+      for (i = 0; i < s_access_cache_log_used; i++)
+         *s_access_cache_log[i] = ~(Addr)0;
+   }
+   s_access_cache_log_used = 0;
+}
+
+/**
+ * Invalidate the access cache entries for accesses that overlap the address
+ * range [ a1, a2 [.
+ */
+void DRD_(access_cache_stop_using_mem)(const Addr a1, const Addr a2)
+{
+   UInt i, j;
+   Addr a;
+
+   if (s_access_cache_log_overflow)
+   {
+      if (a2 - a1 > ACCESS_CACHE_LOG_SIZE)
+      {
+         DRD_(access_cache_flush)();
+         return;
+      }
+      for (i = 0; i < 2; i++)
+      {
+         for (j = 0; j < 4; j++)
+         {
+            for (a = a1 >= (1U << j) ? a1 - (1U << j) + 1 : 0; a < a2; a++)
+            {
+               Addr* const entry
+                  = &s_access_cache[i][j][(a >> j) & (ACCESS_CACHE_SIZE - 1)];
+               if (*entry == a)
+                  *entry = ~(Addr)0;
+            }
+         }
+      }
+      return;
+   }
+
+   for (i = 0; i < s_access_cache_log_used; i++)
+   {
+      Addr* const entry = s_access_cache_log[i];
+      const UInt log2_size
+         = ((entry - &s_access_cache[0][0][0]) >> ACCESS_CACHE_BITS) & 3;
+
+      if (*entry < a2 && *entry + (1 << log2_size) > a1)
+         *entry = ~(Addr)0;
+   }
+}
+
+/**
+ * Save the access cache entries of thread old_tid, which stops running, and
+ * reload the entries saved for thread new_tid that are still valid. Must be
+ * called after the conflict set of new_tid has been computed.
+ */
+void DRD_(access_cache_switch)(const DrdThreadId old_tid,
+                               const DrdThreadId new_tid)
+{
+   struct saved_access_cache* saved;
+   struct bitmap* bm;
+   UInt i, n;
+
+   if (s_access_cache_saved == NULL)
+      s_access_cache_saved = VG_(calloc)("drd.access_cache.sv.1",
+                                         DRD_N_THREADS,
+                                         sizeof(s_access_cache_saved[0]));
+
+   if (DRD_(IsValidDrdThreadId)(old_tid) && !s_access_cache_log_overflow)
+   {
+      saved = s_access_cache_saved[old_tid];
+      if (saved == NULL)
+         saved = s_access_cache_saved[old_tid]
+            = VG_(malloc)("drd.access_cache.sv.2", sizeof(*saved));
+      for (i = n = 0; i < s_access_cache_log_used; i++)
+      {
+         Addr* const entry = s_access_cache_log[i];
+         if (*entry != ~(Addr)0)
+         {
+            saved->entry[n].addr = *entry;
+            saved->entry[n].index = entry - &s_access_cache[0][0][0];
+            n++;
+         }
+      }
+      saved->count = n;
+   }
+
+   DRD_(access_cache_flush)();
+
+   saved = s_access_cache_saved[new_tid];
+   if (saved == NULL || saved->count == 0)
+      return;
+   bm = DRD_(sg_bm)(DRD_(thread_get_segment)(new_tid));
+   for (i = 0; i < saved->count; i++)
+   {
+      const Addr addr = saved->entry[i].addr;
+      const UInt index = saved->entry[i].index;
+      const BmAccessTypeT access_type
+         = (index >> (ACCESS_CACHE_BITS + 2)) ? eStore : eLoad;
+      const SizeT size = 1 << ((index >> ACCESS_CACHE_BITS) & 3);
+      SizeT j;
+
+      for (j = 0; j < size; j++)
+      {
+         if (!DRD_(bm_has_1)(bm, addr + j, access_type))
+            break;
+      }
+      if (j < size
+          || DRD_(bm_has_conflict_with)(DRD_(g_conflict_set), addr,
+                                        addr + size, access_type))
+         continue;
+      (&s_access_cache[0][0][0])[index] = addr;
+      s_access_cache_log[s_access_cache_log_used++]
+         = &(&s_access_cache[0][0][0])[index];
+   }
+   saved->count = 0;
+}
+
+/** Discard the access cache entries saved for thread tid. */
+void DRD_(access_cache_thread_delete)(const DrdThreadId tid)
+{
+   if (s_access_cache_saved && s_access_cache_saved[tid])
+   {
+      VG_(free)(s_access_cache_saved[tid]);
+      s_access_cache_saved[tid] = NULL;
+   }
+}
+
+/**
+ * Remember that the access of 2**log2_size bytes at address addr has been
+ * recorded in the current segment of the running thread.
+ */
+static __inline__
+void access_cache_insert(const BmAccessTypeT access_type,
+                         const UInt log2_size, const Addr addr)
+{
+   Addr* entry;
+
+   if (!s_inline_access_filter)
+      return;
+
+   entry = &s_access_cache[access_type == eStore][log2_size]
+                          [(addr >> log2_size) & (ACCESS_CACHE_SIZE - 1)];
+   *entry = addr;
+   if (s_access_cache_log_used < ACCESS_CACHE_LOG_SIZE)
+      s_access_cache_log[s_access_cache_log_used++] = entry;
+   else
+      s_access_cache_log_overflow = True;
+}
+
 Bool DRD_(get_first_race_only)(void)
 {
    return s_first_race_only;
@@ -191,52 +405,62 @@ VG_REGPARM(2) void DRD_(trace_load)(Addr addr, SizeT size)
    }
 }
 
-static VG_REGPARM(1) void drd_trace_load_1(Addr addr)
+/**
+ * Check a load or store of 1, 2, 4 or 8 bytes. Since this function is always
+ * called with constant access_type and log2_size arguments, the compiler
+ * generates a specialized copy of it for each of the helpers below.
+ */
+static __inline__ __attribute__((always_inline))
+void drd_trace_access(const Addr addr, const BmAccessTypeT access_type,
+                      const UInt log2_size)
 {
-   if (DRD_(running_thread_is_recording_loads)()
-       && (s_check_stack_accesses
-           || ! DRD_(thread_address_on_stack)(addr))
-       && bm_access_load_1_triggers_conflict(addr)
-       && ! DRD_(is_suppressed)(addr, addr + 1))
+   const SizeT size = 1 << log2_size;
+   Bool conflict;
+
+   if (! (access_type == eLoad
+          ? DRD_(running_thread_is_recording_loads)()
+          : DRD_(running_thread_is_recording_stores)())
+       || (! s_check_stack_accesses
+           && DRD_(thread_address_on_stack)(addr)))
+      return;
+
+   switch (access_type == eLoad ? log2_size : 4 + log2_size)
    {
-      drd_report_race(addr, 1, eLoad);
+   case 0: conflict = bm_access_load_1_triggers_conflict(addr);  break;
+   case 1: conflict = bm_access_load_2_triggers_conflict(addr);  break;
+   case 2: conflict = bm_access_load_4_triggers_conflict(addr);  break;
+   case 3: conflict = bm_access_load_8_triggers_conflict(addr);  break;
+   case 4: conflict = bm_access_store_1_triggers_conflict(addr); break;
+   case 5: conflict = bm_access_store_2_triggers_conflict(addr); break;
+   case 6: conflict = bm_access_store_4_triggers_conflict(addr); break;
+   case 7: conflict = bm_access_store_8_triggers_conflict(addr); break;
+   default: tl_assert(0);
    }
+
+   if (! conflict)
+      access_cache_insert(access_type, log2_size, addr);
+   else if (! DRD_(is_suppressed)(addr, addr + size))
+      drd_report_race(addr, size, access_type);
+}
+
+static VG_REGPARM(1) void drd_trace_load_1(Addr addr)
+{
+   drd_trace_access(addr, eLoad, 0);
 }
 
 static VG_REGPARM(1) void drd_trace_load_2(Addr addr)
 {
-   if (DRD_(running_thread_is_recording_loads)()
-       && (s_check_stack_accesses
-           || ! DRD_(thread_address_on_stack)(addr))
-       && bm_access_load_2_triggers_conflict(addr)
-       && ! DRD_(is_suppressed)(addr, addr + 2))
-   {
-      drd_report_race(addr, 2, eLoad);
-   }
+   drd_trace_access(addr, eLoad, 1);
 }
 
 static VG_REGPARM(1) void drd_trace_load_4(Addr addr)
 {
-   if (DRD_(running_thread_is_recording_loads)()
-       && (s_check_stack_accesses
-           || ! DRD_(thread_address_on_stack)(addr))
-       && bm_access_load_4_triggers_conflict(addr)
-       && ! DRD_(is_suppressed)(addr, addr + 4))
-   {
-      drd_report_race(addr, 4, eLoad);
-   }
+   drd_trace_access(addr, eLoad, 2);
 }
 
 static VG_REGPARM(1) void drd_trace_load_8(Addr addr)
 {
-   if (DRD_(running_thread_is_recording_loads)()
-       && (s_check_stack_accesses
-           || ! DRD_(thread_address_on_stack)(addr))
-       && bm_access_load_8_triggers_conflict(addr)
-       && ! DRD_(is_suppressed)(addr, addr + 8))
-   {
-      drd_report_race(addr, 8, eLoad);
-   }
+   drd_trace_access(addr, eLoad, 3);
 }
 
 VG_REGPARM(2) void DRD_(trace_store)(Addr addr, SizeT size)
@@ -259,50 +483,22 @@ VG_REGPARM(2) void DRD_(trace_store)(Addr addr, SizeT size)
 
 static VG_REGPARM(1) void drd_trace_store_1(Addr addr)
 {
-   if (DRD_(running_thread_is_recording_stores)()
-       && (s_check_stack_accesses
-           || ! DRD_(thread_address_on_stack)(addr))
-       && bm_access_store_1_triggers_conflict(addr)
-       && ! DRD_(is_suppressed)(addr, addr + 1))
-   {
-      drd_report_race(addr, 1, eStore);
-   }
+   drd_trace_access(addr, eStore, 0);
 }
 
 static VG_REGPARM(1) void drd_trace_store_2(Addr addr)
 {
-   if (DRD_(running_thread_is_recording_stores)()
-       && (s_check_stack_accesses
-           || ! DRD_(thread_address_on_stack)(addr))
-       && bm_access_store_2_triggers_conflict(addr)
-       && ! DRD_(is_suppressed)(addr, addr + 2))
-   {
-      drd_report_race(addr, 2, eStore);
-   }
+   drd_trace_access(addr, eStore, 1);
 }
 
 static VG_REGPARM(1) void drd_trace_store_4(Addr addr)
 {
-   if (DRD_(running_thread_is_recording_stores)()
-       && (s_check_stack_accesses
-           || !DRD_(thread_address_on_stack)(addr))
-       && bm_access_store_4_triggers_conflict(addr)
-       && !DRD_(is_suppressed)(addr, addr + 4))
-   {
-      drd_report_race(addr, 4, eStore);
-   }
+   drd_trace_access(addr, eStore, 2);
 }
 
 static VG_REGPARM(1) void drd_trace_store_8(Addr addr)
 {
-   if (DRD_(running_thread_is_recording_stores)()
-       && (s_check_stack_accesses
-           || ! DRD_(thread_address_on_stack)(addr))
-       && bm_access_store_8_triggers_conflict(addr)
-       && ! DRD_(is_suppressed)(addr, addr + 8))
-   {
-      drd_report_race(addr, 8, eStore);
-   }
+   drd_trace_access(addr, eStore, 3);
 }
 
 /**
@@ -470,9 +666,106 @@ static void instr_trace_mem_store(IRSB* const bb, IRExpr* const addr_expr,
    addStmtToIRSB(bb, IRStmt_Dirty(di) );
 }
 
+/** Add the statement 'tmp = e' to bb and return tmp. */
+static IRExpr* assign_new_tmp(IRSB* const bb, IRExpr* const e)
+{
+   const IRTemp tmp = newIRTemp(bb->tyenv, typeOfIRExpr(bb->tyenv, e));
+
+   addStmtToIRSB(bb, IRStmt_WrTmp(tmp, e));
+   return IRExpr_RdTmp(tmp);
+}
+
+/**
+ * Generate code that evaluates to a nonzero Ity_I1 value if and only if the
+ * helper function has to be called for an access of 2**log2_size bytes at
+ * address addr_expr, that is if the access misses in the access cache and,
+ * for --check-stack-var=no, is not an access of the stack of the running
+ * thread. The result is and-ed with guard unless guard is NULL.
+ */
+static IRExpr* instr_access_filter(IRSB* const bb, IRExpr* const addr_expr,
+                                   const BmAccessTypeT access_type,
+                                   const UInt log2_size,
+                                   IRExpr* const guard/* NULL => True */)
+{
+   const Bool   is64     = sizeof(Addr) == 8;
+   const IRType ty       = is64 ? Ity_I64 : Ity_I32;
+   const IROp   op_add   = is64 ? Iop_Add64 : Iop_Add32;
+   const IROp   op_sub   = is64 ? Iop_Sub64 : Iop_Sub32;
+   const IROp   op_and   = is64 ? Iop_And64 : Iop_And32;
+   const IROp   op_shl   = is64 ? Iop_Shl64 : Iop_Shl32;
+   const IROp   op_shr   = is64 ? Iop_Shr64 : Iop_Shr32;
+   const IROp   op_1Uto  = is64 ? Iop_1Uto64 : Iop_1Uto32;
+   const IROp   op_cmpne = is64 ? Iop_CmpNE64 : Iop_CmpNE32;
+   IRExpr* e;
+   IRExpr* result;
+
+   tl_assert(typeOfIRExpr(bb->tyenv, addr_expr) == ty);
+
+   /* entry = s_access_cache[..][log2_size][(addr >> log2_size) & mask] */
+   e = addr_expr;
+   if (log2_size)
+      e = assign_new_tmp(bb, IRExpr_Binop(op_shr, e,
+                                          IRExpr_Const(IRConst_U8(log2_size))));
+   e = assign_new_tmp(bb, IRExpr_Binop(op_and, e,
+                                       mkIRExpr_HWord(ACCESS_CACHE_SIZE - 1)));
+   e = assign_new_tmp(bb, IRExpr_Binop(op_shl, e,
+                                       IRExpr_Const(IRConst_U8(is64 ? 3 : 2))));
+   e = assign_new_tmp(bb, IRExpr_Binop(op_add, e, mkIRExpr_HWord(
+                         (HWord)s_access_cache[access_type == eStore]
+                                              [log2_size])));
+   e = assign_new_tmp(bb, IRExpr_Load(HOST_ENDNESS, ty, e));
+   e = assign_new_tmp(bb, IRExpr_Binop(op_cmpne, e, addr_expr));
+   result = assign_new_tmp(bb, IRExpr_Unop(op_1Uto, e));
+
+   if (!s_check_stack_accesses)
+   {
+      /*
+       * The access is on the stack of the running thread if
+       * stack_min <= addr < stack_max, or equivalently if
+       * addr - stack_min < stack_max - stack_min (unsigned).
+       */
+      IRExpr* ti;
+      IRExpr* stack_min;
+      IRExpr* stack_max;
+
+      tl_assert(sizeof(DRD_(g_drd_running_tid)) == 4);
+      tl_assert(DRD_(g_threadinfo));
+      ti = assign_new_tmp(bb, IRExpr_Load(HOST_ENDNESS, Ity_I32, mkIRExpr_HWord(
+                             (HWord)&DRD_(g_drd_running_tid))));
+      if (is64)
+         ti = assign_new_tmp(bb, IRExpr_Unop(Iop_32Uto64, ti));
+      ti = assign_new_tmp(bb, IRExpr_Binop(is64 ? Iop_Mul64 : Iop_Mul32, ti,
+                                           mkIRExpr_HWord(sizeof(ThreadInfo))));
+      ti = assign_new_tmp(bb, IRExpr_Binop(op_add, ti, mkIRExpr_HWord(
+                             (HWord)DRD_(g_threadinfo))));
+      e = assign_new_tmp(bb, IRExpr_Binop(op_add, ti, mkIRExpr_HWord(
+                            offsetof(ThreadInfo, stack_min))));
+      stack_min = assign_new_tmp(bb, IRExpr_Load(HOST_ENDNESS, ty, e));
+      e = assign_new_tmp(bb, IRExpr_Binop(op_add, ti, mkIRExpr_HWord(
+                            offsetof(ThreadInfo, stack_max))));
+      stack_max = assign_new_tmp(bb, IRExpr_Load(HOST_ENDNESS, ty, e));
+      stack_max = assign_new_tmp(bb, IRExpr_Binop(op_sub, stack_max,
+                                                  stack_min));
+      e = assign_new_tmp(bb, IRExpr_Binop(op_sub, addr_expr, stack_min));
+      e = assign_new_tmp(bb, IRExpr_Binop(is64 ? Iop_CmpLE64U : Iop_CmpLE32U,
+                                          stack_max, e));
+      e = assign_new_tmp(bb, IRExpr_Unop(op_1Uto, e));
+      result = assign_new_tmp(bb, IRExpr_Binop(op_and, result, e));
+   }
+
+   if (guard)
+   {
+      e = assign_new_tmp(bb, IRExpr_Unop(op_1Uto, guard));
+      result = assign_new_tmp(bb, IRExpr_Binop(op_and, result, e));
+   }
+
+   return assign_new_tmp(bb, IRExpr_Binop(op_cmpne, result,
+                                          mkIRExpr_HWord(0)));
+}
+
 static void instrument_load(IRSB* const bb, IRExpr* const addr_expr,
                             const HWord size,
-                            IRExpr* const guard/* NULL => True */)
+                            IRExpr* guard/* NULL => True */)
 {
    IRExpr* size_expr;
    IRExpr** argv;
@@ -481,6 +774,14 @@ static void instrument_load(IRSB* const bb, IRExpr* const addr_expr,
    if (!s_check_stack_accesses && is_stack_access(bb, addr_expr))
       return;
 
+   if (s_inline_access_filter
+       && (size == 1 || size == 2 || size == 4 || size == 8))
+   {
+      guard = instr_access_filter(bb, addr_expr, eLoad,
+                                  size == 1 ? 0 : size == 2 ? 1
+                                  : size == 4 ? 2 : 3, guard);
+   }
+
    switch (size)
    {
    case 1:
@@ -526,7 +827,7 @@ static void instrument_load(IRSB* const bb, IRExpr* const addr_expr,
 
 static void instrument_store(IRSB* const bb, IRExpr* addr_expr,
                              IRExpr* const data_expr,
-                             IRExpr* const guard_expr/* NULL => True */)
+                             IRExpr* guard_expr/* NULL => True */)
 {
    IRExpr* size_expr;
    IRExpr** argv;
@@ -545,6 +846,14 @@ static void instrument_store(IRSB* const bb, IRExpr* addr_expr,
    if (!s_check_stack_accesses && is_stack_access(bb, addr_expr))
       return;
 
+   if (s_inline_access_filter
+       && (size == 1 || size == 2 || size == 4 || size == 8))
+   {
+      guard_expr = instr_access_filter(bb, addr_expr, eStore,
+                                       size == 1 ? 0 : size == 2 ? 1
+                                       : size == 4 ? 2 : 3, guard_expr);
+   }
+
    switch (size)
    {
    case 1:
@@ -29,6 +29,7 @@
 #define __DRD_LOAD_STORE_H
 
 
+#include "drd_basics.h"         /* DrdThreadId */
 #include <libvex.h>             /* IRSB */
 #include <pub_tool_tooliface.h> /* VgCallbackClosure */
 
@@ -37,6 +38,13 @@ Bool DRD_(get_check_stack_accesses)(void);
 void DRD_(set_check_stack_accesses)(const Bool c);
 Bool DRD_(get_first_race_only)(void);
 void DRD_(set_first_race_only)(const Bool fro);
+Bool DRD_(get_inline_access_filter)(void);
+void DRD_(set_inline_access_filter)(const Bool f);
+void DRD_(access_cache_flush)(void);
+void DRD_(access_cache_stop_using_mem)(const Addr a1, const Addr a2);
+void DRD_(access_cache_switch)(const DrdThreadId old_tid,
+                               const DrdThreadId new_tid);
+void DRD_(access_cache_thread_delete)(const DrdThreadId tid);
 IRSB* DRD_(instrument)(VgCallbackClosure* const closure,
                        IRSB* const bb_in,
                        const VexGuestLayout* const layout,
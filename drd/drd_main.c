@@ -69,6 +69,7 @@ static Bool DRD_(process_cmd_line_option)(const HChar* arg)
    int join_list_vol           = -1;
    int exclusive_threshold_ms  = -1;
    Bool first_race_only        = False;
+   Bool inline_access_filter   = True;
    Bool report_signal_unlocked = False;
    Bool segment_merging        = False;
    int segment_merge_interval  = -1;
@@ -99,6 +100,9 @@ static Bool DRD_(process_cmd_line_option)(const HChar* arg)
       DRD_(set_first_race_only)(first_race_only);
    }
    else if VG_BOOL_CLO(arg, "--free-is-write",       DRD_(g_free_is_write)) {}
+   else if VG_BOOL_CLO(arg, "--inline-access-filter", inline_access_filter) {
+      DRD_(set_inline_access_filter)(inline_access_filter);
+   }
    else if VG_BOOL_CLO(arg,"--report-signal-unlocked",report_signal_unlocked) {
       DRD_(cond_set_report_signal_unlocked)(report_signal_unlocked);
    }
@@ -251,6 +255,9 @@ static void DRD_(print_debug_usage)(void)
 {
    VG_(printf)(
 "    --drd-stats=yes|no        Print statistics about DRD activity [no].\n"
+"    --inline-access-filter=yes|no Skip the helper call in the generated\n"
+"                              code for loads and stores that are known not\n"
+"                              to trigger a race report [yes].\n"
 "    --trace-clientobj=yes|no  Trace all client object activity [no].\n"
 "    --trace-csw=yes|no        Trace all scheduler context switches [no].\n"
 "    --trace-conflict-set=yes|no Trace all conflict set updates [no].\n"
@@ -24,6 +24,7 @@
 #include "drd_barrier.h"
 #include "drd_clientobj.h"
 #include "drd_cond.h"
+#include "drd_load_store.h"
 #include "drd_mutex.h"
 #include "drd_segment.h"
 #include "drd_semaphore.h"
@@ -76,6 +77,10 @@ static int      s_segment_merge_interval = 10;
 static unsigned s_join_list_vol = 10;
 static unsigned s_deletion_head;
 static unsigned s_deletion_tail;
+static Segment** s_cs;
+static unsigned s_cs_size;
+static unsigned s_cs_capacity;
+static unsigned s_cs_hint;
 #if defined(VGO_solaris)
 Bool DRD_(ignore_thread_creation) = True;
 #else
@@ -544,6 +549,7 @@ void DRD_(thread_delete)(const DrdThreadId tid, const Bool detached)
       tl_assert(!DRD_(g_threadinfo)[tid].detached_posix_thread);
    DRD_(g_threadinfo)[tid].sg_first = NULL;
    DRD_(g_threadinfo)[tid].sg_last = NULL;
+   DRD_(access_cache_thread_delete)(tid);
 
    tl_assert(!DRD_(IsValidDrdThreadId)(tid));
 }
@@ -783,6 +789,8 @@ void DRD_(thread_set_running_tid)(const ThreadId vg_tid,
 
    if (vg_tid != s_vg_running_tid)
    {
+      const DrdThreadId old_tid = DRD_(g_drd_running_tid);
+
       if (s_trace_context_switches
           && DRD_(g_drd_running_tid) != DRD_INVALID_THREADID)
       {
@@ -795,6 +803,7 @@ void DRD_(thread_set_running_tid)(const ThreadId vg_tid,
       s_vg_running_tid = vg_tid;
       DRD_(g_drd_running_tid) = drd_tid;
       thread_compute_conflict_set(&DRD_(g_conflict_set), drd_tid);
+      DRD_(access_cache_switch)(old_tid, drd_tid);
       s_context_switch_count++;
    }
 
@@ -849,6 +858,9 @@ void thread_append_segment(const DrdThreadId tid, Segment* const sg)
    DRD_(g_threadinfo)[tid].sg_last = sg;
    if (DRD_(g_threadinfo)[tid].sg_first == NULL)
       DRD_(g_threadinfo)[tid].sg_first = sg;
+   /* The access cache only holds accesses of the current segment. */
+   if (tid == DRD_(g_drd_running_tid))
+      DRD_(access_cache_flush)();
 
 #ifdef ENABLE_DRD_CONSISTENCY_CHECKS
    tl_assert(DRD_(sane_ThreadInfo)(&DRD_(g_threadinfo)[tid]));
@@ -1013,6 +1025,58 @@ static void thread_discard_ordered_segments(void)
    DRD_(vc_cleanup)(&thread_vc_min);
 }
 
+/**
+ * Collect the set CS used by thread_consistent_segment_ordering(): the latest
+ * segment of each thread and all segments with a reference count strictly
+ * greater than one. Merging two segments never changes this set, so it is
+ * collected once per invocation of thread_merge_segments().
+ */
+static void thread_collect_cs(void)
+{
+   unsigned i;
+   Segment* sg;
+
+   s_cs_size = 0;
+   s_cs_hint = 0;
+   for (i = 0; i < DRD_N_THREADS; i++) {
+      for (sg = DRD_(g_threadinfo)[i].sg_first; sg; sg = sg->thr_next) {
+         if (!sg->thr_next || DRD_(sg_get_refcnt)(sg) > 1) {
+            if (s_cs_size >= s_cs_capacity) {
+               s_cs_capacity = s_cs_capacity ? 2 * s_cs_capacity : 64;
+               s_cs = VG_(realloc)("drd.thread.cs.1", s_cs,
+                                   s_cs_capacity * sizeof(s_cs[0]));
+            }
+            s_cs[s_cs_size++] = sg;
+         }
+      }
+   }
+}
+
+/**
+ * Look up the counter of thread tid in vector clock vc.
+ *
+ * @return True if vc has an element for tid, and False otherwise.
+ */
+static Bool thread_vc_lookup(const VectorClock* const vc,
+                             const DrdThreadId tid, UInt* const count)
+{
+   unsigned lo = 0, hi = vc->size;
+
+   while (lo < hi) {
+      const unsigned mid = (lo + hi) / 2;
+
+      if (vc->vc[mid].threadid < tid)
+         lo = mid + 1;
+      else if (vc->vc[mid].threadid > tid)
+         hi = mid;
+      else {
+         *count = vc->vc[mid].count;
+         return True;
+      }
+   }
+   return False;
+}
+
 /**
  * An implementation of the property 'equiv(sg1, sg2)' as defined in the paper
  * by Mark Christiaens e.a. The property equiv(sg1, sg2) holds if and only if
@@ -1041,37 +1105,74 @@ static void thread_discard_ordered_segments(void)
  *       }
  *    }
  * }
+ *
+ * Since sg1 <= sg2, the vector clocks of sg1 and sg2 only differ in the
+ * elements collected in diff[] below. vc_lte(sg1, sg) != vc_lte(sg2, sg)
+ * implies that sg has a counter lower than that of sg2 for one of these
+ * elements, and vc_lte(sg, sg1) != vc_lte(sg, sg2) implies that sg has a
+ * counter higher than that of sg1 for one of them. Most segments in CS
+ * fail both tests, which avoids comparing complete vector clocks. If sg1
+ * and sg2 differ in more than max_diff elements, e.g. because sg2 started
+ * with a synchronization operation, all vector clocks are compared. The
+ * scan starts at the segment that prevented the previous merge, since the
+ * same segment often prevents the merging of several pairs. CS must have
+ * been collected by thread_collect_cs().
  */
 static Bool thread_consistent_segment_ordering(const DrdThreadId tid,
                                                Segment* const sg1,
                                                Segment* const sg2)
 {
-   unsigned i;
+   enum { max_diff = 8 };
+   struct { DrdThreadId threadid; Bool in_sg1; UInt count1, count2; }
+      diff[max_diff];
+   const VectorClock* const vc1 = &sg1->vc;
+   const VectorClock* const vc2 = &sg2->vc;
+   unsigned i, j, m, n = 0;
+   Bool filter = True;
 
    tl_assert(sg1->thr_next);
    tl_assert(sg2->thr_next);
    tl_assert(sg1->thr_next == sg2);
-   tl_assert(DRD_(vc_lte)(&sg1->vc, &sg2->vc));
+   tl_assert(DRD_(vc_lte)(vc1, vc2));
 
-   for (i = 0; i < DRD_N_THREADS; i++)
-   {
-      Segment* sg;
+   for (i = j = 0; j < vc2->size; j++) {
+      while (i < vc1->size && vc1->vc[i].threadid < vc2->vc[j].threadid)
+         i++;
+      if (i < vc1->size && vc1->vc[i].threadid == vc2->vc[j].threadid
+          && vc1->vc[i].count == vc2->vc[j].count)
+         continue;
+      if (n == max_diff) {
+         filter = False;
+         break;
+      }
+      diff[n].threadid = vc2->vc[j].threadid;
+      diff[n].in_sg1   = i < vc1->size
+                         && vc1->vc[i].threadid == vc2->vc[j].threadid;
+      diff[n].count1   = diff[n].in_sg1 ? vc1->vc[i].count : 0;
+      diff[n].count2   = vc2->vc[j].count;
+      n++;
+   }
 
-      for (sg = DRD_(g_threadinfo)[i].sg_first; sg; sg = sg->thr_next) {
-         if (!sg->thr_next || DRD_(sg_get_refcnt)(sg) > 1) {
-            if (DRD_(vc_lte)(&sg2->vc, &sg->vc))
-               break;
-            if (DRD_(vc_lte)(&sg1->vc, &sg->vc))
-               return False;
+   for (m = 0; m < s_cs_size; m++) {
+      const unsigned k = (s_cs_hint + m) % s_cs_size;
+      const VectorClock* const vc = &s_cs[k]->vc;
+      Bool below_sg2 = !filter, above_sg1 = !filter;
+      UInt count;
+
+      for (i = 0; i < n && !(below_sg2 && above_sg1); i++) {
+         if (thread_vc_lookup(vc, diff[i].threadid, &count)) {
+            if (count < diff[i].count2)
+               below_sg2 = True;
+            if (!diff[i].in_sg1 || count > diff[i].count1)
+               above_sg1 = True;
+         } else {
+            below_sg2 = True;
          }
       }
-      for (sg = DRD_(g_threadinfo)[i].sg_last; sg; sg = sg->thr_prev) {
-         if (!sg->thr_next || DRD_(sg_get_refcnt)(sg) > 1) {
-            if (DRD_(vc_lte)(&sg->vc, &sg1->vc))
-               break;
-            if (DRD_(vc_lte)(&sg->vc, &sg2->vc))
-               return False;
-         }
+      if ((below_sg2 && DRD_(vc_lte)(vc1, vc) && !DRD_(vc_lte)(vc2, vc))
+          || (above_sg1 && DRD_(vc_lte)(vc, vc2) && !DRD_(vc_lte)(vc, vc1))) {
+         s_cs_hint = k;
+         return False;
       }
    }
    return True;
@@ -1102,6 +1203,8 @@ static void thread_merge_segments(void)
 
    s_new_segments_since_last_merge = 0;
 
+   thread_collect_cs();
+
    for (i = 0; i < DRD_N_THREADS; i++)
    {
       Segment* sg;
@@ -1288,6 +1391,7 @@ void DRD_(thread_stop_using_mem)(const Addr a1, const Addr a2)
       DRD_(bm_clear)(DRD_(sg_bm)(p), a1, a2);
 
    DRD_(bm_clear)(DRD_(g_conflict_set), a1, a2);
+   DRD_(access_cache_stop_using_mem)(a1, a2);
 }
 
 /** Specify whether memory loads should be recorded. */
@@ -1553,6 +1657,21 @@ static void thread_compute_conflict_set(struct bitmap** conflict_set,
    }
 }
 
+/**
+ * Mark the second-level bitmaps of the conflict set that overlap with bm.
+ * The marks left behind by the previous conflict set update are cleared
+ * the first time this function is called during an update.
+ */
+static void thread_mark_conflict_set(struct bitmap* const bm,
+                                     Bool* const marked)
+{
+   if (!*marked) {
+      DRD_(bm_unmark)(DRD_(g_conflict_set));
+      *marked = True;
+   }
+   DRD_(bm_mark)(DRD_(g_conflict_set), bm);
+}
+
 /**
  * Update the conflict set after the vector clock of thread tid has been
  * updated from old_vc to its current value, either because a new segment has
@@ -1564,6 +1683,7 @@ void DRD_(thread_update_conflict_set)(const DrdThreadId tid,
    const VectorClock* new_vc;
    Segment* p;
    unsigned j;
+   Bool marked = False;
 
    tl_assert(0 <= (int)tid && tid < DRD_N_THREADS
              && tid != DRD_INVALID_THREADID);
@@ -1571,6 +1691,8 @@ void DRD_(thread_update_conflict_set)(const DrdThreadId tid,
    tl_assert(tid == DRD_(g_drd_running_tid));
    tl_assert(DRD_(g_conflict_set));
 
+   DRD_(access_cache_flush)();
+
    if (s_trace_conflict_set) {
       HChar* str;
 
@@ -1584,8 +1706,6 @@ void DRD_(thread_update_conflict_set)(const DrdThreadId tid,
    new_vc = DRD_(thread_get_vc)(tid);
    tl_assert(DRD_(vc_lte)(old_vc, new_vc));
 
-   DRD_(bm_unmark)(DRD_(g_conflict_set));
-
    for (j = 0; j < DRD_N_THREADS; j++)
    {
       Segment* q;
@@ -1613,7 +1733,7 @@ void DRD_(thread_update_conflict_set)(const DrdThreadId tid,
             VG_(free)(str);
          }
          if (included_in_old_conflict_set != included_in_new_conflict_set)
-            DRD_(bm_mark)(DRD_(g_conflict_set), DRD_(sg_bm)(q));
+            thread_mark_conflict_set(DRD_(sg_bm)(q), &marked);
       }
 
       for ( ; q && !DRD_(vc_lte)(&q->vc, old_vc); q = q->thr_prev) {
@@ -1635,26 +1755,33 @@ void DRD_(thread_update_conflict_set)(const DrdThreadId tid,
             VG_(free)(str);
          }
          if (included_in_old_conflict_set != included_in_new_conflict_set)
-            DRD_(bm_mark)(DRD_(g_conflict_set), DRD_(sg_bm)(q));
+            thread_mark_conflict_set(DRD_(sg_bm)(q), &marked);
       }
    }
 
-   DRD_(bm_clear_marked)(DRD_(g_conflict_set));
+   /*
+    * If no segment entered or left the conflict set, none of the second-level
+    * bitmaps of the conflict set has to be recomputed.
+    */
+   if (marked) {
+      DRD_(bm_clear_marked)(DRD_(g_conflict_set));
 
-   p = DRD_(g_threadinfo)[tid].sg_last;
-   for (j = 0; j < DRD_N_THREADS; j++) {
-      if (j != tid && DRD_(IsValidDrdThreadId)(j)) {
-         Segment* q;
-         for (q = DRD_(g_threadinfo)[j].sg_last;
-              q && !DRD_(vc_lte)(&q->vc, &p->vc);
-              q = q->thr_prev) {
-            if (!DRD_(vc_lte)(&p->vc, &q->vc))
-               DRD_(bm_merge2_marked)(DRD_(g_conflict_set), DRD_(sg_bm)(q));
+      p = DRD_(g_threadinfo)[tid].sg_last;
+      for (j = 0; j < DRD_N_THREADS; j++) {
+         if (j != tid && DRD_(IsValidDrdThreadId)(j)) {
+            Segment* q;
+            for (q = DRD_(g_threadinfo)[j].sg_last;
+                 q && !DRD_(vc_lte)(&q->vc, &p->vc);
+                 q = q->thr_prev) {
+               if (!DRD_(vc_lte)(&p->vc, &q->vc))
+                  DRD_(bm_merge2_marked)(DRD_(g_conflict_set),
+                                         DRD_(sg_bm)(q));
+            }
          }
       }
-   }
 
-   DRD_(bm_remove_cleared_marked)(DRD_(g_conflict_set));
+      DRD_(bm_remove_cleared_marked)(DRD_(g_conflict_set));
+   }
 
    s_update_conflict_set_count++;
 
@@ -171,6 +171,26 @@ void DRD_(vc_combine)(VectorClock* const result, const VectorClock* const rhs)
    tl_assert(result);
    tl_assert(rhs);
 
+   // Fast case: both vector clocks have a clock for the same threads, which
+   // is the common case once all threads have synchronized with each other.
+   // If the thread id's turn out to differ somewhere, the general algorithm
+   // below is still correct for the elements that have already been combined.
+   if (result->size == rhs->size)
+   {
+      for (i = 0; i < rhs->size; i++)
+      {
+         if (result->vc[i].threadid != rhs->vc[i].threadid)
+            break;
+         if (rhs->vc[i].count > result->vc[i].count)
+            result->vc[i].count = rhs->vc[i].count;
+      }
+      if (i == rhs->size)
+      {
+         DRD_(vc_check)(result);
+         return;
+      }
+   }
+
    // First count the number of shared thread id's.
    j = 0;
    shared = 0;
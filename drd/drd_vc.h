@@ -100,9 +100,17 @@ static __inline__
 Bool DRD_(vc_lte)(const VectorClock* const vc1, const VectorClock* const vc2)
 {
    unsigned i;
-   unsigned j = 0;
+   unsigned j;
 
-   for (i = 0; i < vc1->size; i++)
+   /* Compare the clocks pairwise as long as both mention the same threads. */
+   for (i = 0; i < vc1->size && i < vc2->size; i++)
+   {
+      if (vc1->vc[i].threadid != vc2->vc[i].threadid)
+         break;
+      if (vc1->vc[i].count > vc2->vc[i].count)
+         return False;
+   }
+   for (j = i; i < vc1->size; i++)
    {
       while (j < vc2->size && vc2->vc[j].threadid < vc1->vc[i].threadid)
          j++;
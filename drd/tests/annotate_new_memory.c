@@ -0,0 +1,44 @@
+/*
+ * Test program that stores to a variable, declares the variable as new memory
+ * with ANNOTATE_NEW_MEMORY() and stores to it again while another thread
+ * stores to the same variable without synchronization. The second store of
+ * the main thread must be recorded again, such that the race with the store
+ * by the other thread is reported. Or: this is a test for the invalidation
+ * of the access cache when memory is declared as new.
+ */
+
+
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include "unified_annotations.h"
+
+
+static int s_i;
+
+
+static void* thread_func(void* arg)
+{
+  const struct timespec delay = { 0, 100 * 1000 * 1000 };
+
+  nanosleep(&delay, 0);
+  s_i = 3;
+  return NULL;
+}
+
+int main(int argc, char** argv)
+{
+  pthread_t tid;
+
+  pthread_create(&tid, 0, thread_func, NULL);
+
+  s_i = 1;
+  U_ANNOTATE_NEW_MEMORY(&s_i, sizeof(s_i));
+  s_i = 2;
+
+  pthread_join(tid, NULL);
+
+  fprintf(stderr, "Done.\n");
+
+  return 0;
+}
@@ -319,6 +319,43 @@ void bm_test3(const int outer_loop_step, const int inner_loop_step)
   DRD_(bm_delete)(bm1);
 }
 
+/**
+ * Test whether clearing a range that spans many absent second level bitmaps
+ * leaves the bitmaps outside that range alone.
+ */
+void bm_test4(void)
+{
+  const Addr a1 = make_address(10, 0) + 3;
+  const Addr a2 = make_address(60, 0) + 1;
+  struct bitmap* bm1;
+  struct bitmap* bm2;
+  unsigned k;
+
+  bm1 = DRD_(bm_new)();
+  bm2 = DRD_(bm_new)();
+  for (k = 1; k < 20; k++)
+  {
+    const Addr a = make_address(5 * k, 0) + k;
+
+    DRD_(bm_access_load_1)(bm1, a);
+    DRD_(bm_access_store_1)(bm1, a + 1);
+    if (a < a1 || a >= a2)
+      DRD_(bm_access_load_1)(bm2, a);
+    if (a + 1 < a1 || a + 1 >= a2)
+      DRD_(bm_access_store_1)(bm2, a + 1);
+  }
+  DRD_(bm_clear_load)(bm1, a1, a2);
+  DRD_(bm_clear_store)(bm1, a1, a2);
+  assert(bm_equal_print_diffs(bm1, bm2));
+  DRD_(bm_clear)(bm1, make_address(1, 0), make_address(1000, 0));
+  DRD_(bm_clear)(bm2, make_address(1, 0), make_address(1000, 0));
+  assert(bm_equal_print_diffs(bm1, bm2));
+  assert(! DRD_(bm_has_any_access)(bm1, make_address(1, 0),
+                                   make_address(1000, 0)));
+  DRD_(bm_delete)(bm2);
+  DRD_(bm_delete)(bm1);
+}
+
 int main(int argc, char** argv)
 {
   int outer_loop_step = ADDR_GRANULARITY;
@@ -352,6 +389,7 @@ int main(int argc, char** argv)
   bm_test1();
   bm_test2();
   bm_test3(outer_loop_step, inner_loop_step);
+  bm_test4();
   DRD_(bm_module_cleanup)();
 
   fprintf(stderr, "End of DRD BM unit test.\n");
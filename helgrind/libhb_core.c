@@ -36,7 +36,6 @@
 #include "pub_tool_machine.h"
 #include "pub_tool_mallocfree.h"
 #include "pub_tool_wordfm.h"
-#include "pub_tool_hashtable.h"
 #include "pub_tool_xarray.h"
 #include "pub_tool_oset.h"
 #include "pub_tool_threadstate.h"
@@ -304,6 +303,9 @@ typedef
    }
    RCEC;
 
+/* Nr of RCECs remembered by each thread, see _Thr.rcec_memo. */
+#define N_RCEC_MEMO 4
+
 struct _Thr {
    /* Current VTSs for this thread.  They change as we go along.  viR
       is the VTS to be used for reads, viW for writes.  Usually they
@@ -346,6 +348,18 @@ struct _Thr {
       later, by binary search. */
    XArray* /* ULong_n_EC */ local_Kws_n_stacks;
 
+   /* The RCECs retrieved for the last few values of the first frame of
+      cached_rcec, while cached_rcec stayed valid, i.e. for the last few
+      instructions accessing memory in the current function.  These
+      RCECs only differ by their first frame, and so can be retrieved
+      again without hashing and searching the frames.  The first
+      n_rcec_memo (at most N_RCEC_MEMO) entries are in use, the most
+      recently added first.  Not ref-counted: emptied when RCECs
+      are GC-ed. */
+   UInt  n_rcec_memo;
+   Addr  rcec_memo_frame0[N_RCEC_MEMO];
+   RCEC* rcec_memo[N_RCEC_MEMO];
+
    /* cached_rcec maintains the last RCEC that was retrieved for this thread. */
    RCEC cached_rcec; 
    // cached_rcec value, not ref-counted.
@@ -2424,7 +2438,19 @@ static void VTS__join ( /*OUT*/VTS* out, VTS* a, VTS* b )
       scalarts_limitations_fail_NORETURN( True/*due_to_nThrs*/ );
    tl_assert(out->sizeTS >= useda + usedb);
 
-   ia = ib = 0;
+   /* Fast case: as long as a and b mention the same threads in the
+      same order, which is what they mostly do once all threads have
+      synchronised with each other, take the later of each pair of
+      timestamps.  Then carry on with the general case from where they
+      start to differ, if they do. */
+   for (ia = 0; ia < useda && ia < usedb; ia++) {
+      if (a->ts[ia].thrid != b->ts[ia].thrid)
+         break;
+      out->ts[ia] = a->ts[ia].tym >= b->ts[ia].tym ? a->ts[ia] : b->ts[ia];
+   }
+   out->usedTS = ia;
+   ncommon     = ia;
+   ib          = ia;
 
    while (1) {
 
@@ -2517,7 +2543,17 @@ static UInt/*ThrID*/ VTS__cmpLEQ ( VTS* a, VTS* b )
    useda = a->usedTS;
    usedb = b->usedTS;
 
-   ia = ib = 0;
+   /* Fast case, as in VTS__join: compare the timestamps pairwise as
+      long as a and b mention the same threads. */
+   for (ia = 0; ia < useda && ia < usedb; ia++) {
+      if (a->ts[ia].thrid != b->ts[ia].thrid)
+         break;
+      if (a->ts[ia].tym > b->ts[ia].tym) {
+         tl_assert(a->ts[ia].thrid >= 1024);
+         return a->ts[ia].thrid;
+      }
+   }
+   ib = ia;
 
    while (1) {
 
@@ -2619,12 +2655,10 @@ Word VTS__cmp_structural ( VTS* a, VTS* b )
       ScalarTS *tmpa = NULL, *tmpb = NULL;
       stats__vts__cmp_structural_slow++;
       /* Same length vectors.  Find the first difference, if any, as
-         fast as possible. */
+         fast as possible, comparing each ScalarTS as a whole rather
+         than field by field. */
       for (i = 0; i < useda; i++) {
-         tmpa = &ctsa[i];
-         tmpb = &ctsb[i];
-         if (LIKELY(tmpa->tym == tmpb->tym
-                    && tmpa->thrid == tmpb->thrid))
+         if (LIKELY(*(ULong*)&ctsa[i] == *(ULong*)&ctsb[i]))
             continue;
          else
             break;
@@ -2634,6 +2668,8 @@ Word VTS__cmp_structural ( VTS* a, VTS* b )
          return 0;
       } else {
          tl_assert(i >= 0 && i < useda);
+         tmpa = &ctsa[i];
+         tmpb = &ctsb[i];
          if (tmpa->tym < tmpb->tym) return -1;
          if (tmpa->tym > tmpb->tym) return 1;
          if (tmpa->thrid < tmpb->thrid) return -1;
@@ -4256,22 +4292,22 @@ static inline SVal Ptr2SVal (void* ptr)
 
    2. A Hash table of OldRefs.  These store information about each old
       ref that we need to record.  Hash table key is the address of the
-      location for which the information is recorded.  For LRU
-      purposes, each OldRef in the hash table is also on a doubly
-      linked list maintaining the order in which the OldRef were most
-      recently accessed.
+      location for which the information is recorded.  The OldRefs
+      themselves are kept in a ring, in which they are re-used in CLOCK
+      order.
       Each OldRef also maintains the stamp at which it was last accessed.
       With these stamps, we can quickly check which of 2 OldRef is the
-      'newest', without having to scan the full list of LRU OldRef.
+      'newest', and whether an OldRef was accessed since the CLOCK hand
+      last went around the ring.
 
       The important part of an OldRef is, however, its acc component.
       This binds a TSW triple (thread, size, R/W) to an RCEC.
 
       We allocate a maximum of VG_(clo_conflict_cache_size) OldRef.
-      Then we do exact LRU discarding.  For each discarded OldRef we must
-      of course decrement the reference count on the RCEC it
-      refers to, in order that entries from (1) eventually get
-      discarded too.
+      Then we do CLOCK discarding, which approximates LRU.  For each
+      discarded OldRef we must of course decrement the reference count
+      on the RCEC it refers to, in order that entries from (1)
+      eventually get discarded too.
 */
 
 static UWord stats__evm__lookup_found = 0;
@@ -4459,6 +4495,7 @@ static inline UWord ROLW ( UWord w, Int n )
 static UWord stats__cached_rcec_identical = 0;
 static UWord stats__cached_rcec_updated = 0;
 static UWord stats__cached_rcec_fresh = 0;
+static UWord stats__cached_rcec_memo = 0;
 static UWord stats__cached_rcec_diff = 0;
 static UWord stats__cached_rcec_diff_known_reason = 0;
 
@@ -4672,12 +4709,24 @@ static Bool check_cached_rcec_ok (Thr* thr, Addr previous_frame0)
    return ok;
 }
 
+/* Set the hash of the frames of thr->cached_rcec. */
+static void hash_cached_rcec ( Thr* thr )
+{
+   UInt  i;
+   UWord hash = 0;
+   for (i = 0; i < HG_(clo_history_backtrace_size); i++) {
+      hash ^= thr->cached_rcec.frames[i];
+      hash = ROLW(hash, 19);
+   }
+   thr->cached_rcec.frames_hash = hash;
+}
+
 __attribute__((noinline))
 static RCEC* get_RCEC ( Thr* thr )
 {
    UInt  i;
-   UWord hash;
    Addr  previous_frame0 = 0; // Assignment needed to silence gcc
+   Bool  memo_hit = False;
    RCEC  *res;
    const Bool thr_cached_rcec_valid = cached_rcec_valid(thr);
    const Addr cur_ip = VG_(get_IP)(thr->hgthread->coretid);
@@ -4717,7 +4766,20 @@ static RCEC* get_RCEC ( Thr* thr )
          stats__cached_rcec_identical++;
       else
          stats__cached_rcec_updated++;
+
+      for (i = 0; i < thr->n_rcec_memo; i++) {
+         if (thr->rcec_memo_frame0[i] == thr->cached_rcec.frames[0]) {
+            stats__cached_rcec_memo++;
+            res = thr->rcec_memo[i];
+            memo_hit = True;
+            goto found;
+         }
+      }
    } else {
+      /* The frames other than the first one may be different: forget
+         the RCECs remembered for them. */
+      thr->n_rcec_memo = 0;
+
       /* Compute a fresh stacktrace. */
       main_get_stacktrace( thr, &thr->cached_rcec.frames[0], 
                            HG_(clo_history_backtrace_size) );
@@ -4733,16 +4795,32 @@ static RCEC* get_RCEC ( Thr* thr )
       stats__cached_rcec_fresh++;
    }
 
-   hash = 0;
-   for (i = 0; i < HG_(clo_history_backtrace_size); i++) {
-      hash ^= thr->cached_rcec.frames[i];
-      hash = ROLW(hash, 19);
-   }
-   thr->cached_rcec.frames_hash = hash;
+   hash_cached_rcec(thr);
    res = ctxt__find_or_add( &thr->cached_rcec );
 
+   /* Remember res, forgetting the least recently retrieved RCEC if
+      needed. */
+   if (thr->n_rcec_memo < N_RCEC_MEMO)
+      thr->n_rcec_memo++;
+   for (i = thr->n_rcec_memo - 1; i > 0; i--) {
+      thr->rcec_memo_frame0[i] = thr->rcec_memo_frame0[i-1];
+      thr->rcec_memo[i] = thr->rcec_memo[i-1];
+   }
+   thr->rcec_memo_frame0[0] = thr->cached_rcec.frames[0];
+   thr->rcec_memo[0] = res;
+
+  found:
    if (UNLIKELY(HG_(clo_sanity_flags) & SCE_ACCESS)
        && thr_cached_rcec_valid) {
+      /* The memo does not hold a reference on its RCECs: check that it
+         was emptied when they could have been freed, i.e. that a memoised
+         RCEC is still the one found in contextTab for the cached stack
+         trace. */
+      if (memo_hit) {
+         hash_cached_rcec(thr);
+         tl_assert(res->magic == RCEC_MAGIC);
+         tl_assert(ctxt__find_or_add( &thr->cached_rcec ) == res);
+      }
       /* In case the cached and check differ, invalidate the cached rcec.
          We have less duplicated diffs reported afterwards. */
       if (!check_cached_rcec_ok (thr, previous_frame0))
@@ -4770,7 +4848,7 @@ static RCEC* get_RCEC ( Thr* thr )
    number of held locks. The size (1,2,4,8) is stored as is in szB.
    Note that szB uses more bits than needed to store a size up to 8.
    This allows to use a TSW as a fully initialised UInt e.g. in
-   cmp_oldref_tsw. If needed, a more compact representation of szB
+   oldref_tsw. If needed, a more compact representation of szB
    can be done (e.g. use only 4 bits, or use only 2 bits and encode the
    size (1,2,4,8) as 00 = 1, 01 = 2, 10 = 4, 11 = 8. */
 typedef 
@@ -4791,8 +4869,6 @@ typedef
    struct OldRef {
       struct OldRef *ht_next; // to link hash table nodes together.
       UWord  ga; // hash_table key, == address for which we record an access.
-      struct OldRef *prev; // to refs older than this one
-      struct OldRef *next; // to refs newer that this one
       UWord stamp; // allows to order (by time of access) 2 OldRef
       Thr_n_RCEC acc;
    }
@@ -4804,87 +4880,113 @@ static inline UInt oldref_tsw (const OldRef* or)
    return *(const UInt*)(&or->acc.tsw);
 }
 
-/* Compare the tsw component for 2 OldRef.
-   Used for OldRef hashtable (which already verifies equality of the
-   'key' part. */
-static Word cmp_oldref_tsw (const void* node1, const void* node2 )
-{
-   const UInt tsw1 = oldref_tsw(node1);
-   const UInt tsw2 = oldref_tsw(node2);
 
-   if (tsw1 < tsw2) return -1;
-   if (tsw1 > tsw2) return  1;
-   return 0;
-}
+//////////// BEGIN OldRef ring
+// The OldRef are kept in a ring of at most VG_(clo_conflict_cache_size)
+// elements, allocated by chunks as they are needed.  Once the ring is
+// full, OldRef are re-used in CLOCK order: the clock hand goes around
+// the ring, and re-uses the first OldRef that was not accessed since
+// the hand started its current lap.  This approximates LRU, without
+// having to maintain a list of all OldRef in access order on each
+// access.
+#define OldRef_CHUNK_LOG2 12
+#define OldRef_CHUNK_SIZE (1 << OldRef_CHUNK_LOG2)
 
+static OldRef** oldrefChunks   = NULL; /* the ring, by chunk */
+static UWord    oldrefN        = 0;    /* # OldRef in the ring */
+static UWord    oldrefHand     = 0;    /* next OldRef to consider re-using */
+static UWord    oldrefLapStamp = 0;    /* stamp when the hand was last at 0 */
 
-//////////// BEGIN OldRef pool allocator
-static PoolAlloc* oldref_pool_allocator;
-// Note: We only allocate elements in this pool allocator, we never free them.
-// We stop allocating elements at VG_(clo_conflict_cache_size).
-//////////// END OldRef pool allocator
+static UWord stats__oldref_reused = 0;
+static UWord stats__oldref_spared = 0;
 
-static OldRef mru; 
-static OldRef lru; 
-// A double linked list, chaining all OldREf in a mru/lru order.
-// mru/lru are sentinel nodes.
-// Whenever an oldref is re-used, its position is changed as the most recently
-// used (i.e. pointed to by mru.prev).
-// When a new oldref is needed, it is allocated from the pool
-//  if we have not yet reached --conflict-cache-size.
-// Otherwise, if all oldref have already been allocated,
-// the least recently used (i.e. pointed to by lru.next) is re-used.
-// When an OldRef is used, it is moved as the most recently used entry
-// (i.e. pointed to by mru.prev).
+static inline OldRef* oldref_at ( UWord i )
+{
+   return &oldrefChunks[i >> OldRef_CHUNK_LOG2][i & (OldRef_CHUNK_SIZE - 1)];
+}
+//////////// END OldRef ring
+
+//////////// BEGIN OldRef hashtable
+// A table of 2^oldrefHTLog2 chains of OldRef, doubled when there are
+// more OldRef than chains.  Folding ga >> 3 into ga uses all chains
+// for word aligned accesses, while neighbouring addresses still land in
+// neighbouring chains.
+static OldRef** oldrefHT     = NULL; /* the chains */
+static UInt     oldrefHTLog2 = 0;
 
-// Removes r from the double linked list
-// Note: we do not need to test for special cases such as
-// NULL next or prev pointers, because we have sentinel nodes
-// at both sides of the list. So, a node is always forward and
-// backward linked.
-static inline void OldRef_unchain(OldRef *r)
+static inline OldRef** oldref_chain ( Addr ga )
 {
-   r->next->prev = r->prev;
-   r->prev->next = r->next;
+   return &oldrefHT[(ga ^ (ga >> 3)) & (((UWord)1 << oldrefHTLog2) - 1)];
 }
 
-// Insert new as the newest OldRef
-// Similarly to OldRef_unchain, no need to test for NULL
-// pointers, as e.g. mru.prev is always guaranteed to point
-// to a non NULL node (lru when the list is empty).
-static inline void OldRef_newest(OldRef *new)
+__attribute__((noinline))
+static void oldref_resize_HT ( UInt log2 )
 {
-   new->next = &mru;
-   new->prev = mru.prev;
-   mru.prev = new;
-   new->prev->next = new;
+   UWord i;
+
+   if (oldrefHT)
+      HG_(free)(oldrefHT);
+   oldrefHT = HG_(zalloc)( "libhb.oldref_resize_HT.1 (oldref hashtable)",
+                           ((SizeT)1 << log2) * sizeof(OldRef*) );
+   oldrefHTLog2 = log2;
+   for (i = 0; i < oldrefN; i++) {
+      OldRef*  ref   = oldref_at(i);
+      OldRef** chain = oldref_chain(ref->ga);
+      ref->ht_next = *chain;
+      *chain = ref;
+   }
 }
 
+static void oldref_unlink_HT ( OldRef* ref )
+{
+   OldRef** pp = oldref_chain(ref->ga);
 
-static VgHashTable* oldrefHT    = NULL; /* Hash table* OldRef* */
-static UWord     oldrefHTN    = 0;    /* # elems in oldrefHT */
-/* Note: the nr of ref in the oldrefHT will always be equal to
-   the nr of elements that were allocated from the OldRef pool allocator
-   as we never free an OldRef : we just re-use them. */
+   while (*pp != ref) {
+      tl_assert(*pp);
+      pp = &(*pp)->ht_next;
+   }
+   *pp = ref->ht_next;
+}
+//////////// END OldRef hashtable
 
+static UWord event_map_stamp = 0; // Used to stamp each OldRef when touched.
 
-/* allocates a new OldRef or re-use the lru one if all allowed OldRef
-   have already been allocated. */
+/* allocates a new OldRef or re-use one (see OldRef ring above) if all
+   allowed OldRef have already been allocated.  The returned OldRef is
+   not in the hashtable. */
 static OldRef* alloc_or_reuse_OldRef ( void )
 {
-   if (oldrefHTN < HG_(clo_conflict_cache_size)) {
-      oldrefHTN++;
-      return VG_(allocEltPA) ( oldref_pool_allocator );
-   } else {
-      OldRef *oldref_ht;
-      OldRef *oldref = lru.next;
+   OldRef* oldref;
 
-      OldRef_unchain(oldref);
-      oldref_ht = VG_(HT_gen_remove) (oldrefHT, oldref, cmp_oldref_tsw);
-      tl_assert (oldref == oldref_ht);
-      ctxt__rcdec( oldref->acc.rcec );
+   if (oldrefN < HG_(clo_conflict_cache_size)) {
+      if (oldrefN == ((UWord)1 << oldrefHTLog2))
+         oldref_resize_HT(oldrefHTLog2 + 1);
+      if ((oldrefN & (OldRef_CHUNK_SIZE - 1)) == 0)
+         oldrefChunks[oldrefN >> OldRef_CHUNK_LOG2]
+            = HG_(zalloc)( "libhb.alloc_or_reuse_OldRef.1 (OldRef chunk)",
+                           OldRef_CHUNK_SIZE * sizeof(OldRef) );
+      oldref = oldref_at(oldrefN);
+      oldrefN++;
       return oldref;
    }
+
+   while (True) {
+      oldref = oldref_at(oldrefHand);
+      oldrefHand++;
+      if (oldrefHand == oldrefN) {
+         oldrefHand = 0;
+         oldrefLapStamp = event_map_stamp;
+      }
+      /* The stamps are 'rolled', see libhb_event_map_lookup. */
+      if (event_map_stamp - oldref->stamp
+          > event_map_stamp - oldrefLapStamp)
+         break;
+      stats__oldref_spared++;
+   }
+   oldref_unlink_HT(oldref);
+   ctxt__rcdec( oldref->acc.rcec );
+   stats__oldref_reused++;
+   return oldref;
 }
 
 
@@ -4911,12 +5013,11 @@ static inline Word cmp_nonempty_intervals ( Addr a1, SizeT n1,
    return 0;
 }
 
-static UWord event_map_stamp = 0; // Used to stamp each OldRef when touched.
-
 static void event_map_bind ( Addr a, SizeT szB, Bool isW, Thr* thr )
 {
    OldRef  example;
    OldRef* ref;
+   OldRef** chain;
    RCEC*   rcec;
 
    tl_assert(thr);
@@ -4929,16 +5030,17 @@ static void event_map_bind ( Addr a, SizeT szB, Bool isW, Thr* thr )
 
    /* Look in the oldrefHT to see if we already have a record for this
       address/thr/sz/isW. */
-   example.ga = a;
    example.acc.tsw = (TSW) {.thrid = thrid,
                             .szB = szB,
                             .isW = (UInt)(isW & 1)};
-   ref = VG_(HT_gen_lookup) (oldrefHT, &example, cmp_oldref_tsw);
+   for (ref = *oldref_chain(a); ref; ref = ref->ht_next) {
+      if (ref->ga == a && oldref_tsw(ref) == oldref_tsw(&example))
+         break;
+   }
 
    if (ref) {
       /* We already have a record for this address and this (thrid, R/W,
          size) triple. */
-      tl_assert (ref->ga == a);
 
       /* thread 'thr' has an entry.  Update its RCEC, if it differs. */
       if (rcec == ref->acc.rcec)
@@ -4954,9 +5056,6 @@ static void event_map_bind ( Addr a, SizeT szB, Bool isW, Thr* thr )
       ref->stamp = event_map_stamp;
       ref->acc.locksHeldW = locksHeldW;
 
-      OldRef_unchain(ref);
-      OldRef_newest(ref);
-
    } else {
       tl_assert (szB == 4 || szB == 8 ||szB == 1 || szB == 2);
       // We only need to check the size the first time we insert a ref.
@@ -4967,16 +5066,17 @@ static void event_map_bind ( Addr a, SizeT szB, Bool isW, Thr* thr )
       stats__ctxt_neq_tsw_neq_rcec++;
       ref = alloc_or_reuse_OldRef();
       ref->ga = a;
-      ref->acc.tsw = (TSW) {.thrid  = thrid,
-                            .szB    = szB,
-                            .isW    = (UInt)(isW & 1)};
+      ref->acc.tsw = example.acc.tsw;
       ref->stamp = event_map_stamp;
       ref->acc.locksHeldW = locksHeldW;
       ref->acc.rcec       = rcec;
       ctxt__rcinc(rcec);
 
-      VG_(HT_add_node) ( oldrefHT, ref );
-      OldRef_newest (ref);
+      /* alloc_or_reuse_OldRef might have resized the hashtable, so
+         only look for the chain now. */
+      chain = oldref_chain(a);
+      ref->ht_next = *chain;
+      *chain = ref;
    }
    event_map_stamp++;
 }
@@ -5025,7 +5125,7 @@ Bool libhb_event_map_lookup ( /*OUT*/ExeContext** resEC,
          We might have several of these. They will be linked via ht_next.
          We however need to check various elements as the list contains
          all elements that map to the same bucket. */
-      for (cand_ref = VG_(HT_lookup)( oldrefHT, cand_a ); 
+      for (cand_ref = *oldref_chain(cand_a);
            cand_ref; cand_ref = cand_ref->ht_next) {
          if (cand_ref->ga != cand_a)
             /* OldRef for another address in this HT bucket. Ignore. */
@@ -5092,33 +5192,58 @@ Bool libhb_event_map_lookup ( /*OUT*/ExeContext** resEC,
 }
 
 
+/* Orders 2 OldRef* by time of access, oldest first. */
+static Int cmp_oldref_stamp ( const void* a, const void* b )
+{
+   const OldRef* ref1 = *(const OldRef* const *)a;
+   const OldRef* ref2 = *(const OldRef* const *)b;
+
+   if ((ref1->stamp - event_map_stamp) < (ref2->stamp - event_map_stamp))
+      return -1;
+   if ((ref1->stamp - event_map_stamp) > (ref2->stamp - event_map_stamp))
+      return 1;
+   return 0;
+}
+
 void libhb_event_map_access_history ( Addr a, SizeT szB, Access_t fn )
 {
-   OldRef *ref = lru.next;
+   OldRef *ref;
+   XArray *refs;
    SizeT ref_szB;
+   RCEC* ref_rcec;
+   UWord i;
+   Word k;
    Int n;
 
-   while (ref != &mru) {
+   /* Collect the OldRef overlapping [a, a+szB[, and report them from
+      the least to the most recently accessed. */
+   refs = VG_(newXA)( HG_(zalloc), "libhb.event_map_access_history.1",
+                      HG_(free), sizeof(OldRef*) );
+   for (i = 0; i < oldrefN; i++) {
+      ref = oldref_at(i);
+      if (cmp_nonempty_intervals(a, szB, ref->ga, ref->acc.tsw.szB) == 0)
+         VG_(addToXA)( refs, &ref );
+   }
+   VG_(setCmpFnXA)( refs, cmp_oldref_stamp );
+   VG_(sortXA)( refs );
+
+   for (k = 0; k < VG_(sizeXA)( refs ); k++) {
+      ref = *(OldRef**)VG_(indexXA)( refs, k );
       ref_szB = ref->acc.tsw.szB;
-      if (cmp_nonempty_intervals(a, szB, ref->ga, ref_szB) == 0) {
-         RCEC* ref_rcec = ref->acc.rcec;
-         for (n = 0; n < HG_(clo_history_backtrace_size); n++) {
-            if (0 == ref_rcec->frames[n]) {
-               break;
-            }
+      ref_rcec = ref->acc.rcec;
+      for (n = 0; n < HG_(clo_history_backtrace_size); n++) {
+         if (0 == ref_rcec->frames[n]) {
+            break;
          }
-         (*fn)(&ref_rcec->frames[0], n,
-               Thr__from_ThrID(ref->acc.tsw.thrid),
-               ref->ga,
-               ref_szB,
-               ref->acc.tsw.isW,
-               ref->acc.locksHeldW);
       }
-      tl_assert (ref->next == &mru
-                 || ((ref->stamp - event_map_stamp)
-                        < ref->next->stamp - event_map_stamp));
-      ref = ref->next;
+      (*fn)(&ref_rcec->frames[0], n,
+            Thr__from_ThrID(ref->acc.tsw.thrid),
+            ref->ga,
+            ref_szB,
+            ref->acc.tsw.isW,
+            ref->acc.locksHeldW);
    }
+   VG_(deleteXA)( refs );
 }
 
 static void event_map_init ( void )
@@ -5142,30 +5267,17 @@ static void event_map_init ( void )
    for (i = 0; i < N_RCEC_TAB; i++)
       contextTab[i] = NULL;
 
-   /* Oldref pool allocator */
-   oldref_pool_allocator = VG_(newPA)(
-                               sizeof(OldRef),
-                               1000 /* OldRefs per pool */,
-                               HG_(zalloc),
-                               "libhb.event_map_init.3 (OldRef pools)",
-                               HG_(free)
-                            );
+   /* Oldref ring chunks */
+   tl_assert(!oldrefChunks);
+   oldrefChunks = HG_(zalloc)( "libhb.event_map_init.3 (OldRef chunks)",
+                               (HG_(clo_conflict_cache_size)
+                                + OldRef_CHUNK_SIZE - 1)
+                               / OldRef_CHUNK_SIZE * sizeof(OldRef*) );
 
    /* Oldref hashtable */
    tl_assert(!oldrefHT);
-   oldrefHT = VG_(HT_construct) ("libhb.event_map_init.4 (oldref hashtable)");
-
-   oldrefHTN = 0;
-   mru.prev = &lru;
-   mru.next = NULL;
-   lru.prev = NULL;
-   lru.next = &mru;
-   mru.acc = (Thr_n_RCEC) {.tsw = {.thrid = 0, 
-                                   .szB = 0, 
-                                   .isW = 0},
-                           .locksHeldW = 0, 
-                           .rcec = NULL};
-   lru.acc = mru.acc;
+   oldrefN = 0;
+   oldref_resize_HT(12);
 }
 
 static void event_map__check_reference_counts ( void )
@@ -5194,14 +5306,12 @@ static void event_map__check_reference_counts ( void )
    tl_assert(stats__ctxt_tab_curr <= stats__ctxt_tab_max);
 
    /* visit all the referencing points, inc check ref counts */
-   VG_(HT_ResetIter)( oldrefHT );
-   oldref = VG_(HT_Next)( oldrefHT );
-   while (oldref) {
+   for (i = 0; i < oldrefN; i++) {
+      oldref = oldref_at(i);
       tl_assert (oldref->acc.tsw.thrid);
       tl_assert (oldref->acc.rcec);
       tl_assert (oldref->acc.rcec->magic == RCEC_MAGIC);
       oldref->acc.rcec->rcX++;
-      oldref = VG_(HT_Next)( oldrefHT );
    }
 
    /* compare check ref counts with actual */
@@ -5230,6 +5340,12 @@ static void do_RCEC_GC ( void )
    }
    tl_assert (stats__ctxt_tab_curr > RCEC_referenced);
 
+   /* The RCECs remembered by the threads might be thrown away. */
+   for (Word ix = 0; ix < VG_(sizeXA)( thrid_to_thr_map ); ix++) {
+      Thr* thr = *(Thr**)VG_(indexXA)( thrid_to_thr_map, ix );
+      thr->n_rcec_memo = 0;
+   }
+
    /* Throw away all RCECs with zero reference counts */
    for (i = 0; i < N_RCEC_TAB; i++) {
       RCEC** pp = &contextTab[i];
@@ -6797,13 +6913,13 @@ void libhb_shutdown ( Bool show_stats )
       }
 
       VG_(printf)("%s","\n");
-      VG_(printf)( "   libhb: oldrefHTN %lu (%'d bytes)\n",
-                   oldrefHTN, (int)(oldrefHTN * sizeof(OldRef)));
-      tl_assert (oldrefHTN == VG_(HT_count_nodes) (oldrefHT));
+      VG_(printf)( "   libhb: oldrefN %lu (%'d bytes), %lu HT chains\n",
+                   oldrefN, (int)(oldrefN * sizeof(OldRef)),
+                   (UWord)1 << oldrefHTLog2);
+      VG_(printf)( "   libhb: oldref reused %'lu (%'lu spared by clock)\n",
+                   stats__oldref_reused, stats__oldref_spared);
       VG_(printf)( "   libhb: oldref lookup found=%lu notfound=%lu\n",
                    stats__evm__lookup_found, stats__evm__lookup_notfound);
-      if (VG_(clo_verbosity) > 1)
-         VG_(HT_print_stats) (oldrefHT, cmp_oldref_tsw);
       VG_(printf)( "   libhb: oldref bind tsw/rcec "
                    "==/==:%'lu ==/!=:%'lu !=/!=:%'lu\n",
                    stats__ctxt_eq_tsw_eq_rcec, stats__ctxt_eq_tsw_neq_rcec,
@@ -6817,9 +6933,9 @@ void libhb_shutdown ( Bool show_stats )
                    stats__ctxt_tab_curr, RCEC_referenced,
                    stats__ctxt_tab_max );
       VG_(printf) ("   libhb: stats__cached_rcec "
-                   "identical %'lu updated %'lu fresh %'lu\n",
+                   "identical %'lu updated %'lu fresh %'lu memo %'lu\n",
                    stats__cached_rcec_identical, stats__cached_rcec_updated,
-                   stats__cached_rcec_fresh);
+                   stats__cached_rcec_fresh, stats__cached_rcec_memo);
       if (stats__cached_rcec_diff > 0)
          VG_(printf) ("   libhb: stats__cached_rcec diff unk reason%'lu\n",
                       stats__cached_rcec_diff);
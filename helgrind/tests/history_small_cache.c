@@ -0,0 +1,49 @@
+/* Run with --history-level=full and the smallest --conflict-cache-size.
+   The program writes many more words than there are OldRefs, so that
+   these are re-used over and over, from so many different stack traces
+   that the RCECs are garbage collected, which also empties the RCECs
+   memoised by the thread.  Each call of leaf() starts with a
+   happens-before annotation, so that its stores change the shadow values
+   of the words and are recorded in the conflicting access history. */
+
+#include "../../helgrind/helgrind.h"
+
+/* 2^DEPTH different stack traces, each DEPTH + 2 frames deep. */
+#define DEPTH  16
+#define NWORDS (1 << 15)
+
+static int words[NWORDS];
+static int so;
+
+__attribute__((noinline))
+static void leaf(unsigned path)
+{
+   int i;
+
+   ANNOTATE_HAPPENS_BEFORE(&so);
+   /* Both iterations store from the same instruction, so the second one
+      finds the RCEC of the first in the memo. */
+   for (i = 0; i < 2; i++)
+      words[(path + i) % NWORDS] = i;
+}
+
+/* Reach leaf() through one of two call sites at each level. */
+__attribute__((noinline))
+static void walk(int depth, unsigned path)
+{
+   if (depth == 0)
+      leaf(path);
+   else if (path & (1u << (depth - 1)))
+      walk(depth - 1, path);
+   else
+      walk(depth - 1, path);
+}
+
+int main(void)
+{
+   unsigned path;
+
+   for (path = 0; path < (1u << DEPTH); path++)
+      walk(DEPTH, path);
+   return 0;
+}
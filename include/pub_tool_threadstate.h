@@ -42,6 +42,23 @@ extern UInt VG_N_THREADS;
 /* Get the TID of the thread which currently has the CPU. */
 extern ThreadId VG_(get_running_tid) ( void );
 
+/* Call fn(opaque, i, n) for each i in 0 .. n-1, all at the same time,
+   and return when they have all returned.  i == 0 runs in the calling
+   thread, the others in helper threads which have no ThreadId, never
+   hold the big lock, and start with all signals blocked.  A helper may
+   unblock SIGSEGV and SIGBUS while a fault catcher is set (see
+   pub_tool_signals.h); the catcher must then not return.  n may be
+   reduced if not enough helper threads can be started (always to 1 on
+   non-Linux platforms); fn is told the number actually used. */
+extern void VG_(run_in_helper_threads) ( UInt n,
+                                         void (*fn)(void* opaque,
+                                                    UInt i, UInt n),
+                                         void* opaque );
+
+/* Let another host thread run, for use by helper threads waiting for
+   each other. */
+extern void VG_(helper_thread_yield) ( void );
+
 #endif   // __PUB_TOOL_THREADSTATE_H
 
 /*--------------------------------------------------------------------*/
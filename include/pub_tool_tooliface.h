@@ -499,6 +499,22 @@ extern void VG_(needs_xml_output) ( void );
    function here. */
 extern void VG_(needs_final_IR_tidy_pass) ( IRSB*(*final_tidy)(IRSB*) );
 
+/* Can the instrumented code be run by several threads at once
+   (--parallel-threads=yes)?  Generated code then runs without the big
+   lock, so the tool's instrumentation and helper functions must not
+   touch any shared state without their own synchronisation, and must
+   not call core functions other than pure ones.  The core still
+   serialises everything else, including the tool's event callbacks and
+   client requests. */
+extern void VG_(needs_parallel_threads) ( void );
+
+/* Can translations be saved and reused by later runs
+   (--translation-cache=<dir>)?  Only if the instrumented code depends
+   on nothing but the guest code and the command line: it must not
+   refer to memory the tool allocates at run time, or to anything which
+   may be at a different address in the next run. */
+extern void VG_(needs_translation_cache) ( void );
+
 
 /* ------------------------------------------------------------------ */
 /* Core events to track */
@@ -509,6 +509,23 @@ extern HChar * MC_(snprintf_delta) (HChar * buf, Int size,
 
 Bool MC_(is_valid_aligned_word)     ( Addr a );
 Bool MC_(is_within_valid_secondary) ( Addr a );
+void MC_(freeze_auxmap_L1)          ( Bool frozen );
+
+/* For --incremental-leak-check=yes.  MC_(leak_dirty_map) has one byte
+   per 64KB of address space (wrapping around every
+   1 << (16 + MC_LEAK_DIRTY_BITS) bytes), set to 1 when the client
+   memory or its V+A bits in that range may have changed since the
+   last leak search.  Generated code marks the stores it does; the
+   rest is done with MC_(leak_mark_dirty). */
+#if VG_WORDSIZE == 8
+#  define MC_LEAK_DIRTY_BITS 21
+#else
+#  define MC_LEAK_DIRTY_BITS 16
+#endif
+#define MC_LEAK_DIRTY_IDX(a) \
+   (((a) >> 16) & ((1 << MC_LEAK_DIRTY_BITS) - 1))
+extern UChar MC_(leak_dirty_map)[1 << MC_LEAK_DIRTY_BITS];
+void MC_(leak_mark_dirty) ( Addr a, SizeT len );
 
 // Prints as user msg a description of the given loss record.
 void MC_(pp_LossRecord)(UInt n_this_record, UInt n_total_records,
@@ -680,6 +697,15 @@ typedef
    Default : all heuristics. */
 extern UInt MC_(clo_leak_check_heuristics);
 
+/* How many host threads share the root set scan and the marking of
+   the leak search.  Default : 1. */
+extern Int MC_(clo_leak_check_threads);
+
+/* Keep the results of a leak search's memory scan for the parts of
+   memory which are not written before the next leak search.
+   Default : NO */
+extern Bool MC_(clo_incremental_leak_check);
+
 /* Assume accesses immediately below %esp are due to gcc-2.96 bugs.
  * default: NO */
 extern Bool MC_(clo_workaround_gcc296_bugs);
@@ -732,6 +758,10 @@ extern KeepStacktraces MC_(clo_keep_stacktraces);
 */
 extern Int MC_(clo_mc_level);
 
+/* Number of lines per set (2, 4 or 8) of the L1 cache of origin tags,
+   whose size is fixed.  Default: 2 */
+extern UInt MC_(clo_origin_cache_ways);
+
 /* Should we show mismatched frees?  Default: YES */
 extern Bool MC_(clo_show_mismatched_frees);
 
@@ -752,6 +782,15 @@ typedef
    operations.  Default: EdcAUTO */
 extern ExpensiveDefinednessChecks MC_(clo_expensive_definedness_checks);
 
+/* Find the shadow memory for addresses above those covered by the main
+   primary map with a radix tree (True), rather than a move-to-front
+   list and an OSet (False)?  Default: NO */
+extern Bool MC_(clo_aux_primary_map_radix);
+
+/* Give back the secondary maps whose content has become uniform,
+   replacing them by distinguished ones?  Default: NO */
+extern Bool MC_(clo_compact_secmaps);
+
 /* Do we have a range of stack offsets to ignore?  Default: NO */
 extern Bool MC_(clo_ignore_range_below_sp);
 extern UInt MC_(clo_ignore_range_below_sp__first_offset);
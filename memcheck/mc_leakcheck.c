@@ -35,6 +35,7 @@
 #include "pub_tool_libcbase.h"
 #include "pub_tool_libcassert.h"
 #include "pub_tool_libcprint.h"
+#include "pub_tool_libcproc.h"      // VG_(gettid)
 #include "pub_tool_libcsignal.h"
 #include "pub_tool_machine.h"
 #include "pub_tool_mallocfree.h"
@@ -43,6 +44,7 @@
 #include "pub_tool_poolalloc.h"     
 #include "pub_tool_signals.h"       // Needed for mc_include.h
 #include "pub_tool_libcsetjmp.h"    // setjmp facilities
+#include "pub_tool_threadstate.h"   // VG_(run_in_helper_threads)
 #include "pub_tool_tooliface.h"     // Needed for mc_include.h
 #include "pub_tool_xarray.h"
 #include "pub_tool_xtree.h"
@@ -449,12 +451,21 @@ get_sorted_array_of_active_chunks(Int* pn_chunks)
 // Holds extra info about each block during leak checking.
 typedef 
    struct {
-      UInt  state:2;    // Reachedness.
-      UInt  pending:1;  // Scan pending.
-      UInt  heuristic: (sizeof(UInt)*8)-3;
-      // Heuristic with which this block was considered reachable.
-      // LchNone if state != Reachable or no heuristic needed to
-      // consider it reachable.
+      union {
+         struct {
+            UInt  state:2;    // Reachedness.
+            UInt  pending:1;  // Scan pending.
+            UInt  heuristic: (sizeof(UInt)*8)-3;
+            // Heuristic with which this block was considered reachable.
+            // LchNone if state != Reachable or no heuristic needed to
+            // consider it reachable.  During the parallel marking, the
+            // set (see H2S) of the heuristics that match a definite
+            // interior pointer to a block which is not Reachable.
+         };
+         UInt word;
+         // All of the above, for the compare-and-swap updates of a
+         // parallel leak search (see lc_par_reach).
+      };
    
       union {
          SizeT indirect_szB;
@@ -512,12 +523,40 @@ static Int* lc_markstack;
 // the stack has one element, 1 if it has two, etc.
 static Int  lc_markstack_top;    
 
-// Keeps track of how many bytes of memory we've scanned, for printing.
-// (Nb: We don't keep track of how many register bytes we've scanned.)
-static SizeT lc_scanned_szB;
-// Keeps track of how many bytes we have not scanned due to read errors that
-// caused a signal such as SIGSEGV.
-static SizeT lc_sig_skipped_szB;
+// Per-thread state of a leak search.  A search done by a single thread
+// uses lc_serial_worker.  With --leak-check-threads=N, each of the N
+// threads has its own entry in lc_workers (see "Parallel marking" below).
+#define LC_LOCAL_STACK_SIZE 256
+typedef
+   struct {
+      Int   lwpid;
+      // Host thread using this entry, for lc_fault_catcher.
+      SizeT scanned_szB;
+      // Keeps track of how many bytes of memory we've scanned, for printing.
+      // (Nb: We don't keep track of how many register bytes we've scanned.)
+      SizeT sig_skipped_szB;
+      // Keeps track of how many bytes we have not scanned due to read
+      // errors that caused a signal such as SIGSEGV.
+      SizeT reused_szB;
+      // How many bytes were not scanned again thanks to
+      // --incremental-leak-check=yes, see lc_scan_regions.
+      volatile Addr bad_scanned_addr;
+      // Address of the last read error, see leak_search_fault_catcher.
+      Bool  in_heuristic;
+      // True while in heuristic_reachedness, whose read errors go to
+      // heuristic_jmpbuf rather than to scan_jmpbuf.
+      VG_MINIMAL_JMP_BUF(scan_jmpbuf);
+      VG_MINIMAL_JMP_BUF(heuristic_jmpbuf);
+      Int   n_local;
+      Int   local[LC_LOCAL_STACK_SIZE];
+      // Blocks pushed by this thread and not yet moved to lc_markstack
+      // (parallel search only).
+   }
+   LC_Worker;
+
+static LC_Worker  lc_serial_worker;
+static LC_Worker* lc_workers   = &lc_serial_worker;
+static UInt       lc_n_workers = 1;
 
 
 SizeT MC_(bytes_leaked)     = 0;
@@ -539,15 +578,149 @@ static SizeT MC_(bytes_heuristically_reachable)[N_LEAK_CHECK_HEURISTICS]
 static SizeT MC_(blocks_heuristically_reachable)[N_LEAK_CHECK_HEURISTICS]
                                                 = {0,0,0,0};
 
+// A lookup index over lc_chunks, used by lc_is_a_chunk_ptr instead of a
+// binary search of the whole of lc_chunks.  [lc_index_lo, lc_index_hi) is
+// divided in buckets of 2^lc_index_bshift bytes, there being at most about
+// two buckets per chunk; lc_index_bucket[b] is the number of chunks that
+// start below bucket b, so that a pointer in bucket b can only be inside
+// chunk lc_index_bucket[b]-1 or one starting in bucket b.  lc_index_start
+// and lc_index_end hold the extent of each chunk (zero-sized ones having
+// size 1, as in find_chunk_for) in arrays of their own, so that the search
+// does not have to go through the MC_Chunk.
+// lc_index_filter has a bit for each 2^lc_index_fshift bytes, set when a
+// chunk covers some of them: most of the words scanned are not pointers to
+// a chunk, and this rejects them with a single load, before asking aspacemgr
+// whether they point to client memory at all.
+// The index is only built when no two chunks overlap (see the sanity check
+// in MC_(detect_memory_leaks)); otherwise, lc_is_a_chunk_ptr uses
+// find_chunk_for.
+static Bool   lc_index_usable;
+static Addr   lc_index_lo;
+static Addr   lc_index_hi;
+static UInt   lc_index_bshift;
+static UInt   lc_index_fshift;
+static Int*   lc_index_bucket;
+static Addr*  lc_index_start;
+static Addr*  lc_index_end;
+static UWord* lc_index_filter;
+
+#define LC_INDEX_FILTER_BITS (8 * sizeof(UWord))
+
+static void lc_free_index(void)
+{
+   VG_(free)(lc_index_start);
+   VG_(free)(lc_index_end);
+   VG_(free)(lc_index_bucket);
+   VG_(free)(lc_index_filter);
+   lc_index_start  = NULL;
+   lc_index_end    = NULL;
+   lc_index_bucket = NULL;
+   lc_index_filter = NULL;
+   lc_index_usable = False;
+}
+
+// Builds the lookup index for the lc_n_chunks chunks of lc_chunks.
+static void lc_build_index(void)
+{
+   Int   i, c;
+   UWord span, b, n_buckets, n_granules, g, g_last;
+
+   lc_free_index();
+   tl_assert(lc_n_chunks > 0);
+
+   lc_index_start = VG_(malloc)("mc.lbi.1", lc_n_chunks * sizeof(Addr));
+   lc_index_end   = VG_(malloc)("mc.lbi.2", lc_n_chunks * sizeof(Addr));
+   for (i = 0; i < lc_n_chunks; i++) {
+      lc_index_start[i] = lc_chunks[i]->data;
+      lc_index_end[i]   = lc_chunks[i]->data + lc_chunks[i]->szB
+                          + (lc_chunks[i]->szB == 0 ? 1 : 0);
+      if (i > 0 && lc_index_start[i] < lc_index_end[i-1]) {
+         // Overlapping (metapool) chunks: a pointer can be inside
+         // several of them, let find_chunk_for choose as it always did.
+         lc_free_index();
+         return;
+      }
+   }
+   lc_index_lo = lc_index_start[0];
+   lc_index_hi = lc_index_end[lc_n_chunks-1];
+   span = lc_index_hi - lc_index_lo;
+
+   lc_index_bshift = 4;
+   while ((span >> lc_index_bshift) >= 2 * (UWord)lc_n_chunks)
+      lc_index_bshift++;
+   lc_index_fshift = lc_index_bshift > 7 ? lc_index_bshift - 3 : 4;
+
+   n_buckets = (span >> lc_index_bshift) + 1;
+   lc_index_bucket = VG_(malloc)("mc.lbi.3", (n_buckets + 1) * sizeof(Int));
+   c = 0;
+   for (b = 0; b < n_buckets; b++) {
+      Addr base = lc_index_lo + (b << lc_index_bshift);
+      while (c < lc_n_chunks && lc_index_start[c] < base)
+         c++;
+      lc_index_bucket[b] = c;
+   }
+   lc_index_bucket[n_buckets] = lc_n_chunks;
+
+   n_granules = (span >> lc_index_fshift) + 1;
+   lc_index_filter = VG_(calloc)("mc.lbi.4",
+                                 n_granules / LC_INDEX_FILTER_BITS + 1,
+                                 sizeof(UWord));
+   for (i = 0; i < lc_n_chunks; i++) {
+      g      = (lc_index_start[i] - lc_index_lo) >> lc_index_fshift;
+      g_last = (lc_index_end[i] - 1 - lc_index_lo) >> lc_index_fshift;
+      for (; g <= g_last; g++)
+         lc_index_filter[g / LC_INDEX_FILTER_BITS]
+            |= (UWord)1 << (g % LC_INDEX_FILTER_BITS);
+   }
+
+   lc_index_usable = True;
+}
+
+// Same as find_chunk_for(ptr, lc_chunks, lc_n_chunks), using the index.
+static Int lc_index_lookup(Addr ptr)
+{
+   UWord g, b;
+   Int   lo, hi, mid;
+
+   if (ptr < lc_index_lo || ptr >= lc_index_hi)
+      return -1;
+   g = (ptr - lc_index_lo) >> lc_index_fshift;
+   if (!(lc_index_filter[g / LC_INDEX_FILTER_BITS]
+         & ((UWord)1 << (g % LC_INDEX_FILTER_BITS))))
+      return -1;
+
+   // Find the last chunk starting at or below ptr.
+   b  = (ptr - lc_index_lo) >> lc_index_bshift;
+   lo = lc_index_bucket[b];
+   hi = lc_index_bucket[b+1];
+   while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (lc_index_start[mid] <= ptr)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   lo--;
+   if (lo >= 0 && ptr < lc_index_end[lo])
+      return lo;
+   return -1;
+}
+
 // Determines if a pointer is to a chunk.  Returns the chunk number et al
 // via call-by-reference.
 static Bool
 lc_is_a_chunk_ptr(Addr ptr, Int* pch_no, MC_Chunk** pch, LC_Extra** pex)
 {
-   Int ch_no;
+   Int ch_no = -1;
    MC_Chunk* ch;
    LC_Extra* ex;
 
+   if (lc_index_usable) {
+      ch_no = lc_index_lookup(ptr);
+      if (ch_no == -1)
+         return False;
+   }
+
    // Quick filter. Note: implemented with am, not with get_vabits2
    // as ptr might be random data pointing anywhere. On 64 bit
    // platforms, getting va bits for random data can be quite costly
@@ -555,7 +728,8 @@ lc_is_a_chunk_ptr(Addr ptr, Int* pch_no, MC_Chunk** pch, LC_Extra** pex)
    if (!VG_(am_is_valid_for_client)(ptr, 1, VKI_PROT_READ)) {
       return False;
    } else {
-      ch_no = find_chunk_for(ptr, lc_chunks, lc_n_chunks);
+      if (!lc_index_usable)
+         ch_no = find_chunk_for(ptr, lc_chunks, lc_n_chunks);
       tl_assert(ch_no >= -1 && ch_no < lc_n_chunks);
 
       if (ch_no == -1) {
@@ -717,12 +891,13 @@ static Bool is_valid_aligned_ULong ( Addr a )
    and defined VA bits (see mc_main.c function mc_new_mem_mprotect).
    Currently, 2 functions are dereferencing client memory during leak search:
    heuristic_reachedness and lc_scan_memory.
-   Each such function has its own fault catcher, that will call
-   leak_search_fault_catcher with the proper 'who' and jmpbuf parameters. */
-static volatile Addr bad_scanned_addr;
+   Each such function has its own jmpbuf in the LC_Worker of the thread
+   doing it, and lc_fault_catcher calls leak_search_fault_catcher with
+   the proper 'who' and jmpbuf parameters. */
 static
 void leak_search_fault_catcher ( Int sigNo, Addr addr,
-                                 const HChar *who, VG_MINIMAL_JMP_BUF(jmpbuf) )
+                                 const HChar *who, LC_Worker* w,
+                                 VG_MINIMAL_JMP_BUF(jmpbuf) )
 {
    vki_sigset_t sigmask;
 
@@ -742,7 +917,7 @@ void leak_search_fault_catcher ( Int sigNo, Addr addr,
    VG_(sigprocmask)(VKI_SIG_SETMASK, &sigmask, NULL);
 
    if (sigNo == VKI_SIGSEGV || sigNo == VKI_SIGBUS) {
-      bad_scanned_addr = addr;
+      w->bad_scanned_addr = addr;
       VG_MINIMAL_LONGJMP(jmpbuf);
    } else {
       /* ??? During leak search, we are not supposed to receive any
@@ -755,14 +930,33 @@ void leak_search_fault_catcher ( Int sigNo, Addr addr,
    }
 }
 
-// jmpbuf and fault_catcher used during heuristic_reachedness
-static VG_MINIMAL_JMP_BUF(heuristic_reachedness_jmpbuf);
+// The fault catcher of the leak search.  A serial search sets it in
+// lc_scan_memory and heuristic_reachedness; a parallel search sets it
+// once for all its threads, and here finds which thread took the fault.
 static
-void heuristic_reachedness_fault_catcher ( Int sigNo, Addr addr )
+void lc_fault_catcher ( Int sigNo, Addr addr )
 {
-   leak_search_fault_catcher (sigNo, addr, 
-                              "heuristic_reachedness_fault_catcher",
-                              heuristic_reachedness_jmpbuf);
+   LC_Worker* w = &lc_workers[0];
+
+   if (lc_n_workers > 1) {
+      const Int lwpid = VG_(gettid)();
+      UInt i;
+      for (i = 0; i < lc_n_workers; i++) {
+         if (lc_workers[i].lwpid == lwpid)
+            break;
+      }
+      tl_assert(i < lc_n_workers);
+      w = &lc_workers[i];
+   }
+
+   if (w->in_heuristic)
+      leak_search_fault_catcher (sigNo, addr,
+                                 "heuristic_reachedness_fault_catcher",
+                                 w, w->heuristic_jmpbuf);
+   else
+      leak_search_fault_catcher (sigNo, addr,
+                                 "lc_scan_memory_fault_catcher",
+                                 w, w->scan_jmpbuf);
 }
 
 // If ch is heuristically reachable via an heuristic member of heur_set,
@@ -774,21 +968,11 @@ void heuristic_reachedness_fault_catcher ( Int sigNo, Addr addr )
 // inspired from DrMemory:
 //  see http://www.burningcutlery.com/derek/docs/drmem-CGO11.pdf [section VI,C]
 //  and bug 280271.
-static LeakCheckHeuristic heuristic_reachedness (Addr ptr,
-                                                 MC_Chunk *ch, LC_Extra *ex,
-                                                 UInt heur_set)
+static LeakCheckHeuristic heuristic_reachedness_WRK (Addr ptr,
+                                                     MC_Chunk *ch,
+                                                     LC_Extra *ex,
+                                                     UInt heur_set)
 {
-
-   fault_catcher_t prev_catcher;
-
-   prev_catcher = VG_(set_fault_catcher)(heuristic_reachedness_fault_catcher);
-
-   // See leak_search_fault_catcher
-   if (VG_MINIMAL_SETJMP(heuristic_reachedness_jmpbuf) != 0) {
-      VG_(set_fault_catcher) (prev_catcher);
-      return LchNone;
-   }
-
    if (HiS(LchStdString, heur_set)) {
       // Detects inner pointers to Std::String for layout being
       //     length capacity refcount char_array[] \0
@@ -810,7 +994,6 @@ static LeakCheckHeuristic heuristic_reachedness (Addr ptr,
                // ??? probably not a good idea, as I guess stdstring
                // ??? allocator can be done via custom allocator
                // ??? or even a call to malloc ????
-               VG_(set_fault_catcher) (prev_catcher);
                return LchStdString;
             }
          }
@@ -829,7 +1012,6 @@ static LeakCheckHeuristic heuristic_reachedness (Addr ptr,
           && is_valid_aligned_ULong(ch->data)) {
          const ULong size = *((ULong*)ch->data);
          if (size > 0 && (ch->szB - sizeof(ULong)) == size) {
-            VG_(set_fault_catcher) (prev_catcher);
             return LchLength64;
          }
       }
@@ -856,7 +1038,6 @@ static LeakCheckHeuristic heuristic_reachedness (Addr ptr,
          const SizeT nr_elts = *((SizeT*)ch->data);
          if (nr_elts > 0 && (ch->szB - sizeof(SizeT)) % nr_elts == 0) {
             // ??? could check that ch->allockind is MC_AllocNewVec ???
-            VG_(set_fault_catcher) (prev_catcher);
             return LchNewArray;
          }
       }
@@ -888,22 +1069,48 @@ static LeakCheckHeuristic heuristic_reachedness (Addr ptr,
                 && aligned_ptr_above_page0_is_vtable_addr(inner_addr)
                 && aligned_ptr_above_page0_is_vtable_addr(first_addr)) {
                // ??? could check that ch->allockind is MC_AllocNew ???
-               VG_(set_fault_catcher) (prev_catcher);
                return LchMultipleInheritance;
             }
          }
       }
    }
 
-   VG_(set_fault_catcher) (prev_catcher);
    return LchNone;
 }
 
+static LeakCheckHeuristic heuristic_reachedness (LC_Worker* w, Addr ptr,
+                                                 MC_Chunk *ch, LC_Extra *ex,
+                                                 UInt heur_set)
+{
+   fault_catcher_t prev_catcher = NULL;
+   LeakCheckHeuristic h;
+
+   if (lc_n_workers == 1)
+      prev_catcher = VG_(set_fault_catcher)(lc_fault_catcher);
+   w->in_heuristic = True;
+
+   // See leak_search_fault_catcher
+   if (VG_MINIMAL_SETJMP(w->heuristic_jmpbuf) != 0)
+      h = LchNone;
+   else
+      h = heuristic_reachedness_WRK (ptr, ch, ex, heur_set);
+
+   w->in_heuristic = False;
+   if (lc_n_workers == 1)
+      VG_(set_fault_catcher) (prev_catcher);
+   return h;
+}
+
+
+static void lc_par_reach(LC_Worker* w, Addr ptr,
+                         Int ch_no, MC_Chunk* ch, LC_Extra* ex,
+                         Bool is_prior_definite);
 
 // If 'ptr' is pointing to a heap-allocated block which hasn't been seen
 // before, push it onto the mark stack.
 static void
-lc_push_without_clique_if_a_chunk_ptr(Addr ptr, Bool is_prior_definite)
+lc_push_without_clique_if_a_chunk_ptr(LC_Worker* w, Addr ptr,
+                                      Bool is_prior_definite)
 {
    Int ch_no;
    MC_Chunk* ch;
@@ -913,6 +1120,11 @@ lc_push_without_clique_if_a_chunk_ptr(Addr ptr, Bool is_prior_definite)
    if ( ! lc_is_a_chunk_ptr(ptr, &ch_no, &ch, &ex) )
       return;
 
+   if (lc_n_workers > 1) {
+      lc_par_reach(w, ptr, ch_no, ch, ex, is_prior_definite);
+      return;
+   }
+
    if (ex->state == Reachable) {
       if (ex->heuristic && ptr == ch->data)
          // If block was considered reachable via an heuristic, and it is now
@@ -930,7 +1142,7 @@ lc_push_without_clique_if_a_chunk_ptr(Addr ptr, Bool is_prior_definite)
       ch_via_ptr = Reachable;
    else if (detect_memory_leaks_last_heuristics) {
       ex->heuristic 
-         = heuristic_reachedness (ptr, ch, ex,
+         = heuristic_reachedness (w, ptr, ch, ex,
                                   detect_memory_leaks_last_heuristics);
       if (ex->heuristic)
          ch_via_ptr = Reachable;
@@ -963,7 +1175,8 @@ lc_push_without_clique_if_a_chunk_ptr(Addr ptr, Bool is_prior_definite)
 static void
 lc_push_if_a_chunk_ptr_register(ThreadId tid, const HChar* regname, Addr ptr)
 {
-   lc_push_without_clique_if_a_chunk_ptr(ptr, /*is_prior_definite*/True);
+   lc_push_without_clique_if_a_chunk_ptr(&lc_serial_worker, ptr,
+                                         /*is_prior_definite*/True);
 }
 
 // If ptr is pointing to a heap-allocated block which hasn't been seen
@@ -1011,25 +1224,16 @@ lc_push_with_clique_if_a_chunk_ptr(Addr ptr, Int clique, Int cur_clique)
 }
 
 static void
-lc_push_if_a_chunk_ptr(Addr ptr,
+lc_push_if_a_chunk_ptr(LC_Worker* w, Addr ptr,
                        Int clique, Int cur_clique, Bool is_prior_definite)
 {
    if (-1 == clique) 
-      lc_push_without_clique_if_a_chunk_ptr(ptr, is_prior_definite);
+      lc_push_without_clique_if_a_chunk_ptr(w, ptr, is_prior_definite);
    else
       lc_push_with_clique_if_a_chunk_ptr(ptr, clique, cur_clique);
 }
 
 
-static VG_MINIMAL_JMP_BUF(lc_scan_memory_jmpbuf);
-static
-void lc_scan_memory_fault_catcher ( Int sigNo, Addr addr )
-{
-   leak_search_fault_catcher (sigNo, addr, 
-                              "lc_scan_memory_fault_catcher",
-                              lc_scan_memory_jmpbuf);
-}
-
 // lc_scan_memory has 2 modes:
 //
 // 1. Leak check mode (searched == 0).
@@ -1060,9 +1264,9 @@ void lc_scan_memory_fault_catcher ( Int sigNo, Addr addr )
 // to searched and outputs the places where searched is found.
 // It does not recursively scans the found memory.
 static void
-lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
-               Int clique, Int cur_clique,
-               Addr searched, SizeT szB)
+lc_scan_memory_WRK(LC_Worker* w, Addr start, SizeT len, Bool is_prior_definite,
+                   Int clique, Int cur_clique,
+                   Addr searched, SizeT szB)
 {
    /* memory scan is based on the assumption that valid pointers are aligned
       on a multiple of sizeof(Addr). So, we can (and must) skip the begin and
@@ -1076,12 +1280,13 @@ lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
 #endif
    Addr ptr = VG_ROUNDUP(start, sizeof(Addr));
    const Addr end = VG_ROUNDDN(start+len, sizeof(Addr));
-   fault_catcher_t prev_catcher;
+   fault_catcher_t prev_catcher = NULL;
 
    if (VG_DEBUG_LEAKCHECK)
       VG_(printf)("scan %#lx-%#lx (%lu)\n", start, end, len);
 
-   prev_catcher = VG_(set_fault_catcher)(lc_scan_memory_fault_catcher);
+   if (lc_n_workers == 1)
+      prev_catcher = VG_(set_fault_catcher)(lc_fault_catcher);
 
    /* Optimisation: the loop below will check for each begin
       of SM chunk if the chunk is fully unaddressable. The idea is to
@@ -1109,7 +1314,7 @@ lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
       MC_(detect_memory_leaks). */
 
    // See leak_search_fault_catcher
-   if (VG_MINIMAL_SETJMP(lc_scan_memory_jmpbuf) != 0) {
+   if (VG_MINIMAL_SETJMP(w->scan_jmpbuf) != 0) {
       // Catch read error ...
 #     if defined(VGA_s390x)
       // For a SIGSEGV, s390 delivers the page address of the bad address.
@@ -1118,17 +1323,17 @@ lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
       // So, on this platform, we always skip a full page from ptr.
       // The below implies to mark ptr as volatile, as we read the value
       // after a longjmp to here.
-      lc_sig_skipped_szB += VKI_PAGE_SIZE;
+      w->sig_skipped_szB += VKI_PAGE_SIZE;
       ptr = ptr + VKI_PAGE_SIZE; // Unaddressable, - skip it.
 #     else
       // On other platforms, just skip one Addr.
-      lc_sig_skipped_szB += sizeof(Addr);
+      w->sig_skipped_szB += sizeof(Addr);
       // PJF asserts are always on
       // coverity[ASSERT_SIDE_EFFECT:FALSE]
-      tl_assert(bad_scanned_addr >= VG_ROUNDUP(start, sizeof(Addr)));
+      tl_assert(w->bad_scanned_addr >= VG_ROUNDUP(start, sizeof(Addr)));
       // coverity[ASSERT_SIDE_EFFECT:FALSE]
-      tl_assert(bad_scanned_addr < VG_ROUNDDN(start+len, sizeof(Addr)));
-      ptr = bad_scanned_addr + sizeof(Addr); // Unaddressable, - skip it.
+      tl_assert(w->bad_scanned_addr < VG_ROUNDDN(start+len, sizeof(Addr)));
+      ptr = w->bad_scanned_addr + sizeof(Addr); // Unaddressable, - skip it.
 #endif
    }
    while (ptr < end) {
@@ -1151,7 +1356,7 @@ lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
       }
 
       if ( MC_(is_valid_aligned_word)(ptr) ) {
-         lc_scanned_szB += sizeof(Addr);
+         w->scanned_szB += sizeof(Addr);
          // If the below read fails, we will longjmp to the loop begin.
          addr = *(Addr *)ptr;
          // If we get here, the scanned word is in valid memory.  Now
@@ -1173,7 +1378,8 @@ lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
                   if (lc_is_a_chunk_ptr(addr, &ch_no, &ch, &ex) ) {
                      Int h;
                      for (h = LchStdString; h < N_LEAK_CHECK_HEURISTICS; h++) {
-                        if (heuristic_reachedness(addr, ch, ex, H2S(h)) == h) {
+                        if (heuristic_reachedness(w, addr, ch, ex, H2S(h))
+                            == h) {
                            VG_(umsg)("block at %#lx considered reachable "
                                      "by ptr %#lx using %s heuristic\n",
                                      ch->data, addr, pp_heuristic(h));
@@ -1188,7 +1394,8 @@ lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
                }
             }
          } else {
-            lc_push_if_a_chunk_ptr(addr, clique, cur_clique, is_prior_definite);
+            lc_push_if_a_chunk_ptr(w, addr, clique, cur_clique,
+                                   is_prior_definite);
          }
       } else if (0 && VG_DEBUG_LEAKCHECK) {
          VG_(printf)("%#lx not valid\n", ptr);
@@ -1196,7 +1403,242 @@ lc_scan_memory(Addr start, SizeT len, Bool is_prior_definite,
       ptr += sizeof(Addr);
    }
 
+   if (lc_n_workers == 1)
+      VG_(set_fault_catcher)(prev_catcher);
+}
+
+
+/*------------------------------------------------------------*/
+/*--- Incremental leak search.                             ---*/
+/*------------------------------------------------------------*/
+
+// With --incremental-leak-check=yes, the result of scanning a 64KB region
+// of memory (the area of a secondary map) is kept in an LC_Region, and
+// used again by the next leak searches until MC_(leak_dirty_map) shows
+// the region may have changed: the generated code marks the regions
+// written by the client, and mc_main.c the regions whose V+A bits (or
+// readability) change in any other way.
+//
+// An LC_Region holds the words of the region which were found valid,
+// in increasing address order, except those whose value is outside
+// [LC_MIN_PTR, LC_MAX_PTR].  As long as all the blocks are inside these
+// bounds (which is checked before each search), the other words can
+// never point to a block, so pushing the kept words gives the same
+// result as scanning the region, even if blocks were allocated or freed
+// since.  A region with more than LC_REGION_MAX_WORDS such words is not
+// worth keeping: n_words is then -1, and it is scanned each time.
+//
+// Regions are only created by a search done by one thread.  Memory that
+// other processes can change is never kept.
+
+UChar MC_(leak_dirty_map)[1 << MC_LEAK_DIRTY_BITS];
+
+#define LC_MIN_PTR ((Addr)VKI_PAGE_SIZE)
+#if VG_WORDSIZE == 8
+#  define LC_MAX_PTR ((Addr)0x00FFFFFFFFFFFFFFULL)
+#else
+#  define LC_MAX_PTR (~(Addr)0)
+#endif
+#define LC_REGION_MAX_WORDS (SM_SIZE / sizeof(Addr) / 8)
+
+typedef
+   struct _LC_Region {
+      struct _LC_Region* next;
+      UWord   key;       // Region address >> 16.
+      Int     n_words;   // -1 if not kept, see above.
+      UInt    gen;       // MC_(leak_search_gen) when created.
+      Addr*   vals;
+      UShort* offs;      // Offsets of vals[] in the region.
+   }
+   LC_Region;
+
+static VgHashTable* lc_regions = NULL;
+// True during a leak search if lc_regions can be used.
+static Bool lc_regions_usable = False;
+
+void MC_(leak_mark_dirty) ( Addr a, SizeT len )
+{
+   UWord r, n;
+
+   if (len == 0)
+      return;
+   n = ((a + len - 1) >> 16) - (a >> 16) + 1;
+   if (n >= (1 << MC_LEAK_DIRTY_BITS) || a + len - 1 < a) {
+      VG_(memset)(MC_(leak_dirty_map), 1, sizeof(MC_(leak_dirty_map)));
+      return;
+   }
+   for (r = 0; r < n; r++)
+      MC_(leak_dirty_map)[MC_LEAK_DIRTY_IDX(a + (r << 16))] = 1;
+}
+
+// Called at the start of a leak search, after lc_chunks is built:
+// drops the regions that may have changed since the previous search.
+static void lc_prepare_regions(void)
+{
+   LC_Region* r;
+   Int i;
+
+   lc_regions_usable = False;
+   if (!MC_(clo_incremental_leak_check))
+      return;
+   if (lc_regions == NULL)
+      lc_regions = VG_(HT_construct)( "mc.lpr.1" );
+
+   lc_regions_usable = True;
+   for (i = 0; i < lc_n_chunks; i++) {
+      MC_Chunk* ch = lc_chunks[i];
+      if (ch->data < LC_MIN_PTR || ch->data + ch->szB > LC_MAX_PTR
+          || ch->data + ch->szB < ch->data) {
+         lc_regions_usable = False;
+         break;
+      }
+   }
+
+   VG_(HT_ResetIter)(lc_regions);
+   while ( (r = VG_(HT_Next)(lc_regions)) ) {
+      if (!lc_regions_usable
+          || MC_(leak_dirty_map)[MC_LEAK_DIRTY_IDX(r->key << 16)]) {
+         VG_(HT_remove_at_Iter)(lc_regions);
+         VG_(free)(r);
+      }
+   }
+   VG_(memset)(MC_(leak_dirty_map), 0, sizeof(MC_(leak_dirty_map)));
+}
+
+// Puts in vals/offs the words of the region at base to keep, and returns
+// how many there are, or -1 if the region is not to be kept.  Read
+// errors longjmp to w->scan_jmpbuf.
+static Int lc_collect_region(LC_Worker* w, Addr base,
+                             Addr* vals, UShort* offs)
+{
+   UWord off;
+   Int   n = 0;
+   Addr  a;
+
+   // Don't keep memory shared with other processes.
+   for (a = base; ; ) {
+      NSegment const* seg = VG_(am_find_nsegment)(a);
+      if (seg == NULL)
+         break;
+      if (seg->kind == SkShmC)
+         return -1;
+      if (seg->end >= base + SM_MASK)
+         break;
+      a = seg->end + 1;
+   }
+
+   if (!MC_(is_within_valid_secondary)(base))
+      return 0;
+
+   for (off = 0; off < SM_SIZE; ) {
+      a = base + off;
+      if ((off % VKI_PAGE_SIZE) == 0
+          && !VG_(am_is_valid_for_client)(a, sizeof(Addr), VKI_PROT_READ)) {
+         off += VKI_PAGE_SIZE;
+         continue;
+      }
+      if (MC_(is_valid_aligned_word)(a)) {
+         Addr v = *(Addr *)a;
+         w->scanned_szB += sizeof(Addr);
+         if (v >= LC_MIN_PTR && v <= LC_MAX_PTR) {
+            if (n == LC_REGION_MAX_WORDS)
+               return -1;
+            vals[n] = v;
+            offs[n] = off;
+            n++;
+         }
+      }
+      off += sizeof(Addr);
+   }
+   return n;
+}
+
+// Returns the region at base, creating it if needed and possible.
+static LC_Region* lc_get_region(LC_Worker* w, Addr base)
+{
+   static Addr   vals[LC_REGION_MAX_WORDS];
+   static UShort offs[LC_REGION_MAX_WORDS];
+   fault_catcher_t prev_catcher;
+   LC_Region* r;
+   volatile Int n;
+
+   r = VG_(HT_lookup)(lc_regions, base >> 16);
+   if (r != NULL || lc_n_workers > 1)
+      return r;
+
+   // See leak_search_fault_catcher.  The region is not kept if any of
+   // it can't be read.
+   prev_catcher = VG_(set_fault_catcher)(lc_fault_catcher);
+   if (VG_MINIMAL_SETJMP(w->scan_jmpbuf) != 0)
+      n = -1;
+   else
+      n = lc_collect_region(w, base, vals, offs);
    VG_(set_fault_catcher)(prev_catcher);
+
+   r = VG_(malloc)( "mc.lgr.1", sizeof(LC_Region)
+                    + (n > 0 ? n : 0) * (sizeof(Addr) + sizeof(UShort)) );
+   r->key     = base >> 16;
+   r->n_words = n;
+   r->gen     = MC_(leak_search_gen);
+   r->vals    = (Addr*)(r + 1);
+   r->offs    = (UShort*)(r->vals + (n > 0 ? n : 0));
+   if (n > 0) {
+      VG_(memcpy)(r->vals, vals, n * sizeof(Addr));
+      VG_(memcpy)(r->offs, offs, n * sizeof(UShort));
+   }
+   VG_(HT_add_node)(lc_regions, r);
+   return r;
+}
+
+// Does lc_scan_memory in leak check mode, using the kept regions.
+static void
+lc_scan_regions(LC_Worker* w, Addr start, SizeT len, Bool is_prior_definite,
+                Int clique, Int cur_clique)
+{
+   Addr       a   = VG_ROUNDUP(start, sizeof(Addr));
+   const Addr end = VG_ROUNDDN(start+len, sizeof(Addr));
+
+   while (a < end) {
+      const Addr base  = a & ~(Addr)SM_MASK;
+      const Addr a_end = end - base > SM_SIZE ? base + SM_SIZE : end;
+      LC_Region* r     = lc_get_region(w, base);
+
+      if (r == NULL || r->n_words < 0) {
+         lc_scan_memory_WRK(w, a, a_end - a, is_prior_definite,
+                            clique, cur_clique, /*searched*/ 0, 0);
+      } else {
+         const UWord lo = a - base;
+         const UWord hi = a_end - base;
+         Int i = 0, j = r->n_words;
+         // Find the first kept word at or after a.
+         while (i < j) {
+            Int m = (i + j) / 2;
+            if (r->offs[m] < lo)
+               i = m + 1;
+            else
+               j = m;
+         }
+         for (; i < r->n_words && r->offs[i] < hi; i++)
+            lc_push_if_a_chunk_ptr(w, r->vals[i], clique, cur_clique,
+                                   is_prior_definite);
+         if (r->gen != MC_(leak_search_gen))
+            w->reused_szB += a_end - a;
+      }
+      a = a_end;
+   }
+}
+
+// See lc_scan_memory_WRK.
+static void
+lc_scan_memory(LC_Worker* w, Addr start, SizeT len, Bool is_prior_definite,
+               Int clique, Int cur_clique,
+               Addr searched, SizeT szB)
+{
+   if (lc_regions_usable && searched == 0)
+      lc_scan_regions(w, start, len, is_prior_definite, clique, cur_clique);
+   else
+      lc_scan_memory_WRK(w, start, len, is_prior_definite, clique, cur_clique,
+                         searched, szB);
 }
 
 
@@ -1212,7 +1654,8 @@ static void lc_process_markstack(Int clique)
       // See comment about 'is_prior_definite' at the top to understand this.
       is_prior_definite = ( Possible != lc_extras[top].state );
 
-      lc_scan_memory(lc_chunks[top]->data, lc_chunks[top]->szB,
+      lc_scan_memory(&lc_serial_worker,
+                     lc_chunks[top]->data, lc_chunks[top]->szB,
                      is_prior_definite, clique, (clique == -1 ? -1 : top),
                      /*searched*/ 0, 0);
    }
@@ -1937,6 +2380,43 @@ Bool MC_(print_block_list) ( UInt loss_record_nr_from,
    return True;
 }
 
+// Returns the i-th segment of the memory root set, or NULL if
+// seg_starts[i] is not to be scanned.
+static NSegment const* get_root_segment(const Addr* seg_starts, Int i)
+{
+   NSegment const* seg = VG_(am_find_nsegment)( seg_starts[i] );
+   tl_assert(seg);
+   tl_assert(seg->kind == SkFileC || seg->kind == SkAnonC ||
+             seg->kind == SkShmC);
+
+   if (!(seg->hasR && seg->hasW))                    return NULL;
+   if (seg->isCH)                                    return NULL;
+
+   // Don't poke around in device segments as this may cause
+   // hangs.  Include /dev/zero just in case someone allocated
+   // memory by explicitly mapping /dev/zero.
+   if (seg->kind == SkFileC 
+       && (VKI_S_ISCHR(seg->mode) || VKI_S_ISBLK(seg->mode))) {
+      const HChar* dev_name = VG_(am_get_filename)( seg );
+      if (dev_name && 0 == VG_(strcmp)(dev_name, "/dev/zero")) {
+         // Don't skip /dev/zero.
+      } else {
+         // Skip this device mapping.
+         return NULL;
+      }
+   }
+
+   if (0)
+      VG_(printf)("ACCEPT %2d  %#lx %#lx\n", i, seg->start, seg->end);
+
+   if (VG_(clo_verbosity) > 2) {
+      VG_(message)(Vg_DebugMsg,
+                   "  Scanning root segment: %#lx..%#lx (%lu)\n",
+                   seg->start, seg->end, seg->end - seg->start + 1);
+   }
+   return seg;
+}
+
 // If searched = 0, scan memory root set, pushing onto the mark stack the blocks
 // encountered.
 // Otherwise (searched != 0), scan the memory root set searching for ptr
@@ -1950,52 +2430,369 @@ static void scan_memory_root_set(Addr searched, SizeT szB)
 
    tl_assert(seg_starts && n_seg_starts > 0);
 
-   lc_scanned_szB = 0;
-   lc_sig_skipped_szB = 0;
+   lc_serial_worker.scanned_szB = 0;
+   lc_serial_worker.sig_skipped_szB = 0;
+   lc_serial_worker.reused_szB = 0;
 
    // VG_(am_show_nsegments)( 0, "leakcheck");
    for (i = 0; i < n_seg_starts; i++) {
-      SizeT seg_size;
-      NSegment const* seg = VG_(am_find_nsegment)( seg_starts[i] );
-      tl_assert(seg);
-      tl_assert(seg->kind == SkFileC || seg->kind == SkAnonC ||
-                seg->kind == SkShmC);
-
-      if (!(seg->hasR && seg->hasW))                    continue;
-      if (seg->isCH)                                    continue;
-
-      // Don't poke around in device segments as this may cause
-      // hangs.  Include /dev/zero just in case someone allocated
-      // memory by explicitly mapping /dev/zero.
-      if (seg->kind == SkFileC 
-          && (VKI_S_ISCHR(seg->mode) || VKI_S_ISBLK(seg->mode))) {
-         const HChar* dev_name = VG_(am_get_filename)( seg );
-         if (dev_name && 0 == VG_(strcmp)(dev_name, "/dev/zero")) {
-            // Don't skip /dev/zero.
-         } else {
-            // Skip this device mapping.
-            continue;
-         }
-      }
-
-      if (0)
-         VG_(printf)("ACCEPT %2d  %#lx %#lx\n", i, seg->start, seg->end);
+      NSegment const* seg = get_root_segment(seg_starts, i);
+      if (seg == NULL)
+         continue;
 
       // Scan the segment.  We use -1 for the clique number, because this
       // is a root-set.
-      seg_size = seg->end - seg->start + 1;
-      if (VG_(clo_verbosity) > 2) {
-         VG_(message)(Vg_DebugMsg,
-                      "  Scanning root segment: %#lx..%#lx (%lu)\n",
-                      seg->start, seg->end, seg_size);
-      }
-      lc_scan_memory(seg->start, seg_size, /*is_prior_definite*/True,
+      lc_scan_memory(&lc_serial_worker,
+                     seg->start, seg->end - seg->start + 1,
+                     /*is_prior_definite*/True,
                      /*clique*/-1, /*cur_clique*/-1,
                      searched, szB);
    }
    VG_(free)(seg_starts);
 }
 
+
+/*------------------------------------------------------------*/
+/*--- Parallel marking.                                    ---*/
+/*------------------------------------------------------------*/
+
+// With --leak-check-threads=N, N threads share the scan of the root set
+// and the processing of the mark stack, which is what takes the time
+// with a big heap.  The threads only follow start-pointers to make a
+// block Reachable: whatever the order in which blocks are scanned, a
+// block ends up Reachable if a chain of start-pointers leads to it from
+// the root set, and otherwise Possible if any chain of pointers does.
+// When a definite interior pointer to a block which is not Reachable
+// matches a heuristic, the heuristic is only added to the set kept in
+// the block's heuristic field.  Once the threads are done, the blocks
+// with such a set are made Reachable serially, in the order of
+// lc_chunks, each with the first heuristic of its set, and what they
+// point to is marked as in a serial search (lc_par_resolve_heuristics).
+// So the states, the heuristics reported and the number of bytes
+// checked do not depend on the timing of the threads.  The clique
+// search which follows is done serially.
+//
+// Each thread pushes onto a small stack of its own.  When that is full,
+// the thread moves half of it to lc_markstack, which is shared and
+// protected by a spin lock; when it is empty, the thread refills it from
+// lc_markstack.  A thread which finds both empty waits until either
+// lc_markstack gets something again, or all the threads are waiting,
+// which means the marking is finished.
+//
+// The threads only read the client memory, the shadow memory, the segment
+// list and lc_chunks, and update the LC_Extra states with compare-and-swap
+// (see lc_par_reach).  Read errors are caught per thread, see
+// lc_fault_catcher.
+
+// Root segments are scanned in pieces of this size, so that a big heap
+// can be shared between the threads.
+#define LC_ROOT_PIECE_SZB (256 * SM_SIZE)
+
+typedef
+   struct {
+      Addr  start;
+      SizeT szB;
+   }
+   LC_RootPiece;
+
+static LC_RootPiece* lc_root_pieces;
+static UInt          lc_n_root_pieces;
+static volatile UInt lc_next_root_piece;
+
+static volatile Int  lc_markstack_lock;
+static volatile UInt lc_n_waiting;
+
+static void lc_lock_markstack(void)
+{
+   while (__sync_lock_test_and_set(&lc_markstack_lock, 1)) {
+      while (lc_markstack_lock)
+         VG_(helper_thread_yield)();
+   }
+}
+
+static void lc_unlock_markstack(void)
+{
+   __sync_lock_release(&lc_markstack_lock);
+}
+
+static void lc_par_push(LC_Worker* w, Int ch_no)
+{
+   if (w->n_local == LC_LOCAL_STACK_SIZE) {
+      // Share the older half with the other threads.
+      const Int half = LC_LOCAL_STACK_SIZE / 2;
+      Int i;
+
+      lc_lock_markstack();
+      for (i = 0; i < half; i++) {
+         lc_markstack_top++;
+         tl_assert(lc_markstack_top < lc_n_chunks);
+         lc_markstack[lc_markstack_top] = w->local[i];
+      }
+      lc_unlock_markstack();
+      for (i = half; i < LC_LOCAL_STACK_SIZE; i++)
+         w->local[i - half] = w->local[i];
+      w->n_local -= half;
+   }
+   w->local[w->n_local++] = ch_no;
+}
+
+// Pops the next block to scan into *ret.  Returns False when the marking
+// is finished, i.e. when all n threads have nothing left to do.
+static Bool lc_par_pop(LC_Worker* w, UInt n, Int* ret)
+{
+   while (w->n_local == 0) {
+      lc_lock_markstack();
+      while (lc_markstack_top >= 0 && w->n_local < LC_LOCAL_STACK_SIZE / 2)
+         w->local[w->n_local++] = lc_markstack[lc_markstack_top--];
+      lc_unlock_markstack();
+      if (w->n_local > 0)
+         break;
+
+      // Only a thread which is not waiting can push, so once all are
+      // waiting, lc_markstack stays empty.
+      __sync_fetch_and_add(&lc_n_waiting, 1);
+      while (*(volatile Int*)&lc_markstack_top < 0) {
+         if (lc_n_waiting == n)
+            return False;
+         VG_(helper_thread_yield)();
+      }
+      __sync_fetch_and_sub(&lc_n_waiting, 1);
+   }
+   *ret = w->local[--w->n_local];
+   return True;
+}
+
+// The rest of lc_push_without_clique_if_a_chunk_ptr, for a parallel
+// search.  Only a start-pointer from a definite block makes a block
+// Reachable; a definite interior pointer adds the heuristic it matches
+// to the set of the block, which lc_par_resolve_heuristics uses.  The
+// state is upgraded with a compare-and-swap which also claims the
+// pending bit, so that of several threads reaching a block at the same
+// time, exactly one pushes it.
+static void lc_par_reach(LC_Worker* w, Addr ptr,
+                         Int ch_no, MC_Chunk* ch, LC_Extra* ex,
+                         Bool is_prior_definite)
+{
+   LeakCheckHeuristic h = LchNone;
+   Bool h_done = False;
+   LC_Extra old, new;
+
+   while (True) {
+      old.word = *(volatile UInt*)&ex->word;
+      new.word = old.word;
+
+      if (old.state == Reachable) {
+         // Only the register scan, which is serial, can have made a block
+         // Reachable with a heuristic.  See
+         // lc_push_without_clique_if_a_chunk_ptr.
+         if (!(old.heuristic && ptr == ch->data))
+            return;
+         new.heuristic = LchNone;
+      } else if (ptr == ch->data && is_prior_definite) {
+         new.state = Reachable;
+         new.heuristic = LchNone;
+      } else {
+         if (ptr != ch->data && is_prior_definite
+             && detect_memory_leaks_last_heuristics) {
+            if (!h_done)
+               h = heuristic_reachedness (w, ptr, ch, ex,
+                                          detect_memory_leaks_last_heuristics);
+            h_done = True;
+            if (h != LchNone)
+               new.heuristic |= H2S(h);
+         }
+         if (old.state == Unreached)
+            new.state = Possible;
+         if (new.word == old.word)
+            return;
+      }
+      if (new.state != old.state)
+         new.pending = True;
+
+      if (__sync_bool_compare_and_swap(&ex->word, old.word, new.word))
+         break;
+   }
+
+   if (new.pending && !old.pending)
+      lc_par_push(w, ch_no);
+}
+
+static void lc_par_process_markstack(LC_Worker* w, UInt n)
+{
+   Int top = -1;    // shut gcc up
+
+   while (lc_par_pop(w, n, &top)) {
+      LC_Extra* ex = &lc_extras[top];
+      LC_Extra old, new;
+      SizeT scanned_szB = w->scanned_szB;
+
+      // Clear the pending bit, and scan according to the state at that
+      // point: a later upgrade pushes the block again.
+      do {
+         old.word = *(volatile UInt*)&ex->word;
+         new.word = old.word;
+         new.pending = False;
+      } while (!__sync_bool_compare_and_swap(&ex->word, old.word, new.word));
+      tl_assert(old.pending);
+
+      lc_scan_memory(w, lc_chunks[top]->data, lc_chunks[top]->szB,
+                     /*is_prior_definite*/ Possible != old.state,
+                     /*clique*/-1, /*cur_clique*/-1,
+                     /*searched*/ 0, 0);
+
+      // Whether a block which ends up Reachable was also scanned while
+      // Possible depends on the timing: remember how many bytes such a
+      // scan checked, so that lc_mark_in_parallel can leave them out.
+      if (old.state == Possible)
+         ex->IorC.indirect_szB = w->scanned_szB - scanned_szB;
+   }
+}
+
+// What each of the n threads of a parallel search runs.
+static void lc_par_mark(void* opaque, UInt i, UInt n)
+{
+   LC_Worker* w = &lc_workers[i];
+   UInt p;
+
+   w->lwpid = VG_(gettid)();
+   if (i > 0) {
+      // Helper threads start with all signals blocked.  Let the read
+      // errors through to lc_fault_catcher.
+      vki_sigset_t sigmask;
+      VG_(sigprocmask)(VKI_SIG_SETMASK, NULL, &sigmask);
+      VG_(sigdelset)(&sigmask, VKI_SIGSEGV);
+      VG_(sigdelset)(&sigmask, VKI_SIGBUS);
+      VG_(sigprocmask)(VKI_SIG_SETMASK, &sigmask, NULL);
+   }
+
+   while ((p = __sync_fetch_and_add(&lc_next_root_piece, 1))
+          < lc_n_root_pieces) {
+      lc_scan_memory(w, lc_root_pieces[p].start, lc_root_pieces[p].szB,
+                     /*is_prior_definite*/True,
+                     /*clique*/-1, /*cur_clique*/-1,
+                     /*searched*/ 0, 0);
+   }
+
+   lc_par_process_markstack(w, n);
+}
+
+// Makes Reachable, in the order of lc_chunks, the blocks which are not
+// Reachable after the parallel marking but have a definite interior
+// pointer matching a heuristic, crediting the first heuristic of their
+// set, and marks what they point to.
+static void lc_par_resolve_heuristics(void)
+{
+   UInt* heur_sets;
+   Int   i;
+
+   if (!detect_memory_leaks_last_heuristics)
+      return;
+
+   heur_sets = VG_(malloc)( "mc.lprh.1", lc_n_chunks * sizeof(UInt) );
+   for (i = 0; i < lc_n_chunks; i++) {
+      if (lc_extras[i].state == Reachable) {
+         heur_sets[i] = 0;
+      } else {
+         heur_sets[i] = lc_extras[i].heuristic;
+         lc_extras[i].heuristic = LchNone;
+      }
+   }
+
+   for (i = 0; i < lc_n_chunks; i++) {
+      LeakCheckHeuristic h;
+
+      if (heur_sets[i] == 0 || lc_extras[i].state == Reachable)
+         continue;
+      for (h = LchStdString; !HiS(h, heur_sets[i]); h++)
+         ;
+      lc_extras[i].state = Reachable;
+      lc_extras[i].heuristic = h;
+      lc_push(i, lc_chunks[i]);
+      lc_process_markstack(/*clique*/-1);
+   }
+
+   VG_(free)(heur_sets);
+}
+
+// Does what scan_memory_root_set(0, 0), scanning the GP registers and
+// lc_process_markstack(-1) do in a serial search, using n threads.
+static void lc_mark_in_parallel(UInt n)
+{
+   Int   i;
+   Int   n_seg_starts;
+   Addr* seg_starts = VG_(get_segment_starts)( SkFileC | SkAnonC | SkShmC,
+                                               &n_seg_starts );
+   fault_catcher_t prev_catcher;
+
+   tl_assert(seg_starts && n_seg_starts > 0);
+   tl_assert(lc_n_workers == 1);
+
+   // The registers are few: scan them first, onto lc_markstack.
+   VG_(apply_to_GP_regs)(lc_push_if_a_chunk_ptr_register);
+
+   // Cut the root set into pieces.
+   lc_n_root_pieces = 0;
+   for (i = 0; i < n_seg_starts; i++) {
+      NSegment const* seg = VG_(am_find_nsegment)( seg_starts[i] );
+      lc_n_root_pieces += (seg->end - seg->start) / LC_ROOT_PIECE_SZB + 1;
+   }
+   lc_root_pieces = VG_(malloc)( "mc.lmip.1",
+                                 lc_n_root_pieces * sizeof(LC_RootPiece) );
+   lc_n_root_pieces = 0;
+   for (i = 0; i < n_seg_starts; i++) {
+      NSegment const* seg = get_root_segment(seg_starts, i);
+      Addr a;
+      if (seg == NULL)
+         continue;
+      for (a = seg->start; a <= seg->end && a >= seg->start;
+           a += LC_ROOT_PIECE_SZB) {
+         LC_RootPiece* piece = &lc_root_pieces[lc_n_root_pieces++];
+         piece->start = a;
+         piece->szB   = seg->end - a + 1 < LC_ROOT_PIECE_SZB
+                        ? seg->end - a + 1 : LC_ROOT_PIECE_SZB;
+      }
+   }
+   VG_(free)(seg_starts);
+   lc_next_root_piece = 0;
+
+   lc_workers = VG_(calloc)( "mc.lmip.2", n, sizeof(LC_Worker) );
+   lc_n_workers = n;
+   lc_markstack_lock = 0;
+   lc_n_waiting = 0;
+
+   MC_(freeze_auxmap_L1)(True);
+   prev_catcher = VG_(set_fault_catcher)(lc_fault_catcher);
+
+   VG_(run_in_helper_threads)(n, lc_par_mark, NULL);
+
+   VG_(set_fault_catcher)(prev_catcher);
+   MC_(freeze_auxmap_L1)(False);
+
+   tl_assert(lc_markstack_top == -1);
+   lc_serial_worker.scanned_szB = 0;
+   lc_serial_worker.sig_skipped_szB = 0;
+   lc_serial_worker.reused_szB = 0;
+   for (i = 0; i < n; i++) {
+      tl_assert(lc_workers[i].n_local == 0);
+      lc_serial_worker.scanned_szB     += lc_workers[i].scanned_szB;
+      lc_serial_worker.sig_skipped_szB += lc_workers[i].sig_skipped_szB;
+      lc_serial_worker.reused_szB      += lc_workers[i].reused_szB;
+   }
+   VG_(free)(lc_workers);
+   lc_workers = &lc_serial_worker;
+   lc_n_workers = 1;
+   VG_(free)(lc_root_pieces);
+   lc_root_pieces = NULL;
+
+   for (i = 0; i < lc_n_chunks; i++) {
+      if (lc_extras[i].state == Reachable)
+         lc_serial_worker.scanned_szB -= lc_extras[i].IorC.indirect_szB;
+      lc_extras[i].IorC.indirect_szB = 0;
+   }
+
+   lc_par_resolve_heuristics();
+}
+
 static MC_Mempool *find_mp_of_chunk (MC_Chunk* mc_search)
 {
    MC_Mempool* mp;
@@ -2043,6 +2840,7 @@ void MC_(detect_memory_leaks) ( ThreadId tid, LeakCheckParams* lcp)
       VG_(free)(lc_chunks);
       lc_chunks = NULL;
    }
+   lc_free_index();
    lc_chunks = get_sorted_array_of_active_chunks(&lc_n_chunks);
    lc_chunks_n_frees_marker = MC_(get_cmalloc_n_frees)();
    if (lc_n_chunks == 0) {
@@ -2162,6 +2960,8 @@ void MC_(detect_memory_leaks) ( ThreadId tid, LeakCheckParams* lcp)
       }
    }
 
+   lc_build_index();
+
    // Initialise lc_extras.
    if (lc_extras) {
       VG_(free)(lc_extras);
@@ -2175,6 +2975,9 @@ void MC_(detect_memory_leaks) ( ThreadId tid, LeakCheckParams* lcp)
       lc_extras[i].IorC.indirect_szB = 0;
    }
 
+   // Drop the kept scan results that may be out of date.
+   lc_prepare_regions();
+
    // Initialise lc_markstack.
    lc_markstack = VG_(malloc)( "mc.dml.2", lc_n_chunks * sizeof(Int) );
    for (i = 0; i < lc_n_chunks; i++) {
@@ -2188,22 +2991,30 @@ void MC_(detect_memory_leaks) ( ThreadId tid, LeakCheckParams* lcp)
                  lc_n_chunks );
    }
 
-   // Scan the memory root-set, pushing onto the mark stack any blocks
-   // pointed to.
-   scan_memory_root_set(/*searched*/0, 0);
+   if (MC_(clo_leak_check_threads) > 1) {
+      // Do the three steps below with several threads.
+      lc_mark_in_parallel(MC_(clo_leak_check_threads));
+   } else {
+      // Scan the memory root-set, pushing onto the mark stack any blocks
+      // pointed to.
+      scan_memory_root_set(/*searched*/0, 0);
 
-   // Scan GP registers for chunk pointers.
-   VG_(apply_to_GP_regs)(lc_push_if_a_chunk_ptr_register);
+      // Scan GP registers for chunk pointers.
+      VG_(apply_to_GP_regs)(lc_push_if_a_chunk_ptr_register);
 
-   // Process the pushed blocks.  After this, every block that is reachable
-   // from the root-set has been traced.
-   lc_process_markstack(/*clique*/-1);
+      // Process the pushed blocks.  After this, every block that is
+      // reachable from the root-set has been traced.
+      lc_process_markstack(/*clique*/-1);
+   }
 
    if (VG_(clo_verbosity) > 1 && !VG_(clo_xml)) {
-      VG_(umsg)("Checked %'lu bytes\n", lc_scanned_szB);
-      if (lc_sig_skipped_szB > 0)
+      VG_(umsg)("Checked %'lu bytes\n", lc_serial_worker.scanned_szB);
+      if (lc_serial_worker.reused_szB > 0)
+         VG_(umsg)("Reused the previous scan of %'lu bytes\n",
+                   lc_serial_worker.reused_szB);
+      if (lc_serial_worker.sig_skipped_szB > 0)
          VG_(umsg)("Skipped %'lu bytes due to read errors\n",
-                   lc_sig_skipped_szB);
+                   lc_serial_worker.sig_skipped_szB);
       VG_(umsg)( "\n" );
    }
 
@@ -2241,6 +3052,7 @@ void MC_(detect_memory_leaks) ( ThreadId tid, LeakCheckParams* lcp)
 
    VG_(free) ( lc_markstack );
    lc_markstack = NULL;
+   lc_regions_usable = False;
    // lc_chunks, lc_extras, lr_array and lr_table are kept (needed if user
    // calls MC_(print_block_list)). lr_table also used for delta leak reporting
    // between this leak search and the next leak search.
@@ -2284,7 +3096,7 @@ void MC_(who_points_at) ( Addr address, SizeT szB)
 
    // Scan active malloc-ed chunks
    for (i = 0; i < n_chunks; i++) {
-      lc_scan_memory(chunks[i]->data, chunks[i]->szB,
+      lc_scan_memory(&lc_serial_worker, chunks[i]->data, chunks[i]->szB,
                      /*is_prior_definite*/True,
                      /*clique*/-1, /*cur_clique*/-1,
                      address, szB);
@@ -296,8 +296,9 @@ static INLINE Bool is_distinguished_sm ( SecMap* sm ) {
    return sm >= &sm_distinguished[0] && sm <= &sm_distinguished[2];
 }
 
-// Forward declaration
+// Forward declarations
 static void update_SM_counts(SecMap* oldSM, SecMap* newSM);
+static void maybe_compact_secmaps(void);
 
 /* dist_sm points to one of our three distinguished secondaries.  Make
    a copy of it so that we can write to it.
@@ -309,6 +310,9 @@ static SecMap* copy_for_writing ( SecMap* dist_sm )
           || dist_sm == &sm_distinguished[1]
           || dist_sm == &sm_distinguished[2]);
 
+   if (UNLIKELY(MC_(clo_compact_secmaps)))
+      maybe_compact_secmaps();
+
    SysRes sres = VG_(am_shadow_alloc)(sizeof(SecMap));
    if (sr_isError(sres))
       VG_(out_of_memory_NORETURN)( "memcheck:allocate new SecMap",
@@ -339,6 +343,15 @@ static ULong n_auxmap_L1_cmps      = 0;
    be handed to auxmap_L2. And the number of nodes inserted. */
 static ULong n_auxmap_L2_searches  = 0;
 static ULong n_auxmap_L2_nodes     = 0;
+/* With --aux-primary-map=radix, the number of radix tree nodes, and of
+   leaf entries in use. */
+static ULong n_auxmap_radix_nodes  = 0;
+static ULong n_auxmap_radix_ents   = 0;
+
+/* With --compact-secmaps=yes, the number of compaction passes, and of
+   secondaries they gave back. */
+static ULong n_secmap_compactions  = 0;
+static ULong n_secmaps_compacted   = 0;
 
 static Int   n_sanity_cheap     = 0;
 static Int   n_sanity_expensive = 0;
@@ -413,6 +426,10 @@ static struct {
 
 static OSet* auxmap_L2 = NULL;
 
+/* While True, lookups leave auxmap_L1 alone, so that several threads
+   can do them at once.  See MC_(freeze_auxmap_L1). */
+static Bool auxmap_L1_frozen = False;
+
 static void init_auxmap_L1_L2 ( void )
 {
    Int i;
@@ -540,6 +557,11 @@ static INLINE AuxMapEnt* maybe_find_in_auxmap ( Addr a )
 
    if (LIKELY(auxmap_L1[0].base == a))
       return auxmap_L1[0].ent;
+   if (UNLIKELY(auxmap_L1_frozen)) {
+      key.base = a;
+      key.sm   = 0;
+      return VG_(OSetGen_Lookup)(auxmap_L2, &key);
+   }
    if (LIKELY(auxmap_L1[1].base == a)) {
       Addr       t_base = auxmap_L1[0].base;
       AuxMapEnt* t_ent  = auxmap_L1[0].ent;
@@ -608,6 +630,204 @@ static AuxMapEnt* find_or_alloc_in_auxmap ( Addr a )
    return nyu;
 }
 
+/* --------------- Radix auxiliary primary map --------------- */
+
+/* With --aux-primary-map=radix, the auxiliary primary map is instead a
+   three level radix tree, indexed by bits 63..48, 47..32 and 31..16 of
+   the address, so that finding the secondary for any address above
+   MAX_PRIMARY_ADDRESS takes three loads, however many 64k chunks above
+   it are in use.  This suits programs which use a lot of memory up
+   there, such as large heaps or stacks on riscv64 sv48/sv57.
+
+   Each node is 64k pointers, mapped on demand with VG_(am_shadow_alloc)
+   and so initially zero; only the pages of it which are used take any
+   memory.  A NULL leaf entry means there is no entry, just as for
+   auxmap_L2; entries are set to the NOACCESS distinguished secondary
+   when first looked up for use, the same as auxmap_L2 nodes. */
+
+#define AUXMAP_RADIX_BITS 16
+#define N_AUXMAP_RADIX    (1 << AUXMAP_RADIX_BITS)
+
+static void** auxmap_radix = NULL;
+
+static void** new_auxmap_radix_node ( void )
+{
+   SysRes sres = VG_(am_shadow_alloc)(N_AUXMAP_RADIX * sizeof(void*));
+   if (sr_isError(sres))
+      VG_(out_of_memory_NORETURN)( "memcheck:allocate auxmap radix node",
+                                   N_AUXMAP_RADIX * sizeof(void*),
+                                   sr_Err(sres) );
+   n_auxmap_radix_nodes++;
+   return (void**)(Addr)sr_Res(sres);
+}
+
+/* Find the entry for 'a' in the radix tree.  If there is none, make
+   one if 'alloc', else return NULL. */
+static INLINE SecMap** find_in_auxmap_radix ( Addr a, Bool alloc )
+{
+   ULong   a64 = (ULong)a;
+   UWord   i0  = (a64 >> 48) & (N_AUXMAP_RADIX-1);
+   UWord   i1  = (a64 >> 32) & (N_AUXMAP_RADIX-1);
+   UWord   i2  = (a64 >> 16) & (N_AUXMAP_RADIX-1);
+   void**  mid;
+   void**  leaf;
+   SecMap** ent;
+
+   tl_assert(a > MAX_PRIMARY_ADDRESS);
+
+   if (UNLIKELY(auxmap_radix == NULL)) {
+      if (!alloc)
+         return NULL;
+      auxmap_radix = new_auxmap_radix_node();
+   }
+   mid = auxmap_radix[i0];
+   if (UNLIKELY(mid == NULL)) {
+      if (!alloc)
+         return NULL;
+      mid = auxmap_radix[i0] = new_auxmap_radix_node();
+   }
+   leaf = mid[i1];
+   if (UNLIKELY(leaf == NULL)) {
+      if (!alloc)
+         return NULL;
+      leaf = mid[i1] = new_auxmap_radix_node();
+   }
+   ent = (SecMap**)&leaf[i2];
+   if (UNLIKELY(*ent == NULL)) {
+      if (!alloc)
+         return NULL;
+      *ent = &sm_distinguished[SM_DIST_NOACCESS];
+      n_auxmap_radix_ents++;
+   }
+   return ent;
+}
+
+/* As check_auxmap_L1_L2_sanity, for the radix tree. */
+static const HChar* check_auxmap_radix_sanity ( Word* n_secmaps_found )
+{
+   UWord i0, i1, i2;
+   ULong ents_seen = 0;
+
+   *n_secmaps_found = 0;
+   if (auxmap_radix == NULL)
+      return n_auxmap_radix_ents == 0 ? NULL : "radix: entries but no tree";
+   for (i0 = 0; i0 < N_AUXMAP_RADIX; i0++) {
+      void** mid = auxmap_radix[i0];
+      if (mid == NULL)
+         continue;
+      for (i1 = 0; i1 < N_AUXMAP_RADIX; i1++) {
+         SecMap** leaf = (SecMap**)mid[i1];
+         if (leaf == NULL)
+            continue;
+         for (i2 = 0; i2 < N_AUXMAP_RADIX; i2++) {
+            ULong base = ((ULong)i0 << 48) | ((ULong)i1 << 32)
+                         | ((ULong)i2 << 16);
+            if (leaf[i2] == NULL)
+               continue;
+            ents_seen++;
+            if (base <= MAX_PRIMARY_ADDRESS)
+               return "radix: entry for address <= MAX_PRIMARY_ADDRESS";
+            if (!is_distinguished_sm(leaf[i2]))
+               (*n_secmaps_found)++;
+         }
+      }
+   }
+   if (ents_seen != n_auxmap_radix_ents)
+      return "radix: disagreement on number of entries";
+   return NULL; /* ok */
+}
+
+/* --------------- Secondary map compaction --------------- */
+
+/* With --compact-secmaps=yes, secondaries whose content has become
+   uniformly noaccess, undefined or defined (for instance those of a large
+   block once the program has initialised it) are given back, and replaced
+   by the distinguished secondary with that content.  If they are written
+   to again in a way that makes them non-uniform, copy_for_writing expands
+   them again, as it does for any distinguished secondary.
+
+   The pass is done by copy_for_writing, when the number of
+   non-distinguished secondaries is twice what the previous pass left,
+   and at least MIN_SMS_FOR_COMPACTION.  Its cost, which is mostly one
+   look at the start of each secondary in use, is thus spread over the
+   secondaries made since the previous pass. */
+
+#define MIN_SMS_FOR_COMPACTION 1024   // 16MB of secondaries
+
+static Int n_non_DSM_SMs_for_compaction = MIN_SMS_FOR_COMPACTION;
+
+/* If *sm_ptr is a non-distinguished secondary with uniform content,
+   replace it by the matching distinguished one. */
+static void compact_secmap ( SecMap** sm_ptr )
+{
+   const UWord* w = (const UWord*)*sm_ptr;
+   SecMap*      dsm;
+   UWord        i;
+
+   if (is_distinguished_sm(*sm_ptr))
+      return;
+   if      (w[0] == ((UWord*)&sm_distinguished[SM_DIST_NOACCESS])[0])
+      dsm = &sm_distinguished[SM_DIST_NOACCESS];
+   else if (w[0] == ((UWord*)&sm_distinguished[SM_DIST_UNDEFINED])[0])
+      dsm = &sm_distinguished[SM_DIST_UNDEFINED];
+   else if (w[0] == ((UWord*)&sm_distinguished[SM_DIST_DEFINED])[0])
+      dsm = &sm_distinguished[SM_DIST_DEFINED];
+   else
+      return;
+   for (i = 1; i < sizeof(SecMap) / sizeof(UWord); i++)
+      if (w[i] != w[0])
+         return;
+
+   SysRes sres = VG_(am_munmap_valgrind)((Addr)*sm_ptr, sizeof(SecMap));
+   tl_assert2(! sr_isError(sres), "SecMap valgrind munmap failure\n");
+   update_SM_counts(*sm_ptr, dsm);
+   *sm_ptr = dsm;
+   n_secmaps_compacted++;
+}
+
+static void compact_secmaps ( void )
+{
+   UWord i;
+
+   n_secmap_compactions++;
+   for (i = 0; i < N_PRIMARY_MAP; i++)
+      compact_secmap(&primary_map[i]);
+
+   if (MC_(clo_aux_primary_map_radix)) {
+      UWord i0, i1, i2;
+      if (auxmap_radix == NULL)
+         return;
+      for (i0 = 0; i0 < N_AUXMAP_RADIX; i0++) {
+         void** mid = auxmap_radix[i0];
+         if (mid == NULL)
+            continue;
+         for (i1 = 0; i1 < N_AUXMAP_RADIX; i1++) {
+            SecMap** leaf = (SecMap**)mid[i1];
+            if (leaf == NULL)
+               continue;
+            for (i2 = 0; i2 < N_AUXMAP_RADIX; i2++)
+               if (leaf[i2] != NULL)
+                  compact_secmap(&leaf[i2]);
+         }
+      }
+   } else {
+      AuxMapEnt* elem;
+      VG_(OSetGen_ResetIter)(auxmap_L2);
+      while ( (elem = VG_(OSetGen_Next)(auxmap_L2)) )
+         compact_secmap(&elem->sm);
+   }
+}
+
+static void maybe_compact_secmaps ( void )
+{
+   if (n_non_DSM_SMs < n_non_DSM_SMs_for_compaction)
+      return;
+   compact_secmaps();
+   n_non_DSM_SMs_for_compaction = 2 * n_non_DSM_SMs;
+   if (n_non_DSM_SMs_for_compaction < MIN_SMS_FOR_COMPACTION)
+      n_non_DSM_SMs_for_compaction = MIN_SMS_FOR_COMPACTION;
+}
+
 /* --------------- SecMap fundamentals --------------- */
 
 // In all these, 'low' means it's definitely in the main primary map,
@@ -630,7 +850,10 @@ static INLINE SecMap** get_secmap_low_ptr ( Addr a )
 
 static INLINE SecMap** get_secmap_high_ptr ( Addr a )
 {
-   AuxMapEnt* am = find_or_alloc_in_auxmap(a);
+   AuxMapEnt* am;
+   if (MC_(clo_aux_primary_map_radix))
+      return find_in_auxmap_radix(a, True);
+   am = find_or_alloc_in_auxmap(a);
    return &am->sm;
 }
 
@@ -701,6 +924,9 @@ static SecMap* maybe_get_secmap_for ( Addr a )
 {
    if (a <= MAX_PRIMARY_ADDRESS) {
       return get_secmap_for_reading_low(a);
+   } else if (MC_(clo_aux_primary_map_radix)) {
+      SecMap** ent = find_in_auxmap_radix(a, False);
+      return ent ? *ent : NULL;
    } else {
       AuxMapEnt* am = maybe_find_in_auxmap(a);
       return am ? am->sm : NULL;
@@ -745,6 +971,15 @@ UChar extract_vabits4_from_vabits8 ( Addr a, UChar vabits8 )
    return 0xf & vabits8;               // mask out the rest
 }
 
+// For --incremental-leak-check=yes: note that the V+A bits of the
+// aligned word at 'a' are being changed (see MC_(leak_dirty_map)).
+// Changes over larger ranges use MC_(leak_mark_dirty).
+#define MARK_LEAK_DIRTY_WORD(a) \
+   do { \
+      if (UNLIKELY(MC_(clo_incremental_leak_check))) \
+         MC_(leak_dirty_map)[MC_LEAK_DIRTY_IDX(a)] = 1; \
+   } while (0)
+
 // Note that these four are only used in slow cases.  The fast cases do
 // clever things like combine the auxmap check (in
 // get_secmap_{read,writ}able) with alignment checks.
@@ -759,6 +994,7 @@ void set_vabits2 ( Addr a, UChar vabits2 )
    SecMap* sm       = get_secmap_for_writing(a);
    UWord   sm_off   = SM_OFF(a);
    insert_vabits2_into_vabits8( a, vabits2, &(sm->vabits8[sm_off]) );
+   MARK_LEAK_DIRTY_WORD(a);
 }
 
 static INLINE
@@ -789,6 +1025,7 @@ void set_vabits8_for_aligned_word32 ( Addr a, UChar vabits8 )
    SecMap* sm       = get_secmap_for_writing(a);
    UWord   sm_off   = SM_OFF(a);
    sm->vabits8[sm_off] = vabits8;
+   MARK_LEAK_DIRTY_WORD(a);
 }
 
 
@@ -1226,6 +1463,9 @@ static Bool modify_ignore_ranges ( Bool addRange, Addr start, Addr len )
    if (len == 0) {
       return False;
    }
+   /* The leak search does not scan ignored ranges. */
+   if (UNLIKELY(MC_(clo_incremental_leak_check)))
+      MC_(leak_mark_dirty)(start, len);
    if (addRange) {
       VG_(bindRangeMap)(gIgnoredAddressRanges,
                         start, start+len-1, IAR_ClientReq);
@@ -1689,6 +1929,9 @@ static void set_address_range_perms ( Addr a, SizeT lenT, UWord vabits16,
    if (lenT == 0)
       return;
 
+   if (UNLIKELY(MC_(clo_incremental_leak_check)))
+      MC_(leak_mark_dirty)(a, lenT);
+
    if (lenT > 256 * 1024 * 1024) {
       if (VG_(clo_verbosity) > 0 && !VG_(clo_xml)) {
          const HChar* s = "unknown???";
@@ -2006,34 +2249,69 @@ static void make_mem_defined_if_noaccess ( Addr a, SizeT len )
 /* --- Block-copy permissions (needed for implementing realloc() and
        sys_mremap). --- */
 
-void MC_(copy_address_range_state) ( Addr src, Addr dst, SizeT len )
-{
-   SizeT i, j;
-   UChar vabits2, vabits8;
-   Bool  aligned, nooverlap;
-
-   DEBUG("MC_(copy_address_range_state)\n");
-   PROF_EVENT(MCPE_COPY_ADDRESS_RANGE_STATE);
-
-   if (len == 0 || src == dst)
-      return;
-
-   aligned   = VG_IS_4_ALIGNED(src) && VG_IS_4_ALIGNED(dst);
-   nooverlap = src+len <= dst || dst+len <= src;
-
-   if (nooverlap && aligned) {
-
-      /* Vectorised fast case, when no overlap and suitably aligned */
-      /* vector loop */
-      i = 0;
-      while (len >= 4) {
-         vabits8 = get_vabits8_for_aligned_word32( src+i );
-         set_vabits8_for_aligned_word32( dst+i, vabits8 );
-         if (LIKELY(VA_BITS8_DEFINED == vabits8
-                            || VA_BITS8_UNDEFINED == vabits8
-                            || VA_BITS8_NOACCESS == vabits8)) {
-            /* do nothing */
+static INLINE void copy_vabits2 ( Addr src, Addr dst )
+{
+   UChar vabits2 = get_vabits2( src );
+   set_vabits2( dst, vabits2 );
+   if (VA_BITS2_PARTDEFINED == vabits2) {
+      set_sec_vbits8( dst, get_sec_vbits8( src ) );
+   }
+}
+
+/* Copy the V+A bits of [src, src+len) to [dst, dst+len), which do not
+   overlap, and are 4-aligned, as is len.  This is done a secondary map
+   chunk at a time, with memcpy, or with memset when the source is a
+   distinguished secondary.  Whole destination secondaries are replaced
+   by a distinguished source rather than written. */
+static void copy_address_range_state_aligned ( Addr src, Addr dst, SizeT len )
+{
+   SizeT    n, i;
+   SecMap*  src_sm;
+   SecMap*  dst_sm;
+   SecMap** dst_sm_ptr;
+   UChar*   src_vabits8;
+   UChar    vabits8;
+
+   while (len > 0) {
+      n = len;
+      if (n > start_of_this_sm(src) + SM_SIZE - src)
+         n = start_of_this_sm(src) + SM_SIZE - src;
+      if (n > start_of_this_sm(dst) + SM_SIZE - dst)
+         n = start_of_this_sm(dst) + SM_SIZE - dst;
+
+      src_sm     = get_secmap_for_reading(src);
+      dst_sm_ptr = get_secmap_ptr(dst);
+
+      if (is_distinguished_sm(src_sm)) {
+         if (*dst_sm_ptr == src_sm) {
+            // Already has the V+A bits wanted.
+         } else if (n == SM_SIZE) {
+            if (!is_distinguished_sm(*dst_sm_ptr)) {
+               SysRes sres = VG_(am_munmap_valgrind)((Addr)*dst_sm_ptr,
+                                                     sizeof(SecMap));
+               tl_assert2(! sr_isError(sres),
+                          "SecMap valgrind munmap failure\n");
+            }
+            update_SM_counts(*dst_sm_ptr, src_sm);
+            *dst_sm_ptr = src_sm;
          } else {
+            vabits8 = src_sm->vabits8[0];
+            dst_sm  = get_secmap_for_writing(dst);
+            VG_(memset)(&dst_sm->vabits8[SM_OFF(dst)], vabits8, n >> 2);
+         }
+      } else {
+         // Making the destination writable may compact secondaries
+         // (--compact-secmaps=yes), so look the source up again.
+         dst_sm      = get_secmap_for_writing(dst);
+         src_sm      = get_secmap_for_reading(src);
+         src_vabits8 = &src_sm->vabits8[SM_OFF(src)];
+         VG_(memcpy)(&dst_sm->vabits8[SM_OFF(dst)], src_vabits8, n >> 2);
+         for (i = 0; i < n; i += 4) {
+            vabits8 = src_vabits8[i >> 2];
+            if (LIKELY(VA_BITS8_DEFINED == vabits8
+                       || VA_BITS8_UNDEFINED == vabits8
+                       || VA_BITS8_NOACCESS == vabits8))
+               continue;
             /* have to copy secondary map info */
             if (VA_BITS2_PARTDEFINED == get_vabits2( src+i+0 ))
                set_sec_vbits8( dst+i+0, get_sec_vbits8( src+i+0 ) );
@@ -2044,19 +2322,45 @@ void MC_(copy_address_range_state) ( Addr src, Addr dst, SizeT len )
             if (VA_BITS2_PARTDEFINED == get_vabits2( src+i+3 ))
                set_sec_vbits8( dst+i+3, get_sec_vbits8( src+i+3 ) );
          }
-         i += 4;
-         len -= 4;
       }
-      /* fixup loop */
-      while (len >= 1) {
-         vabits2 = get_vabits2( src+i );
-         set_vabits2( dst+i, vabits2 );
-         if (VA_BITS2_PARTDEFINED == vabits2) {
-            set_sec_vbits8( dst+i, get_sec_vbits8( src+i ) );
-         }
-         i++;
+      src += n;
+      dst += n;
+      len -= n;
+   }
+}
+
+void MC_(copy_address_range_state) ( Addr src, Addr dst, SizeT len )
+{
+   SizeT i, j;
+   Bool  equally_aligned, nooverlap;
+
+   DEBUG("MC_(copy_address_range_state)\n");
+   PROF_EVENT(MCPE_COPY_ADDRESS_RANGE_STATE);
+
+   if (len == 0 || src == dst)
+      return;
+
+   if (UNLIKELY(MC_(clo_incremental_leak_check)))
+      MC_(leak_mark_dirty)(dst, len);
+
+   equally_aligned = (src & 3) == (dst & 3);
+   nooverlap       = src+len <= dst || dst+len <= src;
+
+   if (nooverlap && equally_aligned) {
+
+      /* Fast case, when no overlap and equally aligned: the bytes up
+         to the first 4-aligned address and after the last one are
+         copied one at a time, and the words in between in bulk. */
+      while (len >= 1 && !VG_IS_4_ALIGNED(src)) {
+         copy_vabits2( src, dst );
+         src++;
+         dst++;
          len--;
       }
+      i = len & ~(SizeT)3;
+      copy_address_range_state_aligned( src, dst, i );
+      for (; i < len; i++)
+         copy_vabits2( src+i, dst+i );
 
    } else {
 
@@ -2064,22 +2368,14 @@ void MC_(copy_address_range_state) ( Addr src, Addr dst, SizeT len )
       if (src < dst) {
          for (i = 0, j = len-1; i < len; i++, j--) {
             PROF_EVENT(MCPE_COPY_ADDRESS_RANGE_STATE_LOOP1);
-            vabits2 = get_vabits2( src+j );
-            set_vabits2( dst+j, vabits2 );
-            if (VA_BITS2_PARTDEFINED == vabits2) {
-               set_sec_vbits8( dst+j, get_sec_vbits8( src+j ) );
-            }
+            copy_vabits2( src+j, dst+j );
          }
       }
 
       if (src > dst) {
          for (i = 0; i < len; i++) {
             PROF_EVENT(MCPE_COPY_ADDRESS_RANGE_STATE_LOOP2);
-            vabits2 = get_vabits2( src+i );
-            set_vabits2( dst+i, vabits2 );
-            if (VA_BITS2_PARTDEFINED == vabits2) {
-               set_sec_vbits8( dst+i, get_sec_vbits8( src+i ) );
-            }
+            copy_vabits2( src+i, dst+i );
          }
       }
    }
@@ -2412,6 +2708,12 @@ static UWord stats__ocacheL2_adds          = 0;
 static UWord stats__ocacheL2_dels          = 0;
 static UWord stats__ocacheL2_misses        = 0;
 static UWord stats__ocacheL2_n_nodes_max   = 0;
+static UWord stats__ocacheL2_range_dels    = 0;
+
+/* Lines set and cleared whole by ocache_sarp_Set_Origins and
+   ocache_sarp_Clear_Origins. */
+static UWord stats_ocache_sarp_lines_set     = 0;
+static UWord stats_ocache_sarp_lines_cleared = 0;
 
 /* Cache of 32-bit values, one every 32 bits of address space */
 
@@ -2425,10 +2727,10 @@ static INLINE Bool is_valid_oc_tag ( Addr tag ) {
    return 0 == (tag & ((1 << OC_BITS_PER_LINE) - 1));
 }
 
-#define OC_LINES_PER_SET 2
-
-#define OC_N_SET_BITS    20
-#define OC_N_SETS        (1 << OC_N_SET_BITS)
+/* The L1 has OC_N_LINES lines, in sets of oc_lines_per_set lines
+   (--origin-cache-ways, 2 by default). */
+#define OC_N_LINE_BITS   21
+#define OC_N_LINES       (1 << OC_N_LINE_BITS)
 
 /* These settings give:
    64 bit host: ocache:  100,663,296 sizeB    67,108,864 useful
@@ -2446,7 +2748,6 @@ static INLINE Bool is_valid_oc_tag ( Addr tag ) {
    size is 32 bytes).  Changing that would require a bunch of re-tuning
    effort.  So let's set it in stone for now. */
 STATIC_ASSERT(OC_BITS_PER_LINE == 5);
-STATIC_ASSERT(OC_LINES_PER_SET == 2);
 
 /* Fundamentally we want an OCacheLine structure (see below) as follows:
       struct {
@@ -2523,50 +2824,64 @@ static inline UChar classify_OCacheLine ( OCacheLine* line )
    return 'z'; /* ZERO - no useful info */
 }
 
-typedef
-   struct {
-      OCacheLine line[OC_LINES_PER_SET];
-   }
-   OCacheSet;
+/* The L1 is an array of sets of oc_lines_per_set lines each.  The set
+   for address a starts at line number
+      ((a >> OC_BITS_PER_LINE) & (number of sets - 1)) * oc_lines_per_set
+   which oc_set_for computes as (a >> oc_set_shift) & oc_set_mask.  For
+   the default of 2 ways, it uses constants instead, as the code did
+   before the number of ways could be chosen. */
+static OCacheLine* ocacheL1 = NULL;
+static UWord       ocacheL1_event_ctr = 0;
+static UWord       oc_lines_per_set;
+static UWord       oc_set_shift;
+static UWord       oc_set_mask;
 
-typedef
-   struct {
-      OCacheSet set[OC_N_SETS];
-   }
-   OCache;
+#define OC_DEFAULT_LINES_PER_SET 2
 
-static OCache* ocacheL1 = NULL;
-static UWord   ocacheL1_event_ctr = 0;
+static INLINE OCacheLine* oc_set_for ( Addr a ) {
+   if (LIKELY(oc_lines_per_set == OC_DEFAULT_LINES_PER_SET))
+      return &ocacheL1[(a >> (OC_BITS_PER_LINE - 1))
+                       & (OC_N_LINES - OC_DEFAULT_LINES_PER_SET)];
+   return &ocacheL1[(a >> oc_set_shift) & oc_set_mask];
+}
 
 static void init_ocacheL2 ( void ); /* fwds */
 static void init_OCache ( void )
 {
-   UWord line, set;
+   UWord line, way_bits;
    tl_assert(MC_(clo_mc_level) >= 3);
    tl_assert(ocacheL1 == NULL);
-   SysRes sres = VG_(am_shadow_alloc)(sizeof(OCache));
+
+   oc_lines_per_set = MC_(clo_origin_cache_ways);
+   for (way_bits = 0; (1 << way_bits) < oc_lines_per_set; way_bits++)
+      ;
+   tl_assert(oc_lines_per_set == (1 << way_bits));
+   tl_assert(way_bits >= 1 && way_bits <= OC_BITS_PER_LINE - 2);
+   oc_set_shift = OC_BITS_PER_LINE - way_bits;
+   oc_set_mask  = OC_N_LINES - oc_lines_per_set;
+
+   SysRes sres = VG_(am_shadow_alloc)(OC_N_LINES * sizeof(OCacheLine));
    if (sr_isError(sres)) {
       VG_(out_of_memory_NORETURN)( "memcheck:allocating ocacheL1",
-                                   sizeof(OCache), sr_Err(sres) );
+                                   OC_N_LINES * sizeof(OCacheLine),
+                                   sr_Err(sres) );
    }
    ocacheL1 = (void *)(Addr)sr_Res(sres);
    tl_assert(ocacheL1 != NULL);
-   for (set = 0; set < OC_N_SETS; set++) {
-      for (line = 0; line < OC_LINES_PER_SET; line++) {
-         ocacheL1->set[set].line[line].tag = 1/*invalid*/;
-      }
+   for (line = 0; line < OC_N_LINES; line++) {
+      ocacheL1[line].tag = 1/*invalid*/;
    }
    init_ocacheL2();
 }
 
-static inline void moveLineForwards ( OCacheSet* set, UWord lineno )
+static inline void moveLineForwards ( OCacheLine* set, UWord lineno )
 {
    OCacheLine tmp;
    stats_ocacheL1_movefwds++;
-   tl_assert(lineno > 0 && lineno < OC_LINES_PER_SET);
-   tmp = set->line[lineno-1];
-   set->line[lineno-1] = set->line[lineno];
-   set->line[lineno] = tmp;
+   tl_assert(lineno > 0 && lineno < oc_lines_per_set);
+   tmp = set[lineno-1];
+   set[lineno-1] = set[lineno];
+   set[lineno] = tmp;
 }
 
 static inline void zeroise_OCacheLine ( OCacheLine* line, Addr tag ) {
@@ -2692,52 +3007,50 @@ static void ocacheL2_add_line ( OCacheLine* line )
       stats__ocacheL2_n_nodes_max = stats__ocacheL2_n_nodes;
 }
 
+/* Delete the lines with tags in [a, a+len) from the tree.  The lines of
+   each 2^(OC_BITS_PER_LINE + 11) bytes chunk of the range are in the same
+   tree, in which they are found by iterating from the first of them. */
+static void ocacheL2_del_range ( Addr a, UWord len )
+{
+   Addr end = a + len;
+   tl_assert(is_valid_oc_tag(a) && is_valid_oc_tag(len));
+   while (a < end) {
+      const Addr chunk_szB = (Addr)1 << (OC_BITS_PER_LINE + 11);
+      Addr  chunk_end = (a & ~(chunk_szB - 1)) + chunk_szB;
+      OSet* oset      = ocachesL2[HASH_OCACHE_TAG(a)];
+      Addr  tags[16];
+      UWord n, i;
+      if (chunk_end > end || chunk_end < a)
+         chunk_end = end;
+      while (VG_(OSetGen_Size)(oset) > 0) {
+         OCacheLine* line;
+         n = 0;
+         VG_(OSetGen_ResetIterAt)(oset, &a);
+         while (n < 16 && (line = VG_(OSetGen_Next)(oset)) != NULL
+                && line->tag < chunk_end)
+            tags[n++] = line->tag;
+         for (i = 0; i < n; i++)
+            ocacheL2_del_tag(tags[i]);
+         stats__ocacheL2_range_dels += n;
+         if (n < 16)
+            break;
+         a = tags[15] + (1 << OC_BITS_PER_LINE);
+      }
+      a = chunk_end;
+   }
+}
+
 ////
 //////////////////////////////////////////////////////////////
 
-__attribute__((noinline))
-static OCacheLine* find_OCacheLine_SLOW ( Addr a )
+/* Make room in 'set' for a line which is not in it, by ejecting its last
+   line to the L2 if it has useful info. */
+static void ocacheL1_eject_last ( OCacheLine* set )
 {
    OCacheLine *victim, *inL2;
    UChar c;
-   UWord line;
-   UWord setno   = (a >> OC_BITS_PER_LINE) & (OC_N_SETS - 1);
-   UWord tagmask = ~((1 << OC_BITS_PER_LINE) - 1);
-   UWord tag     = a & tagmask;
-   tl_assert(setno < OC_N_SETS);
 
-   /* we already tried line == 0; skip therefore. */
-   for (line = 1; line < OC_LINES_PER_SET; line++) {
-      if (ocacheL1->set[setno].line[line].tag == tag) {
-         switch (line) {
-         // with OC_LINES_PER_SET equal to 2 this is the only possible case
-         case 1:
-            stats_ocacheL1_found_at_1++;
-            break;
-#if OC_LINES_PER_SET > 2
-         default:
-            stats_ocacheL1_found_at_N++;
-            break;
-#endif
-         }
-         if (UNLIKELY(0 == (ocacheL1_event_ctr++
-                            & ((1<<OC_MOVE_FORWARDS_EVERY_BITS)-1)))) {
-            moveLineForwards( &ocacheL1->set[setno], line );
-            line--;
-         }
-         return &ocacheL1->set[setno].line[line];
-      }
-   }
-
-   /* A miss.  Use the last slot.  Implicitly this means we're
-      ejecting the line in the last slot. */
-   stats_ocacheL1_misses++;
-   tl_assert(line == OC_LINES_PER_SET);
-   line--;
-   tl_assert(line > 0);
-
-   /* First, move the to-be-ejected line to the L2 cache. */
-   victim = &ocacheL1->set[setno].line[line];
+   victim = &set[oc_lines_per_set - 1];
    c = classify_OCacheLine(victim);
    switch (c) {
       case 'e':
@@ -2765,43 +3078,79 @@ static OCacheLine* find_OCacheLine_SLOW ( Addr a )
       default:
          tl_assert(0);
    }
+}
+
+__attribute__((noinline))
+static OCacheLine* find_OCacheLine_SLOW ( Addr a )
+{
+   OCacheLine *inL2;
+   UWord line;
+   OCacheLine* set = oc_set_for(a);
+   UWord tagmask = ~((1 << OC_BITS_PER_LINE) - 1);
+   UWord tag     = a & tagmask;
+
+   /* we already tried line == 0; skip therefore. */
+   for (line = 1; line < oc_lines_per_set; line++) {
+      if (set[line].tag == tag) {
+         if (line == 1)
+            stats_ocacheL1_found_at_1++;
+         else
+            stats_ocacheL1_found_at_N++;
+         if (UNLIKELY(0 == (ocacheL1_event_ctr++
+                            & ((1<<OC_MOVE_FORWARDS_EVERY_BITS)-1)))) {
+            moveLineForwards( set, line );
+            line--;
+         }
+         return &set[line];
+      }
+   }
+
+   /* A miss.  Use the last slot.  Implicitly this means we're
+      ejecting the line in the last slot. */
+   stats_ocacheL1_misses++;
+   tl_assert(line == oc_lines_per_set);
+   line--;
+   tl_assert(line > 0);
+
+   /* First, move the to-be-ejected line to the L2 cache. */
+   ocacheL1_eject_last( set );
 
    /* Now we must reload the L1 cache from the backing tree, if
       possible. */
-   tl_assert(tag != victim->tag); /* stay sane */
+   tl_assert(tag != set[line].tag); /* stay sane */
    inL2 = ocacheL2_find_tag( tag );
    if (inL2) {
       /* We're in luck.  It's in the L2. */
-      ocacheL1->set[setno].line[line] = *inL2;
+      set[line] = *inL2;
    } else {
       /* Missed at both levels of the cache hierarchy.  We have to
          declare it as full of zeroes (unknown origins). */
       stats__ocacheL2_misses++;
-      zeroise_OCacheLine( &ocacheL1->set[setno].line[line], tag );
+      zeroise_OCacheLine( &set[line], tag );
    }
 
    /* Move it one forwards */
-   moveLineForwards( &ocacheL1->set[setno], line );
+   moveLineForwards( set, line );
    line--;
 
-   return &ocacheL1->set[setno].line[line];
+   return &set[line];
 }
 
 static INLINE OCacheLine* find_OCacheLine ( Addr a )
 {
-   UWord setno   = (a >> OC_BITS_PER_LINE) & (OC_N_SETS - 1);
+   OCacheLine* set = oc_set_for(a);
    UWord tagmask = ~((1 << OC_BITS_PER_LINE) - 1);
    UWord tag     = a & tagmask;
 
    stats_ocacheL1_find++;
 
    if (OC_ENABLE_ASSERTIONS) {
-      tl_assert(setno >= 0 && setno < OC_N_SETS);
+      tl_assert(set >= ocacheL1 && set < ocacheL1 + OC_N_LINES);
       tl_assert(0 == (tag & (4 * OC_W32S_PER_LINE - 1)));
    }
 
-   if (LIKELY(ocacheL1->set[setno].line[0].tag == tag)) {
-      return &ocacheL1->set[setno].line[0];
+   if (LIKELY(set[0].tag == tag)) {
+      return &set[0];
    }
 
    return find_OCacheLine_SLOW( a );
@@ -2856,6 +3205,7 @@ static INLINE void make_aligned_word32_undefined ( Addr a )
       sm                  = get_secmap_for_writing_low(a);
       sm_off              = SM_OFF(a);
       sm->vabits8[sm_off] = VA_BITS8_UNDEFINED;
+      MARK_LEAK_DIRTY_WORD(a);
    }
 #endif
 }
@@ -2899,6 +3249,7 @@ void make_aligned_word32_noaccess ( Addr a )
       sm                  = get_secmap_for_writing_low(a);
       sm_off              = SM_OFF(a);
       sm->vabits8[sm_off] = VA_BITS8_NOACCESS;
+      MARK_LEAK_DIRTY_WORD(a);
 
       //// BEGIN inlined, specialised version of MC_(helperc_b_store4)
       //// Set the origins for a+0 .. a+3.
@@ -2940,6 +3291,7 @@ static INLINE void make_aligned_word64_undefined ( Addr a )
       sm       = get_secmap_for_writing_low(a);
       sm_off16 = SM_OFF_16(a);
       sm->vabits16[sm_off16] = VA_BITS16_UNDEFINED;
+      MARK_LEAK_DIRTY_WORD(a);
    }
 #endif
 }
@@ -2983,6 +3335,7 @@ void make_aligned_word64_noaccess ( Addr a )
       sm       = get_secmap_for_writing_low(a);
       sm_off16 = SM_OFF_16(a);
       sm->vabits16[sm_off16] = VA_BITS16_NOACCESS;
+      MARK_LEAK_DIRTY_WORD(a);
 
       //// BEGIN inlined, specialised version of MC_(helperc_b_store8)
       //// Clear the origins for a+0 .. a+7.
@@ -3761,6 +4114,9 @@ void MC_(helperc_MAKE_STACK_UNINIT_w_o) ( Addr base, UWord len, Addr nia )
 
    UInt otag = ecu | MC_OKIND_STACK;
 
+   if (UNLIKELY(MC_(clo_incremental_leak_check)))
+      MC_(leak_mark_dirty)(base, len);
+
 #  if 0
    /* Slow(ish) version, which is fairly easily seen to be correct.
    */
@@ -3958,6 +4314,9 @@ void MC_(helperc_MAKE_STACK_UNINIT_no_o) ( Addr base, UWord len )
       VG_(printf)("helperc_MAKE_STACK_UNINIT_no_o (%#lx,%lu)\n",
                   base, len );
 
+   if (UNLIKELY(MC_(clo_incremental_leak_check)))
+      MC_(leak_mark_dirty)(base, len);
+
 #  if 0
    /* Slow(ish) version, which is fairly easily seen to be correct.
    */
@@ -4102,6 +4461,9 @@ void MC_(helperc_MAKE_STACK_UNINIT_128_no_o) ( Addr base )
    if (0)
       VG_(printf)("helperc_MAKE_STACK_UNINIT_128_no_o (%#lx)\n", base );
 
+   if (UNLIKELY(MC_(clo_incremental_leak_check)))
+      MC_(leak_mark_dirty)(base, 128);
+
 #  if 0
    /* Slow(ish) version, which is fairly easily seen to be correct.
    */
@@ -4565,6 +4927,11 @@ void mc_new_mem_mmap ( Addr a, SizeT len, Bool rr, Bool ww, Bool xx,
 static
 void mc_new_mem_mprotect ( Addr a, SizeT len, Bool rr, Bool ww, Bool xx )
 {
+   /* Whether the leak search can read the memory changes, even where
+      the V+A bits don't. */
+   if (UNLIKELY(MC_(clo_incremental_leak_check)))
+      MC_(leak_mark_dirty)(a, len);
+
    if (rr || ww || xx) {
       /* (4) mprotect other  ->  change any "noaccess" to "defined" */
       make_mem_defined_if_noaccess(a, len);
@@ -5463,6 +5830,7 @@ void mc_STOREV16 ( Addr a, UWord vbits16, Bool isBigEndian )
          }
          PROF_EVENT(MCPE_STOREV16_SLOW2);
          mc_STOREVn_slow( a, 16, (ULong)vbits16, isBigEndian );
+         return;
       }
       if (V_BITS16_UNDEFINED == vbits16) {
          if (vabits8 == VA_BITS8_UNDEFINED) {
@@ -5876,6 +6244,15 @@ Bool MC_(is_within_valid_secondary) ( Addr a )
 }
 
 
+/* For the memory leak detector: while frozen, the two functions above
+   and below only read the shadow memory, and so can be called by
+   several threads at once. */
+void MC_(freeze_auxmap_L1) ( Bool frozen )
+{
+   auxmap_L1_frozen = frozen;
+}
+
+
 /* For the memory leak detector, say whether or not a given word
    address is to be regarded as valid. */
 Bool MC_(is_valid_aligned_word) ( Addr a )
@@ -6004,7 +6381,9 @@ static Bool mc_expensive_sanity_check ( void )
 
    /* check the auxiliary maps, very thoroughly */
    n_secmaps_found = 0;
-   errmsg = check_auxmap_L1_L2_sanity( &n_secmaps_found );
+   errmsg = MC_(clo_aux_primary_map_radix)
+               ? check_auxmap_radix_sanity( &n_secmaps_found )
+               : check_auxmap_L1_L2_sanity( &n_secmaps_found );
    if (errmsg) {
       VG_(printf)("memcheck expensive sanity, auxmaps:\n\t%s", errmsg);
       return False;
@@ -6062,6 +6441,8 @@ UInt          MC_(clo_leak_check_heuristics)  =   H2S(LchStdString)
                                                 | H2S( LchLength64)
                                                 | H2S( LchNewArray)
                                                 | H2S( LchMultipleInheritance);
+Int           MC_(clo_leak_check_threads)     = 1;
+Bool          MC_(clo_incremental_leak_check) = False;
 Bool          MC_(clo_xtree_leak)             = False;
 const HChar*  MC_(clo_xtree_leak_file) = "xtleak.kcg.%p";
 Bool          MC_(clo_workaround_gcc296_bugs) = False;
@@ -6069,11 +6450,14 @@ Int           MC_(clo_malloc_fill)            = -1;
 Int           MC_(clo_free_fill)              = -1;
 KeepStacktraces MC_(clo_keep_stacktraces)     = KS_alloc_and_free;
 Int           MC_(clo_mc_level)               = 2;
+UInt          MC_(clo_origin_cache_ways)      = 2;
 Bool          MC_(clo_show_mismatched_frees)  = True;
 Bool          MC_(clo_show_realloc_size_zero) = True;
 
 ExpensiveDefinednessChecks
               MC_(clo_expensive_definedness_checks) = EdcAUTO;
+Bool          MC_(clo_aux_primary_map_radix)  = False;
+Bool          MC_(clo_compact_secmaps)        = False;
 
 Bool          MC_(clo_ignore_range_below_sp)               = False;
 UInt          MC_(clo_ignore_range_below_sp__first_offset) = 0;
@@ -6125,6 +6509,12 @@ static Bool mc_process_cmd_line_options(const HChar* arg)
          MC_(clo_mc_level) = 2;
       }
    }
+   else if VG_XACT_CLO(arg, "--origin-cache-ways=2",
+                            MC_(clo_origin_cache_ways), 2) {}
+   else if VG_XACT_CLO(arg, "--origin-cache-ways=4",
+                            MC_(clo_origin_cache_ways), 4) {}
+   else if VG_XACT_CLO(arg, "--origin-cache-ways=8",
+                            MC_(clo_origin_cache_ways), 8) {}
    else if VG_BOOL_CLO(arg, "--partial-loads-ok", MC_(clo_partial_loads_ok)) {}
    else if VG_USET_CLOM(cloPD, arg, "--errors-for-leak-kinds",
                         MC_(parse_leak_kinds_tokens),
@@ -6135,6 +6525,10 @@ static Bool mc_process_cmd_line_options(const HChar* arg)
    else if VG_USET_CLOM(cloPD, arg, "--leak-check-heuristics",
                         MC_(parse_leak_heuristics_tokens),
                         MC_(clo_leak_check_heuristics)) {}
+   else if VG_BINT_CLOM(cloPD, arg, "--leak-check-threads",
+                        MC_(clo_leak_check_threads), 1, 64) {}
+   else if VG_BOOL_CLO(arg, "--incremental-leak-check",
+                       MC_(clo_incremental_leak_check)) {}
    else if (VG_BOOL_CLOM(cloPD, arg, "--show-reachable", tmp_show)) {
       if (tmp_show) {
          MC_(clo_show_leak_kinds) = MC_(all_Reachedness)();
@@ -6272,6 +6666,12 @@ static Bool mc_process_cmd_line_options(const HChar* arg)
                             MC_(clo_expensive_definedness_checks), EdcAUTO) {}
    else if VG_XACT_CLO(arg, "--expensive-definedness-checks=yes",
                             MC_(clo_expensive_definedness_checks), EdcYES) {}
+   else if VG_XACT_CLO(arg, "--aux-primary-map=list",
+                            MC_(clo_aux_primary_map_radix), False) {}
+   else if VG_XACT_CLO(arg, "--aux-primary-map=radix",
+                            MC_(clo_aux_primary_map_radix), True) {}
+   else if VG_BOOL_CLO(arg, "--compact-secmaps",
+                       MC_(clo_compact_secmaps)) {}
 
    else if VG_BOOL_CLO(arg, "--xtree-leak",
                        MC_(clo_xtree_leak)) {}
@@ -6305,6 +6705,9 @@ static void mc_print_usage(void)
 "        improving leak search false positive [all]\n"
 "        where heur is one of:\n"
 "          stdstring length64 newarray multipleinheritance all none\n"
+"    --leak-check-threads=<number>    host threads used to search for leaks [1]\n"
+"    --incremental-leak-check=no|yes  reuse the memory scan of the previous\n"
+"                                     leak search where unchanged [no]\n"
 "    --show-reachable=yes             same as --show-leak-kinds=all\n"
 "    --show-reachable=no --show-possibly-lost=yes\n"
 "                                     same as --show-leak-kinds=definite,possible\n"
@@ -6314,9 +6717,14 @@ static void mc_print_usage(void)
 "    --xtree-leak-file=<file>         xtree leak report file [xtleak.kcg.%%p]\n"
 "    --undef-value-errors=no|yes      check for undefined value errors [yes]\n"
 "    --track-origins=no|yes           show origins of undefined values? [no]\n"
+"    --origin-cache-ways=2|4|8        associativity of the cache of origins [2]\n"
 "    --partial-loads-ok=no|yes        too hard to explain here; see manual [yes]\n"
 "    --expensive-definedness-checks=no|auto|yes\n"
 "                                     Use extra-precise definedness tracking [auto]\n"
+"    --aux-primary-map=list|radix     how to find shadow memory for addresses\n"
+"                                     above 128G [list]\n"
+"    --compact-secmaps=no|yes         give back the shadow memory of regions\n"
+"                                     that become uniformly (un)defined [no]\n"
 "    --freelist-vol=<number>          volume of freed blocks queue     [20000000]\n"
 "    --freelist-big-blocks=<number>   releases first blocks with size>= [1000000]\n"
 "    --workaround-gcc296-bugs=no|yes  self explanatory [no].  Deprecated.\n"
@@ -7134,6 +7542,8 @@ static Bool mc_handle_client_request ( ThreadId tid, UWord* arg, UWord* ret )
          break;
 
       case VG_USERREQ__GET_VBITS:
+         if (UNLIKELY(MC_(clo_incremental_leak_check)))
+            MC_(leak_mark_dirty)(arg[2], arg[3]);
          *ret = mc_get_or_set_vbits_for_client
                    ( arg[1], arg[2], arg[3],
                      False /* get them */,
@@ -7149,6 +7559,10 @@ static Bool mc_handle_client_request ( ThreadId tid, UWord* arg, UWord* ret )
 
       case VG_USERREQ__COUNT_LEAKS: { /* count leaked bytes */
          UWord** argp = (UWord**)arg;
+         if (UNLIKELY(MC_(clo_incremental_leak_check))) {
+            for (i = 1; i <= 4; i++)
+               MC_(leak_mark_dirty)((Addr)argp[i], sizeof(UWord));
+         }
          // MC_(bytes_leaked) et al were set by the last leak check (or zero
          // if no prior leak checks performed).
          *argp[1] = MC_(bytes_leaked) + MC_(bytes_indirect);
@@ -7164,6 +7578,10 @@ static Bool mc_handle_client_request ( ThreadId tid, UWord* arg, UWord* ret )
       }
       case VG_USERREQ__COUNT_LEAK_BLOCKS: { /* count leaked blocks */
          UWord** argp = (UWord**)arg;
+         if (UNLIKELY(MC_(clo_incremental_leak_check))) {
+            for (i = 1; i <= 4; i++)
+               MC_(leak_mark_dirty)((Addr)argp[i], sizeof(UWord));
+         }
          // MC_(blocks_leaked) et al were set by the last leak check (or zero
          // if no prior leak checks performed).
          *argp[1] = MC_(blocks_leaked) + MC_(blocks_indirect);
@@ -8042,6 +8460,67 @@ void VG_REGPARM(2) MC_(helperc_b_store32)( Addr a, UWord d32 ) {
 // We may get asked to do very large SARPs (bug 446103), hence it is important
 // to process 32-byte chunks at a time when possible.
 
+/* Set the origins of the whole lines in [a, a+len) to otag, or clear
+   them.  These do the same as MC_(helperc_b_store32) on each line, but
+   do not reload the lines missing in the L1 from the L2 only to overwrite
+   them.  A line set in the L1 replaces any copy of it in the L2 when it
+   is ejected, and the L2 copies of the lines cleared but not in the L1
+   are deleted together. */
+static void ocache_set_lines ( Addr a, UWord len, UInt otag )
+{
+   const ULong w64 = ((ULong)otag << 32) | otag;
+   UWord i;
+
+   tl_assert(otag != 0);
+   STATIC_ASSERT(OC_W32S_PER_LINE == 8 && OC_W64S_PER_MAIN == 5);
+   stats_ocache_sarp_lines_set += len >> OC_BITS_PER_LINE;
+   for (; len > 0; a += 32, len -= 32) {
+      OCacheLine* set = oc_set_for(a);
+      OCacheLine* line;
+      for (i = 0; i < oc_lines_per_set; i++)
+         if (set[i].tag == a)
+            break;
+      if (i < oc_lines_per_set) {
+         line = &set[i];
+      } else {
+         ocacheL1_eject_last( set );
+         set[oc_lines_per_set - 1].tag = a;
+         moveLineForwards( set, oc_lines_per_set - 1 );
+         line = &set[oc_lines_per_set - 2];
+      }
+      line->u.w64s[0] = w64;
+      line->u.w64s[1] = w64;
+      line->u.w64s[2] = w64;
+      line->u.w64s[3] = w64;
+      line->u.w64s[4] = 0x0F0F0F0F0F0F0F0FULL; /* all of descr[] = 0xF */
+   }
+}
+
+static void ocache_clear_lines ( Addr a, UWord len )
+{
+   Addr  first_miss = 0, end_miss = 0;
+   Bool  missed = False;
+   UWord i;
+
+   stats_ocache_sarp_lines_cleared += len >> OC_BITS_PER_LINE;
+   for (; len > 0; a += 32, len -= 32) {
+      OCacheLine* set = oc_set_for(a);
+      for (i = 0; i < oc_lines_per_set; i++)
+         if (set[i].tag == a)
+            break;
+      if (i < oc_lines_per_set) {
+         zeroise_OCacheLine( &set[i], a );
+      } else {
+         if (!missed)
+            first_miss = a;
+         end_miss = a + 32;
+         missed = True;
+      }
+   }
+   if (missed && stats__ocacheL2_n_nodes > 0)
+      ocacheL2_del_range( first_miss, end_miss - first_miss );
+}
+
 __attribute__((noinline))
 static void ocache_sarp_Set_Origins ( Addr a, UWord len, UInt otag ) {
    if ((a & 1) && len >= 1) {
@@ -8071,11 +8550,12 @@ static void ocache_sarp_Set_Origins ( Addr a, UWord len, UInt otag ) {
    }
    if (len >= 32) {
       tl_assert(0 == (a & 31));
-      while (len >= 32) {
-         MC_(helperc_b_store32)( a, otag );
-         a += 32;
-         len -= 32;
-      }
+      if (otag != 0)
+         ocache_set_lines( a, len & ~(UWord)31, otag );
+      else
+         ocache_clear_lines( a, len & ~(UWord)31 );
+      a += len & ~(UWord)31;
+      len &= 31;
    }
    if (len >= 16) {
       MC_(helperc_b_store16)( a, otag );
@@ -8134,11 +8614,9 @@ static void ocache_sarp_Clear_Origins ( Addr a, UWord len ) {
    }
    if (len >= 32) {
       tl_assert(0 == (a & 31));
-      while (len >= 32) {
-         MC_(helperc_b_store32)( a, 0 );
-         a += 32;
-         len -= 32;
-      }
+      ocache_clear_lines( a, len & ~(UWord)31 );
+      a += len & ~(UWord)31;
+      len &= 31;
    }
    if (len >= 16) {
       MC_(helperc_b_store16)( a, 0 );
@@ -8367,6 +8845,12 @@ static void mc_print_stats (void)
       " memcheck: auxmaps_L2: %llu searches, %llu nodes\n",
       n_auxmap_L2_searches, n_auxmap_L2_nodes
    );
+   if (MC_(clo_aux_primary_map_radix))
+      VG_(message)(Vg_DebugMsg,
+         " memcheck: auxmaps_radix: %llu entries, %llu nodes (%lluk)\n",
+         n_auxmap_radix_ents, n_auxmap_radix_nodes,
+         n_auxmap_radix_nodes * N_AUXMAP_RADIX * sizeof(void*) / 1024
+      );
 
    print_SM_info("n_issued     ", n_issued_SMs);
    print_SM_info("n_deissued   ", n_deissued_SMs);
@@ -8374,6 +8858,12 @@ static void mc_print_stats (void)
    print_SM_info("max_undefined", max_undefined_SMs);
    print_SM_info("max_defined  ", max_defined_SMs);
    print_SM_info("max_non_DSM  ", max_non_DSM_SMs);
+   if (MC_(clo_compact_secmaps))
+      VG_(message)(Vg_DebugMsg,
+         " memcheck: SMs: %llu compactions, %llu compacted (%lluk, %lluM)\n",
+         n_secmap_compactions, n_secmaps_compacted,
+         n_secmaps_compacted * sizeof(SecMap) / 1024ULL,
+         n_secmaps_compacted * sizeof(SecMap) / (1024 * 1024ULL) );
 
    // Three DSMs, plus the non-DSM ones
    max_SMs_szB = (3 + max_non_DSM_SMs) * sizeof(SecMap);
@@ -8416,9 +8906,14 @@ static void mc_print_stats (void)
                    stats_ocacheL1_found_at_N,
                    stats_ocacheL1_movefwds );
       VG_(message)(Vg_DebugMsg,
-                   " ocacheL1: %'14lu sizeB  %'14d useful\n",
-                   (SizeT)sizeof(OCache),
-                   4 * OC_W32S_PER_LINE * OC_LINES_PER_SET * OC_N_SETS );
+                   " ocacheL1: %'14lu sizeB  %'14d useful (%lu ways)\n",
+                   (SizeT)(OC_N_LINES * sizeof(OCacheLine)),
+                   4 * OC_W32S_PER_LINE * OC_N_LINES,
+                   oc_lines_per_set );
+      VG_(message)(Vg_DebugMsg,
+                   " ocacheL1: %'14lu lines set in bulk, %'lu cleared\n",
+                   stats_ocache_sarp_lines_set,
+                   stats_ocache_sarp_lines_cleared );
       VG_(message)(Vg_DebugMsg,
                    " ocacheL2: %'14lu finds  %'14lu misses\n",
                    stats__ocacheL2_finds,
@@ -8431,6 +8926,9 @@ static void mc_print_stats (void)
                    " ocacheL2:    %'9lu max nodes %'9lu curr nodes\n",
                    stats__ocacheL2_n_nodes_max,
                    stats__ocacheL2_n_nodes );
+      VG_(message)(Vg_DebugMsg,
+                   " ocacheL2: %'14lu dels by range\n",
+                   stats__ocacheL2_range_dels );
       VG_(message)(Vg_DebugMsg,
                    " niacache: %'12lu refs   %'12lu misses\n",
                    stats__nia_cache_queries, stats__nia_cache_misses);
@@ -8607,6 +9105,7 @@ static void mc_pre_clo_init(void)
    MC_(Malloc_Redzone_SzB) = VG_(malloc_effective_client_redzone_size)();
 
    VG_(needs_xml_output)          ();
+   VG_(needs_translation_cache)   ();
 
    VG_(track_new_mem_startup)     ( mc_new_mem_startup );
 
@@ -6002,6 +6002,46 @@ IRExpr* zwidenToHostWord ( MCEnv* mce, IRAtom* vatom )
 }
 
 
+/* For --incremental-leak-check=yes, generate IR setting the
+   MC_(leak_dirty_map) entries of the first and the last of the szB
+   bytes at addr+bias, which a store may be about to change.  As these
+   are at most 32 bytes apart, no other entry can be involved.  This is
+   done even when a guarded store does not happen, which only makes
+   the next leak search scan a bit more. */
+static void gen_leak_dirty_mark ( MCEnv* mce, IRAtom* addr, UInt bias,
+                                  Int szB )
+{
+   IRType tyAddr  = mce->hWordTy;
+   Bool   is64    = tyAddr == Ity_I64;
+   UInt   offs[2] = { bias, bias + szB - 1 };
+   Int    i;
+   IREndness end;
+
+#  if defined(VG_BIGENDIAN)
+   end = Iend_BE;
+#  else
+   end = Iend_LE;
+#  endif
+
+   for (i = 0; i < (szB == 1 ? 1 : 2); i++) {
+      IRAtom* t = addr;
+      if (offs[i] != 0)
+         t = assignNew('V', mce, tyAddr,
+                       binop(is64 ? Iop_Add64 : Iop_Add32, t,
+                             is64 ? mkU64(offs[i]) : mkU32(offs[i])));
+      t = assignNew('V', mce, tyAddr,
+                    binop(is64 ? Iop_Shr64 : Iop_Shr32, t, mkU8(16)));
+      t = assignNew('V', mce, tyAddr,
+                    binop(is64 ? Iop_And64 : Iop_And32, t,
+                          is64 ? mkU64((1 << MC_LEAK_DIRTY_BITS) - 1)
+                               : mkU32((1 << MC_LEAK_DIRTY_BITS) - 1)));
+      t = assignNew('V', mce, tyAddr,
+                    binop(is64 ? Iop_Add64 : Iop_Add32, t,
+                          mkIRExpr_HWord( (HWord)&MC_(leak_dirty_map)[0] )));
+      stmt( 'V', mce, IRStmt_Store(end, t, mkU8(1)) );
+   }
+}
+
 /* Generate a shadow store.  |addr| is always the original address
    atom.  You can pass in either originals or V-bits for the data
    atom, but obviously not both.  This function generates a check for
@@ -6074,6 +6114,9 @@ void do_shadow_Store ( MCEnv* mce,
       those actions are gated on |guard|. */
    complainIfUndefined( mce, addr, guard );
 
+   if (MC_(clo_incremental_leak_check))
+      gen_leak_dirty_mark( mce, addr, bias, sizeofIRType(ty) );
+
    /* Now decide which helper function to call to write the data V
       bits into shadow memory. */
    if (end == Iend_LE) {
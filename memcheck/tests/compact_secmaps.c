@@ -0,0 +1,62 @@
+/* Check that the V and A bits of memory survive --compact-secmaps=yes
+   giving back its secondary maps, and having to expand them again. */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "../memcheck.h"
+
+#define SM_SIZE 65536
+#define N_SMS   2560   /* enough secondaries for two compactions */
+
+int main(void)
+{
+   char *p = mmap(NULL, N_SMS * SM_SIZE, PROT_READ|PROT_WRITE,
+                  MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+   int  i, n = 0;
+
+   if (p == MAP_FAILED) {
+      perror("mmap");
+      return 1;
+   }
+
+   /* Give each secondary a mixed content, then a uniform one: defined,
+      undefined or noaccess. */
+   VALGRIND_MAKE_MEM_UNDEFINED(p, N_SMS * SM_SIZE);
+   for (i = 0; i < N_SMS; i++) {
+      char *sm = p + i * SM_SIZE;
+      switch (i % 3) {
+      case 0:
+         memset(sm, 1, SM_SIZE);
+         break;
+      case 1:
+         memset(sm, 1, 100);
+         VALGRIND_MAKE_MEM_UNDEFINED(sm, 100);
+         break;
+      case 2:
+         memset(sm, 1, 100);
+         VALGRIND_MAKE_MEM_NOACCESS(sm, SM_SIZE - 1);
+         VALGRIND_MAKE_MEM_NOACCESS(sm + SM_SIZE - 1, 1);
+         break;
+      }
+   }
+
+   for (i = 0; i < 3; i++) {
+      char *sm = p + i * SM_SIZE;
+      fprintf(stderr, "secondary %d:\n", i);
+      if (VALGRIND_CHECK_MEM_IS_DEFINED(sm, SM_SIZE) == 0)
+         fprintf(stderr, "is defined\n");
+      if (i != 2 && sm[SM_SIZE / 2])
+         n++;
+   }
+   n += p[2 * SM_SIZE + 5];
+
+   /* Make the first one mixed again. */
+   VALGRIND_MAKE_MEM_UNDEFINED(p + 1, 1);
+   if (p[0])
+      n++;
+   if (p[1])
+      n++;
+
+   return n == 0;
+}
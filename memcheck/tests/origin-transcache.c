@@ -0,0 +1,59 @@
+/* Run with --track-origins=yes, --translation-cache and
+   --trace-children=yes.  The program execs itself twice, so that the
+   second and the third process run with the translations saved by the
+   earlier ones.  Each process must report the stack allocations of the
+   functions below as the origins of the undefined values. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int x = 0;
+
+__attribute__((noinline))
+static int get(volatile int* p, int i)
+{
+   return p[i];
+}
+
+/* The arrays are bigger than the red zone which is marked undefined at
+   each call, so that the undefined values read here get their origin
+   from the stack pointer update, whose ECU is part of the translation. */
+__attribute__((noinline))
+static int stack_a(void)
+{
+   volatile int undef_stack_int[100];
+   return get(undef_stack_int, 1);
+}
+
+__attribute__((noinline))
+static int stack_b(void)
+{
+   volatile int undef_stack_int[200];
+   return get(undef_stack_int, 5);
+}
+
+int main(int argc, char** argv)
+{
+   int gen = argc > 1 ? atoi(argv[1]) : 0;
+
+   /* Call the functions in a different order in the second process, so
+      that their stack allocations get different ECUs than in the
+      first. */
+   fprintf(stderr, "\nprocess %d\n", gen);
+   if (gen == 1) {
+      x += (stack_b() == 0x1234 ? 10 : 21);
+      x += (stack_a() == 0x5678 ? 11 : 22);
+   } else {
+      x += (stack_a() == 0x5678 ? 11 : 22);
+      x += (stack_b() == 0x1234 ? 10 : 21);
+   }
+
+   if (gen < 2) {
+      char next[2] = { (char)('1' + gen), 0 };
+      execl(argv[0], argv[0], next, (char*)NULL);
+      perror("execl");
+      return 1;
+   }
+   return 0;
+}
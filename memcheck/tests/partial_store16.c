@@ -0,0 +1,12 @@
+#include <stdlib.h>
+
+/* A 2-byte store of a defined value that is half outside its block
+   takes the slow path of STOREV16, which must report it only once. */
+int main ( void )
+{
+   volatile short* p = malloc(1);
+
+   *p = 0;
+   free((void*)p);
+   return 0;
+}
@@ -69,6 +69,8 @@ static void nl_pre_clo_init(void)
                                  nl_fini);
    VG_(needs_xml_output)        ();
    VG_(needs_core_errors)       (True); /* Yes, but... see nl_post_clo_init  */
+   VG_(needs_parallel_threads)  ();     /* Nothing to share */
+   VG_(needs_translation_cache) ();     /* Nothing instrumented */
 
    /* No needs, no core events to track */
 }
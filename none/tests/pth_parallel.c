@@ -0,0 +1,75 @@
+/* Several threads running client code at once with
+   --parallel-threads=yes.  Each thread runs a compute loop with calls
+   and indirect jumps, takes a fault which it recovers from, and maps
+   and unmaps memory, so that translations get chained and discarded
+   while other threads run. */
+
+#include <assert.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+#define NTHREADS 4
+
+static __thread sigjmp_buf env;
+
+static void handler(int sig)
+{
+   siglongjmp(env, 1);
+}
+
+static unsigned step_a(unsigned x) { return x * 1103515245u + 12345u; }
+static unsigned step_b(unsigned x) { return (x >> 3) ^ (x << 7); }
+static unsigned (*const steps[2])(unsigned) = { step_a, step_b };
+
+static void* worker(void* arg)
+{
+   unsigned x = (unsigned)(unsigned long)arg + 1;
+   int faulted = 0;
+   int i;
+
+   for (i = 0; i < 2000000; i++)
+      x = steps[x & 1](x);
+
+   if (sigsetjmp(env, 1) == 0)
+      *(volatile int*)0 = 1;
+   else
+      faulted = 1;
+
+   for (i = 0; i < 100; i++) {
+      char* p = mmap(NULL, 4096, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      assert(p != MAP_FAILED);
+      p[0] = (char)x;
+      x += p[0];
+      munmap(p, 4096);
+   }
+
+   return (void*)(unsigned long)(x ^ faulted);
+}
+
+int main(void)
+{
+   pthread_t threads[NTHREADS];
+   void* res[NTHREADS];
+   struct sigaction sa;
+   int i;
+
+   sa.sa_handler = handler;
+   sigemptyset(&sa.sa_mask);
+   sa.sa_flags = 0;
+   sigaction(SIGSEGV, &sa, NULL);
+
+   for (i = 0; i < NTHREADS; i++)
+      pthread_create(&threads[i], NULL, worker, (void*)(unsigned long)i);
+   for (i = 0; i < NTHREADS; i++)
+      pthread_join(threads[i], &res[i]);
+
+   /* Compare against a run of the same code in this thread. */
+   for (i = 0; i < NTHREADS; i++)
+      printf("thread %d: %s\n", i,
+             worker((void*)(unsigned long)i) == res[i] ? "ok" : "MISMATCH");
+   return 0;
+}
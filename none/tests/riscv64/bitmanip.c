@@ -0,0 +1,449 @@
+/* Tests for the RV64Zba, RV64Zbb and RV64Zbs standard bit-manipulation
+   extensions.
+
+   The last group runs base instruction sequences which produce the IR shapes
+   that instruction selection matches onto single bit-manipulation
+   instructions, both where a match is expected and where it must not happen.
+ */
+
+#include "testinst.h"
+
+static void test_zba(void)
+{
+   printf("RV64Zba address generation instructions\n");
+
+   /* ----------------- add.uw rd, rs1, rs2 ----------------- */
+   TESTINST_1_2(4, "add.uw a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "add.uw a0, a1, a2", 0xffffffff80000000, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_1(4, "add.uw a0, a1, zero", 0x8000000012345678, a0, a1);
+
+   /* ----------------- sh1add rd, rs1, rs2 ----------------- */
+   TESTINST_1_2(4, "sh1add a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "sh1add a0, a1, a2", 0xc000000000000001, 0x0000000000000010,
+                a0, a1, a2);
+
+   /* ----------------- sh2add rd, rs1, rs2 ----------------- */
+   TESTINST_1_2(4, "sh2add a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "sh2add a0, a1, a2", 0xc000000000000001, 0x0000000000000010,
+                a0, a1, a2);
+
+   /* ----------------- sh3add rd, rs1, rs2 ----------------- */
+   TESTINST_1_2(4, "sh3add a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "sh3add a0, a1, a2", 0xc000000000000001, 0x0000000000000010,
+                a0, a1, a2);
+
+   /* --------------- sh1add.uw rd, rs1, rs2 ---------------- */
+   TESTINST_1_2(4, "sh1add.uw a0, a1, a2", 0x0123456789abcdef,
+                0xfedcba9876543210, a0, a1, a2);
+   TESTINST_1_2(4, "sh1add.uw a0, a1, a2", 0xfffffffff0000001,
+                0x0000000000000010, a0, a1, a2);
+
+   /* --------------- sh2add.uw rd, rs1, rs2 ---------------- */
+   TESTINST_1_2(4, "sh2add.uw a0, a1, a2", 0x0123456789abcdef,
+                0xfedcba9876543210, a0, a1, a2);
+   TESTINST_1_2(4, "sh2add.uw a0, a1, a2", 0xfffffffff0000001,
+                0x0000000000000010, a0, a1, a2);
+
+   /* --------------- sh3add.uw rd, rs1, rs2 ---------------- */
+   TESTINST_1_2(4, "sh3add.uw a0, a1, a2", 0x0123456789abcdef,
+                0xfedcba9876543210, a0, a1, a2);
+   TESTINST_1_2(4, "sh3add.uw a0, a1, a2", 0xfffffffff0000001,
+                0x0000000000000010, a0, a1, a2);
+
+   /* ------------- slli.uw rd, rs1, uimm[5:0] -------------- */
+   TESTINST_1_1(4, "slli.uw a0, a1, 0", 0xfedcba98f0000001, a0, a1);
+   TESTINST_1_1(4, "slli.uw a0, a1, 1", 0xfedcba98f0000001, a0, a1);
+   TESTINST_1_1(4, "slli.uw a0, a1, 31", 0xfedcba98f0000001, a0, a1);
+   TESTINST_1_1(4, "slli.uw a0, a1, 32", 0xfedcba98f0000001, a0, a1);
+   TESTINST_1_1(4, "slli.uw a0, a1, 63", 0xfedcba98f0000001, a0, a1);
+}
+
+static void test_zbb(void)
+{
+   printf("RV64Zbb basic bit-manipulation instructions\n");
+
+   /* ------------------ andn rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "andn a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "andn a0, a1, a2", 0xff00ff00ff00ff00, 0x0ff00ff00ff00ff0,
+                a0, a1, a2);
+
+   /* ------------------ orn rd, rs1, rs2 ------------------- */
+   TESTINST_1_2(4, "orn a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210, a0,
+                a1, a2);
+   TESTINST_1_2(4, "orn a0, a1, a2", 0xff00ff00ff00ff00, 0x0ff00ff00ff00ff0, a0,
+                a1, a2);
+
+   /* ------------------ xnor rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "xnor a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "xnor a0, a1, a2", 0xff00ff00ff00ff00, 0x0ff00ff00ff00ff0,
+                a0, a1, a2);
+
+   /* --------------------- clz rd, rs1 --------------------- */
+   TESTINST_1_1(4, "clz a0, a1", 0x0000000000000000, a0, a1);
+   TESTINST_1_1(4, "clz a0, a1", 0x0000000000000001, a0, a1);
+   TESTINST_1_1(4, "clz a0, a1", 0x8000000000000000, a0, a1);
+   TESTINST_1_1(4, "clz a0, a1", 0x0000000100000000, a0, a1);
+   TESTINST_1_1(4, "clz a0, a1", 0x00000000ffffffff, a0, a1);
+
+   /* -------------------- clzw rd, rs1 --------------------- */
+   TESTINST_1_1(4, "clzw a0, a1", 0x0000000000000000, a0, a1);
+   TESTINST_1_1(4, "clzw a0, a1", 0x0000000000000001, a0, a1);
+   TESTINST_1_1(4, "clzw a0, a1", 0x0000000080000000, a0, a1);
+   TESTINST_1_1(4, "clzw a0, a1", 0xffffffff00000000, a0, a1);
+   TESTINST_1_1(4, "clzw a0, a1", 0xffffffff00010000, a0, a1);
+
+   /* --------------------- ctz rd, rs1 --------------------- */
+   TESTINST_1_1(4, "ctz a0, a1", 0x0000000000000000, a0, a1);
+   TESTINST_1_1(4, "ctz a0, a1", 0x0000000000000001, a0, a1);
+   TESTINST_1_1(4, "ctz a0, a1", 0x8000000000000000, a0, a1);
+   TESTINST_1_1(4, "ctz a0, a1", 0x0000000100000000, a0, a1);
+   TESTINST_1_1(4, "ctz a0, a1", 0xfedcba9876543210, a0, a1);
+
+   /* -------------------- ctzw rd, rs1 --------------------- */
+   TESTINST_1_1(4, "ctzw a0, a1", 0x0000000000000000, a0, a1);
+   TESTINST_1_1(4, "ctzw a0, a1", 0x0000000000000001, a0, a1);
+   TESTINST_1_1(4, "ctzw a0, a1", 0x0000000080000000, a0, a1);
+   TESTINST_1_1(4, "ctzw a0, a1", 0xffffffff00000000, a0, a1);
+   TESTINST_1_1(4, "ctzw a0, a1", 0x0000000100000100, a0, a1);
+
+   /* -------------------- cpop rd, rs1 --------------------- */
+   TESTINST_1_1(4, "cpop a0, a1", 0x0000000000000000, a0, a1);
+   TESTINST_1_1(4, "cpop a0, a1", 0x0000000000000001, a0, a1);
+   TESTINST_1_1(4, "cpop a0, a1", 0xffffffffffffffff, a0, a1);
+   TESTINST_1_1(4, "cpop a0, a1", 0x0123456789abcdef, a0, a1);
+
+   /* -------------------- cpopw rd, rs1 -------------------- */
+   TESTINST_1_1(4, "cpopw a0, a1", 0x0000000000000000, a0, a1);
+   TESTINST_1_1(4, "cpopw a0, a1", 0x0000000000000001, a0, a1);
+   TESTINST_1_1(4, "cpopw a0, a1", 0xffffffffffffffff, a0, a1);
+   TESTINST_1_1(4, "cpopw a0, a1", 0xffffffff00000000, a0, a1);
+   TESTINST_1_1(4, "cpopw a0, a1", 0x0123456789abcdef, a0, a1);
+
+   /* ------------------ max rd, rs1, rs2 ------------------- */
+   TESTINST_1_2(4, "max a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210, a0,
+                a1, a2);
+   TESTINST_1_2(4, "max a0, a1, a2", 0x0000000000000001, 0xffffffffffffffff, a0,
+                a1, a2);
+   TESTINST_1_2(4, "max a0, a1, a2", 0x8000000000000000, 0x7fffffffffffffff, a0,
+                a1, a2);
+
+   /* ------------------ maxu rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "maxu a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "maxu a0, a1, a2", 0x0000000000000001, 0xffffffffffffffff,
+                a0, a1, a2);
+   TESTINST_1_2(4, "maxu a0, a1, a2", 0x8000000000000000, 0x7fffffffffffffff,
+                a0, a1, a2);
+
+   /* ------------------ min rd, rs1, rs2 ------------------- */
+   TESTINST_1_2(4, "min a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210, a0,
+                a1, a2);
+   TESTINST_1_2(4, "min a0, a1, a2", 0x0000000000000001, 0xffffffffffffffff, a0,
+                a1, a2);
+   TESTINST_1_2(4, "min a0, a1, a2", 0x8000000000000000, 0x7fffffffffffffff, a0,
+                a1, a2);
+
+   /* ------------------ minu rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "minu a0, a1, a2", 0x0123456789abcdef, 0xfedcba9876543210,
+                a0, a1, a2);
+   TESTINST_1_2(4, "minu a0, a1, a2", 0x0000000000000001, 0xffffffffffffffff,
+                a0, a1, a2);
+   TESTINST_1_2(4, "minu a0, a1, a2", 0x8000000000000000, 0x7fffffffffffffff,
+                a0, a1, a2);
+
+   /* ------------------- sext.b rd, rs1 -------------------- */
+   TESTINST_1_1(4, "sext.b a0, a1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "sext.b a0, a1", 0xfedcba9876543210, a0, a1);
+   TESTINST_1_1(4, "sext.b a0, a1", 0x0000000000007f7f, a0, a1);
+   TESTINST_1_1(4, "sext.b a0, a1", 0x0000000000008080, a0, a1);
+
+   /* ------------------- sext.h rd, rs1 -------------------- */
+   TESTINST_1_1(4, "sext.h a0, a1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "sext.h a0, a1", 0xfedcba9876543210, a0, a1);
+   TESTINST_1_1(4, "sext.h a0, a1", 0x0000000000007f7f, a0, a1);
+   TESTINST_1_1(4, "sext.h a0, a1", 0x0000000000008080, a0, a1);
+
+   /* ------------------- zext.h rd, rs1 -------------------- */
+   TESTINST_1_1(4, "zext.h a0, a1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "zext.h a0, a1", 0xfedcba9876543210, a0, a1);
+   TESTINST_1_1(4, "zext.h a0, a1", 0x0000000000007f7f, a0, a1);
+   TESTINST_1_1(4, "zext.h a0, a1", 0x0000000000008080, a0, a1);
+
+   /* ------------------ rol rd, rs1, rs2 ------------------- */
+   TESTINST_1_2(4, "rol a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000, a0,
+                a1, a2);
+   TESTINST_1_2(4, "rol a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001, a0,
+                a1, a2);
+   TESTINST_1_2(4, "rol a0, a1, a2", 0x0123456789abcdef, 0x0000000000000004, a0,
+                a1, a2);
+   TESTINST_1_2(4, "rol a0, a1, a2", 0x0123456789abcdef, 0x000000000000003f, a0,
+                a1, a2);
+   TESTINST_1_2(4, "rol a0, a1, a2", 0x0123456789abcdef, 0x0000000000000040, a0,
+                a1, a2);
+   TESTINST_1_2(4, "rol a0, a1, a2", 0x0123456789abcdef, 0x0000000000000041, a0,
+                a1, a2);
+
+   /* ------------------ ror rd, rs1, rs2 ------------------- */
+   TESTINST_1_2(4, "ror a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000, a0,
+                a1, a2);
+   TESTINST_1_2(4, "ror a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001, a0,
+                a1, a2);
+   TESTINST_1_2(4, "ror a0, a1, a2", 0x0123456789abcdef, 0x0000000000000004, a0,
+                a1, a2);
+   TESTINST_1_2(4, "ror a0, a1, a2", 0x0123456789abcdef, 0x000000000000003f, a0,
+                a1, a2);
+   TESTINST_1_2(4, "ror a0, a1, a2", 0x0123456789abcdef, 0x0000000000000040, a0,
+                a1, a2);
+   TESTINST_1_2(4, "ror a0, a1, a2", 0x0123456789abcdef, 0x0000000000000041, a0,
+                a1, a2);
+
+   /* --------------- rori rd, rs1, uimm[5:0] --------------- */
+   TESTINST_1_1(4, "rori a0, a1, 0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "rori a0, a1, 1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "rori a0, a1, 32", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "rori a0, a1, 63", 0x0123456789abcdef, a0, a1);
+
+   /* ------------------ rolw rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "rolw a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rolw a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rolw a0, a1, a2", 0x0123456789abcdef, 0x000000000000001f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rolw a0, a1, a2", 0x0123456789abcdef, 0x0000000000000020,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rolw a0, a1, a2", 0xdeadbeef00000001, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rolw a0, a1, a2", 0x0000000080000000, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rolw a0, a1, a2", 0xffffffff40000000, 0x0000000000000021,
+                a0, a1, a2);
+
+   /* ------------------ rorw rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "rorw a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rorw a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rorw a0, a1, a2", 0x0123456789abcdef, 0x000000000000001f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rorw a0, a1, a2", 0x0123456789abcdef, 0x0000000000000020,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rorw a0, a1, a2", 0xdeadbeef00000001, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rorw a0, a1, a2", 0x0000000080000000, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "rorw a0, a1, a2", 0xffffffff40000000, 0x0000000000000021,
+                a0, a1, a2);
+
+   /* -------------- roriw rd, rs1, uimm[4:0] --------------- */
+   TESTINST_1_1(4, "roriw a0, a1, 0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "roriw a0, a1, 1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "roriw a0, a1, 31", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "roriw a0, a1, 1", 0xdeadbeef00000001, a0, a1);
+   TESTINST_1_1(4, "roriw a0, a1, 1", 0x0000000100000002, a0, a1);
+   TESTINST_1_1(4, "roriw a0, a1, 4", 0x00000000000000ff, a0, a1);
+
+   /* -------------------- orc.b rd, rs1 -------------------- */
+   TESTINST_1_1(4, "orc.b a0, a1", 0x0000000000000000, a0, a1);
+   TESTINST_1_1(4, "orc.b a0, a1", 0x0100000000008000, a0, a1);
+   TESTINST_1_1(4, "orc.b a0, a1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "orc.b a0, a1", 0x00ff00ff00000001, a0, a1);
+
+   /* -------------------- rev8 rd, rs1 --------------------- */
+   TESTINST_1_1(4, "rev8 a0, a1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "rev8 a0, a1", 0xff00000000000001, a0, a1);
+}
+
+static void test_zbs(void)
+{
+   printf("RV64Zbs single-bit instructions\n");
+
+   /* ------------------ bclr rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "bclr a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bclr a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bclr a0, a1, a2", 0x0123456789abcdef, 0x000000000000001f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bclr a0, a1, a2", 0x0123456789abcdef, 0x0000000000000020,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bclr a0, a1, a2", 0x0123456789abcdef, 0x000000000000003f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bclr a0, a1, a2", 0x0123456789abcdef, 0x0000000000000040,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bclr a0, a1, a2", 0x0123456789abcdef, 0x0000000000000041,
+                a0, a1, a2);
+
+   /* -------------- bclri rd, rs1, uimm[5:0] --------------- */
+   TESTINST_1_1(4, "bclri a0, a1, 0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bclri a0, a1, 1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bclri a0, a1, 31", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bclri a0, a1, 32", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bclri a0, a1, 63", 0x0123456789abcdef, a0, a1);
+
+   /* ------------------ bext rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "bext a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bext a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bext a0, a1, a2", 0x0123456789abcdef, 0x000000000000001f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bext a0, a1, a2", 0x0123456789abcdef, 0x0000000000000020,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bext a0, a1, a2", 0x0123456789abcdef, 0x000000000000003f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bext a0, a1, a2", 0x0123456789abcdef, 0x0000000000000040,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bext a0, a1, a2", 0x0123456789abcdef, 0x0000000000000041,
+                a0, a1, a2);
+
+   /* -------------- bexti rd, rs1, uimm[5:0] --------------- */
+   TESTINST_1_1(4, "bexti a0, a1, 0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bexti a0, a1, 1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bexti a0, a1, 31", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bexti a0, a1, 32", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bexti a0, a1, 63", 0x0123456789abcdef, a0, a1);
+
+   /* ------------------ binv rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "binv a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000,
+                a0, a1, a2);
+   TESTINST_1_2(4, "binv a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "binv a0, a1, a2", 0x0123456789abcdef, 0x000000000000001f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "binv a0, a1, a2", 0x0123456789abcdef, 0x0000000000000020,
+                a0, a1, a2);
+   TESTINST_1_2(4, "binv a0, a1, a2", 0x0123456789abcdef, 0x000000000000003f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "binv a0, a1, a2", 0x0123456789abcdef, 0x0000000000000040,
+                a0, a1, a2);
+   TESTINST_1_2(4, "binv a0, a1, a2", 0x0123456789abcdef, 0x0000000000000041,
+                a0, a1, a2);
+
+   /* -------------- binvi rd, rs1, uimm[5:0] --------------- */
+   TESTINST_1_1(4, "binvi a0, a1, 0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "binvi a0, a1, 1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "binvi a0, a1, 31", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "binvi a0, a1, 32", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "binvi a0, a1, 63", 0x0123456789abcdef, a0, a1);
+
+   /* ------------------ bset rd, rs1, rs2 ------------------ */
+   TESTINST_1_2(4, "bset a0, a1, a2", 0x0123456789abcdef, 0x0000000000000000,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bset a0, a1, a2", 0x0123456789abcdef, 0x0000000000000001,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bset a0, a1, a2", 0x0123456789abcdef, 0x000000000000001f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bset a0, a1, a2", 0x0123456789abcdef, 0x0000000000000020,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bset a0, a1, a2", 0x0123456789abcdef, 0x000000000000003f,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bset a0, a1, a2", 0x0123456789abcdef, 0x0000000000000040,
+                a0, a1, a2);
+   TESTINST_1_2(4, "bset a0, a1, a2", 0x0123456789abcdef, 0x0000000000000041,
+                a0, a1, a2);
+
+   /* -------------- bseti rd, rs1, uimm[5:0] --------------- */
+   TESTINST_1_1(4, "bseti a0, a1, 0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bseti a0, a1, 1", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bseti a0, a1, 31", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bseti a0, a1, 32", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "bseti a0, a1, 63", 0x0123456789abcdef, a0, a1);
+}
+
+static void test_isel_patterns(void)
+{
+   printf("RV64I sequences matching bit-manipulation instruction selection\n");
+
+   /* -------------------- shift and add -------------------- */
+   TESTINST_1_2(4, "slli a0, a1, 1; add a0, a0, a2", 0x0123456789abcdef,
+                0xfedcba9876543210, a0, a1, a2);
+   TESTINST_1_2(4, "slli a0, a1, 2; add a0, a2, a0", 0x0123456789abcdef,
+                0xfedcba9876543210, a0, a1, a2);
+   TESTINST_1_2(4, "slli a0, a1, 3; add a0, a0, a2", 0x0123456789abcdef,
+                0xfedcba9876543210, a0, a1, a2);
+   TESTINST_1_2(4, "slli a0, a1, 4; add a0, a0, a2", 0x0123456789abcdef,
+                0xfedcba9876543210, a0, a1, a2);
+
+   /* ------------------ single-bit masks ------------------- */
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; or a0, a1, a0",
+                0x0123456789abcdef, 0x0000000000000000, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; xor a0, a0, a1",
+                0x0123456789abcdef, 0x0000000000000000, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; not a0, a0; and a0, a1, a0",
+                0x0123456789abcdef, 0x0000000000000000, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; andi a0, a0, 1", 0x0123456789abcdef,
+                0x0000000000000000, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; or a0, a1, a0",
+                0x0123456789abcdef, 0x0000000000000005, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; xor a0, a0, a1",
+                0x0123456789abcdef, 0x0000000000000005, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; not a0, a0; and a0, a1, a0",
+                0x0123456789abcdef, 0x0000000000000005, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; andi a0, a0, 1", 0x0123456789abcdef,
+                0x0000000000000005, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; or a0, a1, a0",
+                0x0123456789abcdef, 0x000000000000003f, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; xor a0, a0, a1",
+                0x0123456789abcdef, 0x000000000000003f, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; not a0, a0; and a0, a1, a0",
+                0x0123456789abcdef, 0x000000000000003f, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; andi a0, a0, 1", 0x0123456789abcdef,
+                0x000000000000003f, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; or a0, a1, a0",
+                0x0123456789abcdef, 0x0000000000000040, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; xor a0, a0, a1",
+                0x0123456789abcdef, 0x0000000000000040, a0, a1, a2);
+   TESTINST_1_2(4, "li a0, 1; sll a0, a0, a2; not a0, a0; and a0, a1, a0",
+                0x0123456789abcdef, 0x0000000000000040, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; andi a0, a0, 1", 0x0123456789abcdef,
+                0x0000000000000040, a0, a1, a2);
+   TESTINST_1_1(4, "li a0, 0x40000000; or a0, a1, a0", 0x0123456789abcdef, a0,
+                a1);
+   TESTINST_1_1(4, "li a0, 0x100; xor a0, a1, a0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "li a0, -0x81; and a0, a1, a0", 0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "li a0, 0x8000000000000000; or a0, a0, a1",
+                0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "srli a0, a1, 17; andi a0, a0, 1", 0x0123456789abcdef, a0,
+                a1);
+
+   /* ---------------------- rotations ---------------------- */
+   TESTINST_1_1(4, "slli a0, a1, 13; srli a1, a1, 51; or a0, a0, a1",
+                0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "srli a0, a1, 13; slli a1, a1, 51; or a0, a1, a0",
+                0x0123456789abcdef, a0, a1);
+   TESTINST_1_1(4, "slli a0, a1, 13; srli a1, a1, 50; or a0, a0, a1",
+                0x0123456789abcdef, a0, a1);
+   TESTINST_1_2(4, "sll a0, a1, a2; neg a2, a2; srl a2, a1, a2; or a0, a0, a2",
+                0x0123456789abcdef, 0x0000000000000000, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; neg a2, a2; sll a2, a1, a2; or a0, a2, a0",
+                0x0123456789abcdef, 0x0000000000000000, a0, a1, a2);
+   TESTINST_1_2(4, "sll a0, a1, a2; neg a2, a2; srl a2, a1, a2; or a0, a0, a2",
+                0x0123456789abcdef, 0x0000000000000007, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; neg a2, a2; sll a2, a1, a2; or a0, a2, a0",
+                0x0123456789abcdef, 0x0000000000000007, a0, a1, a2);
+   TESTINST_1_2(4, "sll a0, a1, a2; neg a2, a2; srl a2, a1, a2; or a0, a0, a2",
+                0x0123456789abcdef, 0x0000000000000040, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; neg a2, a2; sll a2, a1, a2; or a0, a2, a0",
+                0x0123456789abcdef, 0x0000000000000040, a0, a1, a2);
+   TESTINST_1_2(4, "sll a0, a1, a2; neg a2, a2; srl a2, a1, a2; or a0, a0, a2",
+                0x0123456789abcdef, 0x0000000000000047, a0, a1, a2);
+   TESTINST_1_2(4, "srl a0, a1, a2; neg a2, a2; sll a2, a1, a2; or a0, a2, a0",
+                0x0123456789abcdef, 0x0000000000000047, a0, a1, a2);
+}
+
+int main(void)
+{
+   test_zba();
+   test_zbb();
+   test_zbs();
+   test_isel_patterns();
+   return 0;
+}
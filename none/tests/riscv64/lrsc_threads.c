@@ -0,0 +1,86 @@
+/* Tests for LR/SC sequences executed by several threads at once. */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define NTHREADS 4
+#define NITERS   20000
+
+static unsigned int  counter32;
+static unsigned long counter64;
+
+/* Increment *p with an lr.w/sc.w loop. */
+static void inc32(unsigned int* p)
+{
+   unsigned long tmp, res;
+   __asm__ __volatile__("1:\n\t"
+                        "lr.w %[tmp], (%[p])\n\t"
+                        "addiw %[tmp], %[tmp], 1\n\t"
+                        "sc.w %[res], %[tmp], (%[p])\n\t"
+                        "bnez %[res], 1b"
+                        : [tmp] "=&r"(tmp), [res] "=&r"(res)
+                        : [p] "r"(p)
+                        : "memory");
+}
+
+/* Likewise with lr.d/sc.d. */
+static void inc64(unsigned long* p)
+{
+   unsigned long tmp, res;
+   __asm__ __volatile__("1:\n\t"
+                        "lr.d %[tmp], (%[p])\n\t"
+                        "addi %[tmp], %[tmp], 1\n\t"
+                        "sc.d %[res], %[tmp], (%[p])\n\t"
+                        "bnez %[res], 1b"
+                        : [tmp] "=&r"(tmp), [res] "=&r"(res)
+                        : [p] "r"(p)
+                        : "memory");
+}
+
+static void* worker(void* arg)
+{
+   for (int i = 0; i < NITERS; i++) {
+      inc32(&counter32);
+      inc64(&counter64);
+   }
+   return NULL;
+}
+
+/* Perform an LR, a system call and an SC to the same location. Another
+   thread may have changed the location and back meanwhile, and Linux clears
+   the reservation when it returns from the system call, so the SC must fail.
+   Returns the SC result. */
+static unsigned long lr_syscall_sc(unsigned long* p)
+{
+   register unsigned long a0 asm("a0");
+   register unsigned long a7 asm("a7") = SYS_sched_yield;
+   unsigned long          tmp, res;
+   __asm__ __volatile__("lr.d %[tmp], (%[p])\n\t"
+                        "ecall\n\t"
+                        "sc.d %[res], %[tmp], (%[p])"
+                        : [tmp] "=&r"(tmp), [res] "=&r"(res), "=r"(a0)
+                        : [p] "r"(p), "r"(a7)
+                        : "memory");
+   return res;
+}
+
+int main(void)
+{
+   pthread_t threads[NTHREADS];
+
+   for (int i = 0; i < NTHREADS; i++)
+      pthread_create(&threads[i], NULL, worker, NULL);
+   for (int i = 0; i < NTHREADS; i++)
+      pthread_join(threads[i], NULL);
+
+   printf("counter32 = %u (expected %u)\n", counter32, NTHREADS * NITERS);
+   printf("counter64 = %lu (expected %u)\n", counter64, NTHREADS * NITERS);
+
+   unsigned long value = 0x1234;
+   unsigned long res   = lr_syscall_sc(&value);
+   printf("sc.d after a system call: %s, value = 0x%lx\n",
+          res != 0 ? "failed" : "succeeded", value);
+   return 0;
+}
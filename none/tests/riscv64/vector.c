@@ -0,0 +1,544 @@
+/* Tests for the RVV 1.0 standard vector extension.
+
+   The tests only depend on VLEN being at least 128 bits. Each one requests an
+   application vector length no larger than VLMAX for VLEN=128, which makes vl
+   equal to it on any implementation, uses the undisturbed tail and mask
+   policies and only looks at the body elements of the result. */
+
+#include <stdio.h>
+#include <string.h>
+
+/* Disable clang-format for the test macros because it would mess up the inline
+   assembly. */
+/* clang-format off */
+
+#define V_CLOBBERS                                                             \
+   "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7",                             \
+   "v8", "v9", "v10", "v11", "v12", "v13", "v14", "v15",                       \
+   "v16", "v17", "v18", "v19", "v20", "v21", "v22", "v23",                     \
+   "v24", "v25", "v26", "v27", "v28", "v29", "v30", "v31"
+
+/* Input and output areas. They are aligned so that no access crosses a page
+   boundary, which keeps fault-only-first loads from trimming vl. */
+static unsigned char src1[256] __attribute__((aligned(256)));
+static unsigned char src2[256] __attribute__((aligned(256)));
+static unsigned char dst[256] __attribute__((aligned(256)));
+static unsigned char mask[32] __attribute__((aligned(256)));
+static unsigned char res[256] __attribute__((aligned(256)));
+static unsigned char resm[32] __attribute__((aligned(256)));
+/* A whole-register store writes VLENB bytes, up to 8192 of them. */
+static unsigned char out[8192] __attribute__((aligned(256)));
+
+/* Byte offsets for the indexed accesses, all distinct and aligned. */
+static const unsigned char  idx8[16]  = {12, 0, 40, 4, 28, 8, 20, 16,
+                                         36, 24, 44, 32, 56, 48, 60, 52};
+static const unsigned short idx16[8]  = {14, 2, 0, 10, 6, 12, 4, 8};
+static const unsigned int   idx32[4]  = {16, 0, 24, 8};
+static const unsigned long  idx64[4]  = {8, 12, 0, 4};
+
+static const float  fs = 1.75f;
+static const double fd = -2.5;
+
+static unsigned char rand_uchar(void)
+{
+   static unsigned int seed = 80021;
+
+   seed = 1103515245 * seed + 12345;
+   return (seed >> 17) & 0xFF;
+}
+
+static void fill_int(void)
+{
+   for (unsigned i = 0; i < sizeof(src1); i++)
+      src1[i] = rand_uchar();
+   for (unsigned i = 0; i < sizeof(src2); i++)
+      src2[i] = rand_uchar();
+   for (unsigned i = 0; i < sizeof(dst); i++)
+      dst[i] = rand_uchar();
+   for (unsigned i = 0; i < sizeof(mask); i++)
+      mask[i] = rand_uchar();
+}
+
+static void fill_float32(void)
+{
+   for (unsigned i = 0; i < sizeof(src1) / 4; i++) {
+      float a = 1.5f * i - 4.25f, b = 2.5f - 0.75f * i, c = 0.25f * i + 1;
+      memcpy(&src1[4 * i], &a, 4);
+      memcpy(&src2[4 * i], &b, 4);
+      memcpy(&dst[4 * i], &c, 4);
+   }
+}
+
+static void fill_float64(void)
+{
+   for (unsigned i = 0; i < sizeof(src1) / 8; i++) {
+      double a = 1.5 * i - 4.25, b = 2.5 - 0.75 * i, c = 0.25 * i + 1;
+      memcpy(&src1[8 * i], &a, 8);
+      memcpy(&src2[8 * i], &b, 8);
+      memcpy(&dst[8 * i], &c, 8);
+   }
+}
+
+static void show_elems(unsigned long vl, unsigned eew)
+{
+   unsigned per_line = eew <= 2 ? 8 : 4;
+   for (unsigned long i = 0; i < vl; i++) {
+      unsigned long e = 0;
+      memcpy(&e, &res[i * eew], eew);
+      if (i % per_line == 0)
+         printf(i == 0 ? "  output: v24=" : "\n              ");
+      else
+         printf(" ");
+      printf("%0*lx", 2 * eew, e);
+   }
+   printf("\n");
+}
+
+static void show_mask(unsigned long vl)
+{
+   printf("  output: v24.mask=");
+   for (unsigned long i = 0; i < vl; i++)
+      printf("%u", (resm[i / 8] >> (i % 8)) & 1);
+   printf("\n");
+}
+
+static void show_memory(unsigned n)
+{
+   for (unsigned i = 0; i < n; i++) {
+      if (i % 16 == 0)
+         printf(i == 0 ? "  memory:" : "\n         ");
+      printf(" %02x", out[i]);
+   }
+   printf("\n");
+}
+
+/* Set up v8 from vs1src, v16 from src2, v24 from dst and the mask v0, run the
+   instruction with a0=xval, a1=&src2, a2=12, a3=&out, fa0=fs and fa1=fd, and
+   save v24 as elements and as a mask. */
+#define VTEST(vtype, avl, eew, ieew, vs1src, instruction, xval)                \
+   unsigned long vl, x;                                                        \
+   memcpy(out, dst, sizeof(dst));                                              \
+   memset(res, 0, sizeof(res));                                                \
+   memset(resm, 0, sizeof(resm));                                              \
+   __asm__ __volatile__(                                                       \
+      "mv a0, %[xv];"                                                          \
+      "mv a1, %[s2];"                                                          \
+      "li a2, 12;"                                                             \
+      "mv a3, %[o];"                                                           \
+      "flw fa0, 0(%[fs]);"                                                     \
+      "fld fa1, 0(%[fd]);"                                                     \
+      "vsetvli zero, %[n], " vtype ";"                                         \
+      "vle" #ieew ".v v8, (%[s1]);"                                            \
+      "vle" #eew ".v v16, (%[s2]);"                                            \
+      "vle" #eew ".v v24, (%[d]);"                                             \
+      "vlm.v v0, (%[m]);"                                                      \
+      instruction ";"                                                          \
+      "csrr %[vl], vl;"                                                        \
+      "mv %[x], a0;"                                                           \
+      "vse" #eew ".v v24, (%[r]);"                                             \
+      "vsm.v v24, (%[rm]);"                                                    \
+      : [vl] "=&r"(vl), [x] "=&r"(x)                                           \
+      : [xv] "r"((unsigned long)(xval)), [n] "r"((unsigned long)(avl)),        \
+        [s1] "r"(vs1src), [s2] "r"(src2), [d] "r"(dst), [m] "r"(mask),         \
+        [o] "r"(out), [r] "r"(res), [rm] "r"(resm), [fs] "r"(&fs),             \
+        [fd] "r"(&fd)                                                          \
+      : "a0", "a1", "a2", "a3", "fa0", "fa1", "fa2", "memory",                 \
+        V_CLOBBERS);                                                           \
+   printf("%s ::\n", instruction);                                             \
+   printf("  vtype: %s, avl=%lu, vl=%lu\n", vtype, (unsigned long)(avl), vl);
+
+/* Result in the elements of v24. */
+#define TESTV_V(vtype, avl, eew, instruction, xval)                            \
+   {                                                                           \
+      VTEST(vtype, avl, eew, eew, src1, instruction, xval)                     \
+      show_elems(vl, eew / 8);                                                 \
+   }
+
+/* Result in the mask v24. */
+#define TESTV_M(vtype, avl, eew, instruction, xval)                            \
+   {                                                                           \
+      VTEST(vtype, avl, eew, eew, src1, instruction, xval)                     \
+      show_mask(vl);                                                           \
+   }
+
+/* Result in the scalar a0. */
+#define TESTV_X(vtype, avl, eew, instruction, xval)                            \
+   {                                                                           \
+      VTEST(vtype, avl, eew, eew, src1, instruction, xval)                     \
+      printf("  output: a0=0x%016lx\n", x);                                    \
+   }
+
+/* Load from src2 into v24, with v8 holding indices from vs1src. */
+#define TESTV_LD(vtype, avl, eew, ieew, vs1src, instruction)                   \
+   {                                                                           \
+      VTEST(vtype, avl, eew, ieew, vs1src, instruction, 0)                     \
+      show_elems(vl, eew / 8);                                                 \
+   }
+
+/* Store v16 to out, with v8 holding indices from vs1src. */
+#define TESTV_ST(vtype, avl, eew, ieew, vs1src, instruction, n)                \
+   {                                                                           \
+      VTEST(vtype, avl, eew, ieew, vs1src, instruction, 0)                     \
+      show_memory(n);                                                          \
+   }
+
+/* Configuration setting with a1=avl and a2=vtype_val. */
+#define TESTV_SET(instruction, avl, vtype_val)                                 \
+   {                                                                           \
+      unsigned long vl, vt;                                                    \
+      __asm__ __volatile__(                                                    \
+         "mv a1, %[n];"                                                        \
+         "mv a2, %[vt_in];"                                                    \
+         instruction ";"                                                       \
+         "mv %[vl], a0;"                                                       \
+         "csrr %[vt], vtype;"                                                  \
+         : [vl] "=&r"(vl), [vt] "=&r"(vt)                                      \
+         : [n] "r"((unsigned long)(avl)),                                      \
+           [vt_in] "r"((unsigned long)(vtype_val))                             \
+         : "a0", "a1", "a2");                                                  \
+      printf("%s ::\n", instruction);                                          \
+      printf("  inputs: a1=0x%016lx, a2=0x%016lx\n", (unsigned long)(avl),     \
+             (unsigned long)(vtype_val));                                      \
+      printf("  output: a0=0x%016lx, vtype=0x%016lx\n", vl, vt);               \
+   }
+
+/* Configuration setting with avl=VLMAX, checked against vlenb. */
+#define TESTV_SETMAX(instruction, sew, lmul_num, lmul_den)                     \
+   {                                                                           \
+      unsigned long vl, vlenb;                                                 \
+      __asm__ __volatile__(                                                    \
+         instruction ";"                                                       \
+         "mv %[vl], a0;"                                                       \
+         "csrr %[vlenb], vlenb;"                                               \
+         : [vl] "=&r"(vl), [vlenb] "=&r"(vlenb)                                \
+         :                                                                     \
+         : "a0");                                                              \
+      printf("%s ::\n", instruction);                                          \
+      printf("  output: a0 %s VLMAX\n",                                        \
+             vl * (sew) * (lmul_den) == vlenb * 8 * (lmul_num) ? "==" : "!="); \
+   }
+
+/* clang-format on */
+
+static void test_vector_config(void)
+{
+   printf("RVV configuration-setting instructions\n");
+
+   /* --------------- vsetvli rd, rs1, vtypei --------------- */
+   TESTV_SET("vsetvli a0, a1, e32, m1, tu, mu", 3, 0);
+   TESTV_SET("vsetvli a0, a1, e32, m1, tu, mu", 4, 0);
+   TESTV_SET("vsetvli a0, a1, e8, mf2, ta, ma", 7, 0);
+   TESTV_SET("vsetvli a0, a1, e64, m8, tu, ma", 16, 0);
+   TESTV_SET("vsetvli a0, a1, e16, m4, ta, mu", 0, 0);
+   TESTV_SETMAX("vsetvli a0, zero, e32, m2, tu, mu", 32, 2, 1);
+   TESTV_SETMAX("vsetvli a0, zero, e8, mf4, tu, mu", 8, 1, 4);
+   TESTV_SETMAX("vsetvli a0, zero, e64, m1, ta, ma", 64, 1, 1);
+
+   /* --------------- vsetivli rd, uimm, vtypei -------------- */
+   TESTV_SET("vsetivli a0, 13, e16, m2, tu, ma", 0, 0);
+   TESTV_SET("vsetivli a0, 1, e64, m1, ta, mu", 0, 0);
+
+   /* ----------------- vsetvl rd, rs1, rs2 ----------------- */
+   TESTV_SET("vsetvl a0, a1, a2", 5, 0x1a);
+   TESTV_SET("vsetvl a0, a1, a2", 2, 0xd7);
+   TESTV_SET("vsetvl a0, a1, a2", 5, 0x20);
+}
+
+static void test_vector_loadstore(void)
+{
+   printf("RVV loads and stores\n");
+   fill_int();
+
+   /* ---------------- vle<eew>.v vd, (rs1) ----------------- */
+   TESTV_LD("e8, m1, tu, mu", 16, 8, 8, src1, "vle8.v v24, (a1)");
+   TESTV_LD("e16, m1, tu, mu", 8, 16, 16, src1, "vle16.v v24, (a1)");
+   TESTV_LD("e32, m1, tu, mu", 4, 32, 32, src1, "vle32.v v24, (a1)");
+   TESTV_LD("e64, m2, tu, mu", 3, 64, 64, src1, "vle64.v v24, (a1)");
+   TESTV_LD("e32, m1, tu, mu", 4, 32, 32, src1, "vle32.v v24, (a1), v0.t");
+   TESTV_LD("e8, m4, tu, mu", 45, 8, 8, src1, "vle8.v v24, (a1), v0.t");
+
+   /* --------------- vle<eew>ff.v vd, (rs1) ---------------- */
+   TESTV_LD("e32, m1, tu, mu", 4, 32, 32, src1, "vle32ff.v v24, (a1)");
+   TESTV_LD("e16, m2, tu, mu", 11, 16, 16, src1, "vle16ff.v v24, (a1), v0.t");
+
+   /* ------------- vlse<eew>.v vd, (rs1), rs2 -------------- */
+   TESTV_LD("e32, m1, tu, mu", 4, 32, 32, src1, "vlse32.v v24, (a1), a2");
+   TESTV_LD("e16, m1, tu, mu", 7, 16, 16, src1, "vlse16.v v24, (a1), a2, v0.t");
+   TESTV_LD("e64, m1, tu, mu", 2, 64, 64, src1, "vlse64.v v24, (a1), zero");
+
+   /* ----------- vl{u,o}xei<eew>.v vd, (rs1), vs2 ---------- */
+   TESTV_LD("e32, m1, tu, mu", 4, 32, 8, idx8, "vluxei8.v v24, (a1), v8");
+   TESTV_LD("e16, m1, tu, mu", 8, 16, 16, idx16, "vloxei16.v v24, (a1), v8");
+   TESTV_LD("e64, m2, tu, mu", 3, 64, 32, idx32,
+            "vluxei32.v v24, (a1), v8, v0.t");
+   TESTV_LD("e8, m1, tu, mu", 4, 8, 64, idx64, "vloxei64.v v24, (a1), v8");
+
+   /* ------------- vl<nr>re<eew>.v vd, (rs1) --------------- */
+   TESTV_LD("e32, m1, tu, mu", 4, 32, 32, src1, "vl1re32.v v24, (a1)");
+   TESTV_LD("e64, m1, tu, mu", 2, 64, 64, src1, "vl2re64.v v24, (a1)");
+
+   /* ------------------- vlm.v vd, (rs1) ------------------- */
+   TESTV_M("e8, m1, tu, mu", 13, 8, "vlm.v v24, (a1)", 0);
+
+   /* --------------- vse<eew>.v vs3, (rs1) ----------------- */
+   TESTV_ST("e8, m1, tu, mu", 13, 8, 8, src1, "vse8.v v16, (a3)", 32);
+   TESTV_ST("e32, m1, tu, mu", 4, 32, 32, src1, "vse32.v v16, (a3)", 32);
+   TESTV_ST("e64, m2, tu, mu", 3, 64, 64, src1, "vse64.v v16, (a3), v0.t", 32);
+
+   /* ------------ vsse<eew>.v vs3, (rs1), rs2 -------------- */
+   TESTV_ST("e32, m1, tu, mu", 4, 32, 32, src1, "vsse32.v v16, (a3), a2", 64);
+   TESTV_ST("e16, m1, tu, mu", 5, 16, 16, src1,
+            "vsse16.v v16, (a3), a2, v0.t", 64);
+
+   /* ---------- vs{u,o}xei<eew>.v vs3, (rs1), vs2 ---------- */
+   TESTV_ST("e32, m1, tu, mu", 4, 32, 8, idx8, "vsuxei8.v v16, (a3), v8", 64);
+   TESTV_ST("e64, m2, tu, mu", 3, 64, 32, idx32, "vsoxei32.v v16, (a3), v8",
+            32);
+   TESTV_ST("e16, m1, tu, mu", 8, 16, 16, idx16,
+            "vsuxei16.v v16, (a3), v8, v0.t", 16);
+
+   /* ----------------- vs<nr>r.v vs3, (rs1) ---------------- */
+   TESTV_ST("e32, m1, tu, mu", 4, 32, 32, src1, "vs1r.v v16, (a3)", 16);
+
+   /* ------------------ vsm.v vs3, (rs1) ------------------- */
+   TESTV_ST("e8, m1, tu, mu", 13, 8, 8, src1, "vsm.v v16, (a3)", 16);
+}
+
+static void test_vector_integer(void)
+{
+   printf("RVV integer arithmetic\n");
+   fill_int();
+
+   /* ------------- vadd.{vv,vx,vi} vd, vs2, vs1 ------------ */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vadd.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vadd.vx v24, v16, a0", 0x123456789);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vadd.vi v24, v16, -5", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vadd.vv v24, v16, v8, v0.t", 0);
+   TESTV_V("e8, m1, tu, mu", 13, 8, "vadd.vv v24, v16, v8", 0);
+   TESTV_V("e16, m2, tu, mu", 11, 16, "vadd.vx v24, v16, a0", 0x8001);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vadd.vv v24, v16, v8", 0);
+   TESTV_V("e8, m8, tu, mu", 100, 8, "vadd.vv v24, v16, v8", 0);
+   TESTV_V("e32, mf2, tu, mu", 2, 32, "vadd.vv v24, v16, v8", 0);
+
+   /* ------------- vsub.{vv,vx} vd, vs2, vs1 --------------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vsub.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vsub.vx v24, v16, a0", 7);
+   TESTV_V("e8, m1, tu, mu", 13, 8, "vsub.vv v24, v16, v8, v0.t", 0);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vsub.vx v24, v16, a0", -1);
+   TESTV_V("e32, mf2, tu, mu", 2, 32, "vsub.vv v24, v16, v8", 0);
+
+   /* ------------ vrsub.{vx,vi} vd, vs2, rs1 --------------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vrsub.vx v24, v16, a0", 100);
+   TESTV_V("e16, m1, tu, mu", 8, 16, "vrsub.vi v24, v16, 15", 0);
+
+   /* ---------- v{min,max}[u].{vv,vx} vd, vs2, vs1 ---------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vminu.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmin.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmaxu.vx v24, v16, a0", 0x80000000);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmax.vx v24, v16, a0", -1);
+   TESTV_V("e8, m1, tu, mu", 13, 8, "vmin.vv v24, v16, v8", 0);
+   TESTV_V("e16, m2, tu, mu", 11, 16, "vmaxu.vv v24, v16, v8", 0);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vmax.vv v24, v16, v8", 0);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vminu.vx v24, v16, a0, v0.t",
+           0x8000000000000000);
+
+   /* -------- v{and,or,xor}.{vv,vx,vi} vd, vs2, vs1 -------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vand.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vor.vx v24, v16, a0", 0xf0f0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vxor.vi v24, v16, -1", 0);
+   TESTV_V("e8, m8, tu, mu", 100, 8, "vand.vx v24, v16, a0", 0x3c);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vxor.vv v24, v16, v8, v0.t", 0);
+
+   /* ------- v{sll,srl,sra}.{vv,vx,vi} vd, vs2, vs1 -------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vsll.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vsrl.vx v24, v16, a0", 35);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vsra.vi v24, v16, 7", 0);
+   TESTV_V("e8, m1, tu, mu", 13, 8, "vsra.vv v24, v16, v8", 0);
+   TESTV_V("e16, m2, tu, mu", 11, 16, "vsrl.vv v24, v16, v8", 0);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vsll.vx v24, v16, a0", 65);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vsra.vv v24, v16, v8", 0);
+
+   /* -------------- vmul.{vv,vx} vd, vs2, vs1 -------------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmul.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmul.vx v24, v16, a0", -3);
+   TESTV_V("e8, m1, tu, mu", 13, 8, "vmul.vx v24, v16, a0", 3);
+   TESTV_V("e16, m2, tu, mu", 11, 16, "vmul.vv v24, v16, v8", 0);
+   TESTV_V("e64, m4, tu, mu", 7, 64, "vmul.vv v24, v16, v8", 0);
+
+   /* ------ vmerge.{vvm,vxm,vim} vd, vs2, vs1, v0 ---------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmerge.vvm v24, v16, v8, v0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmerge.vxm v24, v16, a0, v0", 0x55);
+   TESTV_V("e16, m2, tu, mu", 11, 16, "vmerge.vim v24, v16, -7, v0", 0);
+
+   /* ------------- vmv.v.{v,x,i} vd, vs1 ------------------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmv.v.v v24, v8", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vmv.v.x v24, a0", -2);
+   TESTV_V("e8, m1, tu, mu", 13, 8, "vmv.v.i v24, 9", 0);
+
+   /* ----------------------- vid.v vd ---------------------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vid.v v24", 0);
+   TESTV_V("e8, m2, tu, mu", 20, 8, "vid.v v24, v0.t", 0);
+
+   /* ------------- vmv<nr>r.v vd, vs2 ---------------------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vmv1r.v v24, v16", 0);
+   TESTV_V("e64, m1, tu, mu", 2, 64, "vmv4r.v v24, v16", 0);
+
+   /* ------------- vmv.x.s rd, vs2 / vmv.s.x vd, rs1 ------- */
+   TESTV_X("e8, m1, tu, mu", 13, 8, "vmv.x.s a0, v16", 0);
+   TESTV_X("e16, m1, tu, mu", 8, 16, "vmv.x.s a0, v16", 0);
+   TESTV_X("e32, m1, tu, mu", 4, 32, "vmv.x.s a0, v16", 0);
+   TESTV_X("e64, m1, tu, mu", 2, 64, "vmv.x.s a0, v16", 0);
+   TESTV_V("e16, m1, tu, mu", 5, 16, "vmv.s.x v24, a0", 0x12345);
+}
+
+static void test_vector_compare(void)
+{
+   printf("RVV integer comparisons\n");
+   fill_int();
+
+   /* ------------- vms<cmp>.{vv,vx,vi} vd, vs2, vs1 -------- */
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmseq.vv v24, v16, v16", 0);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmseq.vv v24, v16, v8", 0);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmsne.vx v24, v16, a0", 0);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmsltu.vv v24, v16, v8", 0);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmslt.vx v24, v16, a0", 0);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmsleu.vi v24, v16, 15", 0);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmsle.vv v24, v16, v8", 0);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmsgtu.vx v24, v16, a0", 0x80000000);
+   TESTV_M("e32, m1, tu, mu", 4, 32, "vmsgt.vi v24, v16, -1", 0);
+   TESTV_M("e16, m1, tu, mu", 8, 16, "vmsltu.vv v24, v16, v8", 0);
+   TESTV_M("e16, m1, tu, mu", 8, 16, "vmsle.vv v24, v16, v8, v0.t", 0);
+   TESTV_M("e8, m2, tu, mu", 20, 8, "vmslt.vv v24, v16, v8", 0);
+   TESTV_M("e8, m2, tu, mu", 20, 8, "vmsgtu.vx v24, v16, a0, v0.t", 0x80);
+   TESTV_M("e64, m2, tu, mu", 3, 64, "vmsgt.vx v24, v16, a0", 0);
+}
+
+static void test_vector_reduction(void)
+{
+   printf("RVV integer reductions\n");
+   fill_int();
+
+   /* ------------- vred<op>.vs vd, vs2, vs1 ---------------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredsum.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredand.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredor.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredxor.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredminu.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredmin.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredmaxu.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredmax.vs v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vredsum.vs v24, v16, v8, v0.t", 0);
+   TESTV_V("e8, m1, tu, mu", 16, 8, "vredsum.vs v24, v16, v8", 0);
+   TESTV_V("e8, m1, tu, mu", 16, 8, "vredmin.vs v24, v16, v8", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vredmaxu.vs v24, v16, v8", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vredmax.vs v24, v16, v8, v0.t", 0);
+}
+
+static void test_vector_mask(void)
+{
+   printf("RVV mask operations\n");
+   fill_int();
+
+   /* ---------------- vm<op>.mm vd, vs2, vs1 --------------- */
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmand.mm v24, v16, v8", 0);
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmnand.mm v24, v16, v8", 0);
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmandn.mm v24, v16, v8", 0);
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmxor.mm v24, v16, v8", 0);
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmor.mm v24, v16, v8", 0);
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmnor.mm v24, v16, v8", 0);
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmorn.mm v24, v16, v8", 0);
+   TESTV_M("e8, m1, tu, mu", 16, 8, "vmxnor.mm v24, v16, v8", 0);
+   TESTV_M("e32, m1, tu, mu", 3, 32, "vmand.mm v24, v16, v8", 0);
+
+   /* --------------- vcpop.m rd, vs2{, v0.t} --------------- */
+   TESTV_X("e8, m1, tu, mu", 16, 8, "vcpop.m a0, v16", 0);
+   TESTV_X("e8, m1, tu, mu", 13, 8, "vcpop.m a0, v16, v0.t", 0);
+
+   /* -------------- vfirst.m rd, vs2{, v0.t} --------------- */
+   TESTV_X("e8, m1, tu, mu", 16, 8, "vfirst.m a0, v16", 0);
+   TESTV_X("e8, m1, tu, mu", 16, 8, "vfirst.m a0, v16, v0.t", 0);
+   TESTV_X("e8, m1, tu, mu", 16, 8,
+           "vmxor.mm v16, v16, v16; vfirst.m a0, v16", 0);
+}
+
+static void test_vector_float32(void)
+{
+   printf("RVV single-precision FP arithmetic\n");
+   fill_float32();
+
+   /* ---------- vf<op>.{vv,vf} vd, vs2, {vs1,rs1} ---------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfadd.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfadd.vf v24, v16, fa0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfadd.vv v24, v16, v8, v0.t", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfsub.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfsub.vf v24, v16, fa0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfrsub.vf v24, v16, fa0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmin.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmax.vf v24, v16, fa0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmul.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmul.vf v24, v16, fa0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfdiv.vv v24, v16, v8", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfdiv.vf v24, v16, fa0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfrdiv.vf v24, v16, fa0", 0);
+   TESTV_V("e32, m2, tu, mu", 7, 32, "vfmul.vv v24, v16, v8", 0);
+
+   /* --------- vf[n]m{acc,sac}.{vv,vf} vd, vs1, vs2 -------- */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmacc.vv v24, v8, v16", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmacc.vf v24, fa0, v16", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfnmacc.vv v24, v8, v16", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmsac.vv v24, v8, v16", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfnmsac.vf v24, fa0, v16", 0);
+
+   /* ------------- vfmerge.vfm / vfmv.v.f ------------------ */
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmerge.vfm v24, v16, fa0, v0", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmv.v.f v24, fa0", 0);
+
+   /* ----------- vfmv.f.s rd, vs2 / vfmv.s.f vd, rs1 ------- */
+   TESTV_X("e32, m1, tu, mu", 4, 32, "vfmv.f.s fa2, v16; fmv.x.d a0, fa2", 0);
+   TESTV_V("e32, m1, tu, mu", 4, 32, "vfmv.s.f v24, fa0", 0);
+}
+
+static void test_vector_float64(void)
+{
+   printf("RVV double-precision FP arithmetic\n");
+   fill_float64();
+
+   /* ---------- vf<op>.{vv,vf} vd, vs2, {vs1,rs1} ---------- */
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfadd.vv v24, v16, v8", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfadd.vf v24, v16, fa1", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfsub.vv v24, v16, v8, v0.t", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfrsub.vf v24, v16, fa1", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfmin.vf v24, v16, fa1", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfmax.vv v24, v16, v8", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfmul.vv v24, v16, v8", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfdiv.vv v24, v16, v8", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfrdiv.vf v24, v16, fa1", 0);
+   TESTV_V("e64, m1, tu, mu", 2, 64, "vfdiv.vf v24, v16, fa1", 0);
+
+   /* --------- vf[n]m{acc,sac}.{vv,vf} vd, vs1, vs2 -------- */
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfmacc.vv v24, v8, v16", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfnmacc.vf v24, fa1, v16", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfmsac.vf v24, fa1, v16", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfnmsac.vv v24, v8, v16, v0.t", 0);
+
+   /* ------------- vfmerge.vfm / vfmv.v.f ------------------ */
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfmerge.vfm v24, v16, fa1, v0", 0);
+   TESTV_V("e64, m2, tu, mu", 3, 64, "vfmv.v.f v24, fa1", 0);
+
+   /* ----------- vfmv.f.s rd, vs2 / vfmv.s.f vd, rs1 ------- */
+   TESTV_X("e64, m1, tu, mu", 2, 64, "vfmv.f.s fa2, v16; fmv.x.d a0, fa2", 0);
+   TESTV_V("e64, m1, tu, mu", 2, 64, "vfmv.s.f v24, fa1", 0);
+}
+
+int main(void)
+{
+   test_vector_config();
+   test_vector_loadstore();
+   test_vector_integer();
+   test_vector_compare();
+   test_vector_reduction();
+   test_vector_mask();
+   test_vector_float32();
+   test_vector_float64();
+   return 0;
+}
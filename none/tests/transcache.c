@@ -0,0 +1,44 @@
+/* Run with --translation-cache and --trace-children=yes.  The first
+   process saves its translations when it execs itself, and the second
+   one runs on them.  Both must compute the same results. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int cmp(const void* a, const void* b)
+{
+   unsigned x = *(const unsigned*)a, y = *(const unsigned*)b;
+   return x < y ? -1 : x > y;
+}
+
+static unsigned work(void)
+{
+   unsigned v[1000], x = 12345, sum = 0;
+   char buf[32];
+   int i;
+
+   for (i = 0; i < 1000; i++) {
+      x = x * 1103515245u + 12345u;
+      v[i] = x >> 8;
+   }
+   qsort(v, 1000, sizeof(v[0]), cmp);
+   for (i = 0; i < 1000; i += 10) {
+      snprintf(buf, sizeof(buf), "%u", v[i]);
+      sum = sum * 31 + (unsigned)strlen(buf) + v[i];
+   }
+   return sum;
+}
+
+int main(int argc, char** argv)
+{
+   printf("%s: %u\n", argc > 1 ? "child" : "parent", work());
+   fflush(stdout);
+   if (argc == 1) {
+      execl(argv[0], argv[0], "child", (char*)NULL);
+      perror("execl");
+      return 1;
+   }
+   return 0;
+}
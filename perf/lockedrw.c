@@ -0,0 +1,57 @@
+// This artificial program has a few threads taking turns, under a lock, to
+// read and write a shared array many times over.  Under DRD, every load and
+// store is checked against the accesses of the other threads, but most of
+// them repeat an access already made in the same segment, i.e. since the
+// thread last acquired the lock, and this is dominated by checking those.
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#define NWORDS 4096
+
+static int nthreads = 4;
+static int turns = 100;
+static int passes = 20;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static int shared[NWORDS];
+static char bytes[NWORDS];
+
+static void* worker(void* arg)
+{
+   long me = (long)arg;
+   int  t, p, i;
+
+   for (t = 0; t < turns; t++) {
+      pthread_mutex_lock(&mutex);
+      for (p = 0; p < passes; p++) {
+         for (i = 0; i < NWORDS; i++) {
+            shared[i] += bytes[i] + me;
+            bytes[i] ^= (char)i;
+         }
+      }
+      pthread_mutex_unlock(&mutex);
+   }
+   return NULL;
+}
+
+int main(int argc, char** argv)
+{
+   pthread_t* threads;
+   long       i;
+
+   if (argc > 1)
+      nthreads = atoi(argv[1]);
+   if (argc > 2)
+      turns = atoi(argv[2]);
+   if (argc > 3)
+      passes = atoi(argv[3]);
+
+   threads = malloc(nthreads * sizeof(pthread_t));
+   for (i = 0; i < nthreads; i++)
+      pthread_create(&threads[i], NULL, worker, (void*)i);
+   for (i = 0; i < nthreads; i++)
+      pthread_join(threads[i], NULL);
+   free(threads);
+
+   return 0;
+}
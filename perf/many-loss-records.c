@@ -30,6 +30,12 @@ int malloc_depth = 2;
    bytes are allocated simulating the data stored in the data structure */
 int malloc_data = 5;
 
+/* if given as argument, each block holds that many more words, which do not
+   point to a block, but which the leak checker has to look up as they could:
+   they point to static data, just past the end of the block, or are small
+   integers.  This makes the scan of the blocks the bulk of the leak search. */
+int scan_words = 0;
+
 /* every n top blocks, 1 block and all its children will be freed instead of
    being kept */
 int free_every_n = 2;
@@ -79,12 +85,27 @@ void release (struct Chunk ** mem)
    }
 }
 
+void fill_scan_words (struct Chunk *c, int sz)
+{
+   long *w = (long *) (c->s + malloc_data);
+   int i;
+
+   for (i = 0; i < scan_words; i++) {
+      switch (i % 4) {
+      case 0:  w[i] = (long) &topblocks; break;
+      case 1:  w[i] = (long) "string"; break;
+      case 2:  w[i] = (long) c + sz + 8; break;
+      default: w[i] = i; break;
+      }
+   }
+}
+
 void call_stack (int level)
 {
    int call_fan_out = 1;
 
    if (level == stack_depth) {  
-      int sz = sizeof(struct Chunk*) + malloc_data;
+      int sz = sizeof(struct Chunk*) + malloc_data + scan_words * sizeof(long);
       int d;
       int f;
 
@@ -97,6 +118,7 @@ void call_stack (int level)
             total_malloced += sz;
             blocknr++;
             new->child = prev;
+            fill_scan_words (new, sz);
             prev = new;
          }
          topblocks[freetop] = new;
@@ -196,10 +218,14 @@ void call_stack (int level)
    }
 }
 
-int main()
+int main(int argc, char **argv)
 {
    int d;
    int stacks = 1;
+   if (argc > 1) {
+      scan_words = atoi (argv[1]);
+      malloc_data = (malloc_data + sizeof(long) - 1) & ~(sizeof(long) - 1);
+   }
    for (d = 0; d < stack_depth; d++)
       stacks *= stack_fan_out;
    printf ("will generate %d different stacks\n", stacks);
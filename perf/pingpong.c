@@ -0,0 +1,54 @@
+// This artificial program has many threads taking turns at a few mutexes,
+// so that after a short while each thread has synchronised with all the
+// others.  Under Helgrind and DRD, each lock acquisition and release then
+// joins and compares vector clocks mentioning every thread, and this is
+// dominated by doing so.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NMUTEX 4
+
+static int nthreads = 64;
+static int iters = 2000;
+static pthread_mutex_t mutex[NMUTEX];
+static long counter[NMUTEX];
+
+static void* worker(void* arg)
+{
+   long me = (long)arg;
+   int  i;
+
+   for (i = 0; i < iters; i++) {
+      int k = (me + i) % NMUTEX;
+      pthread_mutex_lock(&mutex[k]);
+      counter[k]++;
+      pthread_mutex_unlock(&mutex[k]);
+   }
+   return NULL;
+}
+
+int main(int argc, char** argv)
+{
+   pthread_t* threads;
+   long       i, sum = 0;
+
+   if (argc > 1)
+      nthreads = atoi(argv[1]);
+   if (argc > 2)
+      iters = atoi(argv[2]);
+
+   threads = malloc(nthreads * sizeof(pthread_t));
+   for (i = 0; i < NMUTEX; i++)
+      pthread_mutex_init(&mutex[i], NULL);
+   for (i = 0; i < nthreads; i++)
+      pthread_create(&threads[i], NULL, worker, (void*)i);
+   for (i = 0; i < nthreads; i++)
+      pthread_join(threads[i], NULL);
+   for (i = 0; i < NMUTEX; i++)
+      sum += counter[i];
+   free(threads);
+
+   return sum != (long)nthreads * iters;
+}
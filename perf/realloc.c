@@ -0,0 +1,36 @@
+// This artificial program keeps a few large buffers, each of them half
+// written, and repeatedly grows and shrinks them with realloc, as a
+// program accumulating network data in growable buffers would.  Under
+// Memcheck, each realloc moves the block, so this is dominated by the
+// copying of the V+A bits of the buffers (copy_address_range_state).
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NBUFS   8
+#define BUFSIZE (1024*1024)
+#define REPS    200
+
+int main(void)
+{
+   char* bufs[NBUFS];
+   int   i, r;
+   long  sum = 0;
+
+   for (i = 0; i < NBUFS; i++) {
+      bufs[i] = malloc(BUFSIZE);
+      memset(bufs[i], i, BUFSIZE/2);
+   }
+
+   for (r = 0; r < REPS; r++) {
+      for (i = 0; i < NBUFS; i++) {
+         bufs[i] = realloc(bufs[i], BUFSIZE + (r & 1) * 4096);
+         sum += bufs[i][r];
+      }
+   }
+
+   for (i = 0; i < NBUFS; i++)
+      free(bufs[i]);
+
+   return sum == 0;
+}
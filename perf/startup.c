@@ -0,0 +1,55 @@
+// This artificial program runs a lot of different code, but each piece
+// only a few times, like the startup of a large program.  Under Valgrind
+// its run time is almost all translation time, so it shows what
+// --translation-cache saves: startup2 runs it with a cache, which is
+// filled by the first run and used by the following ones (use
+// vg_perf --reps=2 or more).
+
+#include <stdio.h>
+
+// 4096 small functions, f100000 .. f133333 (the digits are base 4).
+#define F(n)                                                    \
+   static unsigned f##n(unsigned x)                             \
+   {                                                            \
+      x ^= x >> (n % 13 + 1);                                   \
+      x *= 0x9e3779b1u + n;                                     \
+      if (x & (1u << (n % 31)))                                 \
+         x += n;                                                \
+      else                                                      \
+         x -= 3u * n;                                           \
+      return x ^ (x << (n % 7 + 1));                            \
+   }
+#define F4(n)    F(n##0)     F(n##1)     F(n##2)     F(n##3)
+#define F16(n)   F4(n##0)    F4(n##1)    F4(n##2)    F4(n##3)
+#define F64(n)   F16(n##0)   F16(n##1)   F16(n##2)   F16(n##3)
+#define F256(n)  F64(n##0)   F64(n##1)   F64(n##2)   F64(n##3)
+#define F1024(n) F256(n##0)  F256(n##1)  F256(n##2)  F256(n##3)
+#define F4096(n) F1024(n##0) F1024(n##1) F1024(n##2) F1024(n##3)
+
+F4096(1)
+
+#define T(n)     f##n,
+#define T4(n)    T(n##0)     T(n##1)     T(n##2)     T(n##3)
+#define T16(n)   T4(n##0)    T4(n##1)    T4(n##2)    T4(n##3)
+#define T64(n)   T16(n##0)   T16(n##1)   T16(n##2)   T16(n##3)
+#define T256(n)  T64(n##0)   T64(n##1)   T64(n##2)   T64(n##3)
+#define T1024(n) T256(n##0)  T256(n##1)  T256(n##2)  T256(n##3)
+#define T4096(n) T1024(n##0) T1024(n##1) T1024(n##2) T1024(n##3)
+
+static unsigned (* const fns[])(unsigned) = { T4096(1) };
+
+#define N_FNS   (sizeof(fns) / sizeof(fns[0]))
+#define N_PASSES 4
+
+int main(void)
+{
+   unsigned x = 1;
+   unsigned i, pass;
+
+   for (pass = 0; pass < N_PASSES; pass++)
+      for (i = 0; i < N_FNS; i++)
+         x = fns[i](x);
+
+   printf("%u\n", x);
+   return 0;
+}
@@ -0,0 +1,114 @@
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// This file determines riscv64 features a processor supports.
+// The extensions are probed the same way as Valgrind does at startup, by
+// executing one of their instructions and catching SIGILL. The vector unit is
+// emulated with VLEN=128 regardless of the host VLEN, so only the presence of
+// an extension matters.
+//
+// We return:
+// - 0 if the machine has the asked-for feature.
+// - 1 if the machine doesn't have the asked-for feature.
+// - 2 if the asked-for feature isn't recognised (this will always be the case
+//     for any feature if run on a non-riscv64 machine).
+// - 3 if there was a usage error (it also prints an error message).
+#define FEATURE_PRESENT       0
+#define FEATURE_NOT_PRESENT   1
+#define UNRECOGNISED_FEATURE  2
+#define USAGE_ERROR           3
+
+#if defined(VGA_riscv64)
+
+static sigjmp_buf env_unsup_insn;
+
+static void handler_unsup_insn(int sig)
+{
+   siglongjmp(env_unsup_insn, 1);
+}
+
+// The probes use .word so that the assembler does not need to know the
+// extensions.
+static void probe_v(void)
+{
+   __asm__ __volatile__(".word 0x0c0072d7" /* vsetvli t0, zero, e8, m1 */
+                        ::: "t0");
+}
+
+static void probe_zba(void)
+{
+   __asm__ __volatile__(".word 0x200022b3" /* sh1add t0, zero, zero */
+                        ::: "t0");
+}
+
+static void probe_zbb(void)
+{
+   __asm__ __volatile__(".word 0x60001293" /* clz t0, zero */
+                        ::: "t0");
+}
+
+static void probe_zbs(void)
+{
+   __asm__ __volatile__(".word 0x280012b3" /* bset t0, zero, zero */
+                        ::: "t0");
+}
+
+typedef struct
+{
+   char name[8];
+   void (*probe)(void);
+} capability;
+
+static capability capabilities[] = {
+   {"v",   probe_v},   {"zba", probe_zba},
+   {"zbb", probe_zbb}, {"zbs", probe_zbs},
+   {"",    NULL}
+};
+
+static int go(const char* feature_name)
+{
+   for (int i = 0; capabilities[i].probe; ++i) {
+      if (strcmp(feature_name, capabilities[i].name) != 0)
+         continue;
+
+      struct sigaction sa;
+      memset(&sa, 0, sizeof(sa));
+      sa.sa_handler = handler_unsup_insn;
+      sa.sa_flags   = SA_NODEFER;
+      sigemptyset(&sa.sa_mask);
+      if (sigaction(SIGILL, &sa, NULL) != 0)
+         return FEATURE_NOT_PRESENT;
+
+      if (sigsetjmp(env_unsup_insn, 1))
+         return FEATURE_NOT_PRESENT;
+      capabilities[i].probe();
+      return FEATURE_PRESENT;
+   }
+   return UNRECOGNISED_FEATURE;
+}
+
+#else
+
+static int go(const char* feature_name)
+{
+   // Feature not recognised (non-riscv64 machine!)
+   return UNRECOGNISED_FEATURE;
+}
+
+#endif   // defined(VGA_riscv64)
+
+
+//---------------------------------------------------------------------------
+// main
+//---------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+   if (argc != 2) {
+      fprintf(stderr, "usage: riscv64_features <feature>\n");
+      exit(USAGE_ERROR);
+   }
+   return go(argv[1]);
+}